@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace Ui { class BinaryStringWidget; }
 
 class QString;
+class HexStringValidator;
 
 class EDB_EXPORT BinaryString : public QWidget {
 	Q_OBJECT
@@ -42,11 +43,14 @@ private Q_SLOTS:
 
 public:
 	void setMaxLength(int n);
+	void setWildcardsEnabled(bool enabled);
 	QByteArray value() const;
+	QByteArray mask() const;
 	void setValue(const QByteArray &);
 
 private:
 	 Ui::BinaryStringWidget *const ui;
+	 HexStringValidator *const     validator_;
 };
 
 #endif
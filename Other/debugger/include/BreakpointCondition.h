@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BREAKPOINT_CONDITION_20111017_H_
+#define BREAKPOINT_CONDITION_20111017_H_
+
+#include "Types.h"
+#include "API.h"
+#include "Expression.h"
+#include <QString>
+#include <QVector>
+
+class State;
+
+// a breakpoint condition which is parsed once, when it is set, so that each
+// hit only has to fetch the registers it uses and run the compiled expression
+class EDB_EXPORT BreakpointCondition {
+public:
+	typedef Expression<edb::address_t>::memory_reader_t memory_reader_t;
+
+public:
+	BreakpointCondition(const QString &condition, memory_reader_t mr);
+
+private:
+	BreakpointCondition(const BreakpointCondition &);
+	BreakpointCondition &operator=(const BreakpointCondition &);
+
+public:
+	bool valid() const             { return valid_; }
+	ExpressionError error() const  { return error_; }
+	QString text() const           { return text_; }
+
+public:
+	edb::address_t evaluate(const State &state, bool &ok, ExpressionError &error);
+
+private:
+	void resolve(const State &state);
+
+private:
+	QString                    text_;
+	Expression<edb::address_t> expression_;
+	ExpressionError            error_;
+	QVector<int>               register_ids_;
+	QVector<edb::address_t>    values_;
+	bool                       valid_;
+	bool                       resolved_;
+};
+
+#endif
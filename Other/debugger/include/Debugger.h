@@ -36,6 +36,7 @@ class DebuggerCoreInterface;
 class DebuggerPluginInterface;
 class FunctionInfo;
 class MemoryRegions;
+class ReferenceIndex;
 class SessionFileInterface;
 class State;
 class SymbolManagerInterface;
@@ -63,6 +64,9 @@ namespace edb {
 		// the memory region manager
 		EDB_EXPORT MemoryRegions &memory_regions();
 
+		// the cross reference index (shared by the plugins which need it)
+		EDB_EXPORT ReferenceIndex &reference_index();
+
 		// the current arch processor
 		EDB_EXPORT ArchProcessorInterface &arch_processor();
 
@@ -79,6 +83,8 @@ namespace edb {
 		EDB_EXPORT edb::address_t disable_breakpoint(edb::address_t address);
 		EDB_EXPORT void set_breakpoint_condition(edb::address_t address, const QString &condition);
 		EDB_EXPORT QString get_breakpoint_condition(edb::address_t address);
+		EDB_EXPORT bool eval_breakpoint_condition(const Breakpoint::pointer &bp, const State &state, edb::address_t &value, ExpressionError &err);
+		EDB_EXPORT void clear_breakpoint_conditions();
 
 		EDB_EXPORT edb::address_t current_data_view_address();
 
@@ -58,6 +58,17 @@ public:
 	virtual edb::tid_t active_thread() const     { return static_cast<edb::tid_t>(-1); }
 	virtual void set_active_thread(edb::tid_t)   {}
 
+public:
+	// performance counters (optional), keyed by a descriptive name such as
+	// "memory.read.ptrace", the values only ever increase
+	virtual QHash<QString, quint64> statistics() const { return QHash<QString, quint64>(); }
+
+public:
+	// changes whenever the debugee's memory may have changed, that is each
+	// time it is let run or written to (optional). 0 means that the core
+	// doesn't keep track, so anything may have changed
+	virtual quint64 memory_generation() const { return 0; }
+
 public:
 	virtual bool attach(edb::pid_t pid) = 0;
 	virtual bool open(const QString &path, const QString &cwd, const QStringList &args) = 0;
@@ -80,6 +91,12 @@ public:
 	virtual void clear_breakpoints() = 0;
 	virtual void remove_breakpoint(edb::address_t address) = 0;
 
+public:
+	// arms/disarms a group of breakpoints using as few memory transfers as
+	// possible (optional)
+	virtual void enable_breakpoints(const QList<Breakpoint::pointer> &breakpoints)  { Q_FOREACH(const Breakpoint::pointer &bp, breakpoints) { bp->enable(); } }
+	virtual void disable_breakpoints(const QList<Breakpoint::pointer> &breakpoints) { Q_FOREACH(const Breakpoint::pointer &bp, breakpoints) { bp->disable(); } }
+
 public:
 	virtual StateInterface *create_state() const = 0;
 
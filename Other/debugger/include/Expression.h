@@ -20,7 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EXPRESSION_20070402_H_
 
 #include <QString>
+#include <QStringList>
 #include <boost/function.hpp>
+#include <vector>
 
 struct ExpressionError {
 public:
@@ -135,38 +137,52 @@ private:
 		}
 	};
 
-private:
-	T evaluate_expression() {
-		T result;
+public:
+	// parses the expression into a program which can be run any number of times
+	bool compile(ExpressionError &error) throw();
 
-		get_token();
-		eval_exp(result);
+	// the names of the variables used, a variable's index is its slot
+	const QStringList &variables() const { return variables_; }
 
-		return result;
-	}
+	// runs the compiled program, values holds one value per variable slot
+	T evaluate(const T *values, bool &ok, ExpressionError &error) const throw();
 
-public:
-	T evaluate_expression(bool &ok, ExpressionError &error) throw() {
-		try {
-			ok = true;
-			return evaluate_expression();
-		} catch(const ExpressionError &e) {
-			ok = false;
-			error = e;
-			return T();
+	// compiles (if needed) and evaluates, using the variable getter
+	T evaluate_expression(bool &ok, ExpressionError &error) throw();
+
+private:
+	struct Instruction {
+		enum Opcode {
+			CONSTANT,
+			VARIABLE,
+			MEMORY,
+			UNARY,
+			BINARY
+		};
+
+		Instruction(Opcode opcode, typename Token::Operator oper, T value, int slot) : opcode_(opcode), operator_(oper), value_(value), slot_(slot) {
 		}
-	}
+
+		Opcode                   opcode_;
+		typename Token::Operator operator_;
+		T                        value_;
+		int                      slot_;
+	};
+
 private:
-	void eval_exp(T &result);
-	void eval_exp0(T &result);
-	void eval_exp1(T &result);
-	void eval_exp2(T &result);
-	void eval_exp3(T &result);
-	void eval_exp4(T &result);
-	void eval_exp5(T &result);
-	void eval_exp6(T &result);
-	void eval_exp7(T &result);
-	void eval_atom(T &result);
+	void compile();
+	T run(const T *values) const;
+	void add_instruction(typename Instruction::Opcode opcode, typename Token::Operator oper, T value, int slot);
+	void parse_exp();
+	void parse_exp0();
+	void parse_exp1();
+	void parse_exp2();
+	void parse_exp3();
+	void parse_exp4();
+	void parse_exp5();
+	void parse_exp6();
+	void parse_exp7();
+	void parse_atom();
 	void get_token();
 
 	static bool is_delim(QChar ch) {
@@ -179,6 +195,11 @@ private:
 	Token                   token_;
 	variable_getter_t       variable_reader_;
 	memory_reader_t         memory_reader_;
+	std::vector<Instruction> program_;
+	QStringList             variables_;
+	int                     stack_depth_;
+	bool                    compiled_;
+	mutable std::vector<T>  stack_;
 };
 
 #include "Expression.tcc"
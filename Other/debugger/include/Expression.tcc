@@ -26,20 +26,282 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 template <class T>
 Expression<T>::Expression(const QString &s, variable_getter_t vg, memory_reader_t mr) : 
 		expression_(s), expression_ptr_(expression_.begin()), 
-		variable_reader_(vg), memory_reader_(mr) {
+		variable_reader_(vg), memory_reader_(mr), stack_depth_(0), compiled_(false) {
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_exp(T &result)
+// Name: compile(ExpressionError &error)
+// Desc: parses the expression, returns false if it is malformed
+//------------------------------------------------------------------------------
+template <class T>
+bool Expression<T>::compile(ExpressionError &error) throw() {
+	try {
+		compile();
+		return true;
+	} catch(const ExpressionError &e) {
+		error = e;
+		return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: compile()
+// Desc: 
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compile() {
+	if(!compiled_) {
+		program_.clear();
+		variables_.clear();
+		stack_depth_    = 0;
+		expression_ptr_ = expression_.begin();
+
+		get_token();
+		parse_exp();
+
+		// work out how deep the value stack gets so that running the
+		// program never has to allocate
+		int depth = 0;
+		for(typename std::vector<Instruction>::const_iterator it = program_.begin(); it != program_.end(); ++it) {
+			switch(it->opcode_) {
+			case Instruction::CONSTANT:
+			case Instruction::VARIABLE:
+				stack_depth_ = qMax(stack_depth_, ++depth);
+				break;
+			case Instruction::BINARY:
+				--depth;
+				break;
+			default:
+				break;
+			}
+		}
+
+		stack_.resize(stack_depth_);
+		compiled_ = true;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: evaluate(const T *values, bool &ok, ExpressionError &error) const
+// Desc: 
+//------------------------------------------------------------------------------
+template <class T>
+T Expression<T>::evaluate(const T *values, bool &ok, ExpressionError &error) const throw() {
+	if(!compiled_) {
+		ok = false;
+		error = ExpressionError(ExpressionError::SYNTAX);
+		return T();
+	}
+
+	try {
+		ok = true;
+		return run(values);
+	} catch(const ExpressionError &e) {
+		ok = false;
+		error = e;
+		return T();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: evaluate_expression(bool &ok, ExpressionError &error)
+// Desc: 
+//------------------------------------------------------------------------------
+template <class T>
+T Expression<T>::evaluate_expression(bool &ok, ExpressionError &error) throw() {
+	try {
+		compile();
+
+		std::vector<T> values;
+		values.reserve(variables_.size());
+
+		Q_FOREACH(const QString &name, variables_) {
+			if(!variable_reader_) {
+				throw ExpressionError(ExpressionError::UNKNOWN_VARIABLE);
+			}
+
+			bool var_ok;
+			ExpressionError var_error;
+			values.push_back(variable_reader_(name, var_ok, var_error));
+			if(!var_ok) {
+				throw var_error;
+			}
+		}
+
+		ok = true;
+		return run(values.empty() ? 0 : &values[0]);
+	} catch(const ExpressionError &e) {
+		ok = false;
+		error = e;
+		return T();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: run(const T *values) const
+// Desc: executes the program on a small value stack, the parser has already
+//       made sure that it is well formed
+//------------------------------------------------------------------------------
+template <class T>
+T Expression<T>::run(const T *values) const {
+
+	T *const stack = &stack_[0];
+	int sp = 0;
+
+	for(typename std::vector<Instruction>::const_iterator it = program_.begin(); it != program_.end(); ++it) {
+		switch(it->opcode_) {
+		case Instruction::CONSTANT:
+			stack[sp++] = it->value_;
+			break;
+		case Instruction::VARIABLE:
+			stack[sp++] = values[it->slot_];
+			break;
+		case Instruction::MEMORY:
+			if(memory_reader_) {
+				bool ok;
+				ExpressionError error;
+				stack[sp - 1] = memory_reader_(stack[sp - 1], ok, error);
+				if(!ok) {
+					throw error;
+				}
+			} else {
+				throw ExpressionError(ExpressionError::CANNOT_READ_MEMORY);
+			}
+			break;
+		case Instruction::UNARY:
+			do {
+				T &result = stack[sp - 1];
+				switch(it->operator_) {
+				case Token::PLUS:
+					// this may seems like a waste, but unary + can be overloaded for a type
+					// to have a non-nop effect!
+					result = +result;
+					break;
+				case Token::MINUS:
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable:4146)
+#endif
+					result = -result;
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+					break;
+				case Token::CMP:
+					result = ~result;
+					break;
+				case Token::NOT:
+					result = !result;
+					break;
+				default:
+					break;
+				}
+			} while(0);
+			break;
+		case Instruction::BINARY:
+			do {
+				const T partial_value = stack[--sp];
+				T &result = stack[sp - 1];
+				switch(it->operator_) {
+				case Token::LOGICAL_AND:
+					result = result && partial_value;
+					break;
+				case Token::LOGICAL_OR:
+					result = result || partial_value;
+					break;
+				case Token::AND:
+					result &= partial_value;
+					break;
+				case Token::OR:
+					result |= partial_value;
+					break;
+				case Token::XOR:
+					result ^= partial_value;
+					break;
+				case Token::LT:
+					result = result < partial_value;
+					break;
+				case Token::LE:
+					result = result <= partial_value;
+					break;
+				case Token::GT:
+					result = result > partial_value;
+					break;
+				case Token::GE:
+					result = result >= partial_value;
+					break;
+				case Token::EQ:
+					result = result == partial_value;
+					break;
+				case Token::NE:
+					result = result != partial_value;
+					break;
+				case Token::LSHFT:
+					result <<= partial_value;
+					break;
+				case Token::RSHFT:
+					result >>= partial_value;
+					break;
+				case Token::PLUS:
+					result += partial_value;
+					break;
+				case Token::MINUS:
+#ifdef _MSC_VER
+#pragma warning(push)
+/* disable warning about applying unary - to an unsigned type */
+#pragma warning(disable : 4146)
+#endif
+					result -= partial_value;
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+					break;
+				case Token::MUL:
+					result *= partial_value;
+					break;
+				case Token::DIV:
+					if(partial_value == 0) {
+						throw ExpressionError(ExpressionError::DIVIDE_BY_ZERO);
+					}
+					result /= partial_value;
+					break;
+				case Token::MOD:
+					if(partial_value == 0) {
+						throw ExpressionError(ExpressionError::DIVIDE_BY_ZERO);
+					}
+					result %= partial_value;
+					break;
+				default:
+					break;
+				}
+			} while(0);
+			break;
+		}
+	}
+
+	return stack[0];
+}
+
+//------------------------------------------------------------------------------
+// Name: add_instruction(typename Instruction::Opcode opcode, typename Token::Operator oper, T value, int slot)
+// Desc: appends an instruction to the program
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::add_instruction(typename Instruction::Opcode opcode, typename Token::Operator oper, T value, int slot) {
+	program_.push_back(Instruction(opcode, oper, value, slot));
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_exp()
 // Desc: private entry point with sanity check
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_exp(T &result) {
+void Expression<T>::parse_exp() {
 	if(token_.type_ == Token::UNKNOWN) {
 		throw ExpressionError(ExpressionError::SYNTAX);
 	}
 	
-	eval_exp0(result);
+	parse_exp0();
 	
 	switch(token_.type_) {
 	case Token::OPERATOR:
@@ -63,259 +325,125 @@ void Expression<T>::eval_exp(T &result) {
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_exp0(T &result)
+// Name: parse_exp0()
 // Desc: logic
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_exp0(T &result) {
-	eval_exp1(result);
+void Expression<T>::parse_exp0() {
+	parse_exp1();
 
 	for(Token op = token_; op.operator_ == Token::LOGICAL_AND || op.operator_ == Token::LOGICAL_OR; op = token_) {
-		T partial_value;
-
 		get_token();
-		eval_exp1(partial_value);
-
-		// add or subtract
-		switch(op.operator_) {
-		case Token::LOGICAL_AND:
-			result = result && partial_value;
-			break;
-		case Token::LOGICAL_OR:
-			result = result || partial_value;
-			break;
-		default:
-			break;
-		}
+		parse_exp1();
+		add_instruction(Instruction::BINARY, op.operator_, T(), -1);
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_exp1(T &result)
+// Name: parse_exp1()
 // Desc: binary logic
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_exp1(T &result) {
-	eval_exp2(result);
+void Expression<T>::parse_exp1() {
+	parse_exp2();
 
 	for(Token op = token_; op.operator_ == Token::AND || op.operator_ == Token::OR || op.operator_ == Token::XOR; op = token_) {
-		T partial_value;
-
 		get_token();
-		eval_exp2(partial_value);
-
-		// add or subtract
-		switch(op.operator_) {
-		case Token::AND:
-			result &= partial_value;
-			break;
-		case Token::OR:
-			result |= partial_value;
-			break;
-		case Token::XOR:
-			result ^= partial_value;
-			break;
-		default:
-			break;
-		}
+		parse_exp2();
+		add_instruction(Instruction::BINARY, op.operator_, T(), -1);
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_exp2(T &result)
+// Name: parse_exp2()
 // Desc: comparisons
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_exp2(T &result) {
-	eval_exp3(result);
+void Expression<T>::parse_exp2() {
+	parse_exp3();
 
 	for(Token op = token_; op.operator_ == Token::LT || op.operator_ == Token::LE || op.operator_ == Token::GT || op.operator_ == Token::GE || op.operator_ == Token::EQ || op.operator_ == Token::NE; op = token_) {
-		T partial_value;
-
 		get_token();
-		eval_exp3(partial_value);
-
-		// perform the relational operation
-		switch(op.operator_) {
-		case Token::LT:
-			result = result < partial_value;
-			break;
-		case Token::LE:
-			result = result <= partial_value;
-			break;
-		case Token::GT:
-			result = result > partial_value;
-			break;
-		case Token::GE:
-			result = result >= partial_value;
-			break;
-		case Token::EQ:
-			result = result == partial_value;
-			break;
-		case Token::NE:
-			result = result != partial_value;
-			break;
-		default:
-			break;
-		}
+		parse_exp3();
+		add_instruction(Instruction::BINARY, op.operator_, T(), -1);
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_exp3(T &result)
+// Name: parse_exp3()
 // Desc: shifts
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_exp3(T &result) {
-	eval_exp4(result);
+void Expression<T>::parse_exp3() {
+	parse_exp4();
 
 	for(Token op = token_; op.operator_ == Token::RSHFT || op.operator_ == Token::LSHFT; op = token_) {
-		T partial_value;
-
 		get_token();
-		eval_exp4(partial_value);
-
-		// perform the shift operation
-		switch(op.operator_) {
-		case Token::LSHFT:
-			result <<= partial_value;
-			break;
-		case Token::RSHFT:
-			result >>= partial_value;
-			break;
-		default:
-			break;
-		}
+		parse_exp4();
+		add_instruction(Instruction::BINARY, op.operator_, T(), -1);
 	}	
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_exp4(T &result)
+// Name: parse_exp4()
 // Desc: addition/subtraction
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_exp4(T &result) {
-	eval_exp5(result);
+void Expression<T>::parse_exp4() {
+	parse_exp5();
 
 	for(Token op = token_; op.operator_ == Token::PLUS || op.operator_ == Token::MINUS; op = token_) {
-		T partial_value;
-
 		get_token();
-		eval_exp5(partial_value);
-
-		// add or subtract
-		switch(op.operator_) {
-		case Token::PLUS:
-			result += partial_value;
-			break;
-		case Token::MINUS:
-#ifdef _MSC_VER
-#pragma warning(push)
-/* disable warning about applying unary - to an unsigned type */
-#pragma warning(disable : 4146)
-#endif
-			result -= partial_value;
-#ifdef _MSC_VER
-#pragma warning(pop)
-#endif
-			break;
-		default:
-			break;
-		}
+		parse_exp5();
+		add_instruction(Instruction::BINARY, op.operator_, T(), -1);
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_exp5(T &result)
+// Name: parse_exp5()
 // Desc: multiplication/division
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_exp5(T &result) {
-	eval_exp6(result);
+void Expression<T>::parse_exp5() {
+	parse_exp6();
 
 	for(Token op = token_; op.operator_ == Token::MUL || op.operator_ == Token::DIV || op.operator_ == Token::MOD; op = token_) {
-		T partial_value;
-
 		get_token();
-		eval_exp6(partial_value);
-
-		// mul, div, or modulus
-		switch(op.operator_) {
-		case Token::MUL:
-			result *= partial_value;
-			break;
-		case Token::DIV:
-			if(partial_value == 0) {
-				throw ExpressionError(ExpressionError::DIVIDE_BY_ZERO);
-			}
-			result /= partial_value;
-			break;
-		case Token::MOD:
-			if(partial_value == 0) {
-				throw ExpressionError(ExpressionError::DIVIDE_BY_ZERO);
-			}
-			result %= partial_value;
-			break;
-		default:
-			break;
-		}
+		parse_exp6();
+		add_instruction(Instruction::BINARY, op.operator_, T(), -1);
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_exp6(T &result)
+// Name: parse_exp6()
 // Desc: unary expressions
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_exp6(T &result) {
+void Expression<T>::parse_exp6() {
 
 	Token op = token_;
 	if(op.operator_ == Token::PLUS || op.operator_ == Token::MINUS || op.operator_ == Token::CMP || op.operator_ == Token::NOT) {
 		get_token();
-	}
-
-	eval_exp7(result);
-
-	switch(op.operator_) {
-	case Token::PLUS:
-		// this may seems like a waste, but unary + can be overloaded for a type
-		// to have a non-nop effect!
-		result = +result;
-		break;
-	case Token::MINUS:
-#ifdef _MSC_VER
-#pragma warning(push)
-#pragma warning(disable:4146)
-#endif
-		result = -result;
-#ifdef _MSC_VER
-#pragma warning(pop)
-#endif
-		break;
-	case Token::CMP:
-		result = ~result;
-		break;
-	case Token::NOT:
-		result = !result;
-		break;
-	default:
-		break;
+		parse_exp7();
+		add_instruction(Instruction::UNARY, op.operator_, T(), -1);
+	} else {
+		parse_exp7();
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_exp7(T &result)
+// Name: parse_exp7()
 // Desc: sub-expressions
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_exp7(T &result) {
+void Expression<T>::parse_exp7() {
 
 	switch(token_.operator_) {
 	case Token::LPAREN:
 		get_token();
 
 		// get sub-expression
-		eval_exp0(result);
+		parse_exp0();
 
 		if(token_.operator_ != Token::RPAREN) {
 			throw ExpressionError(ExpressionError::UNBALANCED_PARENS);
@@ -327,69 +455,56 @@ void Expression<T>::eval_exp7(T &result) {
 		throw ExpressionError(ExpressionError::UNBALANCED_PARENS);
 		break;
 	case Token::LBRACE:
-		do {
-			get_token();
+		get_token();
 
-			// get sub-expression
-			T effective_address;
-			eval_exp0(effective_address);
+		// get the effective address, then read what it points to
+		parse_exp0();
+		add_instruction(Instruction::MEMORY, Token::NONE, T(), -1);
 
-			if(memory_reader_) {
-				bool ok;
-				ExpressionError error;
-								
-				result = memory_reader_(effective_address, ok, error);
-				if(!ok) {
-					throw error;
-				}
-			} else {
-				throw ExpressionError(ExpressionError::CANNOT_READ_MEMORY);
-			}
-
-			if(token_.operator_ != Token::RBRACE) {
-				throw ExpressionError(ExpressionError::UNBALANCED_BRACES);
-			}
+		if(token_.operator_ != Token::RBRACE) {
+			throw ExpressionError(ExpressionError::UNBALANCED_BRACES);
+		}
 
-			get_token();
-		} while(0);
+		get_token();
 		break;
 	case Token::RBRACE:
 		throw ExpressionError(ExpressionError::UNBALANCED_BRACES);
 		break;
 	default:
-		eval_atom(result);
+		parse_atom();
 		break;
 	
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: eval_atom(T &result)
+// Name: parse_atom()
 // Desc: atoms (variables/constants)
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::eval_atom(T &result) {
+void Expression<T>::parse_atom() {
 
 	switch(token_.type_) {	
 	case Token::VARIABLE:
-		if(variable_reader_) {
-			bool ok;
-			ExpressionError error;
-			result = variable_reader_(token_.data_, ok, error);
-			if(!ok) {
-				throw error;
-			}			
-		} else {
-			throw ExpressionError(ExpressionError::UNKNOWN_VARIABLE);
-		}
+		do {
+			int slot = variables_.indexOf(token_.data_);
+			if(slot == -1) {
+				slot = variables_.size();
+				variables_.push_back(token_.data_);
+			}
+			add_instruction(Instruction::VARIABLE, Token::NONE, T(), slot);
+		} while(0);
 		get_token();	
 		break;
 	case Token::NUMBER:
-		bool ok;
-		result = token_.data_.toULongLong(&ok, 0);
-		if(!ok) {
-			throw ExpressionError(ExpressionError::INVALID_NUMBER);
-		}
+		do {
+			bool ok;
+			const T value = token_.data_.toULongLong(&ok, 0);
+			if(!ok) {
+				throw ExpressionError(ExpressionError::INVALID_NUMBER);
+			}
+			add_instruction(Instruction::CONSTANT, Token::NONE, value, -1);
+		} while(0);
 		get_token();	
 		break;
 	default:
@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "MemRegion.h"
 
 #include <QAbstractItemModel>
+#include <QByteArray>
 #include <QList>
 
 class EDB_EXPORT MemoryRegions : public QAbstractItemModel {
@@ -54,6 +55,10 @@ public:
 private:
 	edb::pid_t       pid_;
 	QList<MemRegion> regions_;
+
+	// the unparsed map which regions_ was built from (where the platform
+	// has one), if it hasn't changed then there is nothing to do
+	QByteArray       raw_map_;
 };
 
 // provide a reasonable hash function for the region
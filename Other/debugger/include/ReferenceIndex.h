@@ -0,0 +1,114 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REFERENCEINDEX_20121017_H_
+#define REFERENCEINDEX_20121017_H_
+
+#include "Types.h"
+#include "API.h"
+#include "MemRegion.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+#include <cstddef>
+
+// an index of the cross references found in the regions of the process:
+// pointer aligned values which point into a mapped region and the targets of
+// relative jumps and calls. The references of a region are kept sorted by
+// target so "who references X?" is a binary search. A region is only indexed
+// once it is queried, and only rescanned when its contents (or the memory
+// layout) change. Nothing is checked again until the debugger core reports
+// that memory may have changed, so repeated queries during one stop cost only
+// the lookups.
+class EDB_EXPORT ReferenceIndex {
+public:
+	enum Type {
+		REF_DATA,
+		REF_JUMP,
+		REF_CALL
+	};
+
+	struct Reference {
+		edb::address_t target;
+		edb::address_t source;
+		Type           type;
+	};
+
+	typedef QVector<Reference> ReferenceList;
+
+public:
+	ReferenceIndex();
+
+public:
+	// makes sure the region's references are current, returns true if the
+	// region had to be rescanned. The second form is for callers which
+	// already have a snapshot of the region's bytes.
+	bool update(const MemRegion &region);
+	bool update(const MemRegion &region, const quint8 *bytes, std::size_t size);
+
+	void invalidate(const MemRegion &region);
+	void clear();
+
+public:
+	// the references to target from the regions which have been indexed
+	ReferenceList references_to(edb::address_t target) const;
+
+	// these bring the region up to date first
+	ReferenceList references_to(const MemRegion &region, edb::address_t target);
+
+	// all of the references found in a region, sorted by target
+	ReferenceList references(const MemRegion &region);
+
+private:
+	struct Range {
+		edb::address_t start;
+		edb::address_t end;
+	};
+
+	// a reference as it is stored, the source is relative to its region
+	struct Entry {
+		edb::address_t target;
+		quint32        offset;
+		quint32        type;
+	};
+
+	typedef QVector<Entry> EntryList;
+
+	struct RegionInfo {
+		EntryList     entries;
+		QByteArray    md5;
+		quint64       generation; // the memory generation the md5 was checked at
+	};
+
+private:
+	bool sync_layout();
+	bool is_current(const MemRegion &region, quint64 generation) const;
+	bool rebuild(const MemRegion &region, const quint8 *bytes, std::size_t size, quint64 generation);
+	bool is_mapped(edb::address_t address) const;
+	void build(RegionInfo &info, const MemRegion &region, const quint8 *bytes, std::size_t size) const;
+	static void find_in(const MemRegion &region, const EntryList &list, edb::address_t target, ReferenceList &results);
+	static Reference expand(const MemRegion &region, const Entry &entry);
+
+private:
+	QHash<MemRegion, RegionInfo> regions_;
+	QVector<Range>               layout_;
+	quint64                      layout_generation_;
+};
+
+#endif
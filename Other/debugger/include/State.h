@@ -44,6 +44,8 @@ public:
 	QString flags_to_string() const;
 	QString flags_to_string(edb::reg_t flags) const;
 	Register value(const QString &reg) const;
+	int register_id(const QString &reg) const;
+	Register register_value(int id) const;
 	edb::address_t frame_pointer() const;
 	edb::address_t instruction_pointer() const;
 	edb::address_t stack_pointer() const;
@@ -54,6 +56,7 @@ public:
 	QByteArray xmm_register(int n) const;
 	void adjust_stack(int bytes);
 	void clear();
+	void capture();
 	void set_debug_register(int n, edb::reg_t value);
 	void set_flags(edb::reg_t flags);
 	void set_instruction_pointer(edb::address_t value);
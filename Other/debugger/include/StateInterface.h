@@ -48,6 +48,16 @@ public:
 	virtual void set_register(const QString &name, edb::reg_t value) = 0;
 	virtual quint64 mmx_register(int n) const = 0;
 	virtual QByteArray xmm_register(int n) const = 0;
+
+public:
+	// optional, lets callers look a register up by name once and then read
+	// it cheaply by id. -1 means "unknown", callers then fall back to value()
+	virtual int register_id(const QString &) const { return -1; }
+	virtual Register register_value(int) const { return Register(); }
+
+	// optional, for a state which is going to be put back after the thread
+	// has run: reads all of it now and has set_state write all of it back
+	virtual void capture() {}
 };
 
 #endif
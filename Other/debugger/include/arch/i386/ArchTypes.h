@@ -21,16 +21,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QtGlobal>
 #include "Instruction.h"
+#include "InstructionLength.h"
 
 #define EDB_MAX_HEX 8
 #define EDB_X86
 #define EDB_FMT_PTR "%08x"
 
 namespace edb {
-	typedef quint32                     reg_t;
-	typedef quint32                     address_t;
-	typedef Instruction<edisassm::x86>  Instruction;
-	typedef Instruction::operand_t      Operand;
+	typedef quint32                           reg_t;
+	typedef quint32                           address_t;
+	typedef Instruction<edisassm::x86>        Instruction;
+	typedef InstructionLength<edisassm::x86>  InstructionLength;
+	typedef Instruction::operand_t            Operand;
 }
 
 #endif
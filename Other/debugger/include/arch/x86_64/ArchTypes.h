@@ -21,16 +21,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QtGlobal>
 #include "Instruction.h"
+#include "InstructionLength.h"
 
 #define EDB_MAX_HEX 16
 #define EDB_X86_64
 #define EDB_FMT_PTR "%016llx"
 
 namespace edb {
-	typedef quint64                         reg_t;
-	typedef quint64                         address_t;
-	typedef Instruction<edisassm::x86_64>   Instruction;
-	typedef Instruction::operand_t          Operand;
+	typedef quint64                              reg_t;
+	typedef quint64                              address_t;
+	typedef Instruction<edisassm::x86_64>        Instruction;
+	typedef InstructionLength<edisassm::x86_64>  InstructionLength;
+	typedef Instruction::operand_t               Operand;
 }
 
 #endif
@@ -32,14 +32,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QMainWindow>
 #include <QToolBar>
+#include <QBitArray>
 #include <QCoreApplication>
+#include <QDataStream>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QHash>
 #include <QMenu>
 #include <QMessageBox>
 #include <QProgressDialog>
 #include <QSettings>
 #include <QStack>
+#include <QThread>
 #include <QTime>
+#include <QtAlgorithms>
 #include <QtDebug>
 
 #include <boost/function.hpp>
@@ -49,8 +57,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QtConcurrentMap>
 #endif
 
+#include <algorithm>
 #include <cstring>
 
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
 #define MIN_REFCOUNT 2
 
 namespace {
@@ -61,6 +74,392 @@ namespace {
 	const edb::Operand::Register STACK_REG = edb::Operand::REG_RSP;
 	const edb::Operand::Register FRAME_REG = edb::Operand::REG_RBP;
 #endif
+
+	// the smallest piece of a region which is worth giving its own thread
+	const std::size_t min_shard_size = 64 * 1024;
+
+	// identifies (and versions) an analysis cache file
+	const quint32 cache_magic   = 0x41424445; // "EDBA"
+	const quint32 cache_version = 2;
+
+	// a part of a region's snapshot, along with how many times each call
+	// target was seen in it and which pages those calls are in. each shard
+	// is scanned on its own and the results are merged once they are all done
+	struct CallShard {
+		const quint8 *             first;
+		std::size_t                size;
+		std::size_t                begin;
+		std::size_t                end;
+		QHash<edb::address_t, int> targets;
+		QBitArray                  call_pages;
+	};
+
+	//--------------------------------------------------------------------------
+	// Name: is_prefix(quint8 byte)
+	// Desc:
+	//--------------------------------------------------------------------------
+	bool is_prefix(quint8 byte) {
+		switch(byte) {
+		case 0x26: case 0x2e: case 0x36: case 0x3e:
+		case 0x64: case 0x65: case 0x66: case 0x67:
+		case 0xf0: case 0xf2: case 0xf3:
+			return true;
+		default:
+		#if defined(EDB_X86_64)
+			// REX
+			return (byte & 0xf0) == 0x40;
+		#else
+			return false;
+		#endif
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: mark_call_site(const MemRegion &region, edb::address_t address, unsigned int size, QBitArray &call_pages)
+	// Desc: notes the pages of an instruction which led to a function being
+	//       found, if one of them changes the function may no longer exist
+	//--------------------------------------------------------------------------
+	void mark_call_site(const MemRegion &region, edb::address_t address, unsigned int size, QBitArray &call_pages) {
+		static const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+		if(region.contains(address)) {
+			const int first_page = (address - region.start) / page_size;
+			const int last_page  = qMin<int>((address + size - 1 - region.start) / page_size, call_pages.size() - 1);
+
+			for(int page = first_page; page <= last_page; ++page) {
+				call_pages.setBit(page);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: add_call_target(const MemRegion &region, edb::address_t ip, unsigned int size, edb::address_t ea, CallShard &shard)
+	// Desc:
+	//--------------------------------------------------------------------------
+	void add_call_target(const MemRegion &region, edb::address_t ip, unsigned int size, edb::address_t ea, CallShard &shard) {
+		// skip over ones which are : call <label>; label:
+		if(ea != ip + size) {
+			if(region.contains(ea)) {
+				++shard.targets[ea];
+				mark_call_site(region, ip, size, shard.call_pages);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: find_calls_in_shard(const MemRegion &region, CallShard &shard)
+	// Desc: the only relative call is E8, so we just look for that byte. A
+	//       plain "call rel32" is simple enough to resolve by hand, but any
+	//       prefixes in front of it also decode as a call (possibly with a
+	//       different operand size), those offsets get the real disassembler
+	//--------------------------------------------------------------------------
+	void find_calls_in_shard(const MemRegion &region, CallShard &shard) {
+
+		const quint8 *const first = shard.first;
+		const quint8 *const last  = first + shard.end;
+		const quint8 *p           = first + shard.begin;
+
+		while((p = static_cast<const quint8 *>(std::memchr(p, 0xe8, last - p))) != 0) {
+			const std::size_t offset = p - first;
+
+			if(offset + 5 <= shard.size) {
+				qint32 rel;
+				std::memcpy(&rel, p + 1, sizeof(rel));
+
+				const edb::address_t ip = region.start + offset;
+				add_call_target(region, ip, 5, static_cast<edb::address_t>(rel + (ip + 5)), shard);
+			}
+
+			for(std::size_t n = 1; n < edb::Instruction::MAX_SIZE && n <= offset && is_prefix(first[offset - n]); ++n) {
+				const edb::address_t ip = region.start + offset - n;
+				const edb::Instruction insn(first + offset - n, shard.size - (offset - n), ip, std::nothrow);
+
+				if(insn.valid() && insn.type() == edb::Instruction::OP_CALL) {
+					const edb::Operand &op = insn.operand(0);
+					if(op.general_type() == edb::Operand::TYPE_REL) {
+						add_call_target(region, ip, insn.size(), op.relative_target(), shard);
+					}
+				}
+			}
+
+			++p;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: add_new_functions(AnalyzerInterface::FunctionMap &results, const AnalyzerInterface::FunctionMap &functions)
+	// Desc: adds the functions which aren't already in results
+	//--------------------------------------------------------------------------
+	void add_new_functions(AnalyzerInterface::FunctionMap &results, const AnalyzerInterface::FunctionMap &functions) {
+		for(AnalyzerInterface::FunctionMap::const_iterator it = functions.begin(); it != functions.end(); ++it) {
+			if(!results.contains(it.key())) {
+				results.insert(it.key(), it.value());
+			}
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: reset_changed_functions(const MemRegion &region, const QBitArray &dirty_pages, AnalyzerInterface::FunctionMap &results, QSet<edb::address_t> &walked_functions)
+	// Desc: functions which don't touch a changed page are kept as they are
+	//       (and won't be walked again), the rest are cut back to just their
+	//       entry point so that they get walked again
+	//--------------------------------------------------------------------------
+	void reset_changed_functions(const MemRegion &region, const QBitArray &dirty_pages, AnalyzerInterface::FunctionMap &results, QSet<edb::address_t> &walked_functions) {
+		static const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+		for(AnalyzerInterface::FunctionMap::iterator it = results.begin(); it != results.end(); ++it) {
+			AnalyzerInterface::Function &func = it.value();
+
+			// we only know the state of the pages in this region
+			bool changed = !region.contains(func.entry_address);
+
+			if(!changed) {
+				// the walk may have looked at the bytes of an instruction
+				// starting at the last byte of the function
+				const int first_page = (func.entry_address - region.start) / page_size;
+				const int last_page  = qMin<edb::address_t>((func.end_address - region.start + edb::Instruction::MAX_SIZE - 1) / page_size, dirty_pages.size() - 1);
+
+				for(int page = first_page; page <= last_page && !changed; ++page) {
+					changed = dirty_pages.testBit(page);
+				}
+			}
+
+			if(changed) {
+				func.end_address      = func.entry_address;
+				func.last_instruction = func.entry_address;
+			} else {
+				walked_functions.insert(func.entry_address);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: read_snapshot(const MemRegion &region)
+	// Desc: reads the region along with the bytes of an instruction which
+	//       might start at its very end. An empty snapshot is returned if
+	//       the region couldn't be read
+	//--------------------------------------------------------------------------
+	QVector<quint8> read_snapshot(const MemRegion &region) {
+		static const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+		const edb::address_t size_in_pages = region.size() / page_size;
+		const std::size_t size             = size_in_pages * page_size;
+
+		try {
+			QVector<quint8> snapshot(size + edb::Instruction::MAX_SIZE);
+			if(size != 0 && edb::v1::debugger_core->read_pages(region.start, &snapshot[0], size_in_pages)) {
+				int tail_size = edb::Instruction::MAX_SIZE;
+				if(edb::v1::get_instruction_bytes(region.start + size, &snapshot[size], tail_size)) {
+					return snapshot;
+				}
+			}
+		} catch(const std::bad_alloc &) {
+			// we'll just have to read the process directly
+		}
+
+		return QVector<quint8>();
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: snapshot_end(const MemRegion &region, const QVector<quint8> &snapshot)
+	// Desc: returns the first address which an instruction can't be read at from
+	//       the snapshot
+	//--------------------------------------------------------------------------
+	edb::address_t snapshot_end(const MemRegion &region, const QVector<quint8> &snapshot) {
+		return snapshot.isEmpty() ? region.start : region.start + snapshot.size() - edb::Instruction::MAX_SIZE;
+	}
+
+	//--------------------------------------------------------------------------
+	// Name: instruction_bytes(const MemRegion &region, const QVector<quint8> &snapshot, edb::address_t address, quint8 *buf, int &size)
+	// Desc: returns the bytes of the instruction at address, out of the snapshot
+	//       when possible, otherwise they are read into buf. Reading the process
+	//       isn't thread safe, so only code which is running in the main thread
+	//       may ask for an address outside of the snapshot
+	//--------------------------------------------------------------------------
+	const quint8 *instruction_bytes(const MemRegion &region, const QVector<quint8> &snapshot, edb::address_t address, quint8 *buf, int &size) {
+
+		if(address >= region.start && address < snapshot_end(region, snapshot)) {
+			size = edb::Instruction::MAX_SIZE;
+			return &snapshot[address - region.start];
+		}
+
+		return edb::v1::get_instruction_bytes(address, buf, size) ? buf : 0;
+	}
+
+	// a set of addresses, kept as a bitmap for the range which is expected to
+	// hold most of them
+	class AddressSet {
+	public:
+		AddressSet(edb::address_t first, edb::address_t last) : first_(first) {
+			if(last > first && last - first <= max_bitmap_size) {
+				bits_.resize(last - first);
+			}
+		}
+
+	public:
+		bool contains(edb::address_t address) const {
+			if(address >= first_ && address - first_ < static_cast<edb::address_t>(bits_.size())) {
+				return bits_.testBit(address - first_);
+			}
+			return others_.contains(address);
+		}
+
+		void insert(edb::address_t address) {
+			if(address >= first_ && address - first_ < static_cast<edb::address_t>(bits_.size())) {
+				bits_.setBit(address - first_);
+			} else {
+				others_.insert(address);
+			}
+		}
+
+		void remove(edb::address_t address) {
+			if(address >= first_ && address - first_ < static_cast<edb::address_t>(bits_.size())) {
+				bits_.clearBit(address - first_);
+			} else {
+				others_.remove(address);
+			}
+		}
+
+	private:
+		static const edb::address_t max_bitmap_size = 16 * 1024 * 1024;
+
+	private:
+		edb::address_t       first_;
+		QBitArray            bits_;
+		QSet<edb::address_t> others_;
+	};
+
+	// a function which needs to be walked, along with the calls found in it
+	// and the pages those calls are in
+	struct FunctionWalk {
+		AnalyzerInterface::Function *function;
+		edb::address_t               end_address;
+		QSet<edb::address_t>         found_functions;
+		QBitArray                    call_pages;
+	};
+
+	//--------------------------------------------------------------------------
+	// Name: find_function_end(const MemRegion &region, const QVector<quint8> &snapshot, const AnalyzerInterface::FunctionMap &results, FunctionWalk &walk)
+	// Desc: follows the code of a function (which may not go past
+	//       walk.end_address) to find where it ends
+	//--------------------------------------------------------------------------
+	void find_function_end(const MemRegion &region, const QVector<quint8> &snapshot, const AnalyzerInterface::FunctionMap &results, FunctionWalk &walk) {
+
+		AnalyzerInterface::Function &function = *walk.function;
+		const edb::address_t end_address      = walk.end_address;
+
+		QStack<edb::address_t> jump_targets;
+		AddressSet             queued_targets(function.entry_address, end_address);
+		AddressSet             visited_addresses(function.entry_address, end_address);
+
+		function.last_instruction = function.entry_address;
+		function.end_address      = function.entry_address;
+
+		// we start with the entry point of the function
+		jump_targets.push(function.entry_address);
+		queued_targets.insert(function.entry_address);
+
+		// while no more jump targets... (includes entry point)
+		while(!jump_targets.empty()) {
+
+			edb::address_t addr = jump_targets.pop();
+			queued_targets.remove(addr);
+
+			// for certain forward jump scenarioes this is possible.
+			if(visited_addresses.contains(addr)) {
+				continue;
+			}
+
+			// keep going until we go out of bounds
+			while(addr >= function.entry_address && addr < end_address) {
+
+				quint8 buf[edb::Instruction::MAX_SIZE];
+				int buf_size = sizeof(buf);
+				const quint8 *const bytes = instruction_bytes(region, snapshot, addr, buf, buf_size);
+				if(!bytes) {
+					break;
+				}
+
+				// an invalid instruction ends this "block"
+				const edb::Instruction insn(bytes, buf_size, addr, std::nothrow);
+				if(!insn.valid()) {
+					break;
+				}
+
+				// ok, it was a valid instruction, let's add it to the
+				// list of possible 'code addresses'
+				if(!visited_addresses.contains(addr)) {
+					visited_addresses.insert(addr);
+					function.end_address      = qMax(function.end_address,      addr + insn.size() - 1);
+					function.last_instruction = qMax(function.last_instruction, addr);
+				}
+
+				const edb::Instruction::Type type = insn.type();
+
+				if(type == edb::Instruction::OP_RET || type == edb::Instruction::OP_HLT) {
+					// instructions that clearly terminate the current block...
+					break;
+
+				} else if(type == edb::Instruction::OP_JCC) {
+
+					// note if neccessary the Jcc target and move on, yes this can be fooled by "conditional"
+					// jumps which are always true or false, not much we can do about it at this level.
+					const edb::Operand &op = insn.operand(0);
+					if(op.general_type() == edb::Operand::TYPE_REL) {
+						const edb::address_t ea = op.relative_target();
+
+						if(!visited_addresses.contains(ea) && !queued_targets.contains(ea)) {
+							jump_targets.push(ea);
+							queued_targets.insert(ea);
+						}
+					}
+				} else if(type == edb::Instruction::OP_CALL) {
+
+					// similar to above, note the destination and move on
+					// we special case simple things for speed.
+					// also this is an opportunity to find call tables.
+					const edb::Operand &op = insn.operand(0);
+					if(op.general_type() == edb::Operand::TYPE_REL) {
+						const edb::address_t ea = op.relative_target();
+
+						// skip over ones which are: "call <label>; label:"
+						if(ea != addr + insn.size()) {
+							walk.found_functions.insert(ea);
+							mark_call_site(region, addr, insn.size(), walk.call_pages);
+						}
+					} else if(op.general_type() == edb::Operand::TYPE_EXPRESSION) {
+						// looks like: "call [...]", if it is of the form, call [C + REG]
+						// then it may be a jump table using REG as an offset
+					}
+				} else if(type == edb::Instruction::OP_JMP) {
+
+					const edb::Operand &op = insn.operand(0);
+					if(op.general_type() == edb::Operand::TYPE_REL) {
+						const edb::address_t ea = op.relative_target();
+
+						// an absolute jump within this function
+						if(ea >= function.entry_address && ea < addr) {
+							addr += insn.size();
+							continue;
+						}
+
+						// is it a jump to another function's entry point?
+						// if so, this is a dead end, resume from other branches
+						// but give the target a bonus reference
+						if(results.contains(ea)) {
+							walk.found_functions.insert(ea);
+							mark_call_site(region, addr, insn.size(), walk.call_pages);
+						}
+
+						break;
+					}
+				}
+
+				addr += insn.size();
+			}
+		}
+	}
+
 }
 
 //------------------------------------------------------------------------------
@@ -249,51 +648,61 @@ void Analyzer::do_analysis(const MemRegion &region) {
 }
 
 //------------------------------------------------------------------------------
-// Name: find_function_calls(const MemRegion &region, FunctionMap &found_functions)
-// Desc:
+// Name: find_function_calls(const MemRegion &region, const QVector<quint8> &snapshot, FunctionMap &found_functions, QBitArray &call_pages)
+// Desc: the snapshot is scanned for calls in shards (in parallel when
+//       possible), the targets found are merged and checked against the
+//       known functions at the end
 //------------------------------------------------------------------------------
-void Analyzer::find_function_calls(const MemRegion &region, FunctionMap &found_functions) {
-	static const edb::address_t page_size = edb::v1::debugger_core->page_size();
+void Analyzer::find_function_calls(const MemRegion &region, const QVector<quint8> &snapshot, FunctionMap &found_functions, QBitArray &call_pages) {
 
-	const edb::address_t size_in_pages = region.size() / page_size;
+	const std::size_t size = snapshot_end(region, snapshot) - region.start;
 
-	try {
-		QVector<quint8> pages(size_in_pages * page_size);
+	if(size != 0) {
 
-		if(edb::v1::debugger_core->read_pages(region.start, &pages[0], size_in_pages)) {
-			for(edb::address_t i = 0; i < size_in_pages * page_size; ++i) {
+		const int batch_size         = qMax(QThread::idealThreadCount(), 1);
+		const std::size_t shard_size = qMax(min_shard_size, (size + batch_size * 4 - 1) / (batch_size * 4));
 
-				const edb::Instruction insn(&pages[i], region.size() - i, region.start + i, std::nothrow);
-
-				if(insn.valid() && insn.type() == edb::Instruction::OP_CALL) {
+		QVector<CallShard> shards;
+		for(std::size_t begin = 0; begin < size; begin += shard_size) {
+			CallShard shard;
+			shard.first = snapshot.constData();
+			shard.size  = size;
+			shard.begin = begin;
+			shard.end   = qMin(begin + shard_size, size);
+			shard.call_pages.resize(call_pages.size());
+			shards.push_back(shard);
+		}
 
-					const edb::address_t ip = region.start + i;
-					const edb::Operand &op = insn.operand(0);
+		for(int i = 0; i < shards.size(); i += batch_size) {
+			const QVector<CallShard>::iterator first = shards.begin() + i;
+			const QVector<CallShard>::iterator last  = shards.begin() + qMin(i + batch_size, shards.size());
+#ifdef USE_QT_CONCURRENT
+			QtConcurrent::blockingMap(first, last, boost::bind(find_calls_in_shard, boost::cref(region), _1));
+#else
+			std::for_each(first, last, boost::bind(find_calls_in_shard, boost::cref(region), _1));
+#endif
+			emit update_progress(util::percentage(6, 10, (last - 1)->end, size));
+		}
 
-					if(op.general_type() == edb::Operand::TYPE_REL) {
-						const edb::address_t ea = op.relative_target();
+		QHash<edb::address_t, int> targets;
+		Q_FOREACH(const CallShard &shard, shards) {
+			for(QHash<edb::address_t, int>::const_iterator it = shard.targets.begin(); it != shard.targets.end(); ++it) {
+				targets[it.key()] += it.value();
+			}
+			call_pages |= shard.call_pages;
+		}
 
-						// skip over ones which are : call <label>; label:
-						if(ea != ip + insn.size()) {
-							if(region.contains(ea)) {
-								// avoid calls which land in the middle of a function...
-								// this may or may not be the best approach
-								if(!is_inside_known(region, ea)) {
-									found_functions[ea].entry_address = ea;
-									found_functions[ea].end_address   = ea;
-									found_functions[ea].reference_count++;
-								}
-							}
-						}
-					}
+		for(QHash<edb::address_t, int>::const_iterator it = targets.begin(); it != targets.end(); ++it) {
+			const edb::address_t ea = it.key();
 
-					emit update_progress(util::percentage(6, 10, i, region.size()));
-				}
+			// avoid calls which land in the middle of a function...
+			// this may or may not be the best approach
+			if(!is_inside_known(region, ea)) {
+				found_functions[ea].entry_address = ea;
+				found_functions[ea].end_address   = ea;
+				found_functions[ea].reference_count += it.value();
 			}
 		}
-	} catch(const std::bad_alloc &) {
-		QMessageBox::information(0, tr("Memroy Allocation Error"),
-			tr("Unable to satisfy memory allocation request for requested region."));
 	}
 }
 
@@ -473,13 +882,18 @@ void Analyzer::bonus_marked_functions(const MemRegion &region, FunctionMap &resu
 }
 
 //------------------------------------------------------------------------------
-// Name: walk_all_functions(FunctionMap &results, const MemRegion &region, QSet<edb::address_t> &walked_functions)
-// Desc:
+// Name: walk_all_functions(FunctionMap &results, const MemRegion &region, QSet<edb::address_t> &walked_functions, const QVector<quint8> &snapshot, QBitArray &call_pages)
+// Desc: the walks don't depend on each other, so the ones which stay inside of
+//       the snapshot are done in parallel
 //------------------------------------------------------------------------------
-int Analyzer::walk_all_functions(FunctionMap &results, const MemRegion &region, QSet<edb::address_t> &walked_functions) {
+int Analyzer::walk_all_functions(FunctionMap &results, const MemRegion &region, QSet<edb::address_t> &walked_functions, const QVector<quint8> &snapshot, QBitArray &call_pages) {
 	int updates = 0;
 
 	QSet<edb::address_t> found_functions;
+	QVector<FunctionWalk> walks;
+	QVector<FunctionWalk> process_walks;
+
+	const edb::address_t last_address = snapshot_end(region, snapshot);
 
 	FunctionMap::iterator it = results.begin();
 	while(it != results.end()) {
@@ -492,39 +906,63 @@ int Analyzer::walk_all_functions(FunctionMap &results, const MemRegion &region,
 
 				// the function's upper bound is either the entry point of the next function
 				// or the region's end which is the absolute max end this function can have
-				const edb::address_t next_entry = (next != results.end()) ? next.value().entry_address : region.end;
-
-				// walk the function and collect some results
+				FunctionWalk walk;
+				walk.function    = &function;
+				walk.end_address = (next != results.end()) ? next.value().entry_address : region.end;
+				walk.call_pages.resize(call_pages.size());
+
+				if(function.entry_address >= region.start && walk.end_address <= last_address) {
+					walks.push_back(walk);
+				} else {
+					process_walks.push_back(walk);
+				}
 
-				find_function_end(function, next_entry, found_functions, results);
 				walked_functions.insert(function.entry_address);
+			}
+		}
 
-				// if the very last instruction happens to be a jmp, then this may
-				// be a call/ret -> jmp optimization. This isn't always the case
-				// but often enough that it's probably right
-				quint8 buf[edb::Instruction::MAX_SIZE];
-				int buf_size = sizeof(buf);
-				if(edb::v1::get_instruction_bytes(function.last_instruction, buf, buf_size)) {
-					const edb::Instruction insn(buf, buf_size, function.last_instruction, std::nothrow);
-					if(insn.valid() && insn.type() == edb::Instruction::OP_JMP) {
+		it = next;
+	}
 
-						Q_ASSERT(insn.operand_count() == 1);
-						const edb::Operand &op = insn.operand(0);
+	// walk the functions and collect some results
+#ifdef USE_QT_CONCURRENT
+	QtConcurrent::blockingMap(walks, boost::bind(find_function_end, boost::cref(region), boost::cref(snapshot), boost::cref(results), _1));
+#else
+	std::for_each(walks.begin(), walks.end(), boost::bind(find_function_end, boost::cref(region), boost::cref(snapshot), boost::cref(results), _1));
+#endif
+	std::for_each(process_walks.begin(), process_walks.end(), boost::bind(find_function_end, boost::cref(region), boost::cref(snapshot), boost::cref(results), _1));
 
-						if(op.general_type() == edb::Operand::TYPE_REL) {
-							const edb::address_t target = op.relative_target();
+	walks += process_walks;
 
-							Function func;
-							if(!find_containing_function(target, func)) {
-								found_functions.insert(target);
-							}
-						}
+	Q_FOREACH(const FunctionWalk &walk, walks) {
+		found_functions += walk.found_functions;
+		call_pages      |= walk.call_pages;
+
+		// if the very last instruction happens to be a jmp, then this may
+		// be a call/ret -> jmp optimization. This isn't always the case
+		// but often enough that it's probably right
+		quint8 buf[edb::Instruction::MAX_SIZE];
+		int buf_size = sizeof(buf);
+		if(const quint8 *const bytes = instruction_bytes(region, snapshot, walk.function->last_instruction, buf, buf_size)) {
+			const edb::Instruction insn(bytes, buf_size, walk.function->last_instruction, std::nothrow);
+			if(insn.valid() && insn.type() == edb::Instruction::OP_JMP) {
+
+				Q_ASSERT(insn.operand_count() == 1);
+				const edb::Operand &op = insn.operand(0);
+
+				if(op.general_type() == edb::Operand::TYPE_REL) {
+					const edb::address_t target = op.relative_target();
+
+					// this region's functions aren't in the index until
+					// the analysis is done, so look at them directly
+					const bool known = region.contains(target) ? is_inside_known(region, target) : find_function(target) != 0;
+					if(!known) {
+						found_functions.insert(target);
+						mark_call_site(region, walk.function->last_instruction, insn.size(), call_pages);
 					}
 				}
 			}
 		}
-
-		it = next;
 	}
 
 	// add the newly found functions to the list and report the number of "updates"
@@ -556,135 +994,6 @@ void Analyzer::fix_overlaps(FunctionMap &function_map) {
 	}
 }
 
-//------------------------------------------------------------------------------
-// Name: find_function_end(Function &function, edb::address_t end_address, QSet<edb::address_t> &found_functions, const FunctionMap &results)
-// Desc:
-//------------------------------------------------------------------------------
-void Analyzer::find_function_end(Function &function, edb::address_t end_address, QSet<edb::address_t> &found_functions, const FunctionMap &results) {
-
-	QStack<edb::address_t>		jump_targets;
-	QHash<edb::address_t, int>	visited_addresses;
-
-	// we start with the entry point of the function
-	jump_targets.push(function.entry_address);
-
-	// while no more jump targets... (includes entry point)
-	while(!jump_targets.empty()) {
-	
-		edb::address_t addr = jump_targets.pop();
-
-		// for certain forward jump scenarioes this is possible.
-		if(visited_addresses.contains(addr)) {
-			continue;
-		}
-
-		// keep going until we go out of bounds
-		while(addr >= function.entry_address && addr < end_address) {
-
-			quint8 buf[edb::Instruction::MAX_SIZE];
-			int buf_size = sizeof(buf);
-			if(!edb::v1::get_instruction_bytes(addr, buf, buf_size)) {
-				break;
-			}
-
-			// an invalid instruction ends this "block"
-			const edb::Instruction insn(buf, buf_size, addr, std::nothrow);
-			if(!insn.valid()) {
-				break;
-			}
-
-			// ok, it was a valid instruction, let's add it to the
-			// list of possible 'code addresses'
-			visited_addresses.insert(addr, insn.size());
-
-			const edb::Instruction::Type type = insn.type();
-
-			if(type == edb::Instruction::OP_RET || type == edb::Instruction::OP_HLT) {
-				// instructions that clearly terminate the current block...
-				break;
-				
-			} else if(type == edb::Instruction::OP_JCC) {
-
-				// note if neccessary the Jcc target and move on, yes this can be fooled by "conditional"
-				// jumps which are always true or false, not much we can do about it at this level.
-				const edb::Operand &op = insn.operand(0);
-				if(op.general_type() == edb::Operand::TYPE_REL) {
-					const edb::address_t ea = op.relative_target();
-
-					if(!visited_addresses.contains(ea) && !jump_targets.contains(ea)) {
-						jump_targets.push(ea);
-					}
-				}
-			} else if(type == edb::Instruction::OP_CALL) {
-
-
-				// similar to above, note the destination and move on
-				// we special case simple things for speed.
-				// also this is an opportunity to find call tables.
-				const edb::Operand &op = insn.operand(0);
-				if(op.general_type() == edb::Operand::TYPE_REL) {
-					const edb::address_t ea = op.relative_target();
-
-					// skip over ones which are: "call <label>; label:"
-					if(ea != addr + insn.size()) {
-						found_functions.insert(ea);
-					}
-				} else if(op.general_type() == edb::Operand::TYPE_EXPRESSION) {
-					// looks like: "call [...]", if it is of the form, call [C + REG]
-					// then it may be a jump table using REG as an offset
-				}
-			} else if(type == edb::Instruction::OP_JMP) {
-
-				const edb::Operand &op = insn.operand(0);
-				if(op.general_type() == edb::Operand::TYPE_REL) {
-					const edb::address_t ea = op.relative_target();
-
-
-					// an absolute jump within this function
-					if(ea >= function.entry_address && ea < addr) {
-						addr += insn.size();
-						continue;
-					}
-
-
-					// is it a jump to another function's entry point?
-					// if so, this is a dead end, resume from other branches
-					// but give the target a bonus reference
-					FunctionMap::const_iterator it = results.find(ea);
-					if(it != results.end()) {
-						found_functions.insert(ea);
-						break;
-					}
-
-#if 0
-					// ok, it is a jmp to an address we haven't seen yet
-					// so just continue processing from there
-					if(!visited_addresses.contains(ea)) {
-						addr = ea;
-						continue;
-					} else {
-						break;
-					}
-#else
-					break;
-#endif
-				}
-			}
-
-			addr += insn.size();
-		}
-	}
-
-	function.last_instruction = function.entry_address;
-	function.end_address      = function.entry_address;
-
-	// get the last instruction and the last byte of the function
-	for(QHash<edb::address_t, int>::const_iterator it = visited_addresses.begin(); it != visited_addresses.end(); ++it) {
-		function.end_address      = qMax(function.end_address,      it.key() + it.value() - 1);
-		function.last_instruction = qMax(function.last_instruction, it.key());
-	}
-}
-
 //------------------------------------------------------------------------------
 // Name: is_thunk(edb::address_t address)
 // Desc: basically returns true if the first instruction of the function is a
@@ -749,13 +1058,14 @@ bool Analyzer::is_inside_known(const MemRegion &region, edb::address_t address)
 }
 
 //------------------------------------------------------------------------------
-// Name: find_calls_from_known(const MemRegion &region, FunctionMap &results, QSet<edb::address_t> &walked_functions)
+// Name: find_calls_from_known(const MemRegion &region, const QVector<quint8> &snapshot, FunctionMap &results, QSet<edb::address_t> &walked_functions, QBitArray &call_pages)
 // Desc:
 //------------------------------------------------------------------------------
-void Analyzer::find_calls_from_known(const MemRegion &region, FunctionMap &results, QSet<edb::address_t> &walked_functions) {
+void Analyzer::find_calls_from_known(const MemRegion &region, const QVector<quint8> &snapshot, FunctionMap &results, QSet<edb::address_t> &walked_functions, QBitArray &call_pages) {
+
 	int updates;
 	do {
-		updates = walk_all_functions(results, region, walked_functions);
+		updates = walk_all_functions(results, region, walked_functions, snapshot, call_pages);
 		qDebug() << "[Analyzer] got" << updates << "updates";
 	} while(updates != 0);
 }
@@ -825,40 +1135,80 @@ void Analyzer::analyze(const MemRegion &region_ref) {
 
 	RegionInfo &region_info = analysis_info_[region];
 
+	// every pass (and the page hashes) work from the same copy of the region,
+	// it is only read once
+	const QVector<quint8> snapshot = read_snapshot(region);
+	if(snapshot.isEmpty()) {
+		qDebug("[Analyzer] unable to take a snapshot of the region, it will be read as it is analyzed");
+	}
+
 	QSettings settings;
-	const bool fuzzy          = settings.value("Analyzer/fuzzy_logic_functions.enabled", true).toBool();
-	const QByteArray md5      = md5_region(region);
-	const QByteArray prev_md5 = region_info.md5;
-	
-	if(md5 != prev_md5 || fuzzy != region_info.fuzzy) {
+	const bool fuzzy                      = settings.value("Analyzer/fuzzy_logic_functions.enabled", true).toBool();
+	const QVector<QByteArray> page_hashes = hash_pages(region, snapshot);
+
+	// if we know nothing about this region, perhaps we've seen it before
+	if(region_info.page_hashes.isEmpty()) {
+		load_cached_analysis(region, region_info);
+	}
+
+	if(page_hashes != region_info.page_hashes || fuzzy != region_info.fuzzy) {
 		FunctionMap &function_map = region_info.analysis;
-		function_map.clear();
-		
+
 		QSet<edb::address_t> walked_functions;
+		FunctionMap          known_functions;
 		FunctionMap          found_functions;
-		
+		QBitArray            call_pages(page_hashes.size());
+
+		// if only some pages have changed, then only the functions which
+		// touch those pages need another look. But a function may only be
+		// known because of a call in a changed page, there is no telling if
+		// it still exists without starting over
+		bool incremental = fuzzy == region_info.fuzzy && page_hashes.size() == region_info.page_hashes.size() && region_info.call_pages.size() == page_hashes.size() && !function_map.isEmpty();
+		if(incremental) {
+			QBitArray dirty_pages(page_hashes.size());
+			for(int i = 0; i < page_hashes.size(); ++i) {
+				dirty_pages.setBit(i, page_hashes[i] != region_info.page_hashes[i]);
+			}
+
+			if((dirty_pages & region_info.call_pages).count(true) != 0) {
+				qDebug("[Analyzer] a changed page had calls in it, starting over");
+				incremental = false;
+			} else {
+				qDebug("[Analyzer] %d of %d pages changed, updating previous analysis", dirty_pages.count(true), dirty_pages.size());
+				reset_changed_functions(region, dirty_pages, function_map, walked_functions);
+
+				// the functions which are kept won't be walked again
+				call_pages = region_info.call_pages;
+			}
+		}
+
+		if(!incremental) {
+			function_map.clear();
+		}
+
 		const struct {
 			const char             *message;
 			boost::function<void()> function;
 		} analysis_steps[] = {
 			{ "identifying executable headers...",                       boost::bind(&Analyzer::indent_header,          this) },
-			{ "adding entry points to the list...", 					 boost::bind(&Analyzer::bonus_entry_point,      this, boost::cref(region), boost::ref(function_map)) },
-			{ "attempting to add 'main' to the list...",				 boost::bind(&Analyzer::bonus_main,             this, boost::cref(region), boost::ref(function_map)) },
-			{ "attempting to add marked functions to the list...",  	 boost::bind(&Analyzer::bonus_marked_functions, this, boost::cref(region), boost::ref(function_map)) },
-			{ "attempting to add functions with symbols to the list...", boost::bind(&Analyzer::bonus_symbols,          this, boost::cref(region), boost::ref(function_map)) },
-			{ "calculating function bounds... (pass 1)",                 boost::bind(&Analyzer::find_calls_from_known,  this, boost::cref(region), boost::ref(function_map), boost::ref(walked_functions)) },
+			{ "adding entry points to the list...", 					 boost::bind(&Analyzer::bonus_entry_point,      this, boost::cref(region), boost::ref(known_functions)) },
+			{ "attempting to add 'main' to the list...",				 boost::bind(&Analyzer::bonus_main,             this, boost::cref(region), boost::ref(known_functions)) },
+			{ "attempting to add marked functions to the list...",  	 boost::bind(&Analyzer::bonus_marked_functions, this, boost::cref(region), boost::ref(known_functions)) },
+			{ "attempting to add functions with symbols to the list...", boost::bind(&Analyzer::bonus_symbols,          this, boost::cref(region), boost::ref(known_functions)) },
+			{ "merging with previous analysis...",                       boost::bind(add_new_functions,                 boost::ref(function_map), boost::cref(known_functions)) },
+			{ "calculating function bounds... (pass 1)",                 boost::bind(&Analyzer::find_calls_from_known,  this, boost::cref(region), boost::cref(snapshot), boost::ref(function_map), boost::ref(walked_functions), boost::ref(call_pages)) },
 		};		
 		
 		const struct {
 			const char             *message;
 			boost::function<void()> function;
 		} fuzzy_analysis_steps[] = {
-			{ "finding possible function calls...",      boost::bind(&Analyzer::find_function_calls,      this, boost::cref(region), boost::ref(found_functions)) },
+			{ "finding possible function calls...",      boost::bind(&Analyzer::find_function_calls,      this, boost::cref(region), boost::cref(snapshot), boost::ref(found_functions), boost::ref(call_pages)) },
 			{ "bonusing stack frames...",                boost::bind(&Analyzer::bonus_stack_frames,       this, boost::ref(found_functions)) },
 			{ "collecting high reference answers...",    boost::bind(&Analyzer::collect_high_ref_results, this, boost::ref(function_map), boost::ref(found_functions)) },
-			{ "calculating function bounds... (pass 2)", boost::bind(&Analyzer::find_calls_from_known,    this, boost::cref(region), boost::ref(function_map), boost::ref(walked_functions)) },
+			{ "calculating function bounds... (pass 2)", boost::bind(&Analyzer::find_calls_from_known,    this, boost::cref(region), boost::cref(snapshot), boost::ref(function_map), boost::ref(walked_functions), boost::ref(call_pages)) },
 			{ "collecting low reference answers...",     boost::bind(&Analyzer::collect_low_ref_results,  this, boost::cref(region), boost::ref(function_map), boost::ref(found_functions)) },
-			{ "calculating function bounds... (pass 3)", boost::bind(&Analyzer::find_calls_from_known,    this, boost::cref(region), boost::ref(function_map), boost::ref(walked_functions)) },
+			{ "calculating function bounds... (pass 3)", boost::bind(&Analyzer::find_calls_from_known,    this, boost::cref(region), boost::cref(snapshot), boost::ref(function_map), boost::ref(walked_functions), boost::ref(call_pages)) },
 		};
 		
 		const int analysis_steps_count       = sizeof(analysis_steps) / sizeof(analysis_steps[0]);
@@ -889,17 +1239,23 @@ void Analyzer::analyze(const MemRegion &region_ref) {
 		qDebug("[Analyzer] determining function types...");
 		set_function_types(function_map);
 
+		region_info.page_hashes = page_hashes;
+		region_info.call_pages  = call_pages;
+		region_info.fuzzy       = fuzzy;
+		save_cached_analysis(region, region_info);
+		update_function_index();
+
 		qDebug("[Analyzer] complete");
 		emit update_progress(100);
 		
 		if(analyzer_widget_) {
 			analyzer_widget_->repaint();
 		}
-
-		region_info.md5   = md5;
-		region_info.fuzzy = fuzzy;
 	} else {
 		qDebug("[Analyzer] region unchanged, using previous analysis");
+
+		// it may have just come from the cache
+		update_function_index();
 	}
 
 	qDebug("[Analyzer] elapsed: %d ms", t.elapsed());
@@ -911,11 +1267,10 @@ void Analyzer::analyze(const MemRegion &region_ref) {
 //------------------------------------------------------------------------------
 AnalyzerInterface::AddressCategory Analyzer::category(edb::address_t address) const {
 
-	Function func;
-	if(find_containing_function(address, func)) {
-		if(address == func.entry_address) {
+	if(const Function *const func = find_function(address)) {
+		if(address == func->entry_address) {
 			return ADDRESS_FUNC_START;
-		} else if(address == func.end_address) {
+		} else if(address == func->end_address) {
 			return ADDRESS_FUNC_END;
 		} else {
 			return ADDRESS_FUNC_BODY;
@@ -938,41 +1293,299 @@ AnalyzerInterface::FunctionMap Analyzer::functions(const MemRegion &region) cons
 //------------------------------------------------------------------------------
 bool Analyzer::find_containing_function(edb::address_t address, AnalyzerInterface::Function &function) const {
 
-	MemRegion region;
-	if(edb::v1::memory_regions().find_region(address, region)) {
-		const FunctionMap &funcs = functions(region);
+	if(const Function *const f = find_function(address)) {
+		function = *f;
+		return true;
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_function(edb::address_t address) const
+// Desc: returns the function which contains address, or 0 if there isn't one
+//------------------------------------------------------------------------------
+const AnalyzerInterface::Function *Analyzer::find_function(edb::address_t address) const {
+
+	FunctionRange key;
+	key.first = address;
+
+	QVector<FunctionRange>::const_iterator it = qUpperBound(function_index_.begin(), function_index_.end(), key);
+	if(it != function_index_.begin()) {
+		--it;
+		if(address <= it->last) {
+			return &it->function;
+		}
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: update_function_index()
+// Desc: builds a sorted list of non-overlapping address ranges for the
+//       functions of every analyzed region. When functions overlap, the one
+//       with the lowest entry point owns the shared addresses. A region's
+//       functions only answer for addresses inside of that region
+//------------------------------------------------------------------------------
+void Analyzer::update_function_index() {
+
+	function_index_.clear();
+
+	for(QHash<MemRegion, RegionInfo>::const_iterator it = analysis_info_.begin(); it != analysis_info_.end(); ++it) {
+		const MemRegion &region  = it.key();
+		const FunctionMap &funcs = it.value().analysis;
+
+		if(region.size() == 0) {
+			continue;
+		}
+
+		// the map is sorted by entry point, so everything up to covered_end
+		// already belongs to a function we've seen
+		bool           covered     = false;
+		edb::address_t covered_end = 0;
+
 		Q_FOREACH(const Function &f, funcs) {
-			if(address >= f.entry_address && address <= f.end_address) {
-				function = f;
-				return true;
+			if(f.end_address < f.entry_address) {
+				continue;
+			}
+
+			FunctionRange range;
+			range.first    = f.entry_address;
+			range.last     = f.end_address;
+			range.function = f;
+
+			if(covered) {
+				if(covered_end >= range.last) {
+					continue;
+				}
+
+				if(covered_end >= range.first) {
+					range.first = covered_end + 1;
+				}
+			}
+
+			covered     = true;
+			covered_end = range.last;
+
+			range.first = qMax(range.first, region.start);
+			range.last  = qMin(range.last, region.end - 1);
+
+			if(range.first <= range.last) {
+				function_index_.push_back(range);
 			}
 		}
 	}
-	return false;
+
+	qSort(function_index_.begin(), function_index_.end());
 }
 
 //------------------------------------------------------------------------------
-// Name: md5_region(const MemRegion &region) const
-// Desc: returns a byte array representing the MD5 of a region
+// Name: hash_pages(const MemRegion &region, const QVector<quint8> &snapshot) const
+// Desc: returns the MD5 of each page of a region's snapshot
 //------------------------------------------------------------------------------
-QByteArray Analyzer::md5_region(const MemRegion &region) const{
+QVector<QByteArray> Analyzer::hash_pages(const MemRegion &region, const QVector<quint8> &snapshot) const {
 
 	static const edb::address_t page_size = edb::v1::debugger_core->page_size();
 
-	const edb::address_t size_in_pages = region.size() / page_size;
-	try {
-		QVector<quint8> pages(size_in_pages * page_size);
+	const edb::address_t size_in_pages = (snapshot_end(region, snapshot) - region.start) / page_size;
+
+	QVector<QByteArray> hashes;
+	hashes.reserve(size_in_pages);
+	for(edb::address_t i = 0; i < size_in_pages; ++i) {
+		hashes.push_back(edb::v1::get_md5(&snapshot[i * page_size], page_size));
+	}
+
+	return hashes;
+}
+
+//------------------------------------------------------------------------------
+// Name: file_md5(const QString &path) const
+// Desc: hashing a whole library is not cheap and this gets asked for every
+//       region on every load, save and invalidate, so the result is kept
+//       until the file looks different
+//------------------------------------------------------------------------------
+QByteArray Analyzer::file_md5(const QString &path) const {
+
+	const QFileInfo info(path);
+
+	quint64 inode = 0;
+#ifdef Q_OS_UNIX
+	struct stat st;
+	if(::stat(QFile::encodeName(path).constData(), &st) == 0) {
+		inode = st.st_ino;
+	}
+#endif
+
+	QHash<QString, FileHash>::const_iterator it = file_hashes_.find(path);
+	if(it != file_hashes_.end() && it->inode == inode && it->modified == info.lastModified() && it->size == info.size()) {
+		return it->md5;
+	}
+
+	FileHash file_hash;
+	file_hash.inode    = inode;
+	file_hash.modified = info.lastModified();
+	file_hash.size     = info.size();
+	file_hash.md5      = edb::v1::get_file_md5(path);
+
+	if(file_hash.md5.isEmpty()) {
+		file_hashes_.remove(path);
+	} else {
+		file_hashes_.insert(path, file_hash);
+	}
+
+	return file_hash.md5;
+}
+
+//------------------------------------------------------------------------------
+// Name: cache_filename(const MemRegion &region) const
+// Desc: analyses of file mappings are cached by the file's MD5 and the
+//       offset it is mapped from, the functions are stored relative to
+//       the start of the region so it doesn't matter where it is loaded.
+//       They go in the user's cache directory unless configured otherwise
+//------------------------------------------------------------------------------
+QString Analyzer::cache_filename(const MemRegion &region) const {
+
+	if(region.name.isEmpty() || !QFileInfo(region.name).isFile()) {
+		return QString();
+	}
+
+	QString default_path;
+	const QString cache_location = QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+	if(!cache_location.isEmpty()) {
+		default_path = QString("%1/analysis").arg(cache_location);
+	}
+
+	QSettings settings;
+	const QString path = settings.value("Analyzer/analysis_cache.path", default_path).toString();
+	if(path.isEmpty()) {
+		return QString();
+	}
+
+	const QByteArray md5 = file_md5(region.name);
+	if(md5.isEmpty()) {
+		return QString();
+	}
 
-		if(edb::v1::debugger_core->read_pages(region.start, &pages[0], size_in_pages)) {
-			return edb::v1::get_md5(&pages[0], size_in_pages * page_size);
+	return QString("%1/%2-%3-%4.analysis").arg(
+		path,
+		QString(md5.toHex()),
+		QString::number(region.base, 16),
+		QString::number(region.size(), 16));
+}
+
+//------------------------------------------------------------------------------
+// Name: load_cached_analysis(const MemRegion &region, RegionInfo &region_info) const
+// Desc: fills in region_info from the analysis cache if there is an entry for
+//       this region, the page hashes decide how much of it is still valid
+//------------------------------------------------------------------------------
+void Analyzer::load_cached_analysis(const MemRegion &region, RegionInfo &region_info) const {
+
+	static const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+	const QString filename = cache_filename(region);
+	if(filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if(file.open(QIODevice::ReadOnly)) {
+		QDataStream stream(&file);
+		stream.setVersion(QDataStream::Qt_4_5);
+
+		quint32 magic;
+		quint32 version;
+		stream >> magic >> version;
+
+		if(magic != cache_magic || version != cache_version) {
+			return;
+		}
+
+		quint64             cached_page_size;
+		bool                fuzzy;
+		QVector<QByteArray> page_hashes;
+		QBitArray           call_pages;
+		quint32             count;
+		stream >> cached_page_size >> fuzzy >> page_hashes >> call_pages >> count;
+
+		if(cached_page_size != page_size) {
+			return;
+		}
+
+		FunctionMap functions;
+		for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+			quint64 entry_address;
+			quint64 end_address;
+			quint64 last_instruction;
+			qint32  reference_count;
+			quint8  type;
+			stream >> entry_address >> end_address >> last_instruction >> reference_count >> type;
+
+			Function func;
+			func.entry_address    = region.start + entry_address;
+			func.end_address      = region.start + end_address;
+			func.last_instruction = region.start + last_instruction;
+			func.reference_count  = reference_count;
+			func.type             = static_cast<Function::Type>(type);
+			functions.insert(func.entry_address, func);
+		}
+
+		if(stream.status() == QDataStream::Ok) {
+			qDebug() << "[Analyzer] loaded" << functions.size() << "functions from" << filename;
+			region_info.analysis    = functions;
+			region_info.page_hashes = page_hashes;
+			region_info.call_pages  = call_pages;
+			region_info.fuzzy       = fuzzy;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: save_cached_analysis(const MemRegion &region, const RegionInfo &region_info) const
+// Desc: functions the user marked (and whatever was found by walking them)
+//       belong to this session and not to the file, so an analysis of a
+//       region with marked functions in it isn't cached
+//------------------------------------------------------------------------------
+void Analyzer::save_cached_analysis(const MemRegion &region, const RegionInfo &region_info) const {
+
+	static const edb::address_t page_size = edb::v1::debugger_core->page_size();
+
+	Q_FOREACH(edb::address_t addr, specified_functions_) {
+		if(region.contains(addr)) {
+			qDebug("[Analyzer] the region has marked functions, not caching its analysis");
+			return;
 		}
+	}
 
-	} catch(const std::bad_alloc &) {
-		QMessageBox::information(0, tr("Memroy Allocation Error"),
-			tr("Unable to satisfy memory allocation request for requested region."));
+	const QString filename = cache_filename(region);
+	if(filename.isEmpty()) {
+		return;
 	}
 
-	return QByteArray();
+	// anything outside of the region wouldn't move along with it
+	QVector<Function> functions;
+	Q_FOREACH(const Function &func, region_info.analysis) {
+		if(region.contains(func.entry_address)) {
+			functions.push_back(func);
+		}
+	}
+
+	QDir().mkpath(QFileInfo(filename).path());
+
+	QFile file(filename);
+	if(file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		QDataStream stream(&file);
+		stream.setVersion(QDataStream::Qt_4_5);
+
+		stream << cache_magic << cache_version;
+		stream << static_cast<quint64>(page_size) << region_info.fuzzy << region_info.page_hashes << region_info.call_pages << static_cast<quint32>(functions.size());
+
+		Q_FOREACH(const Function &func, functions) {
+			stream << static_cast<quint64>(func.entry_address - region.start);
+			stream << static_cast<quint64>(func.end_address - region.start);
+			stream << static_cast<quint64>(func.last_instruction - region.start);
+			stream << static_cast<qint32>(func.reference_count);
+			stream << static_cast<quint8>(func.type);
+		}
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -1033,6 +1646,13 @@ void Analyzer::invalidate_analysis(const MemRegion &region) {
 //------------------------------------------------------------------------------
 void Analyzer::invalidate_dynamic_analysis(const MemRegion &region) {
 	analysis_info_[region] = RegionInfo();
+	update_function_index();
+
+	// otherwise the next analysis would just pick up where this one left off
+	const QString filename = cache_filename(region);
+	if(!filename.isEmpty()) {
+		QFile::remove(filename);
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -1042,6 +1662,8 @@ void Analyzer::invalidate_dynamic_analysis(const MemRegion &region) {
 void Analyzer::invalidate_analysis() {
 	analysis_info_.clear();
 	specified_functions_.clear();
+	function_index_.clear();
+	file_hashes_.clear();
 }
 
 Q_EXPORT_PLUGIN2(Analyzer, Analyzer)
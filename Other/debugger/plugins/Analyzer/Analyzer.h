@@ -24,9 +24,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "MemRegion.h"
 #include "Symbol.h"
 #include "Types.h"
+#include <QBitArray>
+#include <QDateTime>
 #include <QSet>
 #include <QMap>
 #include <QHash>
+#include <QVector>
 
 class QMenu;
 class AnalyzerWidget;
@@ -67,21 +70,22 @@ private:
 	void bonus_main(const MemRegion &region, FunctionMap &results) const;
 
 private:
-	QByteArray md5_region(const MemRegion &region) const;
+	QVector<QByteArray> hash_pages(const MemRegion &region, const QVector<quint8> &snapshot) const;
 	bool find_containing_function(edb::address_t address, Function &function) const;
+	const Function *find_function(edb::address_t address) const;
 	bool is_inside_known(const MemRegion &region, edb::address_t address);
 	bool is_stack_frame(edb::address_t address) const;
 	bool is_thunk(edb::address_t address) const;
 	edb::address_t module_entry_point(const MemRegion &region) const;
-	int walk_all_functions(FunctionMap &results, const MemRegion &region, QSet<edb::address_t> &walked_functions);
-	void find_calls_from_known(const MemRegion &region, FunctionMap &results, QSet<edb::address_t> &walked_functions);
-	void find_function_calls(const MemRegion &region, FunctionMap &results);
-	void find_function_end(Function &function, edb::address_t end_address, QSet<edb::address_t> &found_functions, const FunctionMap &results);
+	int walk_all_functions(FunctionMap &results, const MemRegion &region, QSet<edb::address_t> &walked_functions, const QVector<quint8> &snapshot, QBitArray &call_pages);
+	void find_calls_from_known(const MemRegion &region, const QVector<quint8> &snapshot, FunctionMap &results, QSet<edb::address_t> &walked_functions, QBitArray &call_pages);
+	void find_function_calls(const MemRegion &region, const QVector<quint8> &snapshot, FunctionMap &results, QBitArray &call_pages);
 	void fix_overlaps(FunctionMap &function_map);
 	void invalidate_dynamic_analysis(const MemRegion &region);
 	void set_function_types(FunctionMap &results);
 	void set_function_types_helper(Function &info) const;
 	void update_results_entry(FunctionMap &results, edb::address_t address) const;
+	void update_function_index();
 	void collect_high_ref_results(FunctionMap &function_map, FunctionMap &found_functions) const;
 	void collect_low_ref_results(const MemRegion &region, FunctionMap &function_map, FunctionMap &found_functions);
 
@@ -101,15 +105,43 @@ private:
 
 private:
 	struct RegionInfo {
-		FunctionMap analysis;
-		QByteArray  md5;
-		bool        fuzzy;
+		FunctionMap         analysis;
+		QVector<QByteArray> page_hashes;
+		QBitArray           call_pages;  // pages with a call that found a function in them
+		bool                fuzzy;
+	};
+
+private:
+	QString cache_filename(const MemRegion &region) const;
+	QByteArray file_md5(const QString &path) const;
+	void load_cached_analysis(const MemRegion &region, RegionInfo &region_info) const;
+	void save_cached_analysis(const MemRegion &region, const RegionInfo &region_info) const;
+
+private:
+	// the part of a function which answers address lookups
+	struct FunctionRange {
+		edb::address_t first;
+		edb::address_t last;
+		Function       function;
+
+		bool operator<(const FunctionRange &other) const { return first < other.first; }
+	};
+
+	// a file's MD5 stays good for as long as it is the same file with the
+	// same contents as far as stat can tell
+	struct FileHash {
+		quint64    inode;
+		QDateTime  modified;
+		qint64     size;
+		QByteArray md5;
 	};
 
 	QMenu *                      menu_;
 	QHash<MemRegion, RegionInfo> analysis_info_;
+	QVector<FunctionRange>       function_index_;
 	QSet<edb::address_t>         specified_functions_;
 	AnalyzerWidget *             analyzer_widget_;
+	mutable QHash<QString, FileHash> file_hashes_;
 };
 
 #endif
@@ -0,0 +1,144 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BinaryPattern.h"
+#include <cstring>
+
+namespace {
+	// patterns shorter than this are found by scanning for their first byte,
+	// memchr is vectorized so it beats Horspool's small shifts
+	const int min_horspool_size = 4;
+}
+
+//------------------------------------------------------------------------------
+// Name: BinaryPattern(const QByteArray &bytes, const QByteArray &mask)
+// Desc: builds the Horspool shift table, a masked byte matches more than one
+//       value so all of those values get its shift
+//------------------------------------------------------------------------------
+BinaryPattern::BinaryPattern(const QByteArray &bytes, const QByteArray &mask) : bytes_(bytes), mask_(mask), exact_(true) {
+
+	mask_.resize(bytes_.size());
+	for(int i = mask.size(); i < mask_.size(); ++i) {
+		mask_[i] = static_cast<char>(0xff);
+	}
+
+	for(int i = 0; i < bytes_.size(); ++i) {
+		bytes_[i] = bytes_[i] & mask_[i];
+		if(static_cast<quint8>(mask_[i]) != 0xff) {
+			exact_ = false;
+		}
+	}
+
+	const std::size_t n = bytes_.size();
+	for(int c = 0; c < 256; ++c) {
+		shift_[c] = n;
+	}
+
+	for(std::size_t i = 0; i + 1 < n; ++i) {
+		const quint8 b = bytes_[i];
+		const quint8 m = mask_[i];
+		if(m == 0xff) {
+			shift_[b] = n - 1 - i;
+		} else {
+			for(int c = 0; c < 256; ++c) {
+				if((c & m) == b) {
+					shift_[c] = n - 1 - i;
+				}
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: matches(const quint8 *p) const
+// Desc:
+//------------------------------------------------------------------------------
+bool BinaryPattern::matches(const quint8 *p) const {
+	const quint8 *b = reinterpret_cast<const quint8 *>(bytes_.constData());
+	const quint8 *m = reinterpret_cast<const quint8 *>(mask_.constData());
+
+	if(exact_) {
+		return std::memcmp(p, b, bytes_.size()) == 0;
+	}
+
+	for(int i = 0; i < bytes_.size(); ++i) {
+		if((p[i] & m[i]) != b[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_memchr(const quint8 *first, const quint8 *last, std::size_t limit, QList<std::size_t> &results) const
+// Desc: for short exact patterns
+//------------------------------------------------------------------------------
+void BinaryPattern::find_memchr(const quint8 *first, const quint8 *last, std::size_t limit, QList<std::size_t> &results) const {
+	const std::size_t n  = bytes_.size();
+	const quint8 *p      = first;
+	const quint8 *const end = first + qMin<std::size_t>(limit, last - first - n + 1);
+
+	while(p < end) {
+		p = static_cast<const quint8 *>(std::memchr(p, bytes_[0], end - p));
+		if(p == 0) {
+			break;
+		}
+
+		if(matches(p)) {
+			results.push_back(p - first);
+		}
+		++p;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_horspool(const quint8 *first, const quint8 *last, std::size_t limit, QList<std::size_t> &results) const
+// Desc:
+//------------------------------------------------------------------------------
+void BinaryPattern::find_horspool(const quint8 *first, const quint8 *last, std::size_t limit, QList<std::size_t> &results) const {
+	const std::size_t n     = bytes_.size();
+	const quint8 last_byte  = bytes_[n - 1];
+	const quint8 last_mask  = mask_[n - 1];
+	const std::size_t end   = qMin<std::size_t>(limit, last - first - n + 1);
+
+	std::size_t pos = 0;
+	while(pos < end) {
+		const quint8 c = first[pos + n - 1];
+		if((c & last_mask) == last_byte && matches(first + pos)) {
+			results.push_back(pos);
+		}
+		pos += shift_[c];
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_all(const quint8 *first, const quint8 *last, std::size_t limit, QList<std::size_t> &results) const
+// Desc:
+//------------------------------------------------------------------------------
+void BinaryPattern::find_all(const quint8 *first, const quint8 *last, std::size_t limit, QList<std::size_t> &results) const {
+
+	if(empty() || static_cast<std::size_t>(last - first) < static_cast<std::size_t>(bytes_.size())) {
+		return;
+	}
+
+	if(exact_ && bytes_.size() < min_horspool_size) {
+		find_memchr(first, last, limit, results);
+	} else {
+		find_horspool(first, last, limit, results);
+	}
+}
@@ -0,0 +1,55 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BINARYPATTERN_20121017_H_
+#define BINARYPATTERN_20121017_H_
+
+#include "Types.h"
+#include <QByteArray>
+#include <QList>
+#include <cstddef>
+
+// a byte pattern where every byte has a mask of the bits which have to match,
+// so "48 8B ?? 24 ??" is {48 8B 00 24 00} / {FF FF 00 FF 00}
+class BinaryPattern {
+public:
+	BinaryPattern(const QByteArray &bytes, const QByteArray &mask);
+
+public:
+	int size() const   { return bytes_.size(); }
+	bool empty() const { return bytes_.isEmpty(); }
+
+public:
+	// appends the offset of every match in [first, last) which starts before
+	// first + limit (a chunk's tail is only there for matches which begin in
+	// the chunk)
+	void find_all(const quint8 *first, const quint8 *last, std::size_t limit, QList<std::size_t> &results) const;
+
+private:
+	bool matches(const quint8 *p) const;
+	void find_memchr(const quint8 *first, const quint8 *last, std::size_t limit, QList<std::size_t> &results) const;
+	void find_horspool(const quint8 *first, const quint8 *last, std::size_t limit, QList<std::size_t> &results) const;
+
+private:
+	QByteArray  bytes_;
+	QByteArray  mask_;
+	bool        exact_;
+	std::size_t shift_[256];
+};
+
+#endif
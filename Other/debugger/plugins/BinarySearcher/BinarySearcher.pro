@@ -2,6 +2,6 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += BinarySearcher.h DialogBinaryString.h DialogASCIIString.h
+HEADERS += BinarySearcher.h DialogBinaryString.h DialogASCIIString.h BinaryPattern.h
 FORMS += dialogbinarystring.ui dialogasciistring.ui
-SOURCES += BinarySearcher.cpp DialogBinaryString.cpp DialogASCIIString.cpp
+SOURCES += BinarySearcher.cpp DialogBinaryString.cpp DialogASCIIString.cpp BinaryPattern.cpp
@@ -17,19 +17,79 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogBinaryString.h"
+#include "BinaryPattern.h"
 #include "DebuggerCoreInterface.h"
 #include "MemoryRegions.h"
 #include "Debugger.h"
-#include "ByteShiftArray.h"
 #include "Util.h"
-#include "Debugger.h"
 
-#include <QVector>
 #include <QMessageBox>
-#include <cstring>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#ifdef USE_QT_CONCURRENT
+#include <QtConcurrentMap>
+#else
+#include <algorithm>
+#endif
 
 #include "ui_dialogbinarystring.h"
 
+namespace {
+
+// regions are read and searched this many pages at a time, so a huge region
+// doesn't need a buffer as big as itself and can be split between threads
+const edb::address_t chunk_pages = 4096;
+
+struct SearchChunk {
+	edb::address_t     address;
+	std::size_t        limit;   // matches have to start before this offset
+	QVector<quint8>    bytes;
+	QList<std::size_t> results;
+};
+
+//------------------------------------------------------------------------------
+// Name: search_chunk(const BinaryPattern &pattern, SearchChunk &chunk)
+// Desc:
+//------------------------------------------------------------------------------
+void search_chunk(const BinaryPattern &pattern, SearchChunk &chunk) {
+	const quint8 *const first = chunk.bytes.constData();
+	pattern.find_all(first, first + chunk.bytes.size(), chunk.limit, chunk.results);
+}
+
+//------------------------------------------------------------------------------
+// Name: search_chunks(const BinaryPattern &pattern, QVector<SearchChunk> &chunks, edb::address_t align)
+// Desc: searches a batch of chunks (in parallel when possible) and returns the
+//       formatted addresses of the hits which have the requested alignment
+//------------------------------------------------------------------------------
+QStringList search_chunks(const BinaryPattern &pattern, QVector<SearchChunk> &chunks, edb::address_t align) {
+
+#ifdef USE_QT_CONCURRENT
+	QtConcurrent::blockingMap(chunks, boost::bind(search_chunk, boost::cref(pattern), _1));
+#else
+	std::for_each(chunks.begin(), chunks.end(), boost::bind(search_chunk, boost::cref(pattern), _1));
+#endif
+
+	QStringList ret;
+	Q_FOREACH(const SearchChunk &chunk, chunks) {
+		Q_FOREACH(std::size_t offset, chunk.results) {
+			const edb::address_t addr = chunk.address + offset;
+			if((addr % align) == 0) {
+				ret << edb::v1::format_pointer(addr);
+			}
+		}
+	}
+
+	chunks.clear();
+	return ret;
+}
+
+}
+
 //------------------------------------------------------------------------------
 // Name: DialogBinaryString(QWidget *parent)
 // Desc: constructor
@@ -38,6 +98,7 @@ DialogBinaryString::DialogBinaryString(QWidget *parent) : QDialog(parent), ui(ne
 	ui->setupUi(this);
 	ui->progressBar->setValue(0);
 	ui->listWidget->clear();
+	ui->binaryString->setWildcardsEnabled(true);
 }
 
 //------------------------------------------------------------------------------
@@ -50,66 +111,74 @@ DialogBinaryString::~DialogBinaryString() {
 
 //------------------------------------------------------------------------------
 // Name: do_find()
-// Desc:
+// Desc: the memory is read on this thread (the debugger core isn't thread
+//       safe) a batch of chunks at a time, each batch is then searched in
+//       parallel and its hits are added to the list in one go
 //------------------------------------------------------------------------------
 void DialogBinaryString::do_find() {
 
-	const QByteArray b = ui->binaryString->value();
+	const BinaryPattern pattern(ui->binaryString->value(), ui->binaryString->mask());
 	ui->listWidget->clear();
 
-	const int sz = b.size();
-	if(sz != 0) {
-		ByteShiftArray bsa(sz);
+	if(!pattern.empty()) {
 
 		edb::v1::memory_regions().sync();
 		const QList<MemRegion> regions = edb::v1::memory_regions().regions();
 		const edb::address_t page_size = edb::v1::debugger_core->page_size();
+		const edb::address_t align     = ui->chkAlignment->isChecked() ? (1 << (ui->cmbAlignment->currentIndex() + 1)) : 1;
 
-		int i = 0;
+		// a chunk is read with enough extra pages to find matches which
+		// start in it but end in the next one
+		const edb::address_t overlap_pages = (pattern.size() - 1 + page_size - 1) / page_size;
+		const int batch_size               = qMax(QThread::idealThreadCount(), 1);
+
+		int total_pages = 0;
 		Q_FOREACH(const MemRegion &region, regions) {
+			total_pages += region.size() / page_size;
+		}
 
-			bsa.clear();
+		QVector<SearchChunk> batch;
+		int done_pages = 0;
 
-			// a short circut for speading things up
-			if(ui->chkSkipNoAccess->isChecked() && !region.accessible()) {
-				ui->progressBar->setValue(util::percentage(++i, regions.size()));
-				continue;
-			}
+		try {
+			Q_FOREACH(const MemRegion &region, regions) {
 
-			const edb::address_t size_in_pages = region.size() / page_size;
-			try {
-				QVector<quint8> pages(size_in_pages * page_size);
-				const quint8 *const pages_end = &pages[0] + region.size();
+				const edb::address_t size_in_pages = region.size() / page_size;
 
-				if(edb::v1::debugger_core->read_pages(region.start, &pages[0], size_in_pages)) {
-					const quint8 *p = &pages[0];
-					QString temp;
-					while(p != pages_end) {
-						// shift in the next byte
-						bsa << *p;
+				// a short circut for speading things up
+				if(ui->chkSkipNoAccess->isChecked() && !region.accessible()) {
+					done_pages += size_in_pages;
+					continue;
+				}
 
-						// compare values..
-						if(std::memcmp(bsa.data(), b.constData(), sz) == 0) {
-							const edb::address_t addr = (p - &pages[0] + region.start) - sz + 1;
-							const edb::address_t align = 1 << (ui->cmbAlignment->currentIndex() + 1);
+				for(edb::address_t page = 0; page < size_in_pages; page += chunk_pages) {
+					const edb::address_t pages      = qMin(chunk_pages, size_in_pages - page);
+					const edb::address_t read_pages = qMin(pages + overlap_pages, size_in_pages - page);
 
-							if(!ui->chkAlignment->isChecked() || (addr % align) == 0) {
-								ui->listWidget->addItem(edb::v1::format_pointer(addr));
-							}
-						}
+					SearchChunk chunk;
+					chunk.address = region.start + page * page_size;
+					chunk.limit   = pages * page_size;
+					chunk.bytes.resize(read_pages * page_size);
 
-						ui->progressBar->setValue(util::percentage(i, regions.size(), p - &pages[0], region.size()));
+					if(edb::v1::debugger_core->read_pages(chunk.address, chunk.bytes.data(), read_pages)) {
+						batch.push_back(chunk);
+					}
+
+					done_pages += pages;
 
-						++p;
+					if(batch.size() >= batch_size) {
+						ui->listWidget->addItems(search_chunks(pattern, batch, align));
+						ui->progressBar->setValue(util::percentage(done_pages, total_pages));
 					}
 				}
-				++i;
-			} catch(const std::bad_alloc &) {
-				QMessageBox::information(
-					0,
-					tr("Memroy Allocation Error"),
-					tr("Unable to satisfy memory allocation request for requested region."));
 			}
+
+			ui->listWidget->addItems(search_chunks(pattern, batch, align));
+		} catch(const std::bad_alloc &) {
+			QMessageBox::information(
+				0,
+				tr("Memroy Allocation Error"),
+				tr("Unable to satisfy memory allocation request for requested region."));
 		}
 	}
 }
@@ -28,6 +28,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ui_dialogbreakpoints.h"
 
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: user_breakpoints()
+// Desc: the breakpoints which are listed, the internal ones are left alone
+//------------------------------------------------------------------------------
+QList<Breakpoint::pointer> user_breakpoints() {
+	QList<Breakpoint::pointer> breakpoints;
+	Q_FOREACH(const Breakpoint::pointer &bp, edb::v1::debugger_core->backup_breakpoints()) {
+		if(!bp->internal()) {
+			breakpoints.push_back(bp);
+		}
+	}
+	return breakpoints;
+}
+
+}
+
 //------------------------------------------------------------------------------
 // Name: DialogBreakpoints(QWidget *parent)
 // Desc:
@@ -81,7 +99,7 @@ void DialogBreakpoints::updateList() {
 			ui->tableWidget->setItem(row, 0, new QTableWidgetItem(edb::v1::format_pointer(address)));
 			ui->tableWidget->setItem(row, 1, new QTableWidgetItem(condition));
 			ui->tableWidget->setItem(row, 2, new QTableWidgetItem(bytes));
-			ui->tableWidget->setItem(row, 3, new QTableWidgetItem(onetime ? tr("One Time") : tr("Standard")));
+			ui->tableWidget->setItem(row, 3, new QTableWidgetItem((onetime ? tr("One Time") : tr("Standard")) + (bp->enabled() ? QString() : tr(" (Disabled)"))));
 			ui->tableWidget->setItem(row, 4, new QTableWidgetItem(symname));
 		}
 	}
@@ -170,6 +188,26 @@ void DialogBreakpoints::on_btnRemove_clicked() {
 	updateList();
 }
 
+//------------------------------------------------------------------------------
+// Name: on_btnEnableAll_clicked()
+// Desc: arms every breakpoint in one pass, a page at a time
+//------------------------------------------------------------------------------
+void DialogBreakpoints::on_btnEnableAll_clicked() {
+	edb::v1::debugger_core->enable_breakpoints(user_breakpoints());
+	edb::v1::repaint_cpu_view();
+	updateList();
+}
+
+//------------------------------------------------------------------------------
+// Name: on_btnDisableAll_clicked()
+// Desc: disarms every breakpoint in one pass, a page at a time
+//------------------------------------------------------------------------------
+void DialogBreakpoints::on_btnDisableAll_clicked() {
+	edb::v1::debugger_core->disable_breakpoints(user_breakpoints());
+	edb::v1::repaint_cpu_view();
+	updateList();
+}
+
 //------------------------------------------------------------------------------
 // Name: on_tableWidget_cellDoubleClicked(int row, int col)
 // Desc:
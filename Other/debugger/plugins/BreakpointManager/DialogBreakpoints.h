@@ -35,6 +35,8 @@ public Q_SLOTS:
 	void on_btnAdd_clicked();
 	void on_btnRemove_clicked();
 	void on_btnCondition_clicked();
+	void on_btnEnableAll_clicked();
+	void on_btnDisableAll_clicked();
 	void on_tableWidget_cellDoubleClicked(int row, int col);
 
 private:
@@ -28,6 +28,8 @@ class Ui_DialogBreakpoints
 public:
     QGridLayout *gridLayout;
     QPushButton *btnCondition;
+    QPushButton *btnEnableAll;
+    QPushButton *btnDisableAll;
     QSpacerItem *spacerItem;
     QPushButton *okButton;
     QPushButton *btnRemove;
@@ -46,15 +48,25 @@ public:
 
         gridLayout->addWidget(btnCondition, 2, 1, 1, 1);
 
+        btnEnableAll = new QPushButton(DialogBreakpoints);
+        btnEnableAll->setObjectName(QString::fromUtf8("btnEnableAll"));
+
+        gridLayout->addWidget(btnEnableAll, 3, 1, 1, 1);
+
+        btnDisableAll = new QPushButton(DialogBreakpoints);
+        btnDisableAll->setObjectName(QString::fromUtf8("btnDisableAll"));
+
+        gridLayout->addWidget(btnDisableAll, 4, 1, 1, 1);
+
         spacerItem = new QSpacerItem(20, 40, QSizePolicy::Minimum, QSizePolicy::Expanding);
 
-        gridLayout->addItem(spacerItem, 3, 1, 1, 1);
+        gridLayout->addItem(spacerItem, 5, 1, 1, 1);
 
         okButton = new QPushButton(DialogBreakpoints);
         okButton->setObjectName(QString::fromUtf8("okButton"));
         okButton->setDefault(true);
 
-        gridLayout->addWidget(okButton, 4, 1, 1, 1);
+        gridLayout->addWidget(okButton, 6, 1, 1, 1);
 
         btnRemove = new QPushButton(DialogBreakpoints);
         btnRemove->setObjectName(QString::fromUtf8("btnRemove"));
@@ -87,12 +99,14 @@ public:
         tableWidget->horizontalHeader()->setStretchLastSection(true);
         tableWidget->verticalHeader()->setVisible(false);
 
-        gridLayout->addWidget(tableWidget, 0, 0, 5, 1);
+        gridLayout->addWidget(tableWidget, 0, 0, 7, 1);
 
         QWidget::setTabOrder(tableWidget, btnAdd);
         QWidget::setTabOrder(btnAdd, btnRemove);
         QWidget::setTabOrder(btnRemove, btnCondition);
-        QWidget::setTabOrder(btnCondition, okButton);
+        QWidget::setTabOrder(btnCondition, btnEnableAll);
+        QWidget::setTabOrder(btnEnableAll, btnDisableAll);
+        QWidget::setTabOrder(btnDisableAll, okButton);
 
         retranslateUi(DialogBreakpoints);
         QObject::connect(okButton, SIGNAL(clicked()), DialogBreakpoints, SLOT(accept()));
@@ -104,6 +118,8 @@ public:
     {
         DialogBreakpoints->setWindowTitle(QApplication::translate("DialogBreakpoints", "Breakpoint Manager", 0, QApplication::UnicodeUTF8));
         btnCondition->setText(QApplication::translate("DialogBreakpoints", "Set Breakpoint &Condition", 0, QApplication::UnicodeUTF8));
+        btnEnableAll->setText(QApplication::translate("DialogBreakpoints", "&Enable All", 0, QApplication::UnicodeUTF8));
+        btnDisableAll->setText(QApplication::translate("DialogBreakpoints", "&Disable All", 0, QApplication::UnicodeUTF8));
         okButton->setText(QApplication::translate("DialogBreakpoints", "&Close", 0, QApplication::UnicodeUTF8));
         btnRemove->setText(QApplication::translate("DialogBreakpoints", "&Remove Breakpoint", 0, QApplication::UnicodeUTF8));
         btnAdd->setText(QApplication::translate("DialogBreakpoints", "&Add Breakpoint", 0, QApplication::UnicodeUTF8));
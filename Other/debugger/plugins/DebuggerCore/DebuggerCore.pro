@@ -11,6 +11,9 @@ unix {
 	linux-* {
 		DEPENDPATH  += unix/linux
 		INCLUDEPATH += unix/linux
+
+		SOURCES += EventWaiter.cpp
+		HEADERS += EventWaiter.h
 	}
 
 	openbsd-* {
@@ -18,12 +18,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DebuggerCoreBase.h"
 #include "X86Breakpoint.h"
+#include <QSet>
+#include <cstring>
 
 //------------------------------------------------------------------------------
 // Name: DebuggerCoreBase()
 // Desc: constructor
 //------------------------------------------------------------------------------
-DebuggerCoreBase::DebuggerCoreBase() : active_thread_(0), pid_(0) {
+DebuggerCoreBase::DebuggerCoreBase() : active_thread_(0), pid_(0), max_breakpoint_size_(0) {
 }
 
 //------------------------------------------------------------------------------
@@ -39,7 +41,13 @@ DebuggerCoreBase::~DebuggerCoreBase() {
 //------------------------------------------------------------------------------
 void DebuggerCoreBase::clear_breakpoints() {
 	if(attached()) {
+		// restore the original code in one pass rather than letting each
+		// breakpoint do it as it is destroyed
+		disable_breakpoints(breakpoints_.values());
+
+		breakpoint_index_.clear();
 		breakpoints_.clear();
+		max_breakpoint_size_ = 0;
 	}
 }
 
@@ -53,7 +61,9 @@ Breakpoint::pointer DebuggerCoreBase::add_breakpoint(edb::address_t address) {
 	if(attached()) {
 		if(!find_breakpoint(address)) {
 			Breakpoint::pointer bp(new X86Breakpoint(address));
-			breakpoints_[address] = bp;
+			breakpoints_[address]      = bp;
+			breakpoint_index_[address] = bp;
+			max_breakpoint_size_       = qMax(max_breakpoint_size_, qMax(bp->original_bytes().size(), breakpoint_size()));
 			return bp;
 		}
 	}
@@ -89,6 +99,7 @@ void DebuggerCoreBase::remove_breakpoint(edb::address_t address) {
 	if(attached()) {
 		const BreakpointState::iterator it = breakpoints_.find(address);
 		if(it != breakpoints_.end()) {
+			breakpoint_index_.remove(address);
 			breakpoints_.erase(it);
 		}
 	}
@@ -127,6 +138,149 @@ bool DebuggerCoreBase::attached() const {
 	return pid() != 0;
 }
 
+//------------------------------------------------------------------------------
+// Name: enable_breakpoints(const QList<Breakpoint::pointer> &breakpoints)
+// Desc: arms all of the given breakpoints, using one read and one write per
+//       page which contains any of them
+//------------------------------------------------------------------------------
+void DebuggerCoreBase::enable_breakpoints(const QList<Breakpoint::pointer> &breakpoints) {
+	set_breakpoints_enabled(breakpoints, true);
+}
+
+//------------------------------------------------------------------------------
+// Name: disable_breakpoints(const QList<Breakpoint::pointer> &breakpoints)
+// Desc: disarms all of the given breakpoints, using one read and one write per
+//       page which contains any of them
+//------------------------------------------------------------------------------
+void DebuggerCoreBase::disable_breakpoints(const QList<Breakpoint::pointer> &breakpoints) {
+	set_breakpoints_enabled(breakpoints, false);
+}
+
+//------------------------------------------------------------------------------
+// Name: set_breakpoints_enabled(const QList<Breakpoint::pointer> &breakpoints, bool enable)
+// Desc: groups the breakpoints which need to change by page, then for each
+//       page reads the span they cover, patches it and writes it back in one
+//       go. Breakpoints we did not create fall back to their own enable/disable
+//------------------------------------------------------------------------------
+void DebuggerCoreBase::set_breakpoints_enabled(const QList<Breakpoint::pointer> &breakpoints, bool enable) {
+
+	if(!attached()) {
+		return;
+	}
+
+	typedef QMap<edb::address_t, QList<X86Breakpoint *> > page_map_t;
+
+	page_map_t              pages;
+	QSet<const Breakpoint *> changing;
+
+	Q_FOREACH(const Breakpoint::pointer &bp, breakpoints) {
+		if(bp && bp->enabled() != enable) {
+			if(X86Breakpoint *const x86_bp = dynamic_cast<X86Breakpoint *>(bp.data())) {
+				pages[bp->address() & ~(page_size() - 1)].append(x86_bp);
+				changing.insert(x86_bp);
+			} else if(enable) {
+				bp->enable();
+			} else {
+				bp->disable();
+			}
+		}
+	}
+
+	for(page_map_t::const_iterator page = pages.begin(); page != pages.end(); ++page) {
+
+		edb::address_t first = page.value().front()->address();
+		edb::address_t last  = first;
+		Q_FOREACH(X86Breakpoint *bp, page.value()) {
+			first = qMin(first, bp->address());
+			last  = qMax(last, bp->address() + X86Breakpoint::size);
+		}
+
+		// reads hide armed breakpoints, so this is the code as it would be
+		// without any of them
+		QByteArray original(last - first, 0);
+		if(!read_bytes(first, original.data(), original.size())) {
+			continue;
+		}
+
+		// anything armed in this span after we are done needs to keep its
+		// instruction in place
+		QByteArray patched(original);
+		const edb::address_t reach = X86Breakpoint::size - 1;
+		for(breakpoint_index_t::const_iterator it = breakpoint_index_.lowerBound(first > reach ? first - reach : 0); it != breakpoint_index_.end() && it.key() < last; ++it) {
+			const Breakpoint *const bp = it.value().data();
+			const bool armed = changing.contains(bp) ? enable : bp->enabled();
+			if(armed) {
+				for(int i = 0; i < X86Breakpoint::size; ++i) {
+					const edb::address_t a = it.key() + i;
+					if(a >= first && a < last) {
+						patched[static_cast<int>(a - first)] = X86Breakpoint::instruction[i];
+					}
+				}
+			}
+		}
+
+		// the ones we were asked about may have already left the index
+		Q_FOREACH(X86Breakpoint *bp, page.value()) {
+			if(enable) {
+				std::memcpy(patched.data() + (bp->address() - first), X86Breakpoint::instruction, X86Breakpoint::size);
+			} else {
+				const QByteArray bytes = bp->original_bytes();
+				std::memcpy(patched.data() + (bp->address() - first), bytes.constData(), qMin(bytes.size(), X86Breakpoint::size));
+			}
+		}
+
+		if(write_bytes(first, patched.constData(), patched.size())) {
+			Q_FOREACH(X86Breakpoint *bp, page.value()) {
+				if(enable) {
+					bp->set_armed(original.mid(bp->address() - first, X86Breakpoint::size));
+				} else {
+					bp->set_disarmed();
+				}
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: apply_breakpoint_overlay(edb::address_t address, quint8 *buf, std::size_t len) const
+// Desc: replaces any breakpoint bytes in <buf> (which holds the process's
+//       memory from [address, address + len)) with the original bytes so
+//       that callers see the program as it would be without breakpoints
+// Note: this is O(log n + k) where k is the number of breakpoints which
+//       overlap the range
+//------------------------------------------------------------------------------
+void DebuggerCoreBase::apply_breakpoint_overlay(edb::address_t address, quint8 *buf, std::size_t len) const {
+
+	if(len == 0 || breakpoint_index_.isEmpty()) {
+		return;
+	}
+
+	// a breakpoint which starts a little before the range may still reach into it
+	const edb::address_t reach = max_breakpoint_size_ > 1 ? max_breakpoint_size_ - 1 : 0;
+	const edb::address_t first = address > reach ? address - reach : 0;
+
+	for(breakpoint_index_t::const_iterator it = breakpoint_index_.lowerBound(first); it != breakpoint_index_.end(); ++it) {
+
+		const edb::address_t bp_address = it.key();
+		if(bp_address >= address && bp_address - address >= len) {
+			break;
+		}
+
+		// a disabled breakpoint's memory is what it would be without it
+		if(!it.value()->enabled()) {
+			continue;
+		}
+
+		const QByteArray bytes = it.value()->original_bytes();
+		for(int i = 0; i < bytes.size(); ++i) {
+			const edb::address_t a = bp_address + i;
+			if(a >= address && a - address < len) {
+				buf[a - address] = bytes[i];
+			}
+		}
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: thread_ids() const
 // Desc:
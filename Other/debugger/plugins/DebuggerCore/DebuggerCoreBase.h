@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DEBUGGERCOREBASE_20090529_H_
 
 #include "DebuggerCoreInterface.h"
+#include <QMap>
 
 class DebuggerCoreBase : public QObject, public DebuggerCoreInterface {
 public:
@@ -43,17 +44,32 @@ public:
 	virtual int breakpoint_size() const;
 	virtual void clear_breakpoints();
 	virtual void remove_breakpoint(edb::address_t address);
+	virtual void enable_breakpoints(const QList<Breakpoint::pointer> &breakpoints);
+	virtual void disable_breakpoints(const QList<Breakpoint::pointer> &breakpoints);
 
 public:
 	virtual edb::pid_t pid() const;
 
 protected:
 	bool attached() const;
+	void apply_breakpoint_overlay(edb::address_t address, quint8 *buf, std::size_t len) const;
+
+private:
+	void set_breakpoints_enabled(const QList<Breakpoint::pointer> &breakpoints, bool enable);
 
 protected:
 	edb::tid_t      active_thread_;
 	edb::pid_t      pid_;
 	BreakpointState breakpoints_;
+
+private:
+	// the same breakpoints as breakpoints_, but ordered by address so that
+	// the ones overlapping a range can be found quickly
+	typedef QMap<edb::address_t, Breakpoint::pointer> breakpoint_index_t;
+
+private:
+	breakpoint_index_t breakpoint_index_;
+	int                max_breakpoint_size_;
 };
 
 #endif
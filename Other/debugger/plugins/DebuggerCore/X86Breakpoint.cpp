@@ -19,9 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "X86Breakpoint.h"
 #include "DebuggerCoreInterface.h"
 #include "Debugger.h"
-namespace {
-const quint8 BreakpointInstruction[X86Breakpoint::size] = {0xcc};
-}
+const quint8 X86Breakpoint::instruction[X86Breakpoint::size] = {0xcc};
 
 //------------------------------------------------------------------------------
 // Name: Breakpoint(edb::address_t address, bool onetime)
@@ -47,7 +45,7 @@ bool X86Breakpoint::enable() {
 	if(!enabled()) {
 		char prev[size];
 		if(edb::v1::debugger_core->read_bytes(address(), prev, size)) {
-			if(edb::v1::debugger_core->write_bytes(address(), BreakpointInstruction, size)) {
+			if(edb::v1::debugger_core->write_bytes(address(), instruction, size)) {
 				original_bytes_ = QByteArray(prev, size);
 				enabled_ = true;
 				return true;
@@ -70,3 +68,21 @@ bool X86Breakpoint::disable() {
 	}
 	return false;
 }
+
+//------------------------------------------------------------------------------
+// Name: set_armed(const QByteArray &original_bytes)
+// Desc: records that the breakpoint instruction has been written over
+//       <original_bytes> on our behalf
+//------------------------------------------------------------------------------
+void X86Breakpoint::set_armed(const QByteArray &original_bytes) {
+	original_bytes_ = original_bytes;
+	enabled_        = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_disarmed()
+// Desc: records that the original bytes have been restored on our behalf
+//------------------------------------------------------------------------------
+void X86Breakpoint::set_disarmed() {
+	enabled_ = false;
+}
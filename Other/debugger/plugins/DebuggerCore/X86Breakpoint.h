@@ -41,8 +41,14 @@ public:
 	virtual void set_one_time(bool value) { one_time_ = value; }
 	virtual void set_internal(bool value) { internal_ = value; }
 
+public:
+	// for the core, which may patch the memory of many breakpoints at once
+	void set_armed(const QByteArray &original_bytes);
+	void set_disarmed();
+
 public:
 	static const int size = 1;
+	static const quint8 instruction[size];
 
 private:
 	QByteArray     original_bytes_;
@@ -0,0 +1,48 @@
+
+# a headless harness which drives the debugger core directly, it is built
+# along with the plugins on linux (or on its own with qmake && make here),
+# run ./edb-core-benchmark [iterations] from this directory, the results
+# are written to stdout as JSON
+
+EDB_ROOT = ../../..
+
+TEMPLATE = app
+TARGET   = edb-core-benchmark
+CONFIG  += console
+CONFIG  -= app_bundle
+
+unix {
+	DEPENDPATH  += .. ../unix $$EDB_ROOT/include $$EDB_ROOT/include/os/unix
+	INCLUDEPATH += .. ../unix $$EDB_ROOT/include $$EDB_ROOT/include/os/unix
+
+	linux-* {
+		DEPENDPATH  += ../unix/linux $$EDB_ROOT/include/os/unix/linux $$EDB_ROOT/src/os/unix/linux
+		INCLUDEPATH += ../unix/linux $$EDB_ROOT/include/os/unix/linux
+	}
+
+	# no widgets are ever created, but MemRegion links against QtGui
+	QT += gui
+
+	INCLUDEPATH += $$EDB_ROOT/include/arch/$$QT_ARCH
+	DEPENDPATH  += $$EDB_ROOT/include/arch/$$QT_ARCH
+}
+
+# the parts of the core under test
+HEADERS += DebuggerCoreBase.h   DebuggerCoreUNIX.h   DebuggerCore.h   PlatformState.h   X86Breakpoint.h   EventWaiter.h
+SOURCES += DebuggerCoreBase.cpp DebuggerCoreUNIX.cpp DebuggerCore.cpp PlatformState.cpp X86Breakpoint.cpp EventWaiter.cpp
+
+# the bits of edb which they need
+SOURCES += $$EDB_ROOT/src/State.cpp $$EDB_ROOT/src/Register.cpp $$EDB_ROOT/src/BreakpointCondition.cpp DebugEvent.cpp
+HEADERS += $$EDB_ROOT/include/MemoryRegions.h
+SOURCES += MemoryRegions.cpp MemRegion.cpp
+
+SOURCES += main.cpp stubs.cpp
+
+# the programs which get debugged
+DEBUGEES += targets/bp_loop.c targets/tight_loop.c targets/large_heap.c targets/many_threads.c targets/many_maps.c
+
+debugee.input    = DEBUGEES
+debugee.output   = ${QMAKE_FILE_BASE}
+debugee.commands = $$QMAKE_CC -O1 -g -pthread -o ${QMAKE_FILE_OUT} ${QMAKE_FILE_NAME}
+debugee.CONFIG  += no_link target_predeps
+QMAKE_EXTRA_COMPILERS += debugee
@@ -0,0 +1,754 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BreakpointCondition.h"
+#include "DebuggerCore.h"
+#include "DebugEvent.h"
+#include "DebugEventHandlerInterface.h"
+#include "Debugger.h"
+#include "Expression.h"
+#include "MemoryRegions.h"
+#include "State.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QStringList>
+#include <QTime>
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <ctime>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// a condition which is never true at the breakpoint, it needs both a register
+// and a memory read (the return address) to find that out
+#if defined(EDB_X86)
+const char CONDITION[] = "[esp] == 0 && eip != 0";
+#elif defined(EDB_X86_64)
+const char CONDITION[] = "[rsp] == 0 && rip != 0";
+#endif
+
+// the registers which running code in the debugee may change
+#if defined(EDB_X86)
+const char *const REGISTERS[] = {
+	"eax", "ebx", "ecx", "edx", "esi", "edi", "ebp", "esp", "eip", "eflags"
+};
+#elif defined(EDB_X86_64)
+const char *const REGISTERS[] = {
+	"rax", "rbx", "rcx", "rdx", "rsi", "rdi", "rbp", "rsp",
+	"r8",  "r9",  "r10", "r11", "r12", "r13", "r14", "r15", "rip", "rflags"
+};
+#endif
+
+DebuggerCore *core = 0;
+
+struct result {
+	result(const char *n, double v, const char *u) : name(n), value(v), unit(u) {
+	}
+
+	const char *name;
+	double      value;
+	const char *unit;
+};
+
+QList<result> results;
+
+//------------------------------------------------------------------------------
+// Name: target_path(const QString &name)
+// Desc: the bundled debugees live next to the benchmark
+//------------------------------------------------------------------------------
+QString target_path(const QString &name) {
+	return QCoreApplication::applicationDirPath() + "/" + name;
+}
+
+//------------------------------------------------------------------------------
+// Name: next_event(DebugEvent &event)
+// Desc: waits for the next event which the core reports, gives up after a
+//       few seconds of silence
+//------------------------------------------------------------------------------
+bool next_event(DebugEvent &event) {
+	for(int i = 0; i < 5; ++i) {
+		if(core->wait_debug_event(event, 1000)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: run_to_stop()
+// Desc: lets the debugee run until it stops (the targets raise a SIGTRAP when
+//       they are ready for us)
+//------------------------------------------------------------------------------
+bool run_to_stop() {
+	DebugEvent event;
+	core->resume(edb::DEBUG_CONTINUE);
+	return next_event(event) && event.stopped();
+}
+
+//------------------------------------------------------------------------------
+// Name: now()
+// Desc: a monotonic timestamp in microseconds, QTime is too coarse for some
+//       of the things we measure
+//------------------------------------------------------------------------------
+quint64 now() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<quint64>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+// Name: report(const char *name, double value, const char *unit)
+// Desc: results are collected and written out as JSON when we are done
+//------------------------------------------------------------------------------
+void report(const char *name, double value, const char *unit) {
+	results.push_back(result(name, value, unit));
+}
+
+//------------------------------------------------------------------------------
+// Name: print_results(bool ok)
+// Desc:
+//------------------------------------------------------------------------------
+void print_results(bool ok) {
+	std::printf("{\n");
+	std::printf("\t\"benchmarks\": [\n");
+	for(int i = 0; i < results.size(); ++i) {
+		const result &r = results[i];
+		std::printf("\t\t{ \"name\": \"%s\", \"value\": %.3f, \"unit\": \"%s\" }%s\n", r.name, r.value, r.unit, (i + 1 < results.size()) ? "," : "");
+	}
+	std::printf("\t],\n");
+	std::printf("\t\"ok\": %s\n", ok ? "true" : "false");
+	std::printf("}\n");
+}
+
+//------------------------------------------------------------------------------
+// Name: open_target(const QString &name, QStringList args, int &fd)
+// Desc: starts one of the bundled targets under the debugger, the write end of
+//       a pipe is passed as its last argument and the read end is returned in
+//       fd (the caller closes it)
+//------------------------------------------------------------------------------
+bool open_target(const QString &name, QStringList args, int &fd) {
+
+	int fds[2];
+	if(::pipe(fds) == -1) {
+		return false;
+	}
+
+	args << QString::number(fds[1]);
+
+	if(!core->open(target_path(name), QDir::currentPath(), args, QString())) {
+		std::fprintf(stderr, "could not start %s\n", qPrintable(target_path(name)));
+		::close(fds[0]);
+		::close(fds[1]);
+		return false;
+	}
+
+	::close(fds[1]);
+	fd = fds[0];
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: start_bp_loop(int iterations, edb::address_t &address)
+// Desc: starts bp_loop and lets it run until it tells us the address of the
+//       function which it calls over and over
+//------------------------------------------------------------------------------
+bool start_bp_loop(int iterations, edb::address_t &address) {
+
+	int fd;
+	if(!open_target("bp_loop", QStringList() << QString::number(iterations), fd)) {
+		return false;
+	}
+
+	if(!run_to_stop() || ::read(fd, &address, sizeof(address)) != sizeof(address)) {
+		::close(fd);
+		core->kill();
+		return false;
+	}
+
+	::close(fd);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: run_bp_loop(edb::address_t address, BreakpointCondition *condition)
+// Desc: puts a breakpoint on address and lets bp_loop run to completion,
+//       every hit is handled the way the GUI does it: rewind, (evaluate the
+//       condition), disable, step, enable, continue. So each hit is two debug
+//       events. Returns the number of hits.
+//------------------------------------------------------------------------------
+int run_bp_loop(edb::address_t address, BreakpointCondition *condition, int &elapsed) {
+
+	Breakpoint::pointer bp = core->add_breakpoint(address);
+
+	int hits = 0;
+	QTime timer;
+	timer.start();
+
+	DebugEvent event;
+	core->resume(edb::DEBUG_CONTINUE);
+	while(next_event(event) && event.stopped()) {
+		State state;
+		core->get_state(state);
+
+		if(state.instruction_pointer() - 1 == address) {
+			++hits;
+			state.set_instruction_pointer(address);
+			core->set_state(state);
+
+			if(condition) {
+				bool ok;
+				ExpressionError error;
+				if(condition->evaluate(state, ok, error) || !ok) {
+					std::fprintf(stderr, "condition unexpectedly true: %s\n", ok ? "" : error.what());
+					break;
+				}
+			}
+
+			bp->disable();
+			core->step(edb::DEBUG_CONTINUE);
+			if(!next_event(event)) {
+				break;
+			}
+			bp->enable();
+		}
+
+		core->resume(edb::DEBUG_CONTINUE);
+
+		// the core's notifications are queued to this thread, don't let them pile up
+		if((hits % 1024) == 0) {
+			QCoreApplication::processEvents();
+		}
+	}
+
+	elapsed = qMax(timer.elapsed(), 1);
+
+	bp.clear();
+	core->kill();
+	return hits;
+}
+
+//------------------------------------------------------------------------------
+// Name: benchmark_breakpoint_events(int iterations)
+// Desc: the cost of an unconditional breakpoint hit
+//------------------------------------------------------------------------------
+bool benchmark_breakpoint_events(int iterations) {
+
+	edb::address_t address;
+	if(!start_bp_loop(iterations, address)) {
+		return false;
+	}
+
+	int elapsed;
+	const int hits = run_bp_loop(address, 0, elapsed);
+
+	report("breakpoint.hits", hits * 1000.0 / elapsed, "hits/s");
+	report("events", hits * 2 * 1000.0 / elapsed, "events/s");
+	return hits == iterations;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_target(edb::address_t address, bool &ok, ExpressionError &err)
+// Desc: memory reader for conditions, the same as edb::v1::get_value
+//------------------------------------------------------------------------------
+edb::address_t read_target(edb::address_t address, bool &ok, ExpressionError &err) {
+	edb::address_t ret = 0;
+	ok = core->read_bytes(address, &ret, sizeof(ret));
+	if(!ok) {
+		err = ExpressionError(ExpressionError::CANNOT_READ_MEMORY);
+	}
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: benchmark_conditional_breakpoints(int iterations)
+// Desc: like benchmark_breakpoint_events, but the breakpoint has a condition
+//       (which uses registers and memory) that is never true
+//------------------------------------------------------------------------------
+bool benchmark_conditional_breakpoints(int iterations) {
+
+	edb::address_t address;
+	if(!start_bp_loop(iterations, address)) {
+		return false;
+	}
+
+	BreakpointCondition condition(CONDITION, read_target);
+
+	int elapsed;
+	const int hits = run_bp_loop(address, &condition, elapsed);
+
+	report("breakpoint.conditional", hits * 1000.0 / elapsed, "hits/s");
+	return hits == iterations;
+}
+
+//------------------------------------------------------------------------------
+// Name: fake_read(edb::address_t address, bool &ok, ExpressionError &)
+// Desc: a memory reader which doesn't need a process
+//------------------------------------------------------------------------------
+edb::address_t fake_read(edb::address_t address, bool &ok, ExpressionError &) {
+	ok = true;
+	return address + 1;
+}
+
+const State *current_state = 0;
+
+//------------------------------------------------------------------------------
+// Name: state_variable(const QString &name, bool &ok, ExpressionError &err)
+// Desc: resolves variables by name, the way edb::v1::get_variable does
+//------------------------------------------------------------------------------
+edb::address_t state_variable(const QString &name, bool &ok, ExpressionError &err) {
+	const Register reg = current_state->value(name);
+	ok = reg;
+	if(!ok) {
+		err = ExpressionError(ExpressionError::UNKNOWN_VARIABLE);
+	}
+	return *reg;
+}
+
+//------------------------------------------------------------------------------
+// Name: benchmark_condition_evaluation(int iterations)
+// Desc: how fast a condition evaluates once compiled, compared to parsing it
+//       on every hit. No process is involved and memory reads are faked
+//------------------------------------------------------------------------------
+bool benchmark_condition_evaluation(int iterations) {
+
+	State state;
+	state.set_instruction_pointer(0x1000);
+	current_state = &state;
+
+	edb::address_t sum = 0;
+	bool ok = true;
+	ExpressionError error;
+
+	QTime timer;
+	timer.start();
+	for(int i = 0; i < iterations && ok; ++i) {
+		Expression<edb::address_t> expression(CONDITION, state_variable, fake_read);
+		sum += expression.evaluate_expression(ok, error);
+	}
+	const int parsed_elapsed = qMax(timer.elapsed(), 1);
+
+	BreakpointCondition condition(CONDITION, fake_read);
+
+	timer.start();
+	for(int i = 0; i < iterations && ok; ++i) {
+		sum += condition.evaluate(state, ok, error);
+	}
+	const int compiled_elapsed = qMax(timer.elapsed(), 1);
+
+	current_state = 0;
+
+	report("condition.parsed", iterations * 1000.0 / parsed_elapsed, "evals/s");
+	report("condition.compiled", iterations * 1000.0 / compiled_elapsed, "evals/s");
+	return ok && sum == 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: benchmark_memory(int megabytes)
+// Desc: moves a large heap block in and out of the process. read_pages is
+//       measured in one big transfer (the way region scans use it), read_bytes
+//       in small chunks (the way the views use it) and write_bytes in 64K
+//       chunks
+//------------------------------------------------------------------------------
+bool benchmark_memory(int megabytes) {
+
+	int fd;
+	if(!open_target("large_heap", QStringList() << QString::number(megabytes), fd)) {
+		return false;
+	}
+
+	edb::address_t address = 0;
+	unsigned long  size    = 0;
+	if(!run_to_stop() || ::read(fd, &address, sizeof(address)) != sizeof(address) || ::read(fd, &size, sizeof(size)) != sizeof(size)) {
+		::close(fd);
+		core->kill();
+		return false;
+	}
+	::close(fd);
+
+	const edb::address_t page_size = core->page_size();
+	const edb::address_t first     = (address + page_size - 1) & ~(page_size - 1);
+	const std::size_t    pages     = (address + size - first) / page_size;
+
+	std::vector<quint8> buffer(pages * page_size);
+	bool ok = true;
+
+	// read_pages
+	quint64 start = now();
+	ok = core->read_pages(first, &buffer[0], pages) && ok;
+	quint64 elapsed = qMax<quint64>(now() - start, 1);
+	report("memory.read_pages", buffer.size() * 1000000.0 / elapsed, "bytes/s");
+
+	ok = ok && buffer[0] == 0x5a && buffer[buffer.size() - 1] == 0x5a;
+
+	// read_bytes
+	const std::size_t read_chunk = 64;
+	const std::size_t read_total = qMin<std::size_t>(buffer.size(), 4 << 20);
+
+	start = now();
+	for(std::size_t offset = 0; offset < read_total; offset += read_chunk) {
+		ok = core->read_bytes(first + offset, &buffer[offset], read_chunk) && ok;
+	}
+	elapsed = qMax<quint64>(now() - start, 1);
+	report("memory.read_bytes", read_total * 1000000.0 / elapsed, "bytes/s");
+
+	// write_bytes
+	const std::size_t write_chunk = 64 * 1024;
+	const std::size_t write_total = buffer.size() - (buffer.size() % write_chunk);
+	std::fill(buffer.begin(), buffer.end(), 0xa5);
+
+	start = now();
+	for(std::size_t offset = 0; offset < write_total; offset += write_chunk) {
+		ok = core->write_bytes(first + offset, &buffer[offset], write_chunk) && ok;
+	}
+	elapsed = qMax<quint64>(now() - start, 1);
+	report("memory.write_bytes", write_total * 1000000.0 / elapsed, "bytes/s");
+
+	quint8 check = 0;
+	ok = core->read_bytes(first, &check, sizeof(check)) && check == 0xa5 && ok;
+
+	core->kill();
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: benchmark_single_step(int iterations)
+// Desc: steps through a tight loop
+//------------------------------------------------------------------------------
+bool benchmark_single_step(int iterations) {
+
+	int fd;
+	if(!open_target("tight_loop", QStringList(), fd)) {
+		return false;
+	}
+	::close(fd);
+
+	if(!run_to_stop()) {
+		core->kill();
+		return false;
+	}
+
+	int steps = 0;
+	const quint64 start = now();
+
+	DebugEvent event;
+	while(steps < iterations) {
+		core->step(edb::DEBUG_CONTINUE);
+		if(!next_event(event) || !event.stopped()) {
+			break;
+		}
+
+		// the core's notifications are queued to this thread, don't let them pile up
+		if((++steps % 1024) == 0) {
+			QCoreApplication::processEvents();
+		}
+	}
+
+	const quint64 elapsed = qMax<quint64>(now() - start, 1);
+	report("single_step", steps * 1000000.0 / elapsed, "steps/s");
+
+	core->kill();
+	return steps == iterations;
+}
+
+//------------------------------------------------------------------------------
+// Name: benchmark_attach(const char *name, int threads)
+// Desc: attaches to (and detaches from) an already running process with the
+//       given number of threads, attaching includes stopping all of them
+//------------------------------------------------------------------------------
+bool benchmark_attach(const char *name, int threads) {
+
+	int fds[2];
+	if(::pipe(fds) == -1) {
+		return false;
+	}
+
+	const QByteArray path         = QFile::encodeName(target_path("many_threads"));
+	const QByteArray thread_count = QByteArray::number(threads);
+	const QByteArray fd_number    = QByteArray::number(fds[1]);
+
+	const pid_t pid = fork();
+	if(pid == 0) {
+		::close(fds[0]);
+		execl(path.constData(), path.constData(), thread_count.constData(), fd_number.constData(), static_cast<char *>(0));
+		_exit(1);
+	}
+
+	::close(fds[1]);
+
+	char ready;
+	const bool started = (pid > 0) && ::read(fds[0], &ready, sizeof(ready)) == sizeof(ready);
+	::close(fds[0]);
+
+	if(!started) {
+		std::fprintf(stderr, "could not start %s\n", path.constData());
+		if(pid > 0) {
+			::kill(pid, SIGKILL);
+			::waitpid(pid, 0, 0);
+		}
+		return false;
+	}
+
+	const int rounds = 10;
+	bool ok = true;
+	quint64 total = 0;
+
+	for(int i = 0; i < rounds && ok; ++i) {
+		const quint64 start = now();
+		ok = core->attach(pid);
+		total += now() - start;
+
+		ok = ok && core->thread_ids().size() == threads;
+		core->detach();
+	}
+
+	::kill(pid, SIGKILL);
+	::waitpid(pid, 0, 0);
+
+	report(name, total / 1000.0 / rounds, "ms");
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: benchmark_region_sync(int maps, int rounds)
+// Desc: how long MemoryRegions::sync takes for a process with lots of
+//       mappings: the first time, when nothing has changed and when one
+//       mapping has changed
+//------------------------------------------------------------------------------
+bool benchmark_region_sync(int maps, int rounds) {
+
+	int fd;
+	if(!open_target("many_maps", QStringList() << QString::number(maps) << QString::number(rounds), fd)) {
+		return false;
+	}
+	::close(fd);
+
+	if(!run_to_stop()) {
+		core->kill();
+		return false;
+	}
+
+	MemoryRegions regions;
+
+	quint64 start = now();
+	regions.set_pid(core->pid());
+	const quint64 full = now() - start;
+
+	bool ok = regions.regions().size() >= maps;
+
+	quint64 unchanged = 0;
+	quint64 changed   = 0;
+	int i;
+	for(i = 0; i < rounds && ok; ++i) {
+		start = now();
+		regions.sync();
+		unchanged += now() - start;
+
+		if(!run_to_stop()) {
+			ok = false;
+			break;
+		}
+
+		start = now();
+		regions.sync();
+		changed += now() - start;
+	}
+
+	regions.clear();
+	core->kill();
+
+	report("regions.sync.full", full / 1000.0, "ms");
+	report("regions.sync.unchanged", unchanged / 1000.0 / qMax(i, 1), "ms");
+	report("regions.sync.changed", changed / 1000.0 / qMax(i, 1), "ms");
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: EventPump
+// Desc: hands the core's events to the current debug event handler from the
+//       event loop, the way the GUI does. The other benchmarks take the events
+//       themselves, so this only exists while something else needs them
+//------------------------------------------------------------------------------
+class EventPump : public QObject {
+public:
+	EventPump() : timer_(startTimer(10)) {
+	}
+
+	virtual ~EventPump() {
+		killTimer(timer_);
+	}
+
+protected:
+	virtual void timerEvent(QTimerEvent *) {
+		DebugEvent event;
+		if(core->wait_debug_event(event, 0)) {
+			if(DebugEventHandlerInterface *const handler = edb::v1::debug_event_handler()) {
+				handler->handle_event(event);
+			}
+		}
+	}
+
+private:
+	int timer_;
+};
+
+//------------------------------------------------------------------------------
+// Name: register_values()
+// Desc: the current values of the registers in REGISTERS
+//------------------------------------------------------------------------------
+QList<edb::reg_t> register_values() {
+	State state;
+	core->get_state(state);
+
+	QList<edb::reg_t> values;
+	for(std::size_t i = 0; i < sizeof(REGISTERS) / sizeof(REGISTERS[0]); ++i) {
+		values.push_back(*state.value(REGISTERS[i]));
+	}
+	return values;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_data_region(const QString &path, MemRegion &region)
+// Desc: finds the writable, non executable mapping of the given file
+//------------------------------------------------------------------------------
+bool find_data_region(const QString &path, MemRegion &region) {
+	Q_FOREACH(const MemRegion &r, edb::v1::memory_regions().regions()) {
+		if(r.name == path && r.readable() && r.writable() && !r.executable()) {
+			region = r;
+			return true;
+		}
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: check_set_permissions()
+// Desc: MemRegion::set_permissions runs an mprotect in the debugee, afterwards
+//       the registers and the code it borrowed must be just as they were. The
+//       data mapping of tight_loop is made read only and then writable again
+//------------------------------------------------------------------------------
+bool check_set_permissions() {
+
+	int fd;
+	if(!open_target("tight_loop", QStringList(), fd)) {
+		return false;
+	}
+	::close(fd);
+
+	if(!run_to_stop()) {
+		core->kill();
+		return false;
+	}
+
+	const QString path = QFileInfo(target_path("tight_loop")).canonicalFilePath();
+	MemoryRegions &regions = edb::v1::memory_regions();
+	regions.set_pid(core->pid());
+
+	MemRegion region;
+	bool ok = find_data_region(path, region);
+
+	// the shellcode goes at the start of the first executable region
+	edb::address_t code_address = 0;
+	Q_FOREACH(const MemRegion &r, regions.regions()) {
+		if(r.executable()) {
+			code_address = r.start;
+			break;
+		}
+	}
+
+	const QList<edb::reg_t> before = register_values();
+
+	quint8 code_before[16];
+	ok = ok && code_address != 0 && core->read_bytes(code_address, code_before, sizeof(code_before));
+
+	quint64 elapsed = 0;
+	if(ok) {
+		EventPump pump;
+
+		const quint64 start = now();
+		region.set_permissions(true, false, false);
+		elapsed = now() - start;
+
+		// it should really have happened
+		regions.sync();
+		MemRegion changed;
+		ok = !find_data_region(path, changed);
+
+		region.set_permissions(true, true, false);
+	}
+
+	regions.sync();
+	ok = ok && find_data_region(path, region);
+
+	const QList<edb::reg_t> after = register_values();
+	for(int i = 0; i < before.size() && i < after.size(); ++i) {
+		if(before[i] != after[i]) {
+			std::fprintf(stderr, "%s changed by set_permissions\n", REGISTERS[i]);
+			ok = false;
+		}
+	}
+
+	quint8 code_after[16];
+	ok = ok && core->read_bytes(code_address, code_after, sizeof(code_after)) && std::equal(code_before, code_before + sizeof(code_before), code_after);
+
+	regions.clear();
+	core->kill();
+
+	report("regions.set_permissions", elapsed / 1000.0, "ms");
+	return ok;
+}
+}
+
+//------------------------------------------------------------------------------
+// Name: main(int argc, char *argv[])
+// Desc:
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+
+	QCoreApplication app(argc, argv);
+
+	const int iterations = (argc > 1) ? std::atoi(argv[1]) : 20000;
+
+	core = new DebuggerCore;
+	edb::v1::debugger_core = core;
+
+	bool ok = true;
+	ok = benchmark_breakpoint_events(iterations) && ok;
+	ok = benchmark_conditional_breakpoints(iterations) && ok;
+	ok = benchmark_condition_evaluation(iterations * 50) && ok;
+	ok = benchmark_single_step(iterations) && ok;
+	ok = benchmark_memory(64) && ok;
+	ok = benchmark_attach("attach.single_thread", 1) && ok;
+	ok = benchmark_attach("attach.many_threads", 64) && ok;
+	ok = benchmark_region_sync(4096, 100) && ok;
+	ok = check_set_permissions() && ok;
+
+	edb::v1::debugger_core = 0;
+	delete core;
+
+	print_results(ok);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
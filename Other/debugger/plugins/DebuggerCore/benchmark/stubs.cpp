@@ -0,0 +1,90 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// the few edb::v1 symbols which the core (and the classes it uses) need when
+// it is linked without the rest of edb
+
+#include "Debugger.h"
+#include "MemoryRegions.h"
+#include "SymbolManagerInterface.h"
+#include <QString>
+
+DebuggerCoreInterface *edb::v1::debugger_core = 0;
+
+namespace {
+
+// MemoryRegions wants to load the symbols of every module it finds, that
+// isn't what is being measured
+class NullSymbolManager : public SymbolManagerInterface {
+public:
+	virtual const QList<Symbol::pointer> symbols() const                      { return QList<Symbol::pointer>(); }
+	virtual const Symbol::pointer find(const QString &) const                 { return Symbol::pointer(); }
+	virtual const Symbol::pointer find(edb::address_t) const                  { return Symbol::pointer(); }
+	virtual const Symbol::pointer find_near_symbol(edb::address_t) const      { return Symbol::pointer(); }
+	virtual void clear()                                                      {}
+	virtual void load_symbol_file(const QString &, edb::address_t)            {}
+	virtual void load_symbols(const QString &)                                {}
+	virtual void add_symbol(const Symbol::pointer &)                          {}
+};
+
+DebugEventHandlerInterface *event_handler = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: symbol_manager()
+// Desc:
+//------------------------------------------------------------------------------
+SymbolManagerInterface &edb::v1::symbol_manager() {
+	static NullSymbolManager symbol_manager;
+	return symbol_manager;
+}
+
+//------------------------------------------------------------------------------
+// Name: memory_regions()
+// Desc:
+//------------------------------------------------------------------------------
+MemoryRegions &edb::v1::memory_regions() {
+	static MemoryRegions regions;
+	return regions;
+}
+
+//------------------------------------------------------------------------------
+// Name: set_debug_event_handler(DebugEventHandlerInterface *p)
+// Desc:
+//------------------------------------------------------------------------------
+DebugEventHandlerInterface *edb::v1::set_debug_event_handler(DebugEventHandlerInterface *p) {
+	DebugEventHandlerInterface *const old = event_handler;
+	event_handler = p;
+	return old;
+}
+
+//------------------------------------------------------------------------------
+// Name: debug_event_handler()
+// Desc:
+//------------------------------------------------------------------------------
+DebugEventHandlerInterface *edb::v1::debug_event_handler() {
+	return event_handler;
+}
+
+//------------------------------------------------------------------------------
+// Name: format_pointer(edb::address_t p)
+// Desc:
+//------------------------------------------------------------------------------
+QString edb::v1::format_pointer(edb::address_t p) {
+	return QString("%1").arg(p, sizeof(edb::address_t) * 2, 16, QChar('0'));
+}
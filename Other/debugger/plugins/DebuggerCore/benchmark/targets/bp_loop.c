@@ -0,0 +1,40 @@
+/*
+ * calls hammer() in a tight loop, the benchmark puts a breakpoint on it
+ *
+ * usage: bp_loop <iterations> <fd>
+ *
+ * the address of hammer() is written to <fd> before the loop starts, then
+ * the program stops itself with a SIGTRAP so that the breakpoint can be set
+ */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+volatile unsigned long counter;
+
+__attribute__((noinline)) void hammer(void) {
+	++counter;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned long i;
+	const unsigned long iterations = (argc > 1) ? strtoul(argv[1], 0, 10) : 100000;
+	void (*fn)(void) = hammer;
+
+	if(argc > 2) {
+		const int fd = atoi(argv[2]);
+		if(write(fd, &fn, sizeof(fn)) != sizeof(fn)) {
+			return 1;
+		}
+		close(fd);
+	}
+
+	raise(SIGTRAP);
+
+	for(i = 0; i < iterations; ++i) {
+		hammer();
+	}
+
+	return 0;
+}
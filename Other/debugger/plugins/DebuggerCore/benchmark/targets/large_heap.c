@@ -0,0 +1,38 @@
+/*
+ * allocates (and touches) a large block of memory, the benchmark reads and
+ * writes it
+ *
+ * usage: large_heap <megabytes> <fd>
+ *
+ * the address and size of the block are written to <fd>, then the program
+ * stops itself with a SIGTRAP
+ */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]) {
+	const unsigned long size = ((argc > 1) ? strtoul(argv[1], 0, 10) : 64) << 20;
+	void *block = malloc(size);
+
+	if(block == 0) {
+		return 1;
+	}
+
+	memset(block, 0x5a, size);
+
+	if(argc > 2) {
+		const int fd = atoi(argv[2]);
+		if(write(fd, &block, sizeof(block)) != sizeof(block) || write(fd, &size, sizeof(size)) != sizeof(size)) {
+			return 1;
+		}
+		close(fd);
+	}
+
+	raise(SIGTRAP);
+
+	free(block);
+	return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * creates lots of small mappings, then changes one of them between each of
+ * a number of stops. The benchmark keeps its memory map up to date
+ *
+ * usage: many_maps <maps> <rounds>
+ *
+ * neighbouring mappings get different protections so that the kernel can't
+ * merge them. The program stops itself with a SIGTRAP once they are all in
+ * place and again after each change.
+ */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+int main(int argc, char *argv[]) {
+	int i;
+	const int maps   = (argc > 1) ? atoi(argv[1]) : 4096;
+	const int rounds = (argc > 2) ? atoi(argv[2]) : 100;
+	const long page_size = sysconf(_SC_PAGESIZE);
+	char **pages = malloc(maps * sizeof(char *));
+	char *area;
+
+	if(pages == 0 || maps < 1) {
+		return 1;
+	}
+
+	/* reserve one range up front so the mappings are all neighbours */
+	area = mmap(0, maps * page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(area == MAP_FAILED) {
+		return 1;
+	}
+
+	for(i = 0; i < maps; ++i) {
+		pages[i] = area + i * page_size;
+		if(i & 1) {
+			mprotect(pages[i], page_size, PROT_READ | PROT_WRITE);
+		}
+	}
+
+	raise(SIGTRAP);
+
+	for(i = 0; i < rounds; ++i) {
+		/* take a read-only page away, then give it back */
+		char *const page = pages[((i / 2) * 2) % maps];
+		mprotect(page, page_size, (i & 1) ? PROT_READ : PROT_NONE);
+		raise(SIGTRAP);
+	}
+
+	munmap(area, maps * page_size);
+	free(pages);
+	return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * starts a bunch of threads which wake up every millisecond, the benchmark
+ * attaches to it
+ *
+ * usage: many_threads <threads> <fd>
+ *
+ * a byte is written to <fd> once all of the threads are running
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void *worker(void *arg) {
+	(void)arg;
+	for(;;) {
+		usleep(1000);
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	int i;
+	const int threads = (argc > 1) ? atoi(argv[1]) : 64;
+
+	for(i = 1; i < threads; ++i) {
+		pthread_t thread;
+		if(pthread_create(&thread, 0, worker, 0) != 0) {
+			return 1;
+		}
+	}
+
+	if(argc > 2) {
+		const int fd = atoi(argv[2]);
+		const char ready = 1;
+		if(write(fd, &ready, sizeof(ready)) != sizeof(ready)) {
+			return 1;
+		}
+		close(fd);
+	}
+
+	worker(0);
+	return 0;
+}
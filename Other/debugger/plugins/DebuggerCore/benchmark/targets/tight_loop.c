@@ -0,0 +1,22 @@
+/*
+ * spins forever, the benchmark single steps it
+ *
+ * usage: tight_loop
+ *
+ * the program stops itself with a SIGTRAP before it starts spinning
+ */
+
+#include <signal.h>
+
+volatile unsigned long counter;
+
+int main(void) {
+
+	raise(SIGTRAP);
+
+	for(;;) {
+		++counter;
+	}
+
+	return 0;
+}
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Debugger.h"
 
 #include <QStringList>
+#include <algorithm>
 #include <cerrno>
 #include <climits>
 #include <csignal>
@@ -33,6 +34,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <unistd.h>
 
 namespace {
+	// reads larger than this are assumed to be scans and bypass the page cache
+	const std::size_t max_cached_read_pages = 64;
+
+	// the cache is simply flushed if a single stop touches more than this
+	const int max_cached_pages = 4096;
+
 	int selfpipe[2];
 	void (*old_sigchld_handler)(int sig, siginfo_t *, void *);
 
@@ -151,6 +158,14 @@ bool native::wait_for_sigchld(int msecs) {
 	return false;
 }
 
+//------------------------------------------------------------------------------
+// Name: sigchld_fd()
+// Desc: the end of the pipe which becomes readable when SIGCHLD is delivered
+//------------------------------------------------------------------------------
+int native::sigchld_fd() {
+	return selfpipe[0];
+}
+
 //------------------------------------------------------------------------------
 // Name: waitpid_timeout(pid_t pid, int *status, int options, int msecs, bool &timeout)
 // Desc:
@@ -172,7 +187,10 @@ pid_t native::waitpid_timeout(pid_t pid, int *status, int options, int msecs, bo
 // Name: DebuggerCoreUNIX()
 // Desc:
 //------------------------------------------------------------------------------
-DebuggerCoreUNIX::DebuggerCoreUNIX() {
+DebuggerCoreUNIX::DebuggerCoreUNIX() : cache_pid_(0), cache_hits_(0), cache_misses_(0), memory_generation_(1) {
+
+	std::fill(read_counters_, read_counters_ + PATH_COUNT, 0);
+	std::fill(write_counters_, write_counters_ + PATH_COUNT, 0);
 
 	// create a pipe and make it non-blocking
 	int r = ::pipe(selfpipe);
@@ -213,13 +231,10 @@ void DebuggerCoreUNIX::write_byte(edb::address_t address, quint8 value, bool &ok
 //------------------------------------------------------------------------------
 quint8 DebuggerCoreUNIX::read_byte(edb::address_t address, bool &ok) {
 
-	// TODO: handle if breakponts have a size more than 1!
-	const quint8 ret = read_byte_base(address, ok);
+	quint8 ret = read_byte_base(address, ok);
 
 	if(ok) {
-		if(const Breakpoint::pointer bp = find_breakpoint(address)) {
-			return bp->original_bytes()[0];
-		}
+		apply_breakpoint_overlay(address, &ret, 1);
 	}
 
 	return ret;
@@ -313,11 +328,233 @@ quint8 DebuggerCoreUNIX::read_byte_base(edb::address_t address, bool &ok) {
 	return 0xff;
 }
 
+//------------------------------------------------------------------------------
+// Name: read_block(edb::address_t address, void *buf, std::size_t len, transfer_path &path)
+// Desc: the default implementation has no bulk transfer mechanism
+//------------------------------------------------------------------------------
+std::size_t DebuggerCoreUNIX::read_block(edb::address_t address, void *buf, std::size_t len, transfer_path &path) {
+	Q_UNUSED(address);
+	Q_UNUSED(buf);
+	Q_UNUSED(len);
+	Q_UNUSED(path);
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_block(edb::address_t address, const void *buf, std::size_t len, transfer_path &path)
+// Desc: the default implementation has no bulk transfer mechanism
+//------------------------------------------------------------------------------
+std::size_t DebuggerCoreUNIX::write_block(edb::address_t address, const void *buf, std::size_t len, transfer_path &path) {
+	Q_UNUSED(address);
+	Q_UNUSED(buf);
+	Q_UNUSED(len);
+	Q_UNUSED(path);
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_words(edb::address_t address, const quint8 *buf, std::size_t len)
+// Desc: writes <len> bytes using word sized writes, the words are aligned so
+//       that none of them straddle a page boundary. Only the (at most two)
+//       words which are partially covered need to be read first.
+// Note: [address, address + len) is expected to lie within a single page
+//------------------------------------------------------------------------------
+bool DebuggerCoreUNIX::write_words(edb::address_t address, const quint8 *buf, std::size_t len) {
+
+	const edb::address_t end_address = address + len;
+	edb::address_t word_address      = address & ~static_cast<edb::address_t>(EDB_WORDSIZE - 1);
+
+	while(word_address < end_address) {
+
+		const edb::address_t first = qMax(word_address, address);
+		const edb::address_t last  = qMin(word_address + EDB_WORDSIZE, end_address);
+
+		long v = 0;
+		if(last - first != EDB_WORDSIZE) {
+			bool ok;
+			v = read_data(word_address, ok);
+			if(!ok) {
+				return false;
+			}
+		}
+
+		quint8 *const word = reinterpret_cast<quint8 *>(&v);
+		std::memcpy(word + (first - word_address), buf + (first - address), last - first);
+
+		if(!write_data(word_address, v)) {
+			return false;
+		}
+
+		word_address += EDB_WORDSIZE;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_words(edb::address_t address, quint8 *buf, std::size_t len)
+// Desc: reads <len> bytes using word sized reads, the words are aligned so
+//       that none of them straddle a page boundary
+// Note: [address, address + len) is expected to lie within a single page
+//------------------------------------------------------------------------------
+bool DebuggerCoreUNIX::read_words(edb::address_t address, quint8 *buf, std::size_t len) {
+
+	const edb::address_t end_address = address + len;
+	edb::address_t word_address      = address & ~static_cast<edb::address_t>(EDB_WORDSIZE - 1);
+
+	while(word_address < end_address) {
+		bool ok;
+		const long v = read_data(word_address, ok);
+		if(!ok) {
+			return false;
+		}
+
+		const quint8 *const word = reinterpret_cast<const quint8 *>(&v);
+		const edb::address_t first = qMax(word_address, address);
+		const edb::address_t last  = qMin(word_address + EDB_WORDSIZE, end_address);
+
+		std::memcpy(buf + (first - address), word + (first - word_address), last - first);
+		word_address += EDB_WORDSIZE;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_range(edb::address_t address, quint8 *buf, std::size_t len)
+// Desc: reads <len> bytes of raw process memory (no breakpoint fixups)
+//       the platform's bulk mechanism is tried first, anything it could not
+//       deliver is retried one page at a time with ptrace. Pages which cannot
+//       be read at all are filled with 0xff bytes.
+// Note: returns false if any part of the range was unreadable
+//------------------------------------------------------------------------------
+bool DebuggerCoreUNIX::read_range(edb::address_t address, quint8 *buf, std::size_t len) {
+
+	bool ret = true;
+
+	while(len != 0) {
+		transfer_path path = PATH_PTRACE;
+		std::size_t n = read_block(address, buf, len, path);
+
+		if(n == 0) {
+			// the bulk path couldn't help with this page, so it is either
+			// unsupported or the page is inaccessible, do this page the slow way
+			const edb::address_t page_end = (address & ~(page_size() - 1)) + page_size();
+			n = qMin<std::size_t>(len, page_end - address);
+
+			path = PATH_PTRACE;
+			if(!read_words(address, buf, n)) {
+				std::memset(buf, 0xff, n);
+				ret = false;
+			}
+		}
+
+		++read_counters_[path];
+
+		address += n;
+		buf     += n;
+		len     -= n;
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_cached(edb::address_t address, quint8 *buf, std::size_t len)
+// Desc: like read_range, but pages are served from (and added to) the page
+//       cache. The cache holds the raw contents of the process, so breakpoint
+//       fixups still need to be applied by the caller.
+//------------------------------------------------------------------------------
+bool DebuggerCoreUNIX::read_cached(edb::address_t address, quint8 *buf, std::size_t len) {
+
+	if(cache_pid_ != pid()) {
+		invalidate_cache();
+		cache_pid_ = pid();
+	}
+
+	const edb::address_t page_mask = ~(page_size() - 1);
+	const edb::address_t last_page = (address + len - 1) & page_mask;
+
+	// big reads are almost always region scans, those would just evict
+	// everything the views care about, so let them go straight to the process
+	if(((last_page - (address & page_mask)) / page_size()) + 1 > max_cached_read_pages) {
+		return read_range(address, buf, len);
+	}
+
+	bool ret = true;
+
+	while(len != 0) {
+		const edb::address_t page = address & page_mask;
+		const std::size_t offset  = address - page;
+		const std::size_t n       = qMin<std::size_t>(len, page_size() - offset);
+
+		page_cache_t::const_iterator it = page_cache_.find(page);
+		if(it != page_cache_.end()) {
+			++cache_hits_;
+		} else {
+			++cache_misses_;
+
+			if(page_cache_.size() >= max_cached_pages) {
+				page_cache_.clear();
+			}
+
+			// unreadable pages are cached too (as an empty array) so that we
+			// don't keep asking the kernel for them
+			QByteArray bytes(page_size(), 0);
+			if(!read_range(page, reinterpret_cast<quint8 *>(bytes.data()), page_size())) {
+				bytes.clear();
+			}
+			it = page_cache_.insert(page, bytes);
+		}
+
+		if(it->isEmpty()) {
+			std::memset(buf, 0xff, n);
+			ret = false;
+		} else {
+			std::memcpy(buf, it->constData() + offset, n);
+		}
+
+		address += n;
+		buf     += n;
+		len     -= n;
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: invalidate_cache()
+// Desc: forgets everything we know about the process's memory
+//------------------------------------------------------------------------------
+void DebuggerCoreUNIX::invalidate_cache() {
+	page_cache_.clear();
+	++memory_generation_;
+}
+
+//------------------------------------------------------------------------------
+// Name: invalidate_cache(edb::address_t address, std::size_t len)
+// Desc: forgets the pages which overlap [address, address + len)
+//------------------------------------------------------------------------------
+void DebuggerCoreUNIX::invalidate_cache(edb::address_t address, std::size_t len) {
+	++memory_generation_;
+	if(len != 0 && !page_cache_.isEmpty()) {
+		const edb::address_t page_mask = ~(page_size() - 1);
+		const edb::address_t last_page = (address + len - 1) & page_mask;
+		for(edb::address_t page = address & page_mask; ; page += page_size()) {
+			page_cache_.remove(page);
+			if(page == last_page) {
+				break;
+			}
+		}
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: read_pages(edb::address_t address, void *buf, std::size_t count)
 // Desc: reads <count> pages from the process starting at <address>
 // Note: buf's size must be >= count * page_size()
 // Note: address should be page aligned.
+// Note: pages which could not be read are filled with 0xff bytes
 //------------------------------------------------------------------------------
 bool DebuggerCoreUNIX::read_pages(edb::address_t address, void *buf, std::size_t count) {
 
@@ -327,36 +564,19 @@ bool DebuggerCoreUNIX::read_pages(edb::address_t address, void *buf, std::size_t
 		return false;
 	}
 
+	bool ok = true;
+
 	if((address & (page_size() - 1)) == 0) {
 		const edb::address_t orig_address = address;
-		long *ptr                         = reinterpret_cast<long *>(buf);
 		quint8 *const orig_ptr            = reinterpret_cast<quint8 *>(buf);
 
-		const edb::address_t end_address  = orig_address + page_size() * count;
-
-		for(std::size_t c = 0; c < count; ++c) {
-			for(edb::address_t i = 0; i < page_size(); i += EDB_WORDSIZE) {
-				bool ok;
-				const long v = read_data(address, ok);
-				if(!ok) {
-					return false;
-				}
-
-				*ptr++ = v;
-				address += EDB_WORDSIZE;
-			}
-		}
+		ok = read_cached(address, orig_ptr, page_size() * count);
 
-		// TODO: handle if breakponts have a size more than 1!
-		Q_FOREACH(const Breakpoint::pointer &bp, breakpoints_) {
-			if(bp->address() >= orig_address && bp->address() < end_address) {
-				// show the original bytes in the buffer..
-				orig_ptr[bp->address() - orig_address] = bp->original_bytes()[0];
-			}
-		}
+		// show the original bytes in the buffer..
+		apply_breakpoint_overlay(orig_address, orig_ptr, page_size() * count);
 	}
 
-	return true;
+	return ok;
 }
 
 //------------------------------------------------------------------------------
@@ -374,23 +594,10 @@ bool DebuggerCoreUNIX::read_bytes(edb::address_t address, void *buf, std::size_t
 	}
 
 	if(len != 0) {
-		bool ok;
-		quint8 *p = reinterpret_cast<quint8 *>(buf);
-		quint8 ch = read_byte(address, ok);
-
-		while(ok && len) {
-			*p++ = ch;
-			if(--len) {
-				++address;
-				ch = read_byte(address, ok);
-			}
-		}
+		quint8 *const p = reinterpret_cast<quint8 *>(buf);
 
-		if(!ok) {
-			while(len--) {
-				*p++ = 0xff;
-			}
-		}
+		read_cached(address, p, len);
+		apply_breakpoint_overlay(address, p, len);
 	}
 
 	return true;
@@ -408,11 +615,30 @@ bool DebuggerCoreUNIX::write_bytes(edb::address_t address, const void *buf, std:
 	if(attached()) {
 		const quint8 *p = reinterpret_cast<const quint8 *>(buf);
 
-		while(len--) {
-			write_byte(address++, *p++, ok);
-			if(!ok) {
-				break;
+		invalidate_cache(address, len);
+
+		ok = true;
+		while(len != 0) {
+			transfer_path path = PATH_PTRACE;
+			std::size_t n = write_block(address, p, len, path);
+
+			if(n == 0) {
+				// no bulk path for this page, poke it a word at a time
+				const edb::address_t page_end = (address & ~(page_size() - 1)) + page_size();
+				n = qMin<std::size_t>(len, page_end - address);
+
+				path = PATH_PTRACE;
+				if(!write_words(address, p, n)) {
+					ok = false;
+					break;
+				}
 			}
+
+			++write_counters_[path];
+
+			address += n;
+			p       += n;
+			len     -= n;
 		}
 	}
 	return ok;
@@ -466,3 +692,49 @@ void DebuggerCoreUNIX::execute_process(const QString &path, const QString &cwd,
 int DebuggerCoreUNIX::pointer_size() const {
 	return sizeof(void *);
 }
+
+//------------------------------------------------------------------------------
+// Name: statistics() const
+// Desc: returns how many memory transfers each mechanism has served
+//------------------------------------------------------------------------------
+QHash<QString, quint64> DebuggerCoreUNIX::statistics() const {
+	QHash<QString, quint64> ret;
+	ret.insert("memory.read.ptrace",              read_counters_[PATH_PTRACE]);
+	ret.insert("memory.read.proc_mem",            read_counters_[PATH_PROC_MEM]);
+	ret.insert("memory.read.process_vm_readv",    read_counters_[PATH_PROCESS_VM]);
+	ret.insert("memory.write.ptrace",             write_counters_[PATH_PTRACE]);
+	ret.insert("memory.write.proc_mem",           write_counters_[PATH_PROC_MEM]);
+	ret.insert("memory.write.process_vm_writev",  write_counters_[PATH_PROCESS_VM]);
+	ret.insert("cache.hits",                      cache_hits_);
+	ret.insert("cache.misses",                    cache_misses_);
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_breakpoint(edb::address_t address)
+// Desc: creates a new breakpoint, dropping any cached copy of the memory
+//       it patches
+//------------------------------------------------------------------------------
+Breakpoint::pointer DebuggerCoreUNIX::add_breakpoint(edb::address_t address) {
+	invalidate_cache(address, breakpoint_size());
+	return DebuggerCoreBase::add_breakpoint(address);
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_breakpoint(edb::address_t address)
+// Desc: removes a breakpoint, dropping any cached copy of the memory it
+//       patched
+//------------------------------------------------------------------------------
+void DebuggerCoreUNIX::remove_breakpoint(edb::address_t address) {
+	invalidate_cache(address, breakpoint_size());
+	DebuggerCoreBase::remove_breakpoint(address);
+}
+
+//------------------------------------------------------------------------------
+// Name: clear_breakpoints()
+// Desc: removes all breakpoints
+//------------------------------------------------------------------------------
+void DebuggerCoreUNIX::clear_breakpoints() {
+	invalidate_cache();
+	DebuggerCoreBase::clear_breakpoints();
+}
@@ -20,6 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DEBUGGERCOREUNIX_20090529_H_
 
 #include "DebuggerCoreBase.h"
+#include <QByteArray>
+#include <QHash>
 #include <QList>
 
 #define SET_OK(ok, v) do { (ok) = ((v) != -1) || (errno == 0); } while(0)
@@ -34,6 +36,7 @@ namespace native {
 	ssize_t read(int fd, void *buf, size_t count);
 	ssize_t write(int fd, const void *buf, size_t count);
 	bool wait_for_sigchld(int msecs);
+	int sigchld_fd();
 }
 
 class DebuggerCoreUNIX : public DebuggerCoreBase {
@@ -41,22 +44,69 @@ public:
 	DebuggerCoreUNIX();
 	virtual ~DebuggerCoreUNIX() {}
 
+protected:
+	// the mechanisms which may be used to move memory to/from the debugee
+	enum transfer_path {
+		PATH_PTRACE,
+		PATH_PROC_MEM,
+		PATH_PROCESS_VM,
+		PATH_COUNT
+	};
+
 protected:
 	quint8 read_byte(edb::address_t address, bool &ok);
 	quint8 read_byte_base(edb::address_t address, bool &ok);
 	void execute_process(const QString &path, const QString &cwd, const QStringList &args);
 	void write_byte(edb::address_t address, quint8 value, bool &ok);
 	void write_byte_base(edb::address_t address, quint8 value, bool &ok);
+	bool read_range(edb::address_t address, quint8 *buf, std::size_t len);
+	bool read_words(edb::address_t address, quint8 *buf, std::size_t len);
+	bool read_cached(edb::address_t address, quint8 *buf, std::size_t len);
+	bool write_words(edb::address_t address, const quint8 *buf, std::size_t len);
+
+protected:
+	// the page cache is only valid while the debugee is stopped, platforms
+	// must call this before letting it run again
+	void invalidate_cache();
+	void invalidate_cache(edb::address_t address, std::size_t len);
 
 public:
 	virtual bool read_pages(edb::address_t address, void *buf, std::size_t count);
 	virtual bool read_bytes(edb::address_t address, void *buf, std::size_t len);
 	virtual bool write_bytes(edb::address_t address, const void *buf, std::size_t len);
 	virtual int pointer_size() const;
+	virtual QHash<QString, quint64> statistics() const;
+	virtual quint64 memory_generation() const { return memory_generation_; }
+
+public:
+	virtual Breakpoint::pointer add_breakpoint(edb::address_t address);
+	virtual void clear_breakpoints();
+	virtual void remove_breakpoint(edb::address_t address);
 
 protected:
 	virtual long read_data(edb::address_t address, bool &ok) = 0;
 	virtual bool write_data(edb::address_t address, long value) = 0;
+
+	// optional bulk transfer, returns the number of bytes which could be read
+	// starting at <address>, 0 means that the caller should fall back to ptrace
+	virtual std::size_t read_block(edb::address_t address, void *buf, std::size_t len, transfer_path &path);
+
+	// optional bulk transfer, returns the number of bytes which could be
+	// written starting at <address>, 0 means that the caller should fall back
+	// to ptrace
+	virtual std::size_t write_block(edb::address_t address, const void *buf, std::size_t len, transfer_path &path);
+
+private:
+	typedef QHash<edb::address_t, QByteArray> page_cache_t;
+
+private:
+	quint64      read_counters_[PATH_COUNT];
+	quint64      write_counters_[PATH_COUNT];
+	page_cache_t page_cache_;
+	edb::pid_t   cache_pid_;
+	quint64      cache_hits_;
+	quint64      cache_misses_;
+	quint64      memory_generation_; // bumped along with every cache invalidation
 };
 
 #endif
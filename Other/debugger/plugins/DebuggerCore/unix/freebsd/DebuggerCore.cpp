@@ -202,6 +202,8 @@ void DebuggerCore::resume(edb::EVENT_STATUS status) {
 
 	if(attached()) {
 		if(status != edb::DEBUG_STOP) {
+			invalidate_cache();
+
 			const edb::tid_t tid = active_thread();
 			const int code = (status == edb::DEBUG_EXCEPTION_NOT_HANDLED) ? resume_code(threads_[tid].status) : 0;
 			ptrace(PT_CONTINUE, tid, reinterpret_cast<caddr_t>(1), code);
@@ -218,6 +220,8 @@ void DebuggerCore::step(edb::EVENT_STATUS status) {
 
 	if(attached()) {
 		if(status != edb::DEBUG_STOP) {
+			invalidate_cache();
+
 			const edb::tid_t tid = active_thread();
 			const int code = (status == edb::DEBUG_EXCEPTION_NOT_HANDLED) ? resume_code(threads_[tid].status) : 0;
 			ptrace(PT_STEP, tid, reinterpret_cast<caddr_t>(1), code);
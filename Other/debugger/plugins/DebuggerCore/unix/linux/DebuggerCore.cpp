@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DebuggerCore.h"
+#include "EventWaiter.h"
 #include "State.h"
 #include "DebugEvent.h"
 #include "PlatformState.h"
@@ -24,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDebug>
 #include <QDir>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <csignal>
@@ -33,9 +35,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #endif
 
 #include <asm/ldt.h>
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/ptrace.h>
 #include <sys/syscall.h>   /* For SYS_xxx definitions */
+#include <sys/uio.h>
 #include <sys/user.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -52,10 +56,26 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PTRACE_SET_THREAD_AREA static_cast<__ptrace_request>(26)
 #endif
 
+// linux 3.4+
+#ifndef PTRACE_SEIZE
+#define PTRACE_SEIZE static_cast<__ptrace_request>(0x4206)
+#endif
+
+#ifndef PTRACE_INTERRUPT
+#define PTRACE_INTERRUPT static_cast<__ptrace_request>(0x4207)
+#endif
+
+#ifndef PTRACE_EVENT_STOP
+#define PTRACE_EVENT_STOP 128
+#endif
+
 #define DEBUG_THREADS
 
 namespace {
 
+// the most iovecs we will hand to process_vm_readv/writev in one call (IOV_MAX)
+const std::size_t max_iovecs = 1024;
+
 //------------------------------------------------------------------------------
 // Name: resume_code(int status)
 // Desc:
@@ -66,6 +86,11 @@ int resume_code(int status) {
 		return 0;
 	}
 
+	// ptrace event stops (clone, exec, interrupt...) don't carry a signal
+	if(WIFSTOPPED(status) && (status >> 16) != 0) {
+		return 0;
+	}
+
 	if(WIFSIGNALED(status)) {
 		return WTERMSIG(status);
 	}
@@ -88,13 +113,57 @@ bool is_clone_event(int status) {
 
 	return false;
 }
+
+//------------------------------------------------------------------------------
+// Name: is_exec_event(int status)
+// Desc:
+//------------------------------------------------------------------------------
+bool is_exec_event(int status) {
+	if(WIFSTOPPED(status) && WSTOPSIG(status) == SIGTRAP) {
+		return (((status >> 16) & 0xffff) == PTRACE_EVENT_EXEC);
+	}
+
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_stop_event(int status)
+// Desc: the stop which PTRACE_INTERRUPT (or a group-stop) produces in a
+//       thread which was attached with PTRACE_SEIZE
+//------------------------------------------------------------------------------
+bool is_stop_event(int status) {
+	return WIFSTOPPED(status) && (((status >> 16) & 0xffff) == PTRACE_EVENT_STOP);
+}
+
+//------------------------------------------------------------------------------
+// Name: trace_options()
+// Desc: the ptrace options every thread gets
+//------------------------------------------------------------------------------
+long trace_options() {
+#ifdef DEBUG_THREADS
+	return PTRACE_O_TRACECLONE | PTRACE_O_TRACEEXEC;
+#else
+	return PTRACE_O_TRACEEXEC;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Name: thread_less
+// Desc: orders thread_info like records by tid (for binary searches)
+//------------------------------------------------------------------------------
+struct thread_less {
+	template <class T>
+	bool operator()(const T &thread, edb::tid_t tid) const {
+		return thread.tid < tid;
+	}
+};
 }
 
 //------------------------------------------------------------------------------
 // Name: DebuggerCore()
 // Desc: constructor
 //------------------------------------------------------------------------------
-DebuggerCore::DebuggerCore() {
+DebuggerCore::DebuggerCore() : waiter_(new EventWaiter(this)), proc_mem_fd_(-1), proc_mem_writable_(false), use_process_vm_(true), seized_(false), state_cache_tid_(0), state_generation_(0) {
 #if defined(_SC_PAGESIZE)
 	page_size_ = sysconf(_SC_PAGESIZE);
 #elif defined(_SC_PAGE_SIZE)
@@ -102,6 +171,9 @@ DebuggerCore::DebuggerCore() {
 #else
 	page_size_ = PAGE_SIZE;
 #endif
+
+	connect(waiter_, SIGNAL(event_ready()), this, SIGNAL(debug_event_ready()));
+	waiter_->start();
 }
 
 //------------------------------------------------------------------------------
@@ -127,6 +199,7 @@ edb::address_t DebuggerCore::page_size() const {
 //------------------------------------------------------------------------------
 DebuggerCore::~DebuggerCore() {
 	detach();
+	waiter_->shutdown();
 }
 
 //------------------------------------------------------------------------------
@@ -137,25 +210,45 @@ long DebuggerCore::ptrace_traceme() {
 	return ptrace(PTRACE_TRACEME, 0, 0, 0);
 }
 
+//------------------------------------------------------------------------------
+// Name: arm_waiter()
+// Desc: has the waiter report the next event from any of our threads
+//------------------------------------------------------------------------------
+void DebuggerCore::arm_waiter() {
+	QList<edb::tid_t> tids = thread_ids();
+	if(tids.isEmpty()) {
+		tids.push_back(pid());
+	}
+	waiter_->arm(pid(), tids);
+}
+
 //------------------------------------------------------------------------------
 // Name: ptrace_continue(edb::tid_t tid, long status)
-// Desc:
+// Desc: the caller arms the waiter once it is done letting threads go
 //------------------------------------------------------------------------------
 long DebuggerCore::ptrace_continue(edb::tid_t tid, long status) {
-	Q_ASSERT(waited_threads_.contains(tid));
+	thread_info *const thread = find_thread(tid);
+	Q_ASSERT(thread && thread->stopped);
 	Q_ASSERT(tid != 0);
-	waited_threads_.remove(tid);
+	if(thread) {
+		thread->stopped = false;
+	}
+	++state_generation_;
 	return ptrace(PTRACE_CONT, tid, 0, status);
 }
 
 //------------------------------------------------------------------------------
 // Name: ptrace_step(edb::tid_t tid, long status)
-// Desc:
+// Desc: the caller arms the waiter once it is done letting threads go
 //------------------------------------------------------------------------------
 long DebuggerCore::ptrace_step(edb::tid_t tid, long status) {
-	Q_ASSERT(waited_threads_.contains(tid));
+	thread_info *const thread = find_thread(tid);
+	Q_ASSERT(thread && thread->stopped);
 	Q_ASSERT(tid != 0);
-	waited_threads_.remove(tid);
+	if(thread) {
+		thread->stopped = false;
+	}
+	++state_generation_;
 	return ptrace(PTRACE_SINGLESTEP, tid, 0, status);
 }
 
@@ -164,7 +257,7 @@ long DebuggerCore::ptrace_step(edb::tid_t tid, long status) {
 // Desc:
 //------------------------------------------------------------------------------
 long DebuggerCore::ptrace_set_options(edb::tid_t tid, long options) {
-	Q_ASSERT(waited_threads_.contains(tid));
+	Q_ASSERT(find_thread(tid) && find_thread(tid)->stopped);
 	Q_ASSERT(tid != 0);
 	return ptrace(PTRACE_SETOPTIONS, tid, 0, options);
 }
@@ -174,25 +267,87 @@ long DebuggerCore::ptrace_set_options(edb::tid_t tid, long options) {
 // Desc:
 //------------------------------------------------------------------------------
 long DebuggerCore::ptrace_get_event_message(edb::tid_t tid, unsigned long *message) {
-	Q_ASSERT(waited_threads_.contains(tid));
+	Q_ASSERT(find_thread(tid) && find_thread(tid)->stopped);
 	Q_ASSERT(tid != 0);
 	return ptrace(PTRACE_GETEVENTMSG, tid, 0, message);
 }
 
+//------------------------------------------------------------------------------
+// Name: find_thread(edb::tid_t tid)
+// Desc: returns the thread's record, or NULL if it isn't one of ours
+//------------------------------------------------------------------------------
+DebuggerCore::thread_info *DebuggerCore::find_thread(edb::tid_t tid) {
+	const threadlist_t::iterator it = std::lower_bound(threads_.begin(), threads_.end(), tid, thread_less());
+	return (it != threads_.end() && it->tid == tid) ? &*it : 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_thread(edb::tid_t tid) const
+// Desc:
+//------------------------------------------------------------------------------
+const DebuggerCore::thread_info *DebuggerCore::find_thread(edb::tid_t tid) const {
+	const threadlist_t::const_iterator it = std::lower_bound(threads_.begin(), threads_.end(), tid, thread_less());
+	return (it != threads_.end() && it->tid == tid) ? &*it : 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: add_thread(edb::tid_t tid)
+// Desc: returns the thread's record, creating it if needed
+// Note: this invalidates pointers returned by find_thread
+//------------------------------------------------------------------------------
+DebuggerCore::thread_info &DebuggerCore::add_thread(edb::tid_t tid) {
+	threadlist_t::iterator it = std::lower_bound(threads_.begin(), threads_.end(), tid, thread_less());
+	if(it == threads_.end() || it->tid != tid) {
+		it = threads_.insert(it, thread_info(tid));
+	}
+	return *it;
+}
+
+//------------------------------------------------------------------------------
+// Name: remove_thread(edb::tid_t tid)
+// Desc:
+//------------------------------------------------------------------------------
+void DebuggerCore::remove_thread(edb::tid_t tid) {
+	const threadlist_t::iterator it = std::lower_bound(threads_.begin(), threads_.end(), tid, thread_less());
+	if(it != threads_.end() && it->tid == tid) {
+		threads_.erase(it);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: thread_ids() const
+// Desc:
+//------------------------------------------------------------------------------
+QList<edb::tid_t> DebuggerCore::thread_ids() const {
+	QList<edb::tid_t> ret;
+	ret.reserve(threads_.size());
+	for(threadlist_t::const_iterator it = threads_.begin(); it != threads_.end(); ++it) {
+		ret.push_back(it->tid);
+	}
+	return ret;
+}
+
 //------------------------------------------------------------------------------
 // Name: handle_event(DebugEvent &event, edb::tid_t tid, int status)
 // Desc:
 //------------------------------------------------------------------------------
 bool DebuggerCore::handle_event(DebugEvent &event, edb::tid_t tid, int status) {
 
+	thread_info *thread = find_thread(tid);
+	if(!thread) {
+		// waitpid only gives us our own threads, so this is one whose creation
+		// we missed. Keep track of it from now on
+		qDebug("[DebuggerCore] warning, event from unknown thread: %d", static_cast<int>(tid));
+		thread = &add_thread(tid);
+	}
+
 	// note that we have waited on this thread
-	waited_threads_.insert(tid);
+	thread->stopped = true;
 
 #ifdef DEBUG_THREADS
 	// was it a thread exit event?
 	if(WIFEXITED(status)) {
-		threads_.remove(tid);
-		waited_threads_.remove(tid);
+		remove_thread(tid);
 
 		// if this was the last thread, return true
 		// so we report it to the user.
@@ -201,28 +356,27 @@ bool DebuggerCore::handle_event(DebugEvent &event, edb::tid_t tid, int status) {
 		return threads_.empty();
 	}
 
-	// was it a thread create event?
-	if(is_clone_event(status)) {
-
-		unsigned long new_tid;
-		if(ptrace_get_event_message(tid, &new_tid) != -1) {
+	// the first stop of a new thread, let it get going
+	if(thread->starting) {
+		thread->starting = false;
 
-			threads_.insert(new_tid, thread_info(0));
-
-			int thread_status = 0;
-			if(!waited_threads_.contains(new_tid)) {
-				if(native::waitpid(new_tid, &thread_status, __WALL) > 0) {
-					waited_threads_.insert(new_tid);
-				}
-			}
+		if(!(seized_ ? is_stop_event(status) : (WIFSTOPPED(status) && WSTOPSIG(status) == SIGSTOP))) {
+			qDebug("[warning] new thread [%d] received an event besides its initial stop", static_cast<int>(tid));
+		}
 
-			if(!WIFSTOPPED(thread_status) || WSTOPSIG(thread_status) != SIGSTOP) {
-				qDebug("[warning] new thread [%d] received an event besides SIGSTOP", static_cast<int>(new_tid));
-			}
+		// TODO: what the heck do we do if this isn't the initial stop?
+		ptrace_continue(tid, resume_code(status));
+		return false;
+	}
 
+	// was it a thread create event?
+	if(is_clone_event(status)) {
 
-			// TODO: what the heck do we do if this isn't a SIGSTOP?
-			ptrace_continue(new_tid, resume_code(thread_status));
+		// the new thread reports its first stop on its own, we pick that up
+		// like any other event rather than waiting for it here
+		unsigned long new_tid;
+		if(ptrace_get_event_message(tid, &new_tid) != -1 && !find_thread(new_tid)) {
+			add_thread(new_tid).starting = true;
 		}
 
 		ptrace_continue(tid, 0);
@@ -230,11 +384,20 @@ bool DebuggerCore::handle_event(DebugEvent &event, edb::tid_t tid, int status) {
 	}
 #endif
 
+	// an interrupt which was overtaken by another event when we stopped the
+	// threads, it isn't interesting to the user. Any other PTRACE_EVENT_STOP
+	// is a group-stop (someone sent a SIGSTOP, pause() does) so that we report
+	if(seized_ && is_stop_event(status) && thread->interrupted) {
+		thread->interrupted = false;
+		ptrace_continue(tid, 0);
+		return false;
+	}
+
 	// normal event
-	event                = DebugEvent(status, pid(), tid);
-	active_thread_       = tid;
-	event_thread_        = tid;
-	threads_[tid].status = status;
+	event          = DebugEvent(status, pid(), tid);
+	active_thread_ = tid;
+	event_thread_  = tid;
+	thread->status = status;
 
 	stop_threads();
 	return true;
@@ -242,23 +405,46 @@ bool DebuggerCore::handle_event(DebugEvent &event, edb::tid_t tid, int status) {
 
 //------------------------------------------------------------------------------
 // Name: stop_threads()
-// Desc:
+// Desc: stops every thread which is still running. All of the stop requests
+//       go out before any of the stops are collected, so the cost is about
+//       that of stopping the slowest thread rather than the sum of them all
 //------------------------------------------------------------------------------
 void DebuggerCore::stop_threads() {
 #ifdef DEBUG_THREADS
-	for(threadmap_t::iterator it = threads_.begin(); it != threads_.end(); ++it) {
-		if(!waited_threads_.contains(it.key())) {
-			const edb::tid_t tid = it.key();
+	QVector<edb::tid_t> pending;
+	pending.reserve(threads_.size());
 
-			tgkill(pid(), tid, SIGSTOP);
+	for(threadlist_t::const_iterator it = threads_.begin(); it != threads_.end(); ++it) {
+		if(!it->stopped) {
+			if(seized_) {
+				ptrace(PTRACE_INTERRUPT, it->tid, 0, 0);
+			} else {
+				tgkill(pid(), it->tid, SIGSTOP);
+			}
+			pending.push_back(it->tid);
+		}
+	}
 
-			int thread_status;
-			if(native::waitpid(tid, &thread_status, __WALL) > 0) {
-				waited_threads_.insert(tid);
-				it->status = thread_status;
+	Q_FOREACH(edb::tid_t tid, pending) {
+		int thread_status;
+		if(native::waitpid(tid, &thread_status, __WALL) > 0) {
 
-				if(!WIFSTOPPED(thread_status) || WSTOPSIG(thread_status) != SIGSTOP) {
-					qDebug("[warning] paused thread [%d] received an event besides SIGSTOP", tid);
+			if(WIFEXITED(thread_status) || WIFSIGNALED(thread_status)) {
+				remove_thread(tid);
+				continue;
+			}
+
+			if(thread_info *const thread = find_thread(tid)) {
+				thread->stopped  = true;
+				thread->starting = false;
+				thread->status   = thread_status;
+
+				if(!(seized_ ? is_stop_event(thread_status) : (WIFSTOPPED(thread_status) && WSTOPSIG(thread_status) == SIGSTOP))) {
+					qDebug("[warning] paused thread [%d] received an event besides the stop", tid);
+
+					// the interrupt is still pending, it will show up once
+					// the thread is resumed
+					thread->interrupted = seized_;
 				}
 			}
 		}
@@ -270,12 +456,36 @@ void DebuggerCore::stop_threads() {
 // Name: wait_debug_event(DebugEvent &event, int msecs)
 // Desc: waits for a debug event, msecs is a timeout
 //      it will return false if an error or timeout occurs
+// Note: the waiter thread tells us which thread has an event, so unless it
+//       is one we don't know about yet, this is a single waitpid
 //------------------------------------------------------------------------------
 bool DebuggerCore::wait_debug_event(DebugEvent &event, int msecs) {
 
 	if(attached()) {
-		if(!native::wait_for_sigchld(msecs)) {
+		edb::tid_t event_tid;
+		if(waiter_->wait_for_event(msecs, event_tid)) {
+
+#ifdef DEBUG_THREADS
+			// a new thread can report in before its parent's clone event
+			// does, we'll know it by the time the parent's event arrives
+			if(!find_thread(event_tid)) {
+				int status;
+				if(native::waitpid(event_tid, &status, __WALL | WNOHANG) > 0) {
+					add_thread(event_tid).starting = true;
+					handle_event(event, event_tid, status);
+				}
+			} else
+#endif
+			{
+				int status;
+				const edb::tid_t tid = native::waitpid(event_tid, &status, __WALL | WNOHANG);
+				if(tid > 0 && handle_event(event, tid, status)) {
+					return true;
+				}
+			}
+
 #ifdef DEBUG_THREADS
+			// check the rest of the threads we know about too
 			Q_FOREACH(edb::tid_t thread, thread_ids()) {
 				int status;
 				const edb::tid_t tid = native::waitpid(thread, &status, __WALL | WNOHANG);
@@ -283,13 +493,9 @@ bool DebuggerCore::wait_debug_event(DebugEvent &event, int msecs) {
 					return true;
 				}
 			}
-#else
-			int status;
-			const edb::tid_t tid = native::waitpid(pid(), &status, __WALL | WNOHANG);
-			if(tid > 0 && handle_event(event, tid, status)) {
-				return true;
-			}
 #endif
+			// nothing we can report yet, keep listening
+			arm_waiter();
 		}
 	}
 	return false;
@@ -316,23 +522,185 @@ bool DebuggerCore::write_data(edb::address_t address, long value) {
 	return ptrace(PTRACE_POKETEXT, pid(), address, value) != -1;
 }
 
+//------------------------------------------------------------------------------
+// Name: read_block(edb::address_t address, void *buf, std::size_t len, transfer_path &path)
+// Desc: reads as much of the range as possible with a single syscall
+//       process_vm_readv is preferred, but it honors page protections, so
+//       /proc/<pid>/mem (which does not) is used for anything it refused.
+//       returns the number of bytes read, 0 if nothing at <address> could be
+//       read.
+//------------------------------------------------------------------------------
+std::size_t DebuggerCore::read_block(edb::address_t address, void *buf, std::size_t len, transfer_path &path) {
+
+#if defined(__NR_process_vm_readv)
+	if(use_process_vm_) {
+
+		// give the kernel one remote iovec per page, it never splits an iovec
+		// so a fault will leave us with a count of whole pages which made it
+		struct iovec remote[max_iovecs];
+		std::size_t count = 0;
+		std::size_t total = 0;
+
+		while(count < max_iovecs && total < len) {
+			const edb::address_t a        = address + total;
+			const edb::address_t page_end = (a & ~(page_size() - 1)) + page_size();
+			const std::size_t n           = qMin<std::size_t>(len - total, page_end - a);
+
+			remote[count].iov_base = reinterpret_cast<void *>(a);
+			remote[count].iov_len  = n;
+			total += n;
+			++count;
+		}
+
+		struct iovec local;
+		local.iov_base = buf;
+		local.iov_len  = total;
+
+		const ssize_t n = syscall(__NR_process_vm_readv, pid(), &local, 1, remote, count, 0);
+		if(n > 0) {
+			path = PATH_PROCESS_VM;
+			return n;
+		}
+
+		if(n == -1 && errno == ENOSYS) {
+			use_process_vm_ = false;
+		}
+	}
+#endif
+
+	if(proc_mem_fd_ != -1) {
+		ssize_t n;
+		do {
+			n = pread64(proc_mem_fd_, buf, len, static_cast<off64_t>(address));
+		} while(n == -1 && errno == EINTR);
+
+		if(n > 0) {
+			path = PATH_PROC_MEM;
+			return n;
+		}
+	}
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_block(edb::address_t address, const void *buf, std::size_t len, transfer_path &path)
+// Desc: writes as much of the range as possible with a single syscall
+//       /proc/<pid>/mem is preferred here since it can write to read-only
+//       pages (which is where breakpoints usually go), process_vm_writev is
+//       used if it isn't available
+//       returns the number of bytes written, 0 if nothing at <address> could
+//       be written.
+//------------------------------------------------------------------------------
+std::size_t DebuggerCore::write_block(edb::address_t address, const void *buf, std::size_t len, transfer_path &path) {
+
+	if(proc_mem_fd_ != -1 && proc_mem_writable_) {
+		ssize_t n;
+		do {
+			n = pwrite64(proc_mem_fd_, buf, len, static_cast<off64_t>(address));
+		} while(n == -1 && errno == EINTR);
+
+		if(n > 0) {
+			path = PATH_PROC_MEM;
+			return n;
+		}
+	}
+
+#if defined(__NR_process_vm_writev)
+	if(use_process_vm_) {
+
+		struct iovec remote[max_iovecs];
+		std::size_t count = 0;
+		std::size_t total = 0;
+
+		while(count < max_iovecs && total < len) {
+			const edb::address_t a        = address + total;
+			const edb::address_t page_end = (a & ~(page_size() - 1)) + page_size();
+			const std::size_t n           = qMin<std::size_t>(len - total, page_end - a);
+
+			remote[count].iov_base = reinterpret_cast<void *>(a);
+			remote[count].iov_len  = n;
+			total += n;
+			++count;
+		}
+
+		struct iovec local;
+		local.iov_base = const_cast<void *>(buf);
+		local.iov_len  = total;
+
+		const ssize_t n = syscall(__NR_process_vm_writev, pid(), &local, 1, remote, count, 0);
+		if(n > 0) {
+			path = PATH_PROCESS_VM;
+			return n;
+		}
+
+		if(n == -1 && errno == ENOSYS) {
+			use_process_vm_ = false;
+		}
+	}
+#endif
+
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: open_proc_mem()
+// Desc: opens /proc/<pid>/mem for the bulk memory access paths
+//------------------------------------------------------------------------------
+void DebuggerCore::open_proc_mem() {
+	if(proc_mem_fd_ != -1) {
+		::close(proc_mem_fd_);
+	}
+
+	const QString path = QString("/proc/%1/mem").arg(pid());
+
+	// older kernels only allow reading, so settle for that if we must
+	proc_mem_writable_ = true;
+	proc_mem_fd_       = ::open(qPrintable(path), O_RDWR);
+	if(proc_mem_fd_ == -1) {
+		proc_mem_writable_ = false;
+		proc_mem_fd_       = ::open(qPrintable(path), O_RDONLY);
+	}
+
+	if(proc_mem_fd_ == -1) {
+		qDebug("[DebuggerCore] failed to open /proc/%d/mem: %s", pid(), strerror(errno));
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: attach_thread(edb::tid_t tid)
-// Desc:
+// Desc: threads are attached with PTRACE_SEIZE when the kernel supports it,
+//       they keep running until stop_threads interrupts them. Otherwise we
+//       fall back on PTRACE_ATTACH which stops them right away
 //------------------------------------------------------------------------------
 bool DebuggerCore::attach_thread(edb::tid_t tid) {
+
+	if(seized_) {
+		if(ptrace(PTRACE_SEIZE, tid, 0, trace_options()) == 0) {
+			add_thread(tid);
+			return true;
+		}
+
+		// only decide that we can't seize if it fails for the very first thread
+		if(!threads_.empty()) {
+			return false;
+		}
+
+		seized_ = false;
+	}
+
 	if(ptrace(PTRACE_ATTACH, tid, 0, 0) == 0) {
 		// I *think* that the PTRACE_O_TRACECLONE is only valid on
 		// on stopped threads
 		int status;
 		if(native::waitpid(tid, &status, __WALL) > 0) {
-			threads_[tid] = thread_info(status);
-			waited_threads_.insert(tid);
-	#ifdef DEBUG_THREADS
-			if(ptrace_set_options(tid, PTRACE_O_TRACECLONE) == -1) {
-				qDebug("[DebuggerCore] failed to set PTRACE_O_TRACECLONE: [%d] %s", tid, strerror(errno));
+			thread_info &thread = add_thread(tid);
+			thread.status  = status;
+			thread.stopped = true;
+
+			if(ptrace_set_options(tid, trace_options()) == -1) {
+				qDebug("[DebuggerCore] failed to set ptrace options: [%d] %s", tid, strerror(errno));
 			}
-	#endif
 		}
 		return true;
 	}
@@ -346,6 +714,8 @@ bool DebuggerCore::attach_thread(edb::tid_t tid) {
 bool DebuggerCore::attach(edb::pid_t pid) {
 	detach();
 
+	seized_ = true;
+
 #ifdef DEBUG_THREADS
 	bool attached;
 	do {
@@ -356,19 +726,24 @@ bool DebuggerCore::attach(edb::pid_t pid) {
 			// when we are attaching. I wish that linux had an atomic way to do this
 			// all in one shot
 			const edb::tid_t tid = s.toUInt();
-			if(!threads_.contains(tid) && attach_thread(tid)) {
+			if(!find_thread(tid) && attach_thread(tid)) {
 				attached = true;
 			}
 		}
 	} while(attached);
 #else
-	attach_thread(pid)
+	attach_thread(pid);
 #endif
 
 	if(!threads_.empty()) {
 		pid_            = pid;
 		active_thread_  = pid;
 		event_thread_   = pid;
+
+		// seized threads are still running
+		stop_threads();
+
+		open_proc_mem();
 		return true;
 	}
 
@@ -381,6 +756,9 @@ bool DebuggerCore::attach(edb::pid_t pid) {
 //------------------------------------------------------------------------------
 void DebuggerCore::detach() {
 	if(attached()) {
+		// the threads are still running if we detach after a resume, and
+		// ptrace can only detach from a stopped thread
+		stop_threads();
 		clear_breakpoints();
 #ifdef DEBUG_THREADS
 		Q_FOREACH(edb::tid_t thread, thread_ids()) {
@@ -439,19 +817,25 @@ void DebuggerCore::resume(edb::EVENT_STATUS status) {
 
 	if(attached()) {
 		if(status != edb::DEBUG_STOP) {
+			invalidate_cache();
+
+			// the active thread may have exited since it was made active
 			const edb::tid_t tid = active_thread();
-			const int code = (status == edb::DEBUG_EXCEPTION_NOT_HANDLED) ? resume_code(threads_[tid].status) : 0;
-			ptrace_continue(tid, code);
+			if(const thread_info *const thread = find_thread(tid)) {
+				const int code = (status == edb::DEBUG_EXCEPTION_NOT_HANDLED) ? resume_code(thread->status) : 0;
+				ptrace_continue(tid, code);
+			}
 
 
 #ifdef DEBUG_THREADS
 			// resume the other threads passing the signal they originally reported had
-			for(threadmap_t::const_iterator it = threads_.begin(); it != threads_.end(); ++it) {
-				if(waited_threads_.contains(it.key())) {
-					ptrace_continue(it.key(), resume_code(it->status));
+			for(threadlist_t::const_iterator it = threads_.begin(); it != threads_.end(); ++it) {
+				if(it->stopped) {
+					ptrace_continue(it->tid, resume_code(it->status));
 				}
 			}
 #endif
+			arm_waiter();
 		}
 	}
 }
@@ -465,16 +849,24 @@ void DebuggerCore::step(edb::EVENT_STATUS status) {
 
 	if(attached()) {
 		if(status != edb::DEBUG_STOP) {
+			invalidate_cache();
+
 			const edb::tid_t tid = active_thread();
-			const int code = (status == edb::DEBUG_EXCEPTION_NOT_HANDLED) ? resume_code(threads_[tid].status) : 0;
-			ptrace_step(tid, code);
+			if(const thread_info *const thread = find_thread(tid)) {
+				const int code = (status == edb::DEBUG_EXCEPTION_NOT_HANDLED) ? resume_code(thread->status) : 0;
+				ptrace_step(tid, code);
+				arm_waiter();
+			} else {
+				qDebug("[DebuggerCore] warning, attempted to step a thread which has exited: %d", static_cast<int>(tid));
+			}
 		}
 	}
 }
 
 //------------------------------------------------------------------------------
 // Name: get_state(State &state)
-// Desc:
+// Desc: nothing is read from the thread here, the state fetches each group
+//       of registers (through fetch_registers) when it is first needed
 //------------------------------------------------------------------------------
 void DebuggerCore::get_state(State &state) {
 	// TODO: assert that we are paused
@@ -482,48 +874,102 @@ void DebuggerCore::get_state(State &state) {
 	PlatformState *const state_impl = static_cast<PlatformState *>(state.impl_);
 
 	if(attached()) {
-		if(ptrace(PTRACE_GETREGS, active_thread(), 0, &state_impl->regs_) != -1) {
-		#if defined(EDB_X86)
-			struct user_desc desc;
-			std::memset(&desc, 0, sizeof(desc));
+		state_impl->core_       = this;
+		state_impl->tid_        = active_thread();
+		state_impl->generation_ = state_generation_;
+		state_impl->loaded_     = 0;
+		state_impl->dirty_      = 0;
+		state_impl->stale_      = false;
+	} else {
+		state_impl->clear();
+		state_impl->core_  = 0;
+		state_impl->dirty_ = 0;
+	}
+}
 
-			if(ptrace(PTRACE_GET_THREAD_AREA, active_thread(), (state_impl->regs_.xgs / LDT_ENTRY_SIZE), &desc) != -1) {
-				state_impl->gs_base = desc.base_addr;
-			} else {
-				state_impl->gs_base = 0;
-			}
+//------------------------------------------------------------------------------
+// Name: fetch_registers(const PlatformState &state, unsigned int groups)
+// Desc: fills in register groups of a state which came from get_state, they
+//       are read from the thread once per stop and then served from the cache
+// Note: returns false, leaving the state alone, if the thread has run since the
+//       state was taken. What it has now aren't the registers which the state
+//       is supposed to hold.
+//------------------------------------------------------------------------------
+bool DebuggerCore::fetch_registers(const PlatformState &state, unsigned int groups) {
 
-			if(ptrace(PTRACE_GET_THREAD_AREA, active_thread(), (state_impl->regs_.xfs / LDT_ENTRY_SIZE), &desc) != -1) {
-				state_impl->fs_base = desc.base_addr;
-			} else {
-				state_impl->fs_base = 0;
-			}
-		#elif defined(EDB_X86_64)
-		#endif
+	if(!attached() || state.generation_ != state_generation_) {
+		return false;
+	}
+
+	const edb::tid_t tid = state.tid_;
+
+	if(tid != state_cache_tid_ || state_cache_.generation_ != state_generation_) {
+		state_cache_tid_         = tid;
+		state_cache_.generation_ = state_generation_;
+		state_cache_.loaded_     = 0;
+	}
+
+	unsigned int missing = groups & ~state_cache_.loaded_;
+
+#if defined(EDB_X86)
+	// the segment bases are looked up using the selectors
+	if(missing & PlatformState::GROUP_SEGMENT_BASES) {
+		missing |= PlatformState::GROUP_GPR & ~state_cache_.loaded_;
+	}
+#endif
+
+	if(missing & PlatformState::GROUP_GPR) {
+		if(ptrace(PTRACE_GETREGS, tid, 0, &state_cache_.regs_) == -1) {
+			std::memset(&state_cache_.regs_, 0, sizeof(state_cache_.regs_));
 		}
+	}
 
-		// floating point registers
-		if(ptrace(PTRACE_GETFPREGS, active_thread(), 0, &state_impl->fpregs_) != -1) {
+#if defined(EDB_X86)
+	if(missing & PlatformState::GROUP_SEGMENT_BASES) {
+		struct user_desc desc;
+		std::memset(&desc, 0, sizeof(desc));
+
+		if(ptrace(PTRACE_GET_THREAD_AREA, tid, (state_cache_.regs_.xgs / LDT_ENTRY_SIZE), &desc) != -1) {
+			state_cache_.gs_base = desc.base_addr;
+		} else {
+			state_cache_.gs_base = 0;
 		}
 
-		// debug registers
-		state_impl->dr_[0] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(user, u_debugreg[0]), 0);
-		state_impl->dr_[1] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(user, u_debugreg[1]), 0);
-		state_impl->dr_[2] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(user, u_debugreg[2]), 0);
-		state_impl->dr_[3] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(user, u_debugreg[3]), 0);
-		state_impl->dr_[4] = 0;
-		state_impl->dr_[5] = 0;
-		state_impl->dr_[6] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(user, u_debugreg[6]), 0);
-		state_impl->dr_[7] = ptrace(PTRACE_PEEKUSER, active_thread(), offsetof(user, u_debugreg[7]), 0);
+		if(ptrace(PTRACE_GET_THREAD_AREA, tid, (state_cache_.regs_.xfs / LDT_ENTRY_SIZE), &desc) != -1) {
+			state_cache_.fs_base = desc.base_addr;
+		} else {
+			state_cache_.fs_base = 0;
+		}
+	}
+#endif
 
-	} else {
-		state_impl->clear();
+	// floating point registers
+	if(missing & PlatformState::GROUP_FPU) {
+		if(ptrace(PTRACE_GETFPREGS, tid, 0, &state_cache_.fpregs_) == -1) {
+			std::memset(&state_cache_.fpregs_, 0, sizeof(state_cache_.fpregs_));
+		}
+	}
+
+	// debug registers
+	if(missing & PlatformState::GROUP_DEBUG) {
+		state_cache_.dr_[0] = ptrace(PTRACE_PEEKUSER, tid, offsetof(user, u_debugreg[0]), 0);
+		state_cache_.dr_[1] = ptrace(PTRACE_PEEKUSER, tid, offsetof(user, u_debugreg[1]), 0);
+		state_cache_.dr_[2] = ptrace(PTRACE_PEEKUSER, tid, offsetof(user, u_debugreg[2]), 0);
+		state_cache_.dr_[3] = ptrace(PTRACE_PEEKUSER, tid, offsetof(user, u_debugreg[3]), 0);
+		state_cache_.dr_[4] = 0;
+		state_cache_.dr_[5] = 0;
+		state_cache_.dr_[6] = ptrace(PTRACE_PEEKUSER, tid, offsetof(user, u_debugreg[6]), 0);
+		state_cache_.dr_[7] = ptrace(PTRACE_PEEKUSER, tid, offsetof(user, u_debugreg[7]), 0);
 	}
+
+	state_cache_.loaded_ |= missing;
+	state.copy_groups(state_cache_, groups);
+	return true;
 }
 
 //------------------------------------------------------------------------------
 // Name: set_state(const State &state)
-// Desc:
+// Desc: writes back the register groups which were changed
 //------------------------------------------------------------------------------
 void DebuggerCore::set_state(const State &state) {
 
@@ -532,17 +978,39 @@ void DebuggerCore::set_state(const State &state) {
 
 	if(attached()) {
 
-		ptrace(PTRACE_SETREGS, active_thread(), 0, &state_impl->regs_);
+		if(state_impl->stale_) {
+			// some of it was never read from the thread, writing it back
+			// would wipe out the thread's real registers
+			qDebug("[DebuggerCore::set_state] refusing to write back a state which was used after the thread ran");
+			return;
+		}
+
+		const unsigned int dirty = state_impl->dirty_;
+
+		if(dirty & PlatformState::GROUP_GPR) {
+			ptrace(PTRACE_SETREGS, active_thread(), 0, &state_impl->regs_);
+		}
 
 		// debug registers
-		ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[0]), state_impl->dr_[0]);
-		ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[1]), state_impl->dr_[1]);
-		ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[2]), state_impl->dr_[2]);
-		ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[3]), state_impl->dr_[3]);
-		//ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[4]), state_impl->dr_[4]);
-		//ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[5]), state_impl->dr_[5]);
-		ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[6]), state_impl->dr_[6]);
-		ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[7]), state_impl->dr_[7]);
+		if(dirty & PlatformState::GROUP_DEBUG) {
+			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[0]), state_impl->dr_[0]);
+			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[1]), state_impl->dr_[1]);
+			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[2]), state_impl->dr_[2]);
+			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[3]), state_impl->dr_[3]);
+			//ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[4]), state_impl->dr_[4]);
+			//ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[5]), state_impl->dr_[5]);
+			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[6]), state_impl->dr_[6]);
+			ptrace(PTRACE_POKEUSER, active_thread(), offsetof(user, u_debugreg[7]), state_impl->dr_[7]);
+		}
+
+		// what was written is now what the thread has, so keep the cache in step
+		const unsigned int written = dirty & (PlatformState::GROUP_GPR | PlatformState::GROUP_DEBUG);
+		if(state_cache_tid_ == active_thread() && state_cache_.generation_ == state_generation_) {
+			state_cache_.copy_groups(*state_impl, written);
+			state_cache_.loaded_ |= written;
+		}
+
+		state_impl->dirty_ = 0;
 	}
 }
 
@@ -558,9 +1026,6 @@ bool DebuggerCore::open(const QString &path, const QString &cwd, const QStringLi
 	case 0:
 		// we are in the child now...
 
-		// set ourselves (the child proc) up to be traced
-		ptrace_traceme();
-
 		// redirect it's I/O
 		if(!tty.isEmpty()) {
 			FILE *const std_out = freopen(qPrintable(tty), "r+b", stdout);
@@ -572,6 +1037,9 @@ bool DebuggerCore::open(const QString &path, const QString &cwd, const QStringLi
 			Q_UNUSED(std_err);
 		}
 
+		// wait here until the parent has seized us
+		raise(SIGSTOP);
+
 		// do the actual exec
 		execute_process(path, cwd, args);
 
@@ -587,34 +1055,37 @@ bool DebuggerCore::open(const QString &path, const QString &cwd, const QStringLi
 		do {
 			reset();
 
+			seized_ = true;
+
 			int status;
-			if(native::waitpid(pid, &status, __WALL) == -1) {
+			if(native::waitpid(pid, &status, __WALL | WUNTRACED) == -1) {
 				return false;
 			}
 
-			// the very first event should be a STOP of type SIGTRAP
-			if(!WIFSTOPPED(status) || WSTOPSIG(status) != SIGTRAP) {
-				detach();
+			if(!WIFSTOPPED(status) || !attach_thread(pid)) {
+				::kill(pid, SIGKILL);
+				native::waitpid(pid, 0, __WALL);
+				reset();
 				return false;
 			}
 
-			waited_threads_.insert(pid);
+			pid_            = pid;
+			active_thread_  = pid;
+			event_thread_   = pid;
 
-#ifdef DEBUG_THREADS
-			// enable following clones (threads)
-			if(ptrace_set_options(pid, PTRACE_O_TRACECLONE) == -1) {
-				qDebug("[DebuggerCore] failed to set PTRACE_SETOPTIONS: %s", strerror(errno));
-				detach();
+			// let it get to the exec, the first event the user sees is the
+			// one for the new image
+			::kill(pid, SIGCONT);
+			if(!wait_for_exec(pid, status)) {
+				reset();
 				return false;
 			}
-#endif
 
 			// setup the first event data for the primary thread
-			waited_threads_.insert(pid);
-			threads_[pid]   = thread_info(status);
-			pid_            = pid;
-			active_thread_  = pid;
-			event_thread_   = pid;
+			thread_info *const thread = find_thread(pid);
+			thread->status  = status;
+			thread->stopped = true;
+			open_proc_mem();
 
 			return true;
 		} while(0);
@@ -622,12 +1093,39 @@ bool DebuggerCore::open(const QString &path, const QString &cwd, const QStringLi
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: wait_for_exec(edb::pid_t pid, int &status)
+// Desc: runs a freshly forked (and traced) child until it reports the exec
+//       event, the stops it sees on the way there are just our own
+//       SIGSTOP/SIGCONT dance so they are not passed on
+//------------------------------------------------------------------------------
+bool DebuggerCore::wait_for_exec(edb::pid_t pid, int &status) {
+	Q_FOREVER {
+		if(native::waitpid(pid, &status, __WALL) == -1) {
+			return false;
+		}
+
+		if(is_exec_event(status)) {
+			return true;
+		}
+
+		if(!WIFSTOPPED(status)) {
+			// it exited (most likely the exec failed)
+			return false;
+		}
+
+		if(ptrace(PTRACE_CONT, pid, 0, 0) == -1) {
+			return false;
+		}
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: set_active_thread(edb::tid_t tid)
 // Desc:
 //------------------------------------------------------------------------------
 void DebuggerCore::set_active_thread(edb::tid_t tid) {
-	if(threads_.contains(tid)) {
+	if(find_thread(tid)) {
 #if 0
 		active_thread_ = tid;
 #else
@@ -643,11 +1141,20 @@ void DebuggerCore::set_active_thread(edb::tid_t tid) {
 // Desc:
 //------------------------------------------------------------------------------
 void DebuggerCore::reset() {
+	waiter_->disarm();
+
+	if(proc_mem_fd_ != -1) {
+		::close(proc_mem_fd_);
+		proc_mem_fd_ = -1;
+	}
+
 	threads_.clear();
-	waited_threads_.clear();
 	active_thread_ = 0;
 	pid_           = 0;
 	event_thread_  = 0;
+
+	state_cache_tid_ = 0;
+	++state_generation_;
 }
 
 //------------------------------------------------------------------------------
@@ -20,8 +20,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DEBUGGERCORE_20090529_H_
 
 #include "DebuggerCoreUNIX.h"
-#include <QHash>
-#include <QSet>
+#include "PlatformState.h"
+#include <QVector>
+
+class EventWaiter;
 
 class DebuggerCore : public DebuggerCoreUNIX {
 	Q_OBJECT
@@ -49,16 +51,23 @@ public:
 
 public:
 	// thread support stuff (optional)
-	virtual QList<edb::tid_t> thread_ids() const { return threads_.keys(); }
+	virtual QList<edb::tid_t> thread_ids() const;
 	virtual edb::tid_t active_thread() const     { return active_thread_; }
 	virtual void set_active_thread(edb::tid_t);
 
 public:
 	virtual StateInterface *create_state() const;
 
+Q_SIGNALS:
+	// emitted (from the GUI thread's event loop) as soon as wait_debug_event
+	// has something to return
+	void debug_event_ready();
+
 private:
 	virtual long read_data(edb::address_t address, bool &ok);
 	virtual bool write_data(edb::address_t address, long value);
+	virtual std::size_t read_block(edb::address_t address, void *buf, std::size_t len, transfer_path &path);
+	virtual std::size_t write_block(edb::address_t address, const void *buf, std::size_t len, transfer_path &path);
 
 private:
 	long ptrace_continue(edb::tid_t tid, long status);
@@ -69,23 +78,53 @@ private:
 
 private:
 	void reset();
+	void arm_waiter();
+	void open_proc_mem();
 	void stop_threads();
 	bool handle_event(DebugEvent &event, edb::tid_t tid, int status);
 	bool attach_thread(edb::tid_t tid);
+	bool wait_for_exec(edb::pid_t pid, int &status);
+
+private:
+	friend class PlatformState;
+	bool fetch_registers(const PlatformState &state, unsigned int groups);
 
 private:
 	struct thread_info {
-		thread_info() : status(0) {}
-		explicit thread_info(int s) : status(s) {}
-		int status;
+		thread_info() : tid(0), status(0), stopped(false), starting(false), interrupted(false) {}
+		explicit thread_info(edb::tid_t t) : tid(t), status(0), stopped(false), starting(false), interrupted(false) {}
+
+		edb::tid_t tid;
+		int        status;
+		bool       stopped;     // we have waited on it and not let it go since
+		bool       starting;    // a new thread which hasn't reported its first stop
+		bool       interrupted; // a PTRACE_INTERRUPT of ours hasn't been reported yet
 	};
 
-	typedef QHash<edb::tid_t, thread_info> threadmap_t;
+	// kept sorted by tid, lookups are a binary search and everything else
+	// is a linear walk
+	typedef QVector<thread_info> threadlist_t;
+
+	thread_info *find_thread(edb::tid_t tid);
+	const thread_info *find_thread(edb::tid_t tid) const;
+	thread_info &add_thread(edb::tid_t tid);
+	void remove_thread(edb::tid_t tid);
 
+private:
 	edb::address_t   page_size_;
-	threadmap_t      threads_;
-	QSet<edb::tid_t> waited_threads_;
+	threadlist_t     threads_;
 	edb::tid_t       event_thread_;
+	EventWaiter *    waiter_;
+	int              proc_mem_fd_;
+	bool             proc_mem_writable_;
+	bool             use_process_vm_;
+	bool             seized_;   // threads were attached with PTRACE_SEIZE
+
+	// the registers of the last thread which was asked about, valid until
+	// any thread is resumed (which bumps state_generation_)
+	PlatformState    state_cache_;
+	edb::tid_t       state_cache_tid_;
+	quint64          state_generation_;
 };
 
 #endif
@@ -0,0 +1,238 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventWaiter.h"
+#include "DebuggerCoreUNIX.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// SIGCHLD is what wakes the waiter up, if it is somehow missed (another
+// handler which doesn't chain to ours for example) the threads are still
+// looked at this often
+const int backstop_msecs = 1000;
+
+//------------------------------------------------------------------------------
+// Name: drain(int fd)
+// Desc: reads everything there is to read from the non-blocking pipe <fd>
+//------------------------------------------------------------------------------
+void drain(int fd) {
+	char buf[64];
+	while(native::read(fd, buf, sizeof(buf)) > 0) {
+	}
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: EventWaiter(QObject *parent)
+// Desc: constructor
+//------------------------------------------------------------------------------
+EventWaiter::EventWaiter(QObject *parent) : QThread(parent), pid_(0), armed_(false), quit_(false) {
+
+	// written to when the waiter has to look at its flags again, non-blocking
+	// so that neither end can ever get stuck on it
+	int r = ::pipe(wake_pipe_);
+	Q_UNUSED(r);
+
+	for(int i = 0; i < 2; ++i) {
+		::fcntl(wake_pipe_[i], F_SETFL, ::fcntl(wake_pipe_[i], F_GETFL) | O_NONBLOCK);
+		::fcntl(wake_pipe_[i], F_SETFD, FD_CLOEXEC);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: ~EventWaiter()
+// Desc: destructor
+//------------------------------------------------------------------------------
+EventWaiter::~EventWaiter() {
+	shutdown();
+	::close(wake_pipe_[0]);
+	::close(wake_pipe_[1]);
+}
+
+//------------------------------------------------------------------------------
+// Name: arm(edb::pid_t pid, const QList<edb::tid_t> &tids)
+// Desc: called once the debugee has been allowed to run, the next event from
+//       any of <pid>'s threads <tids> will be reported
+//------------------------------------------------------------------------------
+void EventWaiter::arm(edb::pid_t pid, const QList<edb::tid_t> &tids) {
+	{
+		QMutexLocker locker(&mutex_);
+		pid_   = pid;
+		tids_  = tids;
+		armed_ = true;
+		armed_condition_.wakeOne();
+	}
+	interrupt();
+}
+
+//------------------------------------------------------------------------------
+// Name: disarm()
+// Desc: stop waiting and forget any events which were not collected yet
+//------------------------------------------------------------------------------
+void EventWaiter::disarm() {
+	{
+		QMutexLocker locker(&mutex_);
+		armed_ = false;
+		events_.clear();
+	}
+	interrupt();
+}
+
+//------------------------------------------------------------------------------
+// Name: shutdown()
+// Desc: stops the waiter thread, it's safe to call this more than once
+//------------------------------------------------------------------------------
+void EventWaiter::shutdown() {
+	{
+		QMutexLocker locker(&mutex_);
+		quit_  = true;
+		armed_ = false;
+		armed_condition_.wakeOne();
+	}
+
+	// the pipe stays readable until the thread drains it, so this can't be
+	// missed even if the thread isn't sleeping yet
+	interrupt();
+	wait();
+}
+
+//------------------------------------------------------------------------------
+// Name: wait_for_event(int msecs, edb::tid_t &tid)
+// Desc: collects the next event reported by the waiter, waiting at most
+//       <msecs> for one to arrive. <tid> is the thread which has an event
+//       ready to be reaped.
+//------------------------------------------------------------------------------
+bool EventWaiter::wait_for_event(int msecs, edb::tid_t &tid) {
+	QMutexLocker locker(&mutex_);
+
+	if(events_.isEmpty() && msecs > 0) {
+		event_condition_.wait(&mutex_, msecs);
+	}
+
+	if(events_.isEmpty()) {
+		return false;
+	}
+
+	tid = events_.dequeue();
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: interrupt()
+// Desc: makes the waiter thread look at its flags again if it is sleeping
+//------------------------------------------------------------------------------
+void EventWaiter::interrupt() {
+	native::write(wake_pipe_[1], " ", sizeof(char));
+}
+
+//------------------------------------------------------------------------------
+// Name: wait_for_wakeup()
+// Desc: sleeps until a child of ours changes state (the core's SIGCHLD handler
+//       writes to its pipe, nothing else reads it on linux) or we are
+//       interrupted. Both pipes are drained before returning, so anything
+//       which happens after that wakes the next wait immediately.
+//------------------------------------------------------------------------------
+void EventWaiter::wait_for_wakeup() {
+	const int sigchld_fd = native::sigchld_fd();
+
+	fd_set rfds;
+	FD_ZERO(&rfds);
+	FD_SET(sigchld_fd, &rfds);
+	FD_SET(wake_pipe_[0], &rfds);
+
+	native::select_ex(std::max(sigchld_fd, wake_pipe_[0]) + 1, &rfds, 0, 0, backstop_msecs);
+
+	drain(sigchld_fd);
+	drain(wake_pipe_[0]);
+}
+
+//------------------------------------------------------------------------------
+// Name: run()
+// Desc: the waiter thread, it peeks (WNOWAIT) at the debugee's threads for a
+//       state change so that the core can reap it from the thread which
+//       attached. Other children of ours (the terminal for example) are never
+//       looked at.
+//------------------------------------------------------------------------------
+void EventWaiter::run() {
+
+	Q_FOREVER {
+		edb::pid_t        pid;
+		QList<edb::tid_t> tids;
+		{
+			QMutexLocker locker(&mutex_);
+			while(!armed_ && !quit_) {
+				armed_condition_.wait(&mutex_);
+			}
+
+			if(quit_) {
+				break;
+			}
+
+			pid  = pid_;
+			tids = tids_;
+		}
+
+		edb::tid_t tid   = 0;
+		bool       alive = false;
+		Q_FOREACH(edb::tid_t thread, tids) {
+			siginfo_t info;
+			std::memset(&info, 0, sizeof(info));
+			if(waitid(P_PID, thread, &info, WEXITED | WSTOPPED | WNOWAIT | WNOHANG | __WALL) == 0) {
+				alive = true;
+				if(info.si_pid != 0) {
+					tid = info.si_pid;
+					break;
+				}
+			} else if(errno != ECHILD) {
+				// interrupted, it's still ours to wait for
+				alive = true;
+			}
+		}
+
+		if(tid == 0) {
+			if(!alive) {
+				// nothing left to wait for, we will be armed again if that changes
+				QMutexLocker locker(&mutex_);
+				armed_ = false;
+			} else {
+				wait_for_wakeup();
+			}
+			continue;
+		}
+
+		QMutexLocker locker(&mutex_);
+		if(armed_ && pid_ == pid) {
+			armed_ = false;
+			events_.enqueue(tid);
+			event_condition_.wakeAll();
+			locker.unlock();
+
+			Q_EMIT event_ready();
+		}
+	}
+}
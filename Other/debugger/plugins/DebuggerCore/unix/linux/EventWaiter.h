@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTWAITER_20111102_H_
+#define EVENTWAITER_20111102_H_
+
+#include "Types.h"
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QList>
+#include <QWaitCondition>
+
+// waits for SIGCHLD on behalf of the debugger core so that the GUI thread can
+// be told about debug events the moment they happen instead of polling for
+// them. Only the debugee's threads are looked at, and the waiter never reaps
+// anything (ptrace requests have to be made by the thread which attached), it
+// only reports which thread has an event ready and then goes idle until the
+// core lets the debugee run again.
+class EventWaiter : public QThread {
+	Q_OBJECT
+
+public:
+	EventWaiter(QObject *parent = 0);
+	virtual ~EventWaiter();
+
+public:
+	void arm(edb::pid_t pid, const QList<edb::tid_t> &tids);
+	void disarm();
+	bool wait_for_event(int msecs, edb::tid_t &tid);
+	void shutdown();
+
+Q_SIGNALS:
+	void event_ready();
+
+protected:
+	virtual void run();
+
+private:
+	void interrupt();
+	void wait_for_wakeup();
+
+private:
+	mutable QMutex         mutex_;
+	QWaitCondition         armed_condition_;
+	QWaitCondition         event_condition_;
+	QQueue<edb::tid_t>     events_;
+	QList<edb::tid_t>      tids_;
+	edb::pid_t             pid_;
+	int                    wake_pipe_[2];
+	bool                   armed_;
+	bool                   quit_;
+};
+
+#endif
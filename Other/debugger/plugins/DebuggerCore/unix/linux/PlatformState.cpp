@@ -17,12 +17,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "PlatformState.h"
+#include "DebuggerCore.h"
+#include <QDebug>
 
 //------------------------------------------------------------------------------
 // Name: PlatformState()
 // Desc:
 //------------------------------------------------------------------------------
-PlatformState::PlatformState() {
+PlatformState::PlatformState() : core_(0), tid_(0), generation_(0), loaded_(GROUP_ALL), dirty_(0), stale_(false) {
 	memset(&regs_, 0, sizeof(regs_));
 	memset(&fpregs_, 0, sizeof(fpregs_));
 	memset(&dr_, 0, sizeof(dr_));
@@ -37,9 +39,61 @@ PlatformState::PlatformState() {
 // Desc: makes a copy of the state object
 //------------------------------------------------------------------------------
 StateInterface *PlatformState::copy() const {
+	// copies may outlive the stop, so they get everything now
+	load(GROUP_ALL);
 	return new PlatformState(*this);
 }
 
+//------------------------------------------------------------------------------
+// Name: load(unsigned int groups) const
+// Desc: makes sure that the given register groups have been fetched
+//------------------------------------------------------------------------------
+void PlatformState::load(unsigned int groups) const {
+	const unsigned int missing = groups & ~loaded_;
+	if(missing) {
+		if(core_ && !core_->fetch_registers(*this, missing)) {
+			qDebug("[PlatformState::load] the thread has run since this state was taken, its registers are out of date");
+			stale_ = true;
+		}
+		loaded_ |= missing;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: modify(unsigned int groups)
+// Desc: called before changing registers, so that set_state knows which
+//       groups need to be written back
+//------------------------------------------------------------------------------
+void PlatformState::modify(unsigned int groups) {
+	load(groups);
+	dirty_ |= groups;
+}
+
+//------------------------------------------------------------------------------
+// Name: copy_groups(const PlatformState &other, unsigned int groups) const
+// Desc: copies the given register groups from other
+//------------------------------------------------------------------------------
+void PlatformState::copy_groups(const PlatformState &other, unsigned int groups) const {
+	if(groups & GROUP_GPR) {
+		regs_ = other.regs_;
+	}
+
+#if defined(EDB_X86)
+	if(groups & GROUP_SEGMENT_BASES) {
+		fs_base = other.fs_base;
+		gs_base = other.gs_base;
+	}
+#endif
+
+	if(groups & GROUP_FPU) {
+		fpregs_ = other.fpregs_;
+	}
+
+	if(groups & GROUP_DEBUG) {
+		memcpy(dr_, other.dr_, sizeof(dr_));
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: flags_to_string(edb::reg_t flags) const
 // Desc: returns the flags in a string form appropriate for this platform
@@ -69,127 +123,182 @@ QString PlatformState::flags_to_string() const {
 	return flags_to_string(flags());
 }
 
+namespace {
+	// the registers which value() knows about, a register's id is its index
+	const char *const register_names[] = {
+#if defined(EDB_X86)
+		"eax", "ebx", "ecx", "edx", "ebp", "esp", "esi", "edi",
+		"eip", "ax", "bx", "cx", "dx", "bp", "sp", "si",
+		"di", "al", "bl", "cl", "dl", "ah", "bh", "ch",
+		"dh", "cs", "ds", "es", "fs", "gs", "ss", "eflags"
+#elif defined(EDB_X86_64)
+		"rax", "rbx", "rcx", "rdx", "rbp", "rsp", "rsi", "rdi",
+		"rip", "r8", "r9", "r10", "r11", "r12", "r13", "r14",
+		"r15", "eax", "ebx", "ecx", "edx", "ebp", "esp", "esi",
+		"edi", "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d",
+		"r15d", "ax", "bx", "cx", "dx", "bp", "sp", "si",
+		"di", "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w",
+		"r15w", "al", "bl", "cl", "dl", "ah", "bh", "ch",
+		"dh", "spl", "bpl", "sil", "dil", "r8b", "r9b", "r10b",
+		"r11b", "r12b", "r13b", "r14b", "r15b", "cs", "ds", "es",
+		"fs", "gs", "ss", "rflags"
+#endif
+	};
+}
+
 //------------------------------------------------------------------------------
 // Name: value(const QString &reg) const
 // Desc: returns a Register object which represents the register with the name
 //       supplied
 //------------------------------------------------------------------------------
 Register PlatformState::value(const QString &reg) const {
+	return register_value(register_id(reg));
+}
+
+//------------------------------------------------------------------------------
+// Name: register_id(const QString &reg) const
+// Desc: returns an id for the named register which register_value() accepts,
+//       or -1 if there is no such register
+//------------------------------------------------------------------------------
+int PlatformState::register_id(const QString &reg) const {
 	const QString lreg = reg.toLower();
 
+	for(size_t i = 0; i < sizeof(register_names) / sizeof(register_names[0]); ++i) {
+		if(lreg == register_names[i]) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: register_value(int id) const
+// Desc: returns the register with the given id (see register_id)
+//------------------------------------------------------------------------------
+Register PlatformState::register_value(int id) const {
+
+	load(GROUP_GPR);
+
+	switch(id) {
 #if defined(EDB_X86)
-	if(lreg == "eax")			return Register("eax", regs_.eax, Register::TYPE_GPR);
-	else if(lreg == "ebx")		return Register("ebx", regs_.ebx, Register::TYPE_GPR);
-	else if(lreg == "ecx")		return Register("ecx", regs_.ecx, Register::TYPE_GPR);
-	else if(lreg == "edx")		return Register("edx", regs_.edx, Register::TYPE_GPR);
-	else if(lreg == "ebp")		return Register("ebp", regs_.ebp, Register::TYPE_GPR);
-	else if(lreg == "esp")		return Register("esp", regs_.esp, Register::TYPE_GPR);
-	else if(lreg == "esi")		return Register("esi", regs_.esi, Register::TYPE_GPR);
-	else if(lreg == "edi")		return Register("edi", regs_.edi, Register::TYPE_GPR);
-	else if(lreg == "eip")		return Register("eip", regs_.eip, Register::TYPE_IP);
-	else if(lreg == "ax")		return Register("ax", regs_.eax & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "bx")		return Register("bx", regs_.ebx & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "cx")		return Register("cx", regs_.ecx & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "dx")		return Register("dx", regs_.edx & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "bp")		return Register("bp", regs_.ebp & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "sp")		return Register("sp", regs_.esp & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "si")		return Register("si", regs_.esi & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "di")		return Register("di", regs_.edi & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "al")		return Register("al", regs_.eax & 0xff, Register::TYPE_GPR);
-	else if(lreg == "bl")		return Register("bl", regs_.ebx & 0xff, Register::TYPE_GPR);
-	else if(lreg == "cl")		return Register("cl", regs_.ecx & 0xff, Register::TYPE_GPR);
-	else if(lreg == "dl")		return Register("dl", regs_.edx & 0xff, Register::TYPE_GPR);
-	else if(lreg == "ah")		return Register("ah", (regs_.eax >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "bh")		return Register("bh", (regs_.ebx >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "ch")		return Register("ch", (regs_.ecx >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "dh")		return Register("dh", (regs_.edx >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "cs")		return Register("cs", regs_.xcs, Register::TYPE_SEG, 0);
-	else if(lreg == "ds")		return Register("ds", regs_.xds, Register::TYPE_SEG, 0);
-	else if(lreg == "es")		return Register("es", regs_.xes, Register::TYPE_SEG, 0);
-	else if(lreg == "fs")		return Register("fs", regs_.xfs, Register::TYPE_SEG, fs_base);
-	else if(lreg == "gs")		return Register("gs", regs_.xgs, Register::TYPE_SEG, gs_base);
-	else if(lreg == "ss") 		return Register("ss", regs_.xss, Register::TYPE_SEG, 0);
-	else if(lreg == "eflags") 	return Register("eflags", regs_.eflags, Register::TYPE_COND);
+	case 0:		return Register("eax", regs_.eax, Register::TYPE_GPR);
+	case 1:		return Register("ebx", regs_.ebx, Register::TYPE_GPR);
+	case 2:		return Register("ecx", regs_.ecx, Register::TYPE_GPR);
+	case 3:		return Register("edx", regs_.edx, Register::TYPE_GPR);
+	case 4:		return Register("ebp", regs_.ebp, Register::TYPE_GPR);
+	case 5:		return Register("esp", regs_.esp, Register::TYPE_GPR);
+	case 6:		return Register("esi", regs_.esi, Register::TYPE_GPR);
+	case 7:		return Register("edi", regs_.edi, Register::TYPE_GPR);
+	case 8:		return Register("eip", regs_.eip, Register::TYPE_IP);
+	case 9:		return Register("ax", regs_.eax & 0xffff, Register::TYPE_GPR);
+	case 10:	return Register("bx", regs_.ebx & 0xffff, Register::TYPE_GPR);
+	case 11:	return Register("cx", regs_.ecx & 0xffff, Register::TYPE_GPR);
+	case 12:	return Register("dx", regs_.edx & 0xffff, Register::TYPE_GPR);
+	case 13:	return Register("bp", regs_.ebp & 0xffff, Register::TYPE_GPR);
+	case 14:	return Register("sp", regs_.esp & 0xffff, Register::TYPE_GPR);
+	case 15:	return Register("si", regs_.esi & 0xffff, Register::TYPE_GPR);
+	case 16:	return Register("di", regs_.edi & 0xffff, Register::TYPE_GPR);
+	case 17:	return Register("al", regs_.eax & 0xff, Register::TYPE_GPR);
+	case 18:	return Register("bl", regs_.ebx & 0xff, Register::TYPE_GPR);
+	case 19:	return Register("cl", regs_.ecx & 0xff, Register::TYPE_GPR);
+	case 20:	return Register("dl", regs_.edx & 0xff, Register::TYPE_GPR);
+	case 21:	return Register("ah", (regs_.eax >> 8) & 0xff, Register::TYPE_GPR);
+	case 22:	return Register("bh", (regs_.ebx >> 8) & 0xff, Register::TYPE_GPR);
+	case 23:	return Register("ch", (regs_.ecx >> 8) & 0xff, Register::TYPE_GPR);
+	case 24:	return Register("dh", (regs_.edx >> 8) & 0xff, Register::TYPE_GPR);
+	case 25:	return Register("cs", regs_.xcs, Register::TYPE_SEG, 0);
+	case 26:	return Register("ds", regs_.xds, Register::TYPE_SEG, 0);
+	case 27:	return Register("es", regs_.xes, Register::TYPE_SEG, 0);
+	case 28:
+		load(GROUP_SEGMENT_BASES);
+		return Register("fs", regs_.xfs, Register::TYPE_SEG, fs_base);
+	case 29:
+		load(GROUP_SEGMENT_BASES);
+		return Register("gs", regs_.xgs, Register::TYPE_SEG, gs_base);
+	case 30:	return Register("ss", regs_.xss, Register::TYPE_SEG, 0);
+	case 31:	return Register("eflags", regs_.eflags, Register::TYPE_COND);
 #elif defined(EDB_X86_64)
-	if(lreg == "rax")			return Register("rax", regs_.rax, Register::TYPE_GPR);
-	else if(lreg == "rbx")		return Register("rbx", regs_.rbx, Register::TYPE_GPR);
-	else if(lreg == "rcx")		return Register("rcx", regs_.rcx, Register::TYPE_GPR);
-	else if(lreg == "rdx")		return Register("rdx", regs_.rdx, Register::TYPE_GPR);
-	else if(lreg == "rbp")		return Register("rbp", regs_.rbp, Register::TYPE_GPR);
-	else if(lreg == "rsp")		return Register("rsp", regs_.rsp, Register::TYPE_GPR);
-	else if(lreg == "rsi")		return Register("rsi", regs_.rsi, Register::TYPE_GPR);
-	else if(lreg == "rdi")		return Register("rdi", regs_.rdi, Register::TYPE_GPR);
-	else if(lreg == "rip")		return Register("rip", regs_.rip, Register::TYPE_IP);
-	else if(lreg == "r8")		return Register("r8", regs_.r8, Register::TYPE_GPR);
-	else if(lreg == "r9")		return Register("r9", regs_.r9, Register::TYPE_GPR);
-	else if(lreg == "r10")		return Register("r10", regs_.r10, Register::TYPE_GPR);
-	else if(lreg == "r11")		return Register("r11", regs_.r11, Register::TYPE_GPR);
-	else if(lreg == "r12")		return Register("r12", regs_.r12, Register::TYPE_GPR);
-	else if(lreg == "r13")		return Register("r13", regs_.r13, Register::TYPE_GPR);
-	else if(lreg == "r14")		return Register("r14", regs_.r14, Register::TYPE_GPR);
-	else if(lreg == "r15")		return Register("r15", regs_.r15, Register::TYPE_GPR);
-	else if(lreg == "eax")		return Register("eax", regs_.rax & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "ebx")		return Register("ebx", regs_.rbx & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "ecx")		return Register("ecx", regs_.rcx & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "edx")		return Register("edx", regs_.rdx & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "ebp")		return Register("ebp", regs_.rbp & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "esp")		return Register("esp", regs_.rsp & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "esi")		return Register("esi", regs_.rsi & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "edi")		return Register("edi", regs_.rdi & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "r8d")		return Register("r8d", regs_.r8 & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "r9d")		return Register("r9d", regs_.r9 & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "r10d") 	return Register("r10d", regs_.r10 & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "r11d") 	return Register("r11d", regs_.r11 & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "r12d") 	return Register("r12d", regs_.r12 & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "r13d") 	return Register("r13d", regs_.r13 & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "r14d") 	return Register("r14d", regs_.r14 & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "r15d")		return Register("r15d", regs_.r15 & 0xffffffff, Register::TYPE_GPR);
-	else if(lreg == "ax")		return Register("ax", regs_.rax & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "bx")		return Register("bx", regs_.rbx & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "cx")		return Register("cx", regs_.rcx & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "dx")		return Register("dx", regs_.rdx & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "bp")		return Register("bp", regs_.rbp & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "sp")		return Register("sp", regs_.rsp & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "si")		return Register("si", regs_.rsi & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "di")		return Register("di", regs_.rdi & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "r8w")		return Register("r8w", regs_.r8 & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "r9w")		return Register("r9w", regs_.r9 & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "r10w")		return Register("r10w", regs_.r10 & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "r11w")		return Register("r11w", regs_.r11 & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "r12w")		return Register("r12w", regs_.r12 & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "r13w")		return Register("r13w", regs_.r13 & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "r14w")		return Register("r14w", regs_.r14 & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "r15w")		return Register("r15w", regs_.r15 & 0xffff, Register::TYPE_GPR);
-	else if(lreg == "al")		return Register("al", regs_.rax & 0xff, Register::TYPE_GPR);
-	else if(lreg == "bl")		return Register("bl", regs_.rbx & 0xff, Register::TYPE_GPR);
-	else if(lreg == "cl")		return Register("cl", regs_.rcx & 0xff, Register::TYPE_GPR);
-	else if(lreg == "dl")		return Register("dl", regs_.rdx & 0xff, Register::TYPE_GPR);
-	else if(lreg == "ah")		return Register("ah", (regs_.rax >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "bh")		return Register("bh", (regs_.rbx >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "ch")		return Register("ch", (regs_.rcx >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "dh")		return Register("dh", (regs_.rdx >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "spl")		return Register("spl", (regs_.rsp >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "bpl")		return Register("bpl", (regs_.rbp >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "sil")		return Register("sil", (regs_.rsi >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "dil")		return Register("dil", (regs_.rdi >> 8) & 0xff, Register::TYPE_GPR);
-	else if(lreg == "r8b")		return Register("r8b", regs_.r8 & 0xff, Register::TYPE_GPR);
-	else if(lreg == "r9b")		return Register("r9b", regs_.r9 & 0xff, Register::TYPE_GPR);
-	else if(lreg == "r10b")		return Register("r10b", regs_.r10 & 0xff, Register::TYPE_GPR);
-	else if(lreg == "r11b")		return Register("r11b", regs_.r11 & 0xff, Register::TYPE_GPR);
-	else if(lreg == "r12b")		return Register("r12b", regs_.r12 & 0xff, Register::TYPE_GPR);
-	else if(lreg == "r13b")		return Register("r13b", regs_.r13 & 0xff, Register::TYPE_GPR);
-	else if(lreg == "r14b")		return Register("r14b", regs_.r14 & 0xff, Register::TYPE_GPR);
-	else if(lreg == "r15b")		return Register("r15b", regs_.r15 & 0xff, Register::TYPE_GPR);
-	else if(lreg == "cs")		return Register("cs", regs_.cs, Register::TYPE_SEG, 0);
-	else if(lreg == "ds")		return Register("ds", regs_.ds, Register::TYPE_SEG, 0);
-	else if(lreg == "es")		return Register("es", regs_.es, Register::TYPE_SEG, 0);
-	else if(lreg == "fs")		return Register("fs", regs_.fs, Register::TYPE_SEG, regs_.fs_base);
-	else if(lreg == "gs")		return Register("gs", regs_.gs, Register::TYPE_SEG, regs_.gs_base);
-	else if(lreg == "ss") 		return Register("ss", regs_.ss, Register::TYPE_SEG, 0);
-	else if(lreg == "rflags") 	return Register("rflags", regs_.eflags, Register::TYPE_COND);
+	case 0:		return Register("rax", regs_.rax, Register::TYPE_GPR);
+	case 1:		return Register("rbx", regs_.rbx, Register::TYPE_GPR);
+	case 2:		return Register("rcx", regs_.rcx, Register::TYPE_GPR);
+	case 3:		return Register("rdx", regs_.rdx, Register::TYPE_GPR);
+	case 4:		return Register("rbp", regs_.rbp, Register::TYPE_GPR);
+	case 5:		return Register("rsp", regs_.rsp, Register::TYPE_GPR);
+	case 6:		return Register("rsi", regs_.rsi, Register::TYPE_GPR);
+	case 7:		return Register("rdi", regs_.rdi, Register::TYPE_GPR);
+	case 8:		return Register("rip", regs_.rip, Register::TYPE_IP);
+	case 9:		return Register("r8", regs_.r8, Register::TYPE_GPR);
+	case 10:	return Register("r9", regs_.r9, Register::TYPE_GPR);
+	case 11:	return Register("r10", regs_.r10, Register::TYPE_GPR);
+	case 12:	return Register("r11", regs_.r11, Register::TYPE_GPR);
+	case 13:	return Register("r12", regs_.r12, Register::TYPE_GPR);
+	case 14:	return Register("r13", regs_.r13, Register::TYPE_GPR);
+	case 15:	return Register("r14", regs_.r14, Register::TYPE_GPR);
+	case 16:	return Register("r15", regs_.r15, Register::TYPE_GPR);
+	case 17:	return Register("eax", regs_.rax & 0xffffffff, Register::TYPE_GPR);
+	case 18:	return Register("ebx", regs_.rbx & 0xffffffff, Register::TYPE_GPR);
+	case 19:	return Register("ecx", regs_.rcx & 0xffffffff, Register::TYPE_GPR);
+	case 20:	return Register("edx", regs_.rdx & 0xffffffff, Register::TYPE_GPR);
+	case 21:	return Register("ebp", regs_.rbp & 0xffffffff, Register::TYPE_GPR);
+	case 22:	return Register("esp", regs_.rsp & 0xffffffff, Register::TYPE_GPR);
+	case 23:	return Register("esi", regs_.rsi & 0xffffffff, Register::TYPE_GPR);
+	case 24:	return Register("edi", regs_.rdi & 0xffffffff, Register::TYPE_GPR);
+	case 25:	return Register("r8d", regs_.r8 & 0xffffffff, Register::TYPE_GPR);
+	case 26:	return Register("r9d", regs_.r9 & 0xffffffff, Register::TYPE_GPR);
+	case 27:	return Register("r10d", regs_.r10 & 0xffffffff, Register::TYPE_GPR);
+	case 28:	return Register("r11d", regs_.r11 & 0xffffffff, Register::TYPE_GPR);
+	case 29:	return Register("r12d", regs_.r12 & 0xffffffff, Register::TYPE_GPR);
+	case 30:	return Register("r13d", regs_.r13 & 0xffffffff, Register::TYPE_GPR);
+	case 31:	return Register("r14d", regs_.r14 & 0xffffffff, Register::TYPE_GPR);
+	case 32:	return Register("r15d", regs_.r15 & 0xffffffff, Register::TYPE_GPR);
+	case 33:	return Register("ax", regs_.rax & 0xffff, Register::TYPE_GPR);
+	case 34:	return Register("bx", regs_.rbx & 0xffff, Register::TYPE_GPR);
+	case 35:	return Register("cx", regs_.rcx & 0xffff, Register::TYPE_GPR);
+	case 36:	return Register("dx", regs_.rdx & 0xffff, Register::TYPE_GPR);
+	case 37:	return Register("bp", regs_.rbp & 0xffff, Register::TYPE_GPR);
+	case 38:	return Register("sp", regs_.rsp & 0xffff, Register::TYPE_GPR);
+	case 39:	return Register("si", regs_.rsi & 0xffff, Register::TYPE_GPR);
+	case 40:	return Register("di", regs_.rdi & 0xffff, Register::TYPE_GPR);
+	case 41:	return Register("r8w", regs_.r8 & 0xffff, Register::TYPE_GPR);
+	case 42:	return Register("r9w", regs_.r9 & 0xffff, Register::TYPE_GPR);
+	case 43:	return Register("r10w", regs_.r10 & 0xffff, Register::TYPE_GPR);
+	case 44:	return Register("r11w", regs_.r11 & 0xffff, Register::TYPE_GPR);
+	case 45:	return Register("r12w", regs_.r12 & 0xffff, Register::TYPE_GPR);
+	case 46:	return Register("r13w", regs_.r13 & 0xffff, Register::TYPE_GPR);
+	case 47:	return Register("r14w", regs_.r14 & 0xffff, Register::TYPE_GPR);
+	case 48:	return Register("r15w", regs_.r15 & 0xffff, Register::TYPE_GPR);
+	case 49:	return Register("al", regs_.rax & 0xff, Register::TYPE_GPR);
+	case 50:	return Register("bl", regs_.rbx & 0xff, Register::TYPE_GPR);
+	case 51:	return Register("cl", regs_.rcx & 0xff, Register::TYPE_GPR);
+	case 52:	return Register("dl", regs_.rdx & 0xff, Register::TYPE_GPR);
+	case 53:	return Register("ah", (regs_.rax >> 8) & 0xff, Register::TYPE_GPR);
+	case 54:	return Register("bh", (regs_.rbx >> 8) & 0xff, Register::TYPE_GPR);
+	case 55:	return Register("ch", (regs_.rcx >> 8) & 0xff, Register::TYPE_GPR);
+	case 56:	return Register("dh", (regs_.rdx >> 8) & 0xff, Register::TYPE_GPR);
+	case 57:	return Register("spl", (regs_.rsp >> 8) & 0xff, Register::TYPE_GPR);
+	case 58:	return Register("bpl", (regs_.rbp >> 8) & 0xff, Register::TYPE_GPR);
+	case 59:	return Register("sil", (regs_.rsi >> 8) & 0xff, Register::TYPE_GPR);
+	case 60:	return Register("dil", (regs_.rdi >> 8) & 0xff, Register::TYPE_GPR);
+	case 61:	return Register("r8b", regs_.r8 & 0xff, Register::TYPE_GPR);
+	case 62:	return Register("r9b", regs_.r9 & 0xff, Register::TYPE_GPR);
+	case 63:	return Register("r10b", regs_.r10 & 0xff, Register::TYPE_GPR);
+	case 64:	return Register("r11b", regs_.r11 & 0xff, Register::TYPE_GPR);
+	case 65:	return Register("r12b", regs_.r12 & 0xff, Register::TYPE_GPR);
+	case 66:	return Register("r13b", regs_.r13 & 0xff, Register::TYPE_GPR);
+	case 67:	return Register("r14b", regs_.r14 & 0xff, Register::TYPE_GPR);
+	case 68:	return Register("r15b", regs_.r15 & 0xff, Register::TYPE_GPR);
+	case 69:	return Register("cs", regs_.cs, Register::TYPE_SEG, 0);
+	case 70:	return Register("ds", regs_.ds, Register::TYPE_SEG, 0);
+	case 71:	return Register("es", regs_.es, Register::TYPE_SEG, 0);
+	case 72:	return Register("fs", regs_.fs, Register::TYPE_SEG, regs_.fs_base);
+	case 73:	return Register("gs", regs_.gs, Register::TYPE_SEG, regs_.gs_base);
+	case 74:	return Register("ss", regs_.ss, Register::TYPE_SEG, 0);
+	case 75:	return Register("rflags", regs_.eflags, Register::TYPE_COND);
 #endif
-
-	return Register();
+	default:
+		return Register();
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -197,6 +306,8 @@ Register PlatformState::value(const QString &reg) const {
 // Desc: returns what is conceptually the frame pointer for this platform
 //------------------------------------------------------------------------------
 edb::address_t PlatformState::frame_pointer() const {
+	load(GROUP_GPR);
+
 #if defined(EDB_X86)
 	return regs_.ebp;
 #elif defined(EDB_X86_64)
@@ -209,6 +320,8 @@ edb::address_t PlatformState::frame_pointer() const {
 // Desc: returns the instruction pointer for this platform
 //------------------------------------------------------------------------------
 edb::address_t PlatformState::instruction_pointer() const {
+	load(GROUP_GPR);
+
 #if defined(EDB_X86)
 	return regs_.eip;
 #elif defined(EDB_X86_64)
@@ -221,6 +334,8 @@ edb::address_t PlatformState::instruction_pointer() const {
 // Desc: returns the stack pointer for this platform
 //------------------------------------------------------------------------------
 edb::address_t PlatformState::stack_pointer() const {
+	load(GROUP_GPR);
+
 #if defined(EDB_X86)
 	return regs_.esp;
 #elif defined(EDB_X86_64)
@@ -233,6 +348,7 @@ edb::address_t PlatformState::stack_pointer() const {
 // Desc:
 //------------------------------------------------------------------------------
 edb::reg_t PlatformState::debug_register(int n) const {
+	load(GROUP_DEBUG);
 	return dr_[n];
 }
 
@@ -241,6 +357,8 @@ edb::reg_t PlatformState::debug_register(int n) const {
 // Desc:
 //------------------------------------------------------------------------------
 edb::reg_t PlatformState::flags() const {
+	load(GROUP_GPR);
+
 #if defined(EDB_X86)
 	return regs_.eflags;
 #elif defined(EDB_X86_64)
@@ -254,6 +372,8 @@ edb::reg_t PlatformState::flags() const {
 //------------------------------------------------------------------------------
 long double PlatformState::fpu_register(int n) const {
 
+	load(GROUP_FPU);
+
 	if(sizeof(long double) == 16) {
 		// st_space is an array of 128 bytes, 16 bytes for each of 8 FPU registers
 		const long double *const p = reinterpret_cast<const long double *>(fpregs_.st_space);
@@ -267,6 +387,8 @@ long double PlatformState::fpu_register(int n) const {
 // Desc:
 //------------------------------------------------------------------------------
 void PlatformState::adjust_stack(int bytes) {
+	modify(GROUP_GPR);
+
 #if defined(EDB_X86)
 	regs_.esp += bytes;
 #elif defined(EDB_X86_64)
@@ -286,6 +408,21 @@ void PlatformState::clear() {
 	fs_base = 0;
 	gs_base = 0;
 #endif
+
+	// there is nothing left to fetch, and all of it should be written back
+	loaded_ = GROUP_ALL;
+	dirty_  = GROUP_ALL;
+	stale_  = false;
+}
+
+//------------------------------------------------------------------------------
+// Name: capture()
+// Desc: fetches every group while the thread is still where it was taken and
+//       marks all of them to be written back
+//------------------------------------------------------------------------------
+void PlatformState::capture() {
+	load(GROUP_ALL);
+	dirty_ = GROUP_ALL;
 }
 
 //------------------------------------------------------------------------------
@@ -293,6 +430,7 @@ void PlatformState::clear() {
 // Desc:
 //------------------------------------------------------------------------------
 void PlatformState::set_debug_register(int n, edb::reg_t value) {
+	modify(GROUP_DEBUG);
 	dr_[n] = value;
 }
 
@@ -301,6 +439,8 @@ void PlatformState::set_debug_register(int n, edb::reg_t value) {
 // Desc:
 //------------------------------------------------------------------------------
 void PlatformState::set_flags(edb::reg_t flags) {
+	modify(GROUP_GPR);
+
 #if defined(EDB_X86)
 	regs_.eflags = flags;
 #elif defined(EDB_X86_64)
@@ -313,6 +453,8 @@ void PlatformState::set_flags(edb::reg_t flags) {
 // Desc:
 //------------------------------------------------------------------------------
 void PlatformState::set_instruction_pointer(edb::address_t value) {
+	modify(GROUP_GPR);
+
 #if defined(EDB_X86)
 	regs_.eip = value;
 	regs_.orig_eax = -1;
@@ -328,6 +470,8 @@ void PlatformState::set_instruction_pointer(edb::address_t value) {
 //------------------------------------------------------------------------------
 void PlatformState::set_register(const QString &name, edb::reg_t value) {
 
+	modify(GROUP_GPR);
+
 	const QString lreg = name.toLower();
 #if defined(EDB_X86)
 	if(lreg == "eax") { regs_.eax = value; }
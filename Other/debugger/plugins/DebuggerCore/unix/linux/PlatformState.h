@@ -23,6 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Types.h"
 #include <sys/user.h>
 
+class DebuggerCore;
+
 class PlatformState : public StateInterface {
 	friend class DebuggerCore;
 
@@ -36,6 +38,8 @@ public:
 	virtual QString flags_to_string() const;
 	virtual QString flags_to_string(edb::reg_t flags) const;
 	virtual Register value(const QString &reg) const;
+	virtual int register_id(const QString &reg) const;
+	virtual Register register_value(int id) const;
 	virtual edb::address_t frame_pointer() const;
 	virtual edb::address_t instruction_pointer() const;
 	virtual edb::address_t stack_pointer() const;
@@ -44,6 +48,7 @@ public:
 	virtual long double fpu_register(int n) const;
 	virtual void adjust_stack(int bytes);
 	virtual void clear();
+	virtual void capture();
 	virtual void set_debug_register(int n, edb::reg_t value);
 	virtual void set_flags(edb::reg_t flags);
 	virtual void set_instruction_pointer(edb::address_t value);
@@ -52,13 +57,38 @@ public:
 	virtual QByteArray xmm_register(int n) const;
 
 private:
-	struct user_regs_struct   regs_;
-	struct user_fpregs_struct fpregs_;
-	edb::reg_t                dr_[8];
+	// the registers come in groups which are each fetched from the thread the
+	// first time that something in them is used
+	enum {
+		GROUP_GPR           = 0x01,
+		GROUP_SEGMENT_BASES = 0x02,
+		GROUP_FPU           = 0x04,
+		GROUP_DEBUG         = 0x08,
+		GROUP_ALL           = 0x0f
+	};
+
+private:
+	void load(unsigned int groups) const;
+	void modify(unsigned int groups);
+	void copy_groups(const PlatformState &other, unsigned int groups) const;
+
+private:
+	mutable struct user_regs_struct   regs_;
+	mutable struct user_fpregs_struct fpregs_;
+	mutable edb::reg_t                dr_[8];
 #if defined(EDB_X86)
-	edb::address_t            fs_base;
-	edb::address_t            gs_base;
+	mutable edb::address_t            fs_base;
+	mutable edb::address_t            gs_base;
 #endif
+
+	// where the missing groups come from, core_ is null for a state which
+	// isn't attached to a thread
+	DebuggerCore *                    core_;
+	edb::tid_t                        tid_;
+	quint64                           generation_;
+	mutable unsigned int              loaded_;
+	mutable unsigned int              dirty_;
+	mutable bool                      stale_; // groups were needed after the thread ran
 };
 
 #endif
@@ -60,7 +60,7 @@ private:
 // Name: DebuggerCore()
 // Desc: constructor
 //------------------------------------------------------------------------------
-DebuggerCore::DebuggerCore() : page_size_(0), process_handle_(0), start_address(0), image_base(0) {
+DebuggerCore::DebuggerCore() : page_size_(0), process_handle_(0), memory_generation_(1), start_address(0), image_base(0) {
 	DebugSetProcessKillOnExit(false);
 
 	SYSTEM_INFO sys_info;
@@ -259,18 +259,7 @@ bool DebuggerCore::read_bytes(edb::address_t address, void *buf, std::size_t len
 
 				if(part_ok) {
 					ok = true;
-					Q_FOREACH(const Breakpoint::pointer &bp, breakpoints_) {
-						if((bp->address() + breakpoint_size()) > cur_address && bp->address() <= cur_end) {
-							// show the original bytes in the buffer..
-							const QByteArray& bytes = bp->original_bytes();
-							Q_ASSERT(bytes.size() == breakpoint_size());
-							size_t offset = qMax(bp->address(), cur_address) - bp->address();
-							const size_t bp_size = qMin<size_t>(breakpoint_size(), (end_address - bp->address() + 1)) - offset;
-							const void* bp_src = bytes.data() + offset;
-							void* bp_dest = reinterpret_cast<quint8 *>(buf) + (bp->address() + offset - address);
-							memcpy(bp_dest, bp_src, bp_size);
-						}
-					}
+					apply_breakpoint_overlay(cur_address, reinterpret_cast<quint8 *>(cur_dest), cur_len);
 				}
 
 				if(changed) {
@@ -313,6 +302,8 @@ bool DebuggerCore::write_bytes(edb::address_t address, const void *buf, std::siz
 			return true;
 		}
 
+		++memory_generation_;
+
 		const edb::address_t max_address = std::numeric_limits<edb::address_t>::max();
 
 		edb::address_t cur_address = address;
@@ -437,6 +428,8 @@ void DebuggerCore::resume(edb::EVENT_STATUS status) {
 
 	if(attached()) {
 		if(status != edb::DEBUG_STOP) {
+			++memory_generation_;
+
 			// TODO: does this resume *all* threads?
 			// it does! (unless you manually paused one using SuspendThread)
 			ContinueDebugEvent(
@@ -48,6 +48,7 @@ public:
 	virtual bool read_bytes(edb::address_t address, void *buf, std::size_t len);
 	virtual bool write_bytes(edb::address_t address, const void *buf, std::size_t len);
 	virtual int pointer_size() const;
+	virtual quint64 memory_generation() const { return memory_generation_; }
 
 public:
 	// thread support stuff (optional)
@@ -70,6 +71,7 @@ private:
 	edb::address_t   page_size_;
 	HANDLE           process_handle_;
 	QSet<edb::tid_t> threads_;
+	quint64          memory_generation_;
 
 private:
 	// Checks if an addition would cause overflow (wraparound)
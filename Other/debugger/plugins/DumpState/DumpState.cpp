@@ -91,7 +91,9 @@ void DumpState::dump_code(const State &state) {
 		if(edb::v1::get_instruction_bytes(address, buf, size)) {
 			edb::Instruction insn(buf, size, address, std::nothrow);
 			if(insn.valid()) {
-				std::cout << ((address == ip) ? "> " : "  ") << hex_string(address) << ": " << edisassm::to_string(insn) << "\n";
+				char text[edisassm::MAX_STRING_SIZE];
+				edisassm::to_string(insn, edisassm::syntax_intel(), text, sizeof(text));
+				std::cout << ((address == ip) ? "> " : "  ") << hex_string(address) << ": " << text << "\n";
 			} else {
 				break;
 			}
@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "SymbolManagerInterface.h"
 #include "Util.h"
 
+#include <QCoreApplication>
 #include <QFileInfo>
 #include <QHeaderView>
 #include <QMessageBox>
@@ -34,8 +35,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QtDebug>
 
 #include <boost/bind.hpp>
+#include <boost/ref.hpp>
 
 #include <algorithm>
+#include <cctype>
+#include <cstring>
 
 #ifdef ENABLE_GRAPH
 #include "GraphWidget.h"
@@ -93,6 +97,196 @@ namespace {
 		Q_ASSERT(result != 0);
 		return block_start(*result);
 	}
+
+	// results are added to the model (and have their pointers found) this
+	// many at a time, so the table fills in while a big heap is processed
+	const int result_batch_size = 16384;
+
+	// a copy of the whole heap, read in one go so that walking the chunks
+	// doesn't need a round trip to the debugger core for every header
+	class HeapSnapshot {
+	public:
+		HeapSnapshot() : address_(0) {
+		}
+
+	public:
+		bool read(edb::address_t start_address, edb::address_t end_address) {
+			const edb::address_t page_size  = edb::v1::debugger_core->page_size();
+			const edb::address_t page_start = start_address & ~(page_size - 1);
+			const edb::address_t page_end   = (end_address + page_size - 1) & ~(page_size - 1);
+			const edb::address_t pages      = (page_end - page_start) / page_size;
+
+			address_ = page_start;
+			bytes_.fill(0, pages * page_size);
+			return pages != 0 && edb::v1::debugger_core->read_pages(page_start, bytes_.data(), pages);
+		}
+
+		// how many bytes of the snapshot there are at address (0 if it isn't in it)
+		std::size_t available(edb::address_t address) const {
+			if(address < address_ || address - address_ >= static_cast<edb::address_t>(bytes_.size())) {
+				return 0;
+			}
+			return bytes_.size() - (address - address_);
+		}
+
+		const quint8 *at(edb::address_t address) const {
+			return bytes_.constData() + (address - address_);
+		}
+
+		// copies n bytes at address, anything outside of the snapshot reads as 0
+		void copy(edb::address_t address, void *p, std::size_t n) const {
+			const std::size_t count = qMin(available(address), n);
+			std::memset(p, 0, n);
+			if(count != 0) {
+				std::memcpy(p, at(address), count);
+			}
+		}
+
+	private:
+		edb::address_t  address_;
+		QVector<quint8> bytes_;
+	};
+
+	// where a block's data is, sorted by start, so any address can be mapped
+	// back to the block it is inside of with a binary search
+	struct BlockInterval {
+		edb::address_t start;
+		edb::address_t end;
+		edb::address_t block;
+	};
+
+	bool interval_less(edb::address_t address, const BlockInterval &interval) {
+		return address < interval.start;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: find_block(const QVector<BlockInterval> &blocks, edb::address_t address)
+	// Desc: returns the block containing address (or 0 if there isn't one)
+	//------------------------------------------------------------------------------
+	edb::address_t find_block(const QVector<BlockInterval> &blocks, edb::address_t address) {
+
+		if(blocks.isEmpty() || address < blocks.first().start || address >= blocks.last().end) {
+			return 0;
+		}
+
+		// the last block which starts at or before address
+		QVector<BlockInterval>::const_iterator it = std::upper_bound(blocks.begin(), blocks.end(), address, interval_less);
+		--it;
+		return (address < it->end) ? it->block : 0;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: escape_string(QString &s)
+	// Desc: the same escapes edb::v1::get_ascii_string_at_address uses
+	//------------------------------------------------------------------------------
+	void escape_string(QString &s) {
+		s.replace("\r", "\\r");
+		s.replace("\n", "\\n");
+		s.replace("\t", "\\t");
+		s.replace("\v", "\\v");
+		s.replace("\"", "\\\"");
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: ascii_string_at(const HeapSnapshot &snapshot, edb::address_t address, int min_length, int max_length, QString &s)
+	// Desc: edb::v1::get_ascii_string_at_address, reading from the snapshot
+	//------------------------------------------------------------------------------
+	bool ascii_string_at(const HeapSnapshot &snapshot, edb::address_t address, int min_length, int max_length, QString &s) {
+
+		if(snapshot.available(address) == 0) {
+			return false;
+		}
+
+		const quint8 *const p = snapshot.at(address);
+		const int n = static_cast<int>(qMin<std::size_t>(snapshot.available(address), qMax(max_length, 0)));
+
+		int length = 0;
+		while(length < n && p[length] < 0x80 && (std::isprint(p[length]) || std::isspace(p[length]))) {
+			++length;
+		}
+
+		if(length == 0 || length < min_length) {
+			return false;
+		}
+
+		s = QString::fromLatin1(reinterpret_cast<const char *>(p), length);
+		escape_string(s);
+		return true;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: utf16_string_at(const HeapSnapshot &snapshot, edb::address_t address, int min_length, int max_length, QString &s)
+	// Desc: edb::v1::get_utf16_string_at_address, reading from the snapshot
+	//------------------------------------------------------------------------------
+	bool utf16_string_at(const HeapSnapshot &snapshot, edb::address_t address, int min_length, int max_length, QString &s) {
+
+		if(snapshot.available(address) == 0) {
+			return false;
+		}
+
+		const quint8 *const p = snapshot.at(address);
+		const int n = static_cast<int>(qMin<std::size_t>(snapshot.available(address) / 2, qMax(max_length, 0)));
+
+		s.clear();
+		for(int i = 0; i < n; ++i) {
+			// for now, we only acknowledge ASCII chars encoded as unicode
+			const quint16 ch = p[i * 2] | (p[i * 2 + 1] << 8);
+			if(ch < 0x20 || ch >= 0x80) {
+				break;
+			}
+			s += QChar(ch);
+		}
+
+		if(s.isEmpty() || s.length() < min_length) {
+			return false;
+		}
+
+		escape_string(s);
+		return true;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: find_pointers(const HeapSnapshot &snapshot, const QVector<BlockInterval> &blocks, Result &result)
+	// Desc: checks every word of the block for a pointer into a block (not just
+	//       to the start of one)
+	//------------------------------------------------------------------------------
+	void find_pointers(const HeapSnapshot &snapshot, const QVector<BlockInterval> &blocks, Result &result) {
+		if(result.data.isEmpty()) {
+			edb::address_t block_ptr = block_start(result);
+			edb::address_t block_end = block_ptr + result.size;
+
+			while(block_ptr < block_end && snapshot.available(block_ptr) >= sizeof(edb::address_t)) {
+
+				edb::address_t pointer;
+				std::memcpy(&pointer, snapshot.at(block_ptr), sizeof(pointer));
+
+				if(const edb::address_t block = find_block(blocks, pointer)) {
+				#if QT_POINTER_SIZE == 4
+					result.data += QString("dword ptr [%1] |").arg(edb::v1::format_pointer(pointer));
+				#elif QT_POINTER_SIZE == 8
+					result.data += QString("qword ptr [%1] |").arg(edb::v1::format_pointer(pointer));
+				#endif
+					result.points_to.push_back(block);
+				}
+
+				block_ptr += sizeof(edb::address_t);
+			}
+
+			result.data.truncate(result.data.size() - 2);
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: detect_pointers(const HeapSnapshot &snapshot, const QVector<BlockInterval> &blocks, QVector<Result> &results, int first, int last)
+	// Desc: finds the pointers in results [first, last)
+	//------------------------------------------------------------------------------
+	void detect_pointers(const HeapSnapshot &snapshot, const QVector<BlockInterval> &blocks, QVector<Result> &results, int first, int last) {
+	#ifdef USE_QT_CONCURRENT
+		QtConcurrent::blockingMap(results.begin() + first, results.begin() + last, boost::bind(find_pointers, boost::cref(snapshot), boost::cref(blocks), _1));
+	#else
+		std::for_each(results.begin() + first, results.begin() + last, boost::bind(find_pointers, boost::cref(snapshot), boost::cref(blocks), _1));
+	#endif
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -182,71 +376,13 @@ void DialogHeap::get_library_names(QString &libcName, QString &ldName) const {
 	}
 }
 
-//------------------------------------------------------------------------------
-// Name: process_potential_pointer(const QHash<edb::address_t, edb::address_t> &targets, Result &result)
-// Desc:
-//------------------------------------------------------------------------------
-void DialogHeap::process_potential_pointer(const QHash<edb::address_t, edb::address_t> &targets, Result &result) {
-	if(result.data.isEmpty()) {
-		edb::address_t pointer;
-		edb::address_t block_ptr = block_start(result);
-		edb::address_t block_end = block_ptr + result.size;
-
-		while(block_ptr < block_end) {
-
-			if(edb::v1::debugger_core->read_bytes(block_ptr, &pointer, sizeof(pointer))) {
-				QHash<edb::address_t, edb::address_t>::const_iterator it = targets.find(pointer);
-				if(it != targets.end()) {
-				#if QT_POINTER_SIZE == 4
-					result.data += QString("dword ptr [%1] |").arg(edb::v1::format_pointer(it.key()));
-				#elif QT_POINTER_SIZE == 8
-					result.data += QString("qword ptr [%1] |").arg(edb::v1::format_pointer(it.key()));
-				#endif
-				result.points_to.push_back(it.value());
-				}
-			}
-			
-			block_ptr += sizeof(edb::address_t);
-		}
-		
-		result.data.truncate(result.data.size() - 2);
-	}
-}
-
-//------------------------------------------------------------------------------
-// Name: detect_pointers()
-// Desc:
-//------------------------------------------------------------------------------
-void DialogHeap::detect_pointers() {
-
-	qDebug() << "[Heap Analyzer] detecting pointers in heap blocks";
-
-	QHash<edb::address_t, edb::address_t> targets;
-	QVector<Result> &results = model_->results();
-
-	// the potential targets
-	qDebug() << "[Heap Analyzer] collecting possible targets addresses";
-	Q_FOREACH(const Result &result, results) {
-		edb::address_t block_ptr = block_start(result);
-		edb::address_t block_end = block_ptr + result.size;
-		while(block_ptr < block_end) {
-			targets.insert(block_ptr, result.block);
-			block_ptr += sizeof(edb::address_t);
-		}
-	}
-
-#ifdef USE_QT_CONCURRENT
-	QtConcurrent::blockingMap(results, boost::bind(&DialogHeap::process_potential_pointer, this, targets, _1));
-#else
-	std::for_each(results.begin(), results.end(), boost::bind(&DialogHeap::process_potential_pointer, this, targets, _1));
-#endif
-
-	model_->update();
-}
-
 //------------------------------------------------------------------------------
 // Name: collect_blocks(edb::address_t start_address, edb::address_t end_address)
-// Desc:
+// Desc: the heap is read in one go and the chunks are walked in the copy, the
+//       blocks are added to the table a batch at a time. Then the blocks are
+//       searched for pointers to other blocks (in parallel when possible), a
+//       batch at a time as well. The event loop gets a turn after each batch
+//       so that the table fills in as the walk goes.
 //------------------------------------------------------------------------------
 void DialogHeap::collect_blocks(edb::address_t start_address, edb::address_t end_address) {
 	model_->clearResults();
@@ -255,16 +391,34 @@ void DialogHeap::collect_blocks(edb::address_t start_address, edb::address_t end
 
 	if(start_address != 0 && end_address != 0) {
 #if defined(Q_OS_LINUX) || defined(Q_OS_FREEBSD) || defined(Q_OS_OPENBSD)
+		HeapSnapshot snapshot;
+
+		try {
+			if(!snapshot.read(start_address, end_address)) {
+				qDebug() << "[Heap Analyzer] failed to read the heap";
+				return;
+			}
+		} catch(const std::bad_alloc &) {
+			QMessageBox::information(
+				0,
+				tr("Memroy Allocation Error"),
+				tr("Unable to satisfy memory allocation request for requested region."));
+			return;
+		}
+
 		malloc_chunk currentChunk;
 		malloc_chunk nextChunk;
 		edb::address_t currentChunkAddress = start_address;
 
-		model_->setUpdatesEnabled(false);
+		model_->setUpdatesEnabled(true);
+
+		QVector<Result>        batch;
+		QVector<BlockInterval> blocks;
 
 		const edb::address_t how_many = end_address - start_address;
 		while(currentChunkAddress != end_address) {
 			// read in the current chunk..
-			edb::v1::debugger_core->read_bytes(currentChunkAddress, &currentChunk, sizeof(currentChunk));
+			snapshot.copy(currentChunkAddress, &currentChunk, sizeof(currentChunk));
 
 			// figure out the address of the next chunk
 			const edb::address_t nextChunkAddress = next_chunk(currentChunkAddress, currentChunk);
@@ -277,7 +431,7 @@ void DialogHeap::collect_blocks(edb::address_t start_address, edb::address_t end
 					currentChunk.chunk_size(),
 					tr("Top"));
 
-				model_->addResult(r);
+				batch.push_back(r);
 
 			} else {
 
@@ -289,35 +443,33 @@ void DialogHeap::collect_blocks(edb::address_t start_address, edb::address_t end
 				QString data;
 
 				// read in the next chunk
-				edb::v1::debugger_core->read_bytes(nextChunkAddress, &nextChunk, sizeof(nextChunk));
+				snapshot.copy(nextChunkAddress, &nextChunk, sizeof(nextChunk));
 
 				// if this block is a container for an ascii string, display it...
 				// there is a lot of room for improvement here, but it's a start
 				QString asciiData;
 				QString utf16Data;
-				int asciisz;
-				int utf16sz;
-				if(edb::v1::get_ascii_string_at_address(
+				if(ascii_string_at(
+						snapshot,
 						block_start(currentChunkAddress),
-						asciiData,
 						min_string_length,
 						currentChunk.chunk_size(),
-						asciisz)) {
+						asciiData)) {
 
 					data = QString("ASCII \"%1\"").arg(asciiData);
-				} else if(edb::v1::get_utf16_string_at_address(
+				} else if(utf16_string_at(
+						snapshot,
 						block_start(currentChunkAddress),
-						utf16Data,
 						min_string_length,
 						currentChunk.chunk_size(),
-						utf16sz)) {
+						utf16Data)) {
 					data = QString("UTF-16 \"%1\"").arg(utf16Data);
 				} else {
 				
 					using std::memcmp;
 					
 					quint8 bytes[16];
-					edb::v1::debugger_core->read_bytes(block_start(currentChunkAddress), bytes, sizeof(bytes));
+					snapshot.copy(block_start(currentChunkAddress), bytes, sizeof(bytes));
 					
 					if(memcmp(bytes, "\x89\x50\x4e\x47", 4) == 0) {
 						data = "PNG IMAGE";
@@ -339,7 +491,21 @@ void DialogHeap::collect_blocks(edb::address_t start_address, edb::address_t end
 					nextChunk.prev_inuse() ? tr("Busy") : tr("Free"),
 					data);
 
-				model_->addResult(r);
+				batch.push_back(r);
+			}
+
+			// the chunks are walked in address order, so this stays sorted
+			const BlockInterval interval = { block_start(batch.last()), block_start(batch.last()) + batch.last().size, batch.last().block };
+			blocks.push_back(interval);
+
+			if(batch.size() >= result_batch_size) {
+				model_->addResults(batch);
+				batch.clear();
+				ui->progressBar->setValue(util::percentage(currentChunkAddress - start_address, how_many) / 2);
+
+				// let the batch (and the progress) paint, input is held back
+				// so that nothing can start another walk or touch the results
+				QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
 			}
 
 			// avoif self referencing blocks
@@ -348,13 +514,20 @@ void DialogHeap::collect_blocks(edb::address_t start_address, edb::address_t end
 			}
 
 			currentChunkAddress = nextChunkAddress;
-
-			ui->progressBar->setValue(util::percentage(currentChunkAddress - start_address, how_many));
 		}
 
-		detect_pointers();
-		model_->setUpdatesEnabled(true);
+		model_->addResults(batch);
+
+		qDebug() << "[Heap Analyzer] detecting pointers in heap blocks";
 
+		QVector<Result> &results = model_->results();
+		for(int first = 0; first < results.size(); first += result_batch_size) {
+			const int last = qMin(first + result_batch_size, results.size());
+			detect_pointers(snapshot, blocks, results, first, last);
+			model_->updateRows(first, last - 1);
+			ui->progressBar->setValue(50 + util::percentage(last, results.size()) / 2);
+			QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+		}
 
 #else
 	#error "Unsupported Platform"
@@ -46,9 +46,7 @@ private:
 private:
 	void get_library_names(QString &libcName, QString &ldName) const;
 	void collect_blocks(edb::address_t start_address, edb::address_t end_address);
-	void detect_pointers();
 	void do_find();
-	void process_potential_pointer(const QHash<edb::address_t, edb::address_t> &targets, Result &result);
 
 	edb::address_t find_heap_start_heuristic(edb::address_t end_address, size_t offset) const;
 
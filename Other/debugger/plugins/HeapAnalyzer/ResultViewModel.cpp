@@ -88,6 +88,33 @@ void ResultViewModel::addResult(const Result &r) {
 	update();
 }
 
+//------------------------------------------------------------------------------
+// Name: addResults(const QVector<Result> &results)
+// Desc: appends a batch of results, the views only hear about the new rows
+//       (rather than a full reset) so this is cheap to do repeatedly
+//------------------------------------------------------------------------------
+void ResultViewModel::addResults(const QVector<Result> &results) {
+	if(!results.isEmpty()) {
+		if(updates_enabled_) {
+			beginInsertRows(QModelIndex(), results_.size(), results_.size() + results.size() - 1);
+			results_ += results;
+			endInsertRows();
+		} else {
+			results_ += results;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: updateRows(int first, int last)
+// Desc: lets the views know that the rows [first, last] have changed
+//------------------------------------------------------------------------------
+void ResultViewModel::updateRows(int first, int last) {
+	if(updates_enabled_ && first <= last) {
+		emit dataChanged(index(first, 0), index(last, columnCount() - 1));
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: clearResults()
 // Desc:
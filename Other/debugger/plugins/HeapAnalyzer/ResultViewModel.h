@@ -53,7 +53,9 @@ public:
 
 public:
 	void addResult(const Result &r);
+	void addResults(const QVector<Result> &results);
 	void clearResults();
+	void updateRows(int first, int last);
 	void update();
 	void setUpdatesEnabled(bool value);
 	bool updatesEnabled() const;
@@ -20,15 +20,25 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DebuggerCoreInterface.h"
 #include "Debugger.h"
 #include "MemoryRegions.h"
-#include "ByteShiftArray.h"
 #include "Util.h"
 
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QSortFilterProxyModel>
 #include <QListWidgetItem>
+#include <QThread>
+#include <QVector>
 #include <QDebug>
 
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#ifdef USE_QT_CONCURRENT
+#include <QtConcurrentMap>
+#else
+#include <algorithm>
+#endif
+
 #include "ui_dialogopcodes.h"
 
 namespace {
@@ -37,126 +47,218 @@ namespace {
 #elif defined(EDB_X86_64)
 	const edb::Operand::Register STACK_REG = edb::Operand::REG_RSP;
 #endif
-}
 
-//------------------------------------------------------------------------------
-// Name: DialogOpcodes(QWidget *parent)
-// Desc:
-//------------------------------------------------------------------------------
-DialogOpcodes::DialogOpcodes(QWidget *parent) : QDialog(parent), ui(new Ui::DialogOpcodes) {
-	ui->setupUi(this);
-	ui->tableView->verticalHeader()->hide();
-	ui->tableView->horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
-
-	filter_model_ = new QSortFilterProxyModel(this);
-	connect(ui->txtSearch, SIGNAL(textChanged(const QString &)), filter_model_, SLOT(setFilterFixedString(const QString &)));
-
-#if defined(EDB_X86)
-	ui->comboBox->addItem("EAX -> EIP", 1);
-	ui->comboBox->addItem("EBX -> EIP", 2);
-	ui->comboBox->addItem("ECX -> EIP", 3);
-	ui->comboBox->addItem("EDX -> EIP", 4);
-	ui->comboBox->addItem("EBP -> EIP", 5);
-	ui->comboBox->addItem("ESP -> EIP", 6);
-	ui->comboBox->addItem("ESI -> EIP", 7);
-	ui->comboBox->addItem("EDI -> EIP", 8);
-	ui->comboBox->addItem("ANY REGISTER -> EIP", 17);
-	ui->comboBox->addItem("[ESP] -> EIP", 18);
-	ui->comboBox->addItem("[ESP + 4] -> EIP", 19);
-	ui->comboBox->addItem("[ESP + 8] -> EIP", 20);
-	ui->comboBox->addItem("[ESP - 4] -> EIP", 21);
-#elif defined(EDB_X86_64)
-	ui->comboBox->addItem("RAX -> RIP", 1);
-	ui->comboBox->addItem("RBX -> RIP", 2);
-	ui->comboBox->addItem("RCX -> RIP", 3);
-	ui->comboBox->addItem("RDX -> RIP", 4);
-	ui->comboBox->addItem("RBP -> RIP", 5);
-	ui->comboBox->addItem("RSP -> RIP", 6);
-	ui->comboBox->addItem("RSI -> RIP", 7);
-	ui->comboBox->addItem("RDI -> RIP", 8);
-	ui->comboBox->addItem("R8 -> RIP", 9);
-	ui->comboBox->addItem("R9 -> RIP", 10);
-	ui->comboBox->addItem("R10 -> RIP", 11);
-	ui->comboBox->addItem("R11 -> RIP", 12);
-	ui->comboBox->addItem("R12 -> RIP", 13);
-	ui->comboBox->addItem("R13 -> RIP", 14);
-	ui->comboBox->addItem("R14 -> RIP", 15);
-	ui->comboBox->addItem("R15 -> RIP", 16);
-	ui->comboBox->addItem("ANY REGISTER -> RIP", 17);
-	ui->comboBox->addItem("[RSP] -> RIP", 18);
-	ui->comboBox->addItem("[RSP + 8] -> RIP", 19);
-	ui->comboBox->addItem("[RSP + 16] -> RIP", 20);
-	ui->comboBox->addItem("[RSP - 8] -> RIP", 21);
-#endif
-}
+// we currently only support opcodes sequences up to 8 bytes big
+const std::size_t window_size = sizeof(quint64);
+
+// the smallest piece of a region which is worth giving its own thread
+const std::size_t min_shard_size = 64 * 1024;
+
+typedef QList<edb::Instruction> InstructionList;
+
+enum SearchType {
+	SEARCH_REG_TO_IP,
+	SEARCH_ESP_ADD_0,
+	SEARCH_ESP_ADD_REGX1,
+	SEARCH_ESP_ADD_REGX2,
+	SEARCH_ESP_SUB_REGX1
+};
+
+// a search class compiled down to the bytes its first instruction can start
+// with (after any prefixes), only offsets which pass this get disassembled
+struct SearchClass {
+	SearchType                        type;
+	QVector<edb::Operand::Register>   registers;    // for SEARCH_REG_TO_IP
+	bool                              opcodes[256];
+	quint8                            ff_regs;      // the FF /r forms which are allowed
+	bool                              pop_segment;  // 0F A1/A9 (pop fs/gs)
+};
+
+struct OpcodeResult {
+	edb::address_t address;
+	QString        text;
+};
+
+// a part of a region's snapshot, the snapshot is padded with window_size
+// zeros so that the tests can look past the end of the region
+struct SearchShard {
+	const quint8 *       first;
+	edb::address_t       address;
+	std::size_t          begin;
+	std::size_t          end;
+	QList<OpcodeResult>  results;
+};
 
 //------------------------------------------------------------------------------
-// Name: ~DialogOpcodes()
+// Name: is_prefix(quint8 byte)
 // Desc:
 //------------------------------------------------------------------------------
-DialogOpcodes::~DialogOpcodes() {
-	delete ui;
+bool is_prefix(quint8 byte) {
+	switch(byte) {
+	case 0x26: case 0x2e: case 0x36: case 0x3e:
+	case 0x64: case 0x65: case 0x66: case 0x67:
+	case 0xf0: case 0xf2: case 0xf3:
+		return true;
+	default:
+	#if defined(EDB_X86_64)
+		// REX
+		return (byte & 0xf0) == 0x40;
+	#else
+		return false;
+	#endif
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: on_listWidget_itemDoubleClicked(QListWidgetItem *item)
-// Desc: follows the found item in the data view
+// Name: add_opcodes(SearchClass &search, int first, int last)
+// Desc: marks [first, last] as possible first opcode bytes
 //------------------------------------------------------------------------------
-void DialogOpcodes::on_listWidget_itemDoubleClicked(QListWidgetItem *item) {
-	bool ok;
-	const edb::address_t addr = item->data(Qt::UserRole).toULongLong(&ok);
-	if(ok) {
-		edb::v1::jump_to_address(addr);
+void add_opcodes(SearchClass &search, int first, int last) {
+	for(int i = first; i <= last; ++i) {
+		search.opcodes[i] = true;
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: showEvent(QShowEvent *)
-// Desc:
+// Name: compile_search(int classtype)
+// Desc: the opcodes each test can match on, the register tests match jmp/call
+//       reg (FF /2, FF /4) and push reg (50-57, FF /6). The stack tests match
+//       ret (C2, C3), jmp/call [esp+n] (FF /2-/5), pop (07, 17, 1F, 58-5F,
+//       8F, 0F A1, 0F A9) and add/sub esp, imm (81, 83)
 //------------------------------------------------------------------------------
-void DialogOpcodes::showEvent(QShowEvent *) {
-	filter_model_->setFilterKeyColumn(3);
-	filter_model_->setSourceModel(&edb::v1::memory_regions());
-	ui->tableView->setModel(filter_model_);
-	ui->progressBar->setValue(0);
-	ui->listWidget->clear();
+SearchClass compile_search(int classtype) {
+
+	SearchClass search;
+	search.type = SEARCH_REG_TO_IP;
+	std::fill(search.opcodes, search.opcodes + 256, false);
+	search.ff_regs     = 0;
+	search.pop_segment = false;
+
+	switch(classtype) {
+#if defined(EDB_X86)
+	case 1: search.registers << edb::Operand::REG_EAX; break;
+	case 2: search.registers << edb::Operand::REG_EBX; break;
+	case 3: search.registers << edb::Operand::REG_ECX; break;
+	case 4: search.registers << edb::Operand::REG_EDX; break;
+	case 5: search.registers << edb::Operand::REG_EBP; break;
+	case 6: search.registers << edb::Operand::REG_ESP; break;
+	case 7: search.registers << edb::Operand::REG_ESI; break;
+	case 8: search.registers << edb::Operand::REG_EDI; break;
+	case 17:
+		search.registers
+			<< edb::Operand::REG_EAX << edb::Operand::REG_EBX << edb::Operand::REG_ECX << edb::Operand::REG_EDX
+			<< edb::Operand::REG_EBP << edb::Operand::REG_ESP << edb::Operand::REG_ESI << edb::Operand::REG_EDI;
+		break;
+#elif defined(EDB_X86_64)
+	case 1: search.registers << edb::Operand::REG_RAX; break;
+	case 2: search.registers << edb::Operand::REG_RBX; break;
+	case 3: search.registers << edb::Operand::REG_RCX; break;
+	case 4: search.registers << edb::Operand::REG_RDX; break;
+	case 5: search.registers << edb::Operand::REG_RBP; break;
+	case 6: search.registers << edb::Operand::REG_RSP; break;
+	case 7: search.registers << edb::Operand::REG_RSI; break;
+	case 8: search.registers << edb::Operand::REG_RDI; break;
+	case 9: search.registers << edb::Operand::REG_R8; break;
+	case 10: search.registers << edb::Operand::REG_R9; break;
+	case 11: search.registers << edb::Operand::REG_R10; break;
+	case 12: search.registers << edb::Operand::REG_R11; break;
+	case 13: search.registers << edb::Operand::REG_R12; break;
+	case 14: search.registers << edb::Operand::REG_R13; break;
+	case 15: search.registers << edb::Operand::REG_R14; break;
+	case 16: search.registers << edb::Operand::REG_R15; break;
+	case 17:
+		search.registers
+			<< edb::Operand::REG_RAX << edb::Operand::REG_RBX << edb::Operand::REG_RCX << edb::Operand::REG_RDX
+			<< edb::Operand::REG_RBP << edb::Operand::REG_RSP << edb::Operand::REG_RSI << edb::Operand::REG_RDI
+			<< edb::Operand::REG_R8  << edb::Operand::REG_R9  << edb::Operand::REG_R10 << edb::Operand::REG_R11
+			<< edb::Operand::REG_R12 << edb::Operand::REG_R13 << edb::Operand::REG_R14 << edb::Operand::REG_R15;
+		break;
+#endif
+	case 18: search.type = SEARCH_ESP_ADD_0;     break;
+	case 19: search.type = SEARCH_ESP_ADD_REGX1; break;
+	case 20: search.type = SEARCH_ESP_ADD_REGX2; break;
+	case 21: search.type = SEARCH_ESP_SUB_REGX1; break;
+	}
+
+	if(!search.registers.isEmpty()) {
+		search.type = SEARCH_REG_TO_IP;
+		add_opcodes(search, 0x50, 0x57);
+		search.opcodes[0xff] = true;
+		search.ff_regs       = (1 << 2) | (1 << 4) | (1 << 6);
+		return search;
+	}
+
+	// every stack test can be a (near or far) jmp/call through the stack
+	search.opcodes[0xff] = true;
+	search.ff_regs       = (1 << 2) | (1 << 3) | (1 << 4) | (1 << 5);
+
+	switch(search.type) {
+	case SEARCH_ESP_ADD_0:
+		search.opcodes[0xc2] = true;
+		search.opcodes[0xc3] = true;
+		add_opcodes(search, 0x58, 0x5f);
+		search.opcodes[0x8f] = true;
+		break;
+	case SEARCH_ESP_ADD_REGX1:
+	case SEARCH_ESP_ADD_REGX2:
+		add_opcodes(search, 0x58, 0x5f);
+		search.opcodes[0x07] = true;
+		search.opcodes[0x17] = true;
+		search.opcodes[0x1f] = true;
+		search.opcodes[0x8f] = true;
+		search.opcodes[0x0f] = true;
+		search.pop_segment   = true;
+		// fall through
+	case SEARCH_ESP_SUB_REGX1:
+		search.opcodes[0x81] = true;
+		search.opcodes[0x83] = true;
+		break;
+	default:
+		break;
+	}
+
+	return search;
 }
 
 //------------------------------------------------------------------------------
-// Name: add_result(QList<edb::Instruction> instructions, edb::address_t rva)
-// Desc:
+// Name: is_candidate(const SearchClass &search, const quint8 *p)
+// Desc: skips the prefixes and checks the opcode against the compiled class
 //------------------------------------------------------------------------------
-void DialogOpcodes::add_result(QList<edb::Instruction> instructions, edb::address_t rva) {
-	if(!instructions.isEmpty()) {
-		const edb::Instruction insn1 = instructions.takeFirst();
-
-		QString instruction_string = QString("%1: %2").arg(
-			edb::v1::format_pointer(rva),
-			QString::fromStdString(edisassm::to_string(insn1)));
+bool is_candidate(const SearchClass &search, const quint8 *p) {
 
+	const quint8 *const last = p + window_size;
+	while(p != last && is_prefix(*p)) {
+		++p;
+	}
 
-		Q_FOREACH(const edb::Instruction &instruction, instructions) {
-			instruction_string.append(QString("; %1").arg(QString::fromStdString(edisassm::to_string(instruction))));
-		}
+	if(p == last || !search.opcodes[*p]) {
+		return false;
+	}
 
-		QListWidgetItem *const item = new QListWidgetItem(instruction_string);
+	if(p + 1 == last) {
+		// let the disassembler decide on a truncated instruction
+		return true;
+	}
 
-		item->setData(Qt::UserRole, rva);
-		ui->listWidget->addItem(item);
+	switch(*p) {
+	case 0xff:
+		return (search.ff_regs >> ((p[1] >> 3) & 0x07)) & 1;
+	case 0x0f:
+		return search.pop_segment && (p[1] == 0xa1 || p[1] == 0xa9);
+	default:
+		return true;
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: test_reg_to_ip(const DialogOpcodes::OpcodeData &data, edb::address_t start_address)
+// Name: test_reg_to_ip(const quint8 *p, edb::address_t address, const QVector<edb::Operand::Register> &registers, InstructionList &results)
 // Desc:
 //------------------------------------------------------------------------------
-template <edb::Operand::Register REG>
-void DialogOpcodes::test_reg_to_ip(const DialogOpcodes::OpcodeData &data, edb::address_t start_address) {
+bool test_reg_to_ip(const quint8 *p, edb::address_t address, const QVector<edb::Operand::Register> &registers, InstructionList &results) {
 
-	const quint8 *p = data.data;
-	int len = sizeof(data);
+	int len = window_size;
 
-	edb::Instruction insn(p, len, 0, std::nothrow);
+	edb::Instruction insn(p, len, address, std::nothrow);
 
 	if(insn.valid()) {
 		const edb::Operand &op1 = insn.operand(0);
@@ -164,27 +266,27 @@ void DialogOpcodes::test_reg_to_ip(const DialogOpcodes::OpcodeData &data, edb::a
 		case edb::Instruction::OP_JMP:
 		case edb::Instruction::OP_CALL:
 			if(op1.general_type() == edb::Operand::TYPE_REGISTER) {
-				if(op1.reg() == REG) {
-					add_result((QList<edb::Instruction>() << insn), start_address);
-					return;
+				if(registers.contains(op1.reg())) {
+					results << insn;
+					return true;
 				}
 			}
 			break;
 
 		case edb::Instruction::OP_PUSH:
 			if(op1.general_type() == edb::Operand::TYPE_REGISTER) {
-				if(op1.reg() == REG) {
+				if(registers.contains(op1.reg())) {
 
 					p += insn.size();
 					len -= insn.size();
 
-					edb::Instruction insn2(p, len, 0, std::nothrow);
+					edb::Instruction insn2(p, len, address + insn.size(), std::nothrow);
 					if(insn2.valid()) {
 						const edb::Operand &op2 = insn2.operand(0);
 						switch(insn2.type()) {
 						case edb::Instruction::OP_RET:
-							add_result((QList<edb::Instruction>() << insn << insn2), start_address);
-							break;
+							results << insn << insn2;
+							return true;
 						case edb::Instruction::OP_JMP:
 						case edb::Instruction::OP_CALL:
 
@@ -193,13 +295,13 @@ void DialogOpcodes::test_reg_to_ip(const DialogOpcodes::OpcodeData &data, edb::a
 								if(op2.expression().displacement_type == edb::Operand::DISP_NONE) {
 
 									if(op2.expression().base == STACK_REG && op2.expression().index == edb::Operand::REG_NULL) {
-										add_result((QList<edb::Instruction>() << insn << insn2), start_address);
-										return;
+										results << insn << insn2;
+										return true;
 									}
 
 									if(op2.expression().index == STACK_REG && op2.expression().base == edb::Operand::REG_NULL) {
-										add_result((QList<edb::Instruction>() << insn << insn2), start_address);
-										return;
+										results << insn << insn2;
+										return true;
 									}
 								}
 							}
@@ -215,25 +317,25 @@ void DialogOpcodes::test_reg_to_ip(const DialogOpcodes::OpcodeData &data, edb::a
 			break;
 		}
 	}
+	return false;
 }
 
 //------------------------------------------------------------------------------
-// Name: test_esp_add_0(const OpcodeData &data, edb::address_t start_address)
+// Name: test_esp_add_0(const quint8 *p, edb::address_t address, InstructionList &results)
 // Desc:
 //------------------------------------------------------------------------------
-void DialogOpcodes::test_esp_add_0(const OpcodeData &data, edb::address_t start_address) {
+bool test_esp_add_0(const quint8 *p, edb::address_t address, InstructionList &results) {
 
-	const quint8 *p = data.data;
-	int len = sizeof(data);
+	int len = window_size;
 
-	edb::Instruction insn(p, len, 0, std::nothrow);
+	edb::Instruction insn(p, len, address, std::nothrow);
 
 	if(insn.valid()) {
 		const edb::Operand &op1 = insn.operand(0);
 		switch(insn.type()) {
 		case edb::Instruction::OP_RET:
-			add_result((QList<edb::Instruction>() << insn), start_address);
-			break;
+			results << insn;
+			return true;
 
 		case edb::Instruction::OP_CALL:
 		case edb::Instruction::OP_JMP:
@@ -242,13 +344,13 @@ void DialogOpcodes::test_esp_add_0(const OpcodeData &data, edb::address_t start_
 				if(op1.expression().displacement_type == edb::Operand::DISP_NONE) {
 
 					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << insn), start_address);
-						return;
+						results << insn;
+						return true;
 					}
 
 					if(op1.expression().index == STACK_REG && op1.expression().base == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << insn), start_address);
-						return;
+						results << insn;
+						return true;
 					}
 				}
 			}
@@ -259,7 +361,7 @@ void DialogOpcodes::test_esp_add_0(const OpcodeData &data, edb::address_t start_
 				p += insn.size();
 				len -= insn.size();
 
-				edb::Instruction insn2(p, len, 0, std::nothrow);
+				edb::Instruction insn2(p, len, address + insn.size(), std::nothrow);
 				if(insn2.valid()) {
 					const edb::Operand &op2 = insn2.operand(0);
 					switch(insn2.type()) {
@@ -269,7 +371,8 @@ void DialogOpcodes::test_esp_add_0(const OpcodeData &data, edb::address_t start_
 						if(op2.general_type() == edb::Operand::TYPE_REGISTER) {
 
 							if(op1.reg() == op2.reg()) {
-								add_result((QList<edb::Instruction>() << insn << insn2), start_address);
+								results << insn << insn2;
+								return true;
 							}
 						}
 						break;
@@ -284,18 +387,19 @@ void DialogOpcodes::test_esp_add_0(const OpcodeData &data, edb::address_t start_
 			break;
 		}
 	}
+	return false;
 }
 
 //------------------------------------------------------------------------------
-// Name: test_esp_add_regx1(const OpcodeData &data, edb::address_t start_address)
-// Desc:
+// Name: test_esp_add_regx(const quint8 *p, edb::address_t address, int count, InstructionList &results)
+// Desc: [ESP + 4] and [ESP + 8] -> EIP, count is the number of stack slots
+//       which have to be skipped (one or two pops)
 //------------------------------------------------------------------------------
-void DialogOpcodes::test_esp_add_regx1(const OpcodeData &data, edb::address_t start_address) {
+bool test_esp_add_regx(const quint8 *p, edb::address_t address, int count, InstructionList &results) {
 
-	const quint8 *p = data.data;
-	int len = sizeof(data);
+	int len = window_size;
 
-	edb::Instruction insn(p, len, 0, std::nothrow);
+	edb::Instruction insn(p, len, address, std::nothrow);
 
 	if(insn.valid()) {
 		const edb::Operand &op1 = insn.operand(0);
@@ -306,64 +410,66 @@ void DialogOpcodes::test_esp_add_regx1(const OpcodeData &data, edb::address_t st
 				p += insn.size();
 				len -= insn.size();
 
-				edb::Instruction insn2(p, len, 0, std::nothrow);
+				edb::Instruction insn2(p, len, address + insn.size(), std::nothrow);
 				if(insn2.valid()) {
-					if(insn2.type() == edb::Instruction::OP_RET) {
-						add_result((QList<edb::Instruction>() << insn << insn2), start_address);
+					const edb::Operand &op2 = insn2.operand(0);
+					if(count == 1) {
+						if(insn2.type() == edb::Instruction::OP_RET) {
+							results << insn << insn2;
+							return true;
+						}
+					} else if(insn2.type() == edb::Instruction::OP_POP) {
+
+						if(op2.general_type() != edb::Operand::TYPE_REGISTER || op2.reg() != STACK_REG) {
+							p += insn2.size();
+							len -= insn2.size();
+
+							edb::Instruction insn3(p, len, address + insn.size() + insn2.size(), std::nothrow);
+							if(insn3.valid()) {
+								if(insn3.type() == edb::Instruction::OP_RET) {
+									results << insn << insn2 << insn3;
+									return true;
+								}
+							}
+						}
 					}
 				}
 			}
 			break;
+
 		case edb::Instruction::OP_JMP:
 		case edb::Instruction::OP_CALL:
-
 			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
 
-				if(op1.displacement() == 4) {
+				if(op1.displacement() == static_cast<int>(sizeof(edb::reg_t) * count)) {
 					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << insn), start_address);
+						results << insn;
+						return true;
 					} else if(op1.expression().base == edb::Operand::REG_NULL && op1.expression().index == STACK_REG && op1.expression().scale == 1) {
-						add_result((QList<edb::Instruction>() << insn), start_address);
-					}
-
-				}
-			}
-			break;
-		case edb::Instruction::OP_SUB:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
-
-				const edb::Operand &op2 = insn.operand(1);
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
-
-					if(op2.immediate() == -static_cast<int>(sizeof(edb::reg_t))) {
-						p += insn.size();
-						len -= insn.size();
-
-						edb::Instruction insn2(p, len, 0, std::nothrow);
-						if(insn2.valid()) {
-							if(insn2.type() == edb::Instruction::OP_RET) {
-								add_result((QList<edb::Instruction>() << insn << insn2), start_address);
-							}
-						}
+						results << insn;
+						return true;
 					}
 				}
 			}
 			break;
 
+		case edb::Instruction::OP_SUB:
 		case edb::Instruction::OP_ADD:
 			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
 
 				const edb::Operand &op2 = insn.operand(1);
 				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
 
-					if(op2.immediate() == sizeof(edb::reg_t)) {
+					const int expected = static_cast<int>(sizeof(edb::reg_t) * count);
+					if(op2.immediate() == ((insn.type() == edb::Instruction::OP_ADD) ? expected : -expected)) {
 						p += insn.size();
 						len -= insn.size();
 
-						edb::Instruction insn2(p, len, 0, std::nothrow);
+						edb::Instruction insn2(p, len, address + insn.size(), std::nothrow);
 						if(insn2.valid()) {
 							if(insn2.type() == edb::Instruction::OP_RET) {
-								add_result((QList<edb::Instruction>() << insn << insn2), start_address);
+								results << insn << insn2;
+								return true;
 							}
 						}
 					}
@@ -375,104 +481,55 @@ void DialogOpcodes::test_esp_add_regx1(const OpcodeData &data, edb::address_t st
 			break;
 		}
 	}
+	return false;
 }
 
 //------------------------------------------------------------------------------
-// Name: test_esp_add_regx2(const OpcodeData &data, edb::address_t start_address)
+// Name: test_esp_sub_regx1(const quint8 *p, edb::address_t address, InstructionList &results)
 // Desc:
 //------------------------------------------------------------------------------
-void DialogOpcodes::test_esp_add_regx2(const OpcodeData &data, edb::address_t start_address) {
-
+bool test_esp_sub_regx1(const quint8 *p, edb::address_t address, InstructionList &results) {
 
-	const quint8 *p = data.data;
-	int len = sizeof(data);
+	int len = window_size;
 
-	edb::Instruction insn(p, len, 0, std::nothrow);
+	edb::Instruction insn(p, len, address, std::nothrow);
 
 	if(insn.valid()) {
 		const edb::Operand &op1 = insn.operand(0);
 		switch(insn.type()) {
-		case edb::Instruction::OP_POP:
-
-			if(op1.general_type() != edb::Operand::TYPE_REGISTER || op1.reg() != STACK_REG) {
-				p += insn.size();
-				len -= insn.size();
-
-				edb::Instruction insn2(p, len, 0, std::nothrow);
-				if(insn2.valid()) {
-					const edb::Operand &op2 = insn2.operand(0);
-					switch(insn2.type()) {
-					case edb::Instruction::OP_POP:
-
-						if(op2.general_type() != edb::Operand::TYPE_REGISTER || op2.reg() != STACK_REG) {
-							p += insn2.size();
-							len -= insn2.size();
-
-							edb::Instruction insn3(p, len, 0, std::nothrow);
-							if(insn3.valid()) {
-								if(insn3.type() == edb::Instruction::OP_RET) {
-									add_result((QList<edb::Instruction>() << insn << insn2 << insn3), start_address);
-								}
-							}
-						}
-						break;
-					default:
-						break;
-					}
-				}
-			}
-			break;
-
 		case edb::Instruction::OP_JMP:
 		case edb::Instruction::OP_CALL:
 			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
 
-				if(op1.displacement() == (sizeof(edb::reg_t) * 2)) {
+				if(op1.displacement() == -static_cast<int>(sizeof(edb::reg_t))) {
 					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << insn), start_address);
+						results << insn;
+						return true;
 					} else if(op1.expression().base == edb::Operand::REG_NULL && op1.expression().index == STACK_REG && op1.expression().scale == 1) {
-						add_result((QList<edb::Instruction>() << insn), start_address);
+						results << insn;
+						return true;
 					}
-
 				}
 			}
 			break;
 
 		case edb::Instruction::OP_SUB:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
-
-				const edb::Operand &op2 = insn.operand(1);
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
-
-					if(op2.immediate() == -static_cast<int>(sizeof(edb::reg_t) * 2)) {
-						p += insn.size();
-						len -= insn.size();
-
-						edb::Instruction insn2(p, len, 0, std::nothrow);
-						if(insn2.valid()) {
-							if(insn2.type() == edb::Instruction::OP_RET) {
-								add_result((QList<edb::Instruction>() << insn << insn2), start_address);
-							}
-						}
-					}
-				}
-			}
-			break;
-
 		case edb::Instruction::OP_ADD:
 			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
 
 				const edb::Operand &op2 = insn.operand(1);
 				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
 
-					if(op2.immediate() == (sizeof(edb::reg_t) * 2)) {
+					const int expected = static_cast<int>(sizeof(edb::reg_t));
+					if(op2.immediate() == ((insn.type() == edb::Instruction::OP_SUB) ? expected : -expected)) {
 						p += insn.size();
 						len -= insn.size();
 
-						edb::Instruction insn2(p, len, 0, std::nothrow);
+						edb::Instruction insn2(p, len, address + insn.size(), std::nothrow);
 						if(insn2.valid()) {
 							if(insn2.type() == edb::Instruction::OP_RET) {
-								add_result((QList<edb::Instruction>() << insn << insn2), start_address);
+								results << insn << insn2;
+								return true;
 							}
 						}
 					}
@@ -484,89 +541,156 @@ void DialogOpcodes::test_esp_add_regx2(const OpcodeData &data, edb::address_t st
 			break;
 		}
 	}
+	return false;
 }
 
 //------------------------------------------------------------------------------
-// Name: test_esp_sub_regx1(const OpcodeData &data, edb::address_t start_address)
+// Name: run_test(const SearchClass &search, const quint8 *p, edb::address_t address, InstructionList &results)
 // Desc:
 //------------------------------------------------------------------------------
-void DialogOpcodes::test_esp_sub_regx1(const OpcodeData &data, edb::address_t start_address) {
+bool run_test(const SearchClass &search, const quint8 *p, edb::address_t address, InstructionList &results) {
+	switch(search.type) {
+	case SEARCH_REG_TO_IP:     return test_reg_to_ip(p, address, search.registers, results);
+	case SEARCH_ESP_ADD_0:     return test_esp_add_0(p, address, results);     // [ESP] -> EIP
+	case SEARCH_ESP_ADD_REGX1: return test_esp_add_regx(p, address, 1, results); // [ESP + 4] -> EIP
+	case SEARCH_ESP_ADD_REGX2: return test_esp_add_regx(p, address, 2, results); // [ESP + 8] -> EIP
+	case SEARCH_ESP_SUB_REGX1: return test_esp_sub_regx1(p, address, results); // [ESP - 4] -> EIP
+	}
+	return false;
+}
 
-	const quint8 *p = data.data;
-	int len = sizeof(data);
+//------------------------------------------------------------------------------
+// Name: format_result(const InstructionList &instructions, edb::address_t address)
+// Desc:
+//------------------------------------------------------------------------------
+QString format_result(const InstructionList &instructions, edb::address_t address) {
 
-	edb::Instruction insn(p, len, 0, std::nothrow);
+	QString instruction_string = QString("%1: %2").arg(
+		edb::v1::format_pointer(address),
+		QString::fromStdString(edisassm::to_string(instructions.first())));
 
-	if(insn.valid()) {
-		const edb::Operand &op1 = insn.operand(0);
-		switch(insn.type()) {
-		case edb::Instruction::OP_JMP:
-		case edb::Instruction::OP_CALL:
-			if(op1.general_type() == edb::Operand::TYPE_EXPRESSION) {
+	for(int i = 1; i < instructions.size(); ++i) {
+		instruction_string.append(QString("; %1").arg(QString::fromStdString(edisassm::to_string(instructions[i]))));
+	}
 
-				if(op1.displacement() == -static_cast<int>(sizeof(edb::reg_t))) {
-					if(op1.expression().base == STACK_REG && op1.expression().index == edb::Operand::REG_NULL) {
-						add_result((QList<edb::Instruction>() << insn), start_address);
-					} else if(op1.expression().base == edb::Operand::REG_NULL && op1.expression().index == STACK_REG && op1.expression().scale == 1) {
-						add_result((QList<edb::Instruction>() << insn), start_address);
-					}
+	return instruction_string;
+}
 
-				}
-			}
-			break;
+//------------------------------------------------------------------------------
+// Name: search_shard(const SearchClass &search, SearchShard &shard)
+// Desc:
+//------------------------------------------------------------------------------
+void search_shard(const SearchClass &search, SearchShard &shard) {
 
-		case edb::Instruction::OP_SUB:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
+	for(std::size_t offset = shard.begin; offset < shard.end; ++offset) {
 
-				const edb::Operand &op2 = insn.operand(1);
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
+		const quint8 *const p = shard.first + offset;
+		if(!is_candidate(search, p)) {
+			continue;
+		}
 
-					if(op2.immediate() == static_cast<int>(sizeof(edb::reg_t))) {
-						p += insn.size();
-						len -= insn.size();
+		InstructionList instructions;
+		const edb::address_t address = shard.address + offset;
+		if(run_test(search, p, address, instructions)) {
+			OpcodeResult result;
+			result.address = address;
+			result.text    = format_result(instructions, address);
+			shard.results.push_back(result);
+		}
+	}
+}
 
-						edb::Instruction insn2(p, len, 0, std::nothrow);
-						if(insn2.valid()) {
-							if(insn2.type() == edb::Instruction::OP_RET) {
-								add_result((QList<edb::Instruction>() << insn << insn2), start_address);
-							}
-						}
-					}
-				}
-			}
-			break;
+}
 
-		case edb::Instruction::OP_ADD:
-			if(op1.general_type() == edb::Operand::TYPE_REGISTER && op1.reg() == STACK_REG) {
+//------------------------------------------------------------------------------
+// Name: DialogOpcodes(QWidget *parent)
+// Desc:
+//------------------------------------------------------------------------------
+DialogOpcodes::DialogOpcodes(QWidget *parent) : QDialog(parent), ui(new Ui::DialogOpcodes) {
+	ui->setupUi(this);
+	ui->tableView->verticalHeader()->hide();
+	ui->tableView->horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
 
-				const edb::Operand &op2 = insn.operand(1);
-				if(op2.general_type() == edb::Operand::TYPE_IMMEDIATE) {
+	filter_model_ = new QSortFilterProxyModel(this);
+	connect(ui->txtSearch, SIGNAL(textChanged(const QString &)), filter_model_, SLOT(setFilterFixedString(const QString &)));
 
-					if(op2.immediate() == -static_cast<int>(sizeof(edb::reg_t))) {
-						p += insn.size();
-						len -= insn.size();
+#if defined(EDB_X86)
+	ui->comboBox->addItem("EAX -> EIP", 1);
+	ui->comboBox->addItem("EBX -> EIP", 2);
+	ui->comboBox->addItem("ECX -> EIP", 3);
+	ui->comboBox->addItem("EDX -> EIP", 4);
+	ui->comboBox->addItem("EBP -> EIP", 5);
+	ui->comboBox->addItem("ESP -> EIP", 6);
+	ui->comboBox->addItem("ESI -> EIP", 7);
+	ui->comboBox->addItem("EDI -> EIP", 8);
+	ui->comboBox->addItem("ANY REGISTER -> EIP", 17);
+	ui->comboBox->addItem("[ESP] -> EIP", 18);
+	ui->comboBox->addItem("[ESP + 4] -> EIP", 19);
+	ui->comboBox->addItem("[ESP + 8] -> EIP", 20);
+	ui->comboBox->addItem("[ESP - 4] -> EIP", 21);
+#elif defined(EDB_X86_64)
+	ui->comboBox->addItem("RAX -> RIP", 1);
+	ui->comboBox->addItem("RBX -> RIP", 2);
+	ui->comboBox->addItem("RCX -> RIP", 3);
+	ui->comboBox->addItem("RDX -> RIP", 4);
+	ui->comboBox->addItem("RBP -> RIP", 5);
+	ui->comboBox->addItem("RSP -> RIP", 6);
+	ui->comboBox->addItem("RSI -> RIP", 7);
+	ui->comboBox->addItem("RDI -> RIP", 8);
+	ui->comboBox->addItem("R8 -> RIP", 9);
+	ui->comboBox->addItem("R9 -> RIP", 10);
+	ui->comboBox->addItem("R10 -> RIP", 11);
+	ui->comboBox->addItem("R11 -> RIP", 12);
+	ui->comboBox->addItem("R12 -> RIP", 13);
+	ui->comboBox->addItem("R13 -> RIP", 14);
+	ui->comboBox->addItem("R14 -> RIP", 15);
+	ui->comboBox->addItem("R15 -> RIP", 16);
+	ui->comboBox->addItem("ANY REGISTER -> RIP", 17);
+	ui->comboBox->addItem("[RSP] -> RIP", 18);
+	ui->comboBox->addItem("[RSP + 8] -> RIP", 19);
+	ui->comboBox->addItem("[RSP + 16] -> RIP", 20);
+	ui->comboBox->addItem("[RSP - 8] -> RIP", 21);
+#endif
+}
 
-						edb::Instruction insn2(p, len, 0, std::nothrow);
-						if(insn2.valid()) {
-							if(insn2.type() == edb::Instruction::OP_RET) {
-								add_result((QList<edb::Instruction>() << insn << insn2), start_address);
-							}
-						}
-					}
-				}
-			}
-			break;
+//------------------------------------------------------------------------------
+// Name: ~DialogOpcodes()
+// Desc:
+//------------------------------------------------------------------------------
+DialogOpcodes::~DialogOpcodes() {
+	delete ui;
+}
 
-		default:
-			break;
-		}
+//------------------------------------------------------------------------------
+// Name: on_listWidget_itemDoubleClicked(QListWidgetItem *item)
+// Desc: follows the found item in the data view
+//------------------------------------------------------------------------------
+void DialogOpcodes::on_listWidget_itemDoubleClicked(QListWidgetItem *item) {
+	bool ok;
+	const edb::address_t addr = item->data(Qt::UserRole).toULongLong(&ok);
+	if(ok) {
+		edb::v1::jump_to_address(addr);
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: do_find()
+// Name: showEvent(QShowEvent *)
 // Desc:
 //------------------------------------------------------------------------------
+void DialogOpcodes::showEvent(QShowEvent *) {
+	filter_model_->setFilterKeyColumn(3);
+	filter_model_->setSourceModel(&edb::v1::memory_regions());
+	ui->tableView->setModel(filter_model_);
+	ui->progressBar->setValue(0);
+	ui->listWidget->clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: do_find()
+// Desc: each selected region is read in one go and searched in shards (in
+//       parallel when possible), only the offsets which pass the compiled
+//       opcode filter get disassembled
+//------------------------------------------------------------------------------
 void DialogOpcodes::do_find() {
 
 	const int classtype = ui->comboBox->itemData(ui->comboBox->currentIndex()).toInt();
@@ -581,113 +705,60 @@ void DialogOpcodes::do_find() {
 			tr("You must select a region which is to be scanned for the desired opcode."));
 	} else {
 
+		const SearchClass search       = compile_search(classtype);
+		const edb::address_t page_size = edb::v1::debugger_core->page_size();
+		const std::size_t shard_count  = qMax(QThread::idealThreadCount(), 1) * 4;
+
+		int i = 0;
 		Q_FOREACH(const QModelIndex &selected_item, sel) {
 
 			const QModelIndex index = filter_model_->mapToSource(selected_item);
 			const MemRegion *const region = reinterpret_cast<const MemRegion *>(index.internalPointer());
 
-			edb::address_t start_address     = region->start;
-			const edb::address_t end_address = region->end;
-			const edb::address_t orig_start  = start_address;
-			ByteShiftArray bsa(sizeof(OpcodeData));
-
-			// create a reference to the bsa's data so we can pass it to the testXXXX functions
-			const OpcodeData &opcode = *reinterpret_cast<const OpcodeData *>(bsa.data());
-
-			// do the search for this region!
-			// we intentionally look slightly past the end of the region
-			// but we are at that point, we just shift in 0x00's.
-			// this will let us find edge case opcodes
-			while(start_address < end_address + sizeof(OpcodeData)) {
-
-				// read in the next byte
-				quint8 byte;
-				if(start_address >= end_address) {
-					byte = 0x00;
-				} else {
-					edb::v1::debugger_core->read_bytes(start_address, &byte, 1);
-				}
-				bsa <<  byte;
-
-				switch(classtype) {
-			#if defined(EDB_X86)
-				case 1: test_reg_to_ip<edb::Operand::REG_EAX>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 2: test_reg_to_ip<edb::Operand::REG_EBX>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 3: test_reg_to_ip<edb::Operand::REG_ECX>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 4: test_reg_to_ip<edb::Operand::REG_EDX>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 5: test_reg_to_ip<edb::Operand::REG_EBP>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 6: test_reg_to_ip<edb::Operand::REG_ESP>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 7: test_reg_to_ip<edb::Operand::REG_ESI>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 8: test_reg_to_ip<edb::Operand::REG_EDI>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-			#elif defined(EDB_X86_64)
-				case 1: test_reg_to_ip<edb::Operand::REG_RAX>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 2: test_reg_to_ip<edb::Operand::REG_RBX>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 3: test_reg_to_ip<edb::Operand::REG_RCX>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 4: test_reg_to_ip<edb::Operand::REG_RDX>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 5: test_reg_to_ip<edb::Operand::REG_RBP>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 6: test_reg_to_ip<edb::Operand::REG_RSP>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 7: test_reg_to_ip<edb::Operand::REG_RSI>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 8: test_reg_to_ip<edb::Operand::REG_RDI>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 9: test_reg_to_ip<edb::Operand::REG_R8>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 10: test_reg_to_ip<edb::Operand::REG_R9>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 11: test_reg_to_ip<edb::Operand::REG_R10>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 12: test_reg_to_ip<edb::Operand::REG_R11>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 13: test_reg_to_ip<edb::Operand::REG_R12>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 14: test_reg_to_ip<edb::Operand::REG_R13>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 15: test_reg_to_ip<edb::Operand::REG_R14>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-				case 16: test_reg_to_ip<edb::Operand::REG_R15>(opcode, start_address - (sizeof(OpcodeData) - 1)); break;
-			#endif
-
-				case 17:
-				#if defined(EDB_X86)
-					test_reg_to_ip<edb::Operand::REG_EAX>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_EBX>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_ECX>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_EDX>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_EBP>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_ESP>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_ESI>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_EDI>(opcode, start_address - (sizeof(OpcodeData) - 1));
-				#elif defined(EDB_X86_64)
-					test_reg_to_ip<edb::Operand::REG_RAX>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_RBX>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_RCX>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_RDX>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_RBP>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_RSP>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_RSI>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_RDI>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_R8>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_R9>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_R10>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_R11>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_R12>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_R13>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_R14>(opcode, start_address - (sizeof(OpcodeData) - 1));
-					test_reg_to_ip<edb::Operand::REG_R15>(opcode, start_address - (sizeof(OpcodeData) - 1));
-				#endif
-					break;
-				case 18:
-					// [ESP] -> EIP
-					test_esp_add_0(opcode, start_address - (sizeof(OpcodeData) - 1));
-					break;
-				case 19:
-					// [ESP + 4] -> EIP
-					test_esp_add_regx1(opcode, start_address - (sizeof(OpcodeData) - 1));
-					break;
-				case 20:
-					// [ESP + 8] -> EIP
-					test_esp_add_regx2(opcode, start_address - (sizeof(OpcodeData) - 1));
-					break;
-				case 21:
-					// [ESP - 4] -> EIP
-					test_esp_sub_regx1(opcode, start_address - (sizeof(OpcodeData) - 1));
-					break;
-				}
+			const edb::address_t size_in_pages = region->size() / page_size;
+			const std::size_t size             = size_in_pages * page_size;
+
+			try {
+				// we intentionally look slightly past the end of the region
+				// (at zeros), this will let us find edge case opcodes
+				QVector<quint8> bytes(size + window_size, 0);
 
-				ui->progressBar->setValue(util::percentage(start_address - orig_start, region->size()));
-				++start_address;
+				if(size != 0 && edb::v1::debugger_core->read_pages(region->start, bytes.data(), size_in_pages)) {
+
+					const std::size_t shard_size = qMax(min_shard_size, (size + shard_count - 1) / shard_count);
+
+					QVector<SearchShard> shards;
+					for(std::size_t begin = 0; begin < size; begin += shard_size) {
+						SearchShard shard;
+						shard.first   = bytes.constData();
+						shard.address = region->start;
+						shard.begin   = begin;
+						shard.end     = qMin(begin + shard_size, size);
+						shards.push_back(shard);
+					}
+
+#ifdef USE_QT_CONCURRENT
+					QtConcurrent::blockingMap(shards, boost::bind(search_shard, boost::cref(search), _1));
+#else
+					std::for_each(shards.begin(), shards.end(), boost::bind(search_shard, boost::cref(search), _1));
+#endif
+
+					Q_FOREACH(const SearchShard &shard, shards) {
+						Q_FOREACH(const OpcodeResult &result, shard.results) {
+							QListWidgetItem *const item = new QListWidgetItem(result.text);
+							item->setData(Qt::UserRole, result.address);
+							ui->listWidget->addItem(item);
+						}
+					}
+				}
+			} catch(const std::bad_alloc &) {
+				QMessageBox::information(
+					0,
+					tr("Memroy Allocation Error"),
+					tr("Unable to satisfy memory allocation request for requested region."));
 			}
+
+			ui->progressBar->setValue(util::percentage(++i, sel.size()));
 		}
 	}
 }
@@ -20,10 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define DIALOGOPCODES_20061101_H_
 
 #include "Types.h"
-#include "Instruction.h"
 
 #include <QDialog>
-#include <QList>
 
 class QSortFilterProxyModel;
 class QListWidgetItem;
@@ -42,22 +40,7 @@ public Q_SLOTS:
 	void on_listWidget_itemDoubleClicked(QListWidgetItem *);
 
 private:
-	// we currently only support opcodes sequences up to 8 bytes big
-	union OpcodeData {
-		quint32 dword;
-		quint64 qword;
-		quint8  data[sizeof(quint64)];
-	};
-
-	void test_esp_add_0(const OpcodeData &data, edb::address_t start_address);
-	void test_esp_add_regx1(const OpcodeData &data, edb::address_t start_address);
-	void test_esp_add_regx2(const OpcodeData &data, edb::address_t start_address);
-	void test_esp_sub_regx1(const OpcodeData &data, edb::address_t start_address);
 	void do_find();
-	void add_result(QList<edb::Instruction> instructions, edb::address_t rva);
-
-	template <edb::Operand::Register REG>
-	void test_reg_to_ip(const OpcodeData &data, edb::address_t start_address);
 
 private:
 	virtual void showEvent(QShowEvent *event);
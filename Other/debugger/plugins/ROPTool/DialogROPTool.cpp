@@ -19,123 +19,136 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DialogROPTool.h"
 #include "DebuggerCoreInterface.h"
 #include "Debugger.h"
+#include "GadgetModel.h"
 #include "MemoryRegions.h"
-#include "ByteShiftArray.h"
 #include "Util.h"
 
 #include <QDebug>
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QSortFilterProxyModel>
-#include <QStandardItemModel>
 #include <QModelIndex>
+#include <QThread>
+#include <QVector>
 
-#include "ui_dialogrop.h"
-
-//------------------------------------------------------------------------------
-// Name: DialogROPTool(QWidget *parent)
-// Desc:
-//------------------------------------------------------------------------------
-DialogROPTool::DialogROPTool(QWidget *parent) : QDialog(parent), ui(new Ui::DialogROPTool) {
-	ui->setupUi(this);
-	ui->tableView->verticalHeader()->hide();
-	ui->tableView->horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
-
-	filter_model_ = new QSortFilterProxyModel(this);
-	connect(ui->txtSearch, SIGNAL(textChanged(const QString &)), filter_model_, SLOT(setFilterFixedString(const QString &)));
+#ifdef USE_QT_CONCURRENT
+#include <QtConcurrentMap>
+#else
+#include <algorithm>
+#endif
 
+#include "ui_dialogrop.h"
 
-	result_model_ = new QStandardItemModel(this);
-	result_filter_ = new ResultFilterProxy(this);
-	result_filter_->setSourceModel(result_model_);
-	ui->listView->setModel(result_filter_);
-}
+namespace {
+
+// the longest an x86 instruction can be
+const std::size_t max_instruction_size = 15;
+
+// the smallest piece of a region which is worth giving its own thread
+const std::size_t min_shard_size = 64 * 1024;
+
+enum TerminatorType {
+	TERMINATOR_NONE,
+	TERMINATOR_RET,     // ret, ret imm16, retf
+	TERMINATOR_SYSCALL, // int 0x80, sysenter, syscall
+	TERMINATOR_JMP_REG  // jmp reg, only useful after a pop of the same reg
+};
+
+// a part of a region's snapshot, the shard owns the terminators which start in
+// [begin, end) but may look at the bytes before begin to find gadgets
+struct SearchShard {
+	const quint8 *   first;
+	std::size_t      size;
+	edb::address_t   address;
+	std::size_t      begin;
+	std::size_t      end;
+	int              depth;
+	QVector<Gadget>  gadgets;
+};
 
 //------------------------------------------------------------------------------
-// Name: ~DialogROPTool()
+// Name: terminator_type(const edb::Instruction &insn)
 // Desc:
 //------------------------------------------------------------------------------
-DialogROPTool::~DialogROPTool() {
-	delete ui;
-}
-
-//------------------------------------------------------------------------------
-// Name: on_listView_itemDoubleClicked(QListViewItem *item)
-// Desc: follows the found item in the data view
-//------------------------------------------------------------------------------
-void DialogROPTool::on_listView_doubleClicked(const QModelIndex &index) {
-	bool ok;
-	const edb::address_t addr = index.data(Qt::UserRole).toULongLong(&ok);
-	if(ok) {
-		edb::v1::jump_to_address(addr);
+TerminatorType terminator_type(const edb::Instruction &insn) {
+	switch(insn.type()) {
+	case edb::Instruction::OP_RET:
+	case edb::Instruction::OP_RETF:
+		return TERMINATOR_RET;
+	case edb::Instruction::OP_SYSENTER:
+	case edb::Instruction::OP_SYSCALL:
+		return TERMINATOR_SYSCALL;
+	case edb::Instruction::OP_INT:
+		if(insn.operand(0).general_type() == edb::Operand::TYPE_IMMEDIATE && (insn.operand(0).immediate() & 0xff) == 0x80) {
+			return TERMINATOR_SYSCALL;
+		}
+		return TERMINATOR_NONE;
+	case edb::Instruction::OP_JMP:
+		if(insn.operand_count() == 1 && insn.operand(0).general_type() == edb::Operand::TYPE_REGISTER) {
+			return TERMINATOR_JMP_REG;
+		}
+		return TERMINATOR_NONE;
+	default:
+		return TERMINATOR_NONE;
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: showEvent(QShowEvent *)
-// Desc:
-//------------------------------------------------------------------------------
-void DialogROPTool::showEvent(QShowEvent *) {
-	filter_model_->setFilterKeyColumn(3);
-	filter_model_->setSourceModel(&edb::v1::memory_regions());
-	ui->tableView->setModel(filter_model_);
-	ui->progressBar->setValue(0);
-
-	result_filter_->set_mask_bit(0x01, ui->chkShowALU->isChecked());
-	result_filter_->set_mask_bit(0x02, ui->chkShowStack->isChecked());
-	result_filter_->set_mask_bit(0x04, ui->chkShowLogic->isChecked());
-	result_filter_->set_mask_bit(0x08, ui->chkShowData->isChecked());
-	result_filter_->set_mask_bit(0x10, ui->chkShowOther->isChecked());
-
-	result_model_->clear();
-}
-
-//------------------------------------------------------------------------------
-// Name: on_chkShowALU_stateChanged(int state)
-// Desc:
-//------------------------------------------------------------------------------
-void DialogROPTool::on_chkShowALU_stateChanged(int state) {
-	result_filter_->set_mask_bit(0x01, state);
-}
-
-//------------------------------------------------------------------------------
-// Name: on_chkShowStack_stateChanged(int state)
-// Desc:
-//------------------------------------------------------------------------------
-void DialogROPTool::on_chkShowStack_stateChanged(int state) {
-	result_filter_->set_mask_bit(0x02, state);
-}
-
-//------------------------------------------------------------------------------
-// Name: on_chkShowLogic_stateChanged(int state)
-// Desc:
-//------------------------------------------------------------------------------
-void DialogROPTool::on_chkShowLogic_stateChanged(int state) {
-	result_filter_->set_mask_bit(0x04, state);
-}
-
+// Name: is_terminator_start(quint8 byte)
+// Desc: the first byte of every terminator we look for, so most bytes can be
+//       skipped without decoding anything
 //------------------------------------------------------------------------------
-// Name: on_chkShowData_stateChanged(int state)
-// Desc:
-//------------------------------------------------------------------------------
-void DialogROPTool::on_chkShowData_stateChanged(int state) {
-	result_filter_->set_mask_bit(0x08, state);
+bool is_terminator_start(quint8 byte) {
+	switch(byte) {
+	case 0xc2: // ret imm16
+	case 0xc3: // ret
+	case 0xca: // retf imm16
+	case 0xcb: // retf
+	case 0xcd: // int imm8
+	case 0x0f: // syscall, sysenter
+	case 0xff: // jmp reg
+		return true;
+	default:
+		return false;
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: on_chkShowOther_stateChanged(int state)
-// Desc:
+// Name: is_flow_control(const edb::Instruction &insn)
+// Desc: instructions which can't be in the middle of a gadget
 //------------------------------------------------------------------------------
-void DialogROPTool::on_chkShowOther_stateChanged(int state) {
-	result_filter_->set_mask_bit(0x10, state);
+bool is_flow_control(const edb::Instruction &insn) {
+	switch(insn.type()) {
+	case edb::Instruction::OP_JMP:
+	case edb::Instruction::OP_JCC:
+	case edb::Instruction::OP_LOOP:
+	case edb::Instruction::OP_LOOPE:
+	case edb::Instruction::OP_LOOPNE:
+	case edb::Instruction::OP_CALL:
+	case edb::Instruction::OP_RET:
+	case edb::Instruction::OP_RETF:
+	case edb::Instruction::OP_IRET:
+	case edb::Instruction::OP_INT:
+	case edb::Instruction::OP_INT3:
+	case edb::Instruction::OP_INTO:
+	case edb::Instruction::OP_SYSENTER:
+	case edb::Instruction::OP_SYSEXIT:
+	case edb::Instruction::OP_SYSCALL:
+	case edb::Instruction::OP_SYSRET:
+	case edb::Instruction::OP_HLT:
+	case edb::Instruction::OP_UD:
+	case edb::Instruction::OP_UD2:
+		return true;
+	default:
+		return false;
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: set_gadget_role(QStandardItem *item, const edb::Instruction &insn1)
-// Desc:
+// Name: gadget_role(const edb::Instruction &insn1)
+// Desc: which of the "show" filters a gadget starting with insn1 belongs to
 //------------------------------------------------------------------------------
-void DialogROPTool::set_gadget_role(QStandardItem *item, const edb::Instruction &insn1) {
-
+quint32 gadget_role(const edb::Instruction &insn1) {
 	switch(insn1.type()) {
 	case edb::Instruction::OP_ADD:
 	case edb::Instruction::OP_ADC:
@@ -156,15 +169,13 @@ void DialogROPTool::set_gadget_role(QStandardItem *item, const edb::Instruction
 	case edb::Instruction::OP_AAM:
 	case edb::Instruction::OP_AAD:
 		// ALU ops
-		item->setData(0x01, Qt::UserRole + 1);
-		break;
+		return 0x01;
 	case edb::Instruction::OP_PUSH:
 	case edb::Instruction::OP_PUSHA:
 	case edb::Instruction::OP_POP:
 	case edb::Instruction::OP_POPA:
 		// stack ops
-		item->setData(0x02, Qt::UserRole + 1);
-		break;
+		return 0x02;
 	case edb::Instruction::OP_AND:
 	case edb::Instruction::OP_OR:
 	case edb::Instruction::OP_XOR:
@@ -186,8 +197,7 @@ void DialogROPTool::set_gadget_role(QStandardItem *item, const edb::Instruction
 	case edb::Instruction::OP_BSF:
 	case edb::Instruction::OP_BSR:
 		// logic ops
-		item->setData(0x04, Qt::UserRole + 1);
-		break;
+		return 0x04;
 	case edb::Instruction::OP_MOV:
 	case edb::Instruction::OP_CMOVCC:
 	case edb::Instruction::OP_XCHG:
@@ -213,50 +223,200 @@ void DialogROPTool::set_gadget_role(QStandardItem *item, const edb::Instruction
 	case edb::Instruction::OP_CMPXCHG8B:
 	case edb::Instruction::OP_CMPXCHG16B:
 		// data ops
-		item->setData(0x08, Qt::UserRole + 1);
-		break;
+		return 0x08;
 	default:
 		// other ops
-		item->setData(0x10, Qt::UserRole + 1);
-		break;
-
+		return 0x10;
 	}
 }
 
 //------------------------------------------------------------------------------
-// Name: add_gadget(edb::address_t start_address, QList<edb::Instruction> instructions, size_t size)
-// Desc:
+// Name: find_gadgets(SearchShard &shard)
+// Desc: finds the terminators in the shard, then for each one tries every
+//       starting point in the bytes before it (up to depth - 1 instructions
+//       worth) which decodes into a run of instructions ending exactly on it
 //------------------------------------------------------------------------------
-void DialogROPTool::add_gadget(edb::address_t start_address, QList<edb::Instruction> instructions, size_t size) {
+void find_gadgets(SearchShard &shard) {
+
+	const quint8 *const first   = shard.first;
+	const std::size_t max_back  = (shard.depth - 1) * max_instruction_size;
+
+	for(std::size_t t = shard.begin; t < shard.end; ++t) {
+
+		if(!is_terminator_start(first[t])) {
+			continue;
+		}
 
-	if(!instructions.isEmpty()) {
-		const edb::Instruction insn1 = instructions.takeFirst();
+		const edb::Instruction terminator(first + t, shard.size - t, shard.address + t, std::nothrow);
+		if(!terminator.valid()) {
+			continue;
+		}
+
+		const TerminatorType type = terminator_type(terminator);
+		if(type == TERMINATOR_NONE) {
+			continue;
+		}
+
+		const std::size_t end = t + terminator.size();
 
-		QString instruction_string = QString("%1").arg(QString::fromStdString(edisassm::to_string(insn1)));
-		Q_FOREACH(const edb::Instruction &instruction, instructions) {
-			instruction_string.append(QString("; %1").arg(QString::fromStdString(edisassm::to_string(instruction))));
+		if(type == TERMINATOR_SYSCALL) {
+			Gadget gadget;
+			gadget.address = shard.address + t;
+			gadget.bytes   = QByteArray(reinterpret_cast<const char *>(first + t), end - t);
+			gadget.role    = gadget_role(terminator);
+			shard.gadgets.push_back(gadget);
+			continue;
 		}
 
-		if(!ui->checkUnique->isChecked() || !unique_results_.contains(instruction_string)) {
-			unique_results_.insert(instruction_string);
+		for(std::size_t start = (t > max_back) ? t - max_back : 0; start < t; ++start) {
+
+			std::size_t offset = start;
+			quint32 role       = 0;
+			bool ok            = true;
+
+			for(int count = 0; ok && offset < t && count < shard.depth - 1; ++count) {
+
+				// limiting the size keeps it from running into the terminator
+				const edb::Instruction insn(first + offset, t - offset, shard.address + offset, std::nothrow);
+				if(!insn.valid() || is_flow_control(insn)) {
+					ok = false;
+					break;
+				}
 
-			// found a gadget
-			QStandardItem *const item = new QStandardItem(QString("%1: %2").arg(
-					edb::v1::format_pointer(start_address - size + 1),
-					instruction_string));
+				if(count == 0) {
+					role = gadget_role(insn);
+				}
 
-			item->setData(static_cast<qulonglong>(start_address - size + 1), Qt::UserRole);
-			set_gadget_role(item, insn1);
+				offset += insn.size();
 
-			result_model_->insertRow(result_model_->rowCount(), item);
+				if(type == TERMINATOR_JMP_REG && offset == t) {
+					ok = insn.type() == edb::Instruction::OP_POP &&
+						insn.operand_count() == 1 &&
+						insn.operand(0).general_type() == edb::Operand::TYPE_REGISTER &&
+						insn.operand(0).reg() == terminator.operand(0).reg();
+				}
+			}
+
+			if(ok && offset == t) {
+				Gadget gadget;
+				gadget.address = shard.address + start;
+				gadget.bytes   = QByteArray(reinterpret_cast<const char *>(first + start), end - start);
+				gadget.role    = role;
+				shard.gadgets.push_back(gadget);
+			}
 		}
 	}
 }
 
+}
+
+//------------------------------------------------------------------------------
+// Name: DialogROPTool(QWidget *parent)
+// Desc:
+//------------------------------------------------------------------------------
+DialogROPTool::DialogROPTool(QWidget *parent) : QDialog(parent), ui(new Ui::DialogROPTool) {
+	ui->setupUi(this);
+	ui->tableView->verticalHeader()->hide();
+	ui->tableView->horizontalHeader()->setResizeMode(QHeaderView::ResizeToContents);
+
+	filter_model_ = new QSortFilterProxyModel(this);
+	connect(ui->txtSearch, SIGNAL(textChanged(const QString &)), filter_model_, SLOT(setFilterFixedString(const QString &)));
+
+
+	result_model_ = new GadgetModel(this);
+	result_filter_ = new ResultFilterProxy(this);
+	result_filter_->setSourceModel(result_model_);
+	ui->listView->setModel(result_filter_);
+
+	// so that the view doesn't have to format every row to lay them out
+	ui->listView->setUniformItemSizes(true);
+}
+
+//------------------------------------------------------------------------------
+// Name: ~DialogROPTool()
+// Desc:
+//------------------------------------------------------------------------------
+DialogROPTool::~DialogROPTool() {
+	delete ui;
+}
+
+//------------------------------------------------------------------------------
+// Name: on_listView_itemDoubleClicked(QListViewItem *item)
+// Desc: follows the found item in the data view
+//------------------------------------------------------------------------------
+void DialogROPTool::on_listView_doubleClicked(const QModelIndex &index) {
+	bool ok;
+	const edb::address_t addr = index.data(Qt::UserRole).toULongLong(&ok);
+	if(ok) {
+		edb::v1::jump_to_address(addr);
+	}
+}
+
 //------------------------------------------------------------------------------
-// Name: do_find()
+// Name: showEvent(QShowEvent *)
+// Desc:
+//------------------------------------------------------------------------------
+void DialogROPTool::showEvent(QShowEvent *) {
+	filter_model_->setFilterKeyColumn(3);
+	filter_model_->setSourceModel(&edb::v1::memory_regions());
+	ui->tableView->setModel(filter_model_);
+	ui->progressBar->setValue(0);
+
+	result_filter_->set_mask_bit(0x01, ui->chkShowALU->isChecked());
+	result_filter_->set_mask_bit(0x02, ui->chkShowStack->isChecked());
+	result_filter_->set_mask_bit(0x04, ui->chkShowLogic->isChecked());
+	result_filter_->set_mask_bit(0x08, ui->chkShowData->isChecked());
+	result_filter_->set_mask_bit(0x10, ui->chkShowOther->isChecked());
+
+	result_model_->clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: on_chkShowALU_stateChanged(int state)
+// Desc:
+//------------------------------------------------------------------------------
+void DialogROPTool::on_chkShowALU_stateChanged(int state) {
+	result_filter_->set_mask_bit(0x01, state);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_chkShowStack_stateChanged(int state)
+// Desc:
+//------------------------------------------------------------------------------
+void DialogROPTool::on_chkShowStack_stateChanged(int state) {
+	result_filter_->set_mask_bit(0x02, state);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_chkShowLogic_stateChanged(int state)
+// Desc:
+//------------------------------------------------------------------------------
+void DialogROPTool::on_chkShowLogic_stateChanged(int state) {
+	result_filter_->set_mask_bit(0x04, state);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_chkShowData_stateChanged(int state)
+// Desc:
+//------------------------------------------------------------------------------
+void DialogROPTool::on_chkShowData_stateChanged(int state) {
+	result_filter_->set_mask_bit(0x08, state);
+}
+
+//------------------------------------------------------------------------------
+// Name: on_chkShowOther_stateChanged(int state)
 // Desc:
 //------------------------------------------------------------------------------
+void DialogROPTool::on_chkShowOther_stateChanged(int state) {
+	result_filter_->set_mask_bit(0x10, state);
+}
+
+//------------------------------------------------------------------------------
+// Name: do_find()
+// Desc: each selected region is read in one go, then searched in shards (in
+//       parallel when possible). Duplicates are found by comparing the
+//       gadgets' bytes, the text is only made when a row is displayed
+//------------------------------------------------------------------------------
 void DialogROPTool::do_find() {
 
 	const QItemSelectionModel *const selModel = ui->tableView->selectionModel();
@@ -271,70 +431,67 @@ void DialogROPTool::do_find() {
 
 		unique_results_.clear();
 
+		const edb::address_t page_size = edb::v1::debugger_core->page_size();
+		const int depth                = ui->spinDepth->value();
+		const std::size_t shard_count  = qMax(QThread::idealThreadCount(), 1) * 4;
+
+		int i = 0;
 		Q_FOREACH(const QModelIndex &selected_item, sel) {
 
 			const QModelIndex index = filter_model_->mapToSource(selected_item);
 			const MemRegion *const region = reinterpret_cast<const MemRegion *>(index.internalPointer());
 
-			edb::address_t start_address     = region->start;
-			const edb::address_t end_address = region->end;
-			const edb::address_t orig_start  = start_address;
-			size_t size = 0;
-
-			ByteShiftArray bsa(64);
-
-			while(start_address < end_address) {
-
-				// TODO: allow NOPs or effective nops in the streams
-
-				// read in the next byte
-				quint8 byte;
-				if(edb::v1::debugger_core->read_bytes(start_address, &byte, 1)) {
-					bsa << byte;
-
-					size = qMin(size + 1, bsa.size());
-
-					const quint8 *const p = bsa.data();
-					edb::Instruction insn1(p, size, start_address - size + 1, std::nothrow);
-
-					if(insn1.valid()) {
-					
-						if(insn1.type() == edb::Instruction::OP_INT && insn1.operand(0).general_type() == edb::Operand::TYPE_IMMEDIATE && (insn1.operand(0).immediate() & 0xff) == 0x80) {
-							add_gadget(start_address, (QList<edb::Instruction>() << insn1), size);
-						} else if(insn1.type() == edb::Instruction::OP_SYSENTER) {
-							add_gadget(start_address, (QList<edb::Instruction>() << insn1), size);
-						} else if(insn1.type() == edb::Instruction::OP_SYSCALL) {
-							add_gadget(start_address, (QList<edb::Instruction>() << insn1), size);
-						} else {
-					
-							edb::Instruction insn2(p + insn1.size(), size - insn1.size(), 0, std::nothrow);
-
-							if(insn2.valid() && insn2.type() == edb::Instruction::OP_RET) {
-								add_gadget(start_address, (QList<edb::Instruction>() << insn1 << insn2), size);
-							} else if(insn2.valid() && insn2.type() == edb::Instruction::OP_POP) {
-
-								edb::Instruction insn3(p + insn1.size() + insn2.size(), size - insn1.size() - insn2.size(), 0, std::nothrow);
-								if(insn3.valid() && insn3.type() == edb::Instruction::OP_JMP) {
-
-									if(insn2.operand_count() == 1 && insn2.operand(0).general_type() == edb::Operand::TYPE_REGISTER) {
-										if(insn3.operand_count() == 1 && insn3.operand(0).general_type() == edb::Operand::TYPE_REGISTER) {
-											if(insn2.operand(0).reg() == insn3.operand(0).reg()) {
-												add_gadget(start_address, (QList<edb::Instruction>() << insn1 << insn2 << insn3), size);
-											}
-										}
-									}
-								}
+			const edb::address_t size_in_pages = region->size() / page_size;
+
+			try {
+				QVector<quint8> bytes(size_in_pages * page_size);
+
+				if(!bytes.isEmpty() && edb::v1::debugger_core->read_pages(region->start, bytes.data(), size_in_pages)) {
+
+					// TODO: allow NOPs or effective nops in the streams
+
+					const std::size_t size       = bytes.size();
+					const std::size_t shard_size = qMax(min_shard_size, (size + shard_count - 1) / shard_count);
+
+					QVector<SearchShard> shards;
+					for(std::size_t begin = 0; begin < size; begin += shard_size) {
+						SearchShard shard;
+						shard.first   = bytes.constData();
+						shard.size    = size;
+						shard.address = region->start;
+						shard.begin   = begin;
+						shard.end     = qMin(begin + shard_size, size);
+						shard.depth   = depth;
+						shards.push_back(shard);
+					}
+
+#ifdef USE_QT_CONCURRENT
+					QtConcurrent::blockingMap(shards, find_gadgets);
+#else
+					std::for_each(shards.begin(), shards.end(), find_gadgets);
+#endif
+
+					const bool unique_only = ui->checkUnique->isChecked();
+					QVector<Gadget> gadgets;
+					Q_FOREACH(const SearchShard &shard, shards) {
+						Q_FOREACH(const Gadget &gadget, shard.gadgets) {
+							if(!unique_only || !unique_results_.contains(gadget.bytes)) {
+								unique_results_.insert(gadget.bytes);
+								gadgets.push_back(gadget);
 							}
 						}
-
-						// TODO: catch things like "add rsp, 8; jmp [rsp - 8]" and similar, it's rare,
-						// but could happen
 					}
-				}
 
-				ui->progressBar->setValue(util::percentage(start_address - orig_start, region->size()));
-				++start_address;
+					result_model_->add_gadgets(gadgets);
+				}
+			} catch(const std::bad_alloc &) {
+				QMessageBox::information(
+					0,
+					tr("Memroy Allocation Error"),
+					tr("Unable to satisfy memory allocation request for requested region."));
 			}
+
+			ui->progressBar->setValue(util::percentage(++i, sel.size()));
 		}
 	}
 }
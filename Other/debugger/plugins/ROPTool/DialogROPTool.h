@@ -22,16 +22,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Types.h"
 #include "Instruction.h"
 
+#include <QByteArray>
 #include <QDialog>
 #include <QSet>
 #include <QList>
 #include <QSortFilterProxyModel>
 
+class GadgetModel;
 class QListWidgetItem;
 class QModelIndex;
 class QSortFilterProxyModel;
-class QStandardItem;
-class QStandardItemModel;
 
 class ResultFilterProxy;
 
@@ -83,8 +83,6 @@ public Q_SLOTS:
 
 private:
 	void do_find();
-	void add_gadget(edb::address_t start_address, QList<edb::Instruction> instructions, size_t size);
-	void set_gadget_role(QStandardItem *item, const edb::Instruction &insn1);
 
 private:
 	virtual void showEvent(QShowEvent *event);
@@ -92,9 +90,9 @@ private:
 private:
 	Ui::DialogROPTool *const ui;
 	QSortFilterProxyModel *  filter_model_;
-	QStandardItemModel *     result_model_;
+	GadgetModel *            result_model_;
 	ResultFilterProxy *      result_filter_;
-	QSet<QString>            unique_results_;
+	QSet<QByteArray>         unique_results_;
 };
 
 #endif
@@ -0,0 +1,103 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "GadgetModel.h"
+#include "Debugger.h"
+#include "Instruction.h"
+
+//------------------------------------------------------------------------------
+// Name: GadgetModel(QObject *parent)
+// Desc:
+//------------------------------------------------------------------------------
+GadgetModel::GadgetModel(QObject *parent) : QAbstractListModel(parent) {
+}
+
+//------------------------------------------------------------------------------
+// Name: rowCount(const QModelIndex &parent) const
+// Desc:
+//------------------------------------------------------------------------------
+int GadgetModel::rowCount(const QModelIndex &parent) const {
+	return parent.isValid() ? 0 : gadgets_.size();
+}
+
+//------------------------------------------------------------------------------
+// Name: data(const QModelIndex &index, int role) const
+// Desc:
+//------------------------------------------------------------------------------
+QVariant GadgetModel::data(const QModelIndex &index, int role) const {
+
+	if(!index.isValid() || index.row() >= gadgets_.size()) {
+		return QVariant();
+	}
+
+	const Gadget &gadget = gadgets_[index.row()];
+
+	switch(role) {
+	case Qt::DisplayRole:
+		do {
+			const quint8 *const buf = reinterpret_cast<const quint8 *>(gadget.bytes.constData());
+			const std::size_t size  = gadget.bytes.size();
+
+			QString instruction_string;
+			char text[edisassm::MAX_STRING_SIZE];
+			std::size_t offset = 0;
+			while(offset < size) {
+				const edb::Instruction insn(buf + offset, size - offset, gadget.address + offset, std::nothrow);
+				if(!insn.valid()) {
+					break;
+				}
+
+				if(offset != 0) {
+					instruction_string.append("; ");
+				}
+				edisassm::to_string(insn, edisassm::syntax_intel(), text, sizeof(text));
+				instruction_string.append(QLatin1String(text));
+				offset += insn.size();
+			}
+
+			return QString("%1: %2").arg(edb::v1::format_pointer(gadget.address), instruction_string);
+		} while(0);
+	case Qt::UserRole:
+		return static_cast<qulonglong>(gadget.address);
+	case Qt::UserRole + 1:
+		return gadget.role;
+	default:
+		return QVariant();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: add_gadgets(const QVector<Gadget> &gadgets)
+// Desc:
+//------------------------------------------------------------------------------
+void GadgetModel::add_gadgets(const QVector<Gadget> &gadgets) {
+	if(!gadgets.isEmpty()) {
+		beginInsertRows(QModelIndex(), gadgets_.size(), gadgets_.size() + gadgets.size() - 1);
+		gadgets_ += gadgets;
+		endInsertRows();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: clear()
+// Desc:
+//------------------------------------------------------------------------------
+void GadgetModel::clear() {
+	gadgets_.clear();
+	reset();
+}
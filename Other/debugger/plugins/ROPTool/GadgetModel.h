@@ -0,0 +1,52 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GADGETMODEL_20121017_H_
+#define GADGETMODEL_20121017_H_
+
+#include "Types.h"
+
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QVector>
+
+struct Gadget {
+	edb::address_t address;
+	QByteArray     bytes;
+	quint32        role;    // which of the "show" filters it belongs to
+};
+
+// the gadgets are kept as raw bytes, they are only disassembled and formatted
+// when a view asks for a row
+class GadgetModel : public QAbstractListModel {
+public:
+	GadgetModel(QObject *parent = 0);
+
+public:
+	virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	virtual QVariant data(const QModelIndex &index, int role) const;
+
+public:
+	void add_gadgets(const QVector<Gadget> &gadgets);
+	void clear();
+
+private:
+	QVector<Gadget> gadgets_;
+};
+
+#endif
@@ -2,7 +2,7 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += ROPTool.h DialogROPTool.h
+HEADERS += ROPTool.h DialogROPTool.h GadgetModel.h
 FORMS += dialogrop.ui
-SOURCES += ROPTool.cpp DialogROPTool.cpp
+SOURCES += ROPTool.cpp DialogROPTool.cpp GadgetModel.cpp
 
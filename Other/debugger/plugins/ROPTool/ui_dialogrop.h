@@ -26,6 +26,7 @@
 #include <QtGui/QProgressBar>
 #include <QtGui/QPushButton>
 #include <QtGui/QSpacerItem>
+#include <QtGui/QSpinBox>
 #include <QtGui/QTableView>
 #include <QtGui/QVBoxLayout>
 
@@ -48,6 +49,7 @@ public:
     QTableView *tableView;
     QCheckBox *checkUnique;
     QLabel *label_2;
+    QSpinBox *spinDepth;
     QListView *listView;
     QHBoxLayout *hboxLayout;
     QPushButton *btnClose;
@@ -140,6 +142,14 @@ public:
 
         gridLayout->addWidget(label_2, 4, 0, 1, 1);
 
+        spinDepth = new QSpinBox(DialogROPTool);
+        spinDepth->setObjectName(QString::fromUtf8("spinDepth"));
+        spinDepth->setMinimum(2);
+        spinDepth->setMaximum(8);
+        spinDepth->setValue(3);
+
+        gridLayout->addWidget(spinDepth, 4, 2, 1, 1);
+
         listView = new QListView(DialogROPTool);
         listView->setObjectName(QString::fromUtf8("listView"));
         listView->setFont(font);
@@ -207,6 +217,7 @@ public:
         chkShowOther->setText(QApplication::translate("DialogROPTool", "Other", 0, QApplication::UnicodeUTF8));
         checkUnique->setText(QApplication::translate("DialogROPTool", "Unique Gadgets Only", 0, QApplication::UnicodeUTF8));
         label_2->setText(QApplication::translate("DialogROPTool", "Results:", 0, QApplication::UnicodeUTF8));
+        spinDepth->setPrefix(QApplication::translate("DialogROPTool", "Max Instructions: ", 0, QApplication::UnicodeUTF8));
         btnClose->setText(QApplication::translate("DialogROPTool", "&Close", 0, QApplication::UnicodeUTF8));
         btnHelp->setText(QApplication::translate("DialogROPTool", "&Help", 0, QApplication::UnicodeUTF8));
         btnFind->setText(QApplication::translate("DialogROPTool", "&Find", 0, QApplication::UnicodeUTF8));
@@ -21,10 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Debugger.h"
 #include "Util.h"
 #include "MemoryRegions.h"
-#include "Debugger.h"
-
-#include <QVector>
-#include <QMessageBox>
+#include "ReferenceIndex.h"
 
 #include "ui_dialogreferences.h"
 
@@ -56,82 +53,36 @@ void DialogReferences::showEvent(QShowEvent *) {
 
 //------------------------------------------------------------------------------
 // Name: do_find()
-// Desc:
+// Desc: looks the address up in the shared reference index, which indexes
+//       (or brings up to date) each region as it is queried. Regions are only
+//       read again if the debugee has run since the last query, and only the
+//       ones whose contents changed get rescanned
 //------------------------------------------------------------------------------
 void DialogReferences::do_find() {
 	bool ok;
-	const edb::address_t address   = edb::v1::string_to_address(ui->txtAddress->text(), ok);
-	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+	const edb::address_t address = edb::v1::string_to_address(ui->txtAddress->text(), ok);
 
 	if(ok) {
 		edb::v1::memory_regions().sync();
 		const QList<MemRegion> regions = edb::v1::memory_regions().regions();
+		ReferenceIndex &index          = edb::v1::reference_index();
+
+		ReferenceIndex::ReferenceList references;
 
 		int i = 0;
 		Q_FOREACH(const MemRegion &region, regions) {
 			// a short circut for speading things up
 			if(region.accessible() || !ui->chkSkipNoAccess->isChecked()) {
-
-				const edb::address_t size_in_pages = region.size() / page_size;
-
-				try {
-
-					QVector<quint8> pages(size_in_pages * page_size);
-					const quint8 *const pages_end = &pages[0] + size_in_pages * page_size;
-
-					if(edb::v1::debugger_core->read_pages(region.start, &pages[0], size_in_pages)) {
-						const quint8 *p = &pages[0];
-						while(p != pages_end) {
-
-							if(static_cast<std::size_t>(pages_end - p) < sizeof(edb::address_t)) {
-								break;
-							}
-
-							const edb::address_t addr = p - &pages[0] + region.start;
-
-							edb::address_t test_address;
-							memcpy(&test_address, p, sizeof(edb::address_t));
-
-							if(test_address == address) {
-
-								QListWidgetItem *const item = new QListWidgetItem(edb::v1::format_pointer(addr));
-								item->setData(Qt::UserRole, 'D');
-								ui->listWidget->addItem(item);
-							}
-
-							edb::Instruction insn(p, pages_end - p, addr, std::nothrow);
-							if(insn.valid()) {
-								switch(insn.type()) {
-								case edb::Instruction::OP_JMP:
-								case edb::Instruction::OP_CALL:
-								case edb::Instruction::OP_JCC:
-									if(insn.operand(0).general_type() == edb::Operand::TYPE_REL) {
-										if(insn.operand(0).relative_target() == address) {
-											QListWidgetItem *const item = new QListWidgetItem(edb::v1::format_pointer(addr));
-											item->setData(Qt::UserRole, 'C');
-											ui->listWidget->addItem(item);
-										}
-									}
-									break;
-								default:
-									break;
-								}
-							}
-
-							emit updateProgress(util::percentage(i, regions.size(), p - &pages[0], region.size()));
-							++p;
-						}
-					}
-				} catch(const std::bad_alloc &) {
-					QMessageBox::information(
-						0,
-						tr("Memroy Allocation Error"),
-						tr("Unable to satisfy memory allocation request for requested region."));
-				}
-			} else {
-				emit updateProgress(util::percentage(i, regions.size()));
+				references += index.references_to(region, address);
 			}
-			++i;
+
+			emit updateProgress(util::percentage(++i, regions.size()));
+		}
+
+		Q_FOREACH(const ReferenceIndex::Reference &ref, references) {
+			QListWidgetItem *const item = new QListWidgetItem(edb::v1::format_pointer(ref.source));
+			item->setData(Qt::UserRole, (ref.type == ReferenceIndex::REF_DATA) ? 'D' : 'C');
+			ui->listWidget->addItem(item);
 		}
 	}
 }
@@ -17,17 +17,101 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "DialogStrings.h"
+#include "StringExtractor.h"
+#include "DebuggerCoreInterface.h"
 #include "Debugger.h"
 #include "MemoryRegions.h"
 #include "Util.h"
 #include "Configuration.h"
 
 #include <QHeaderView>
+#include <QListWidget>
 #include <QMessageBox>
 #include <QSortFilterProxyModel>
+#include <QThread>
+#include <QVector>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#ifdef USE_QT_CONCURRENT
+#include <QtConcurrentMap>
+#else
+#include <algorithm>
+#endif
 
 #include "ui_dialogstrings.h"
 
+namespace {
+
+struct FoundString {
+	edb::address_t address;
+	QString        text;
+};
+
+struct RegionScan {
+	edb::address_t       address;
+	QVector<quint8>      bytes;
+	QVector<FoundString> results;
+};
+
+//------------------------------------------------------------------------------
+// Name: scan_region(const StringExtractor &extractor, RegionScan &scan)
+// Desc: finds the strings in a region which has already been read, the text
+//       is formatted here too so the GUI thread only has to add the items
+//------------------------------------------------------------------------------
+void scan_region(const StringExtractor &extractor, RegionScan &scan) {
+
+	const quint8 *const first = scan.bytes.constData();
+
+	QVector<StringExtractor::Match> matches;
+	extractor.find_all(first, first + scan.bytes.size(), matches);
+
+	scan.results.reserve(matches.size());
+	Q_FOREACH(const StringExtractor::Match &match, matches) {
+		FoundString found;
+		found.address = scan.address + match.offset;
+		if(match.encoding == StringExtractor::UTF16) {
+			found.text = QString("%1: UTF16 \"%2\"").arg(edb::v1::format_pointer(found.address), extractor.text(first, match));
+		} else {
+			found.text = QString("%1: %2").arg(edb::v1::format_pointer(found.address), extractor.text(first, match));
+		}
+		scan.results.push_back(found);
+	}
+
+	// the bytes aren't needed anymore, no reason to hold on to them until
+	// the whole batch is done
+	scan.bytes = QVector<quint8>();
+}
+
+//------------------------------------------------------------------------------
+// Name: add_results(const StringExtractor &extractor, QVector<RegionScan> &batch, QListWidget *list)
+// Desc: scans a batch of regions (in parallel when possible) and adds what was
+//       found to the list
+//------------------------------------------------------------------------------
+void add_results(const StringExtractor &extractor, QVector<RegionScan> &batch, QListWidget *list) {
+
+#ifdef USE_QT_CONCURRENT
+	QtConcurrent::blockingMap(batch, boost::bind(scan_region, boost::cref(extractor), _1));
+#else
+	std::for_each(batch.begin(), batch.end(), boost::bind(scan_region, boost::cref(extractor), _1));
+#endif
+
+	list->setUpdatesEnabled(false);
+	Q_FOREACH(const RegionScan &scan, batch) {
+		Q_FOREACH(const FoundString &found, scan.results) {
+			QListWidgetItem *const item = new QListWidgetItem(found.text);
+			item->setData(Qt::UserRole, found.address);
+			list->addItem(item);
+		}
+	}
+	list->setUpdatesEnabled(true);
+
+	batch.clear();
+}
+
+}
+
 //------------------------------------------------------------------------------
 // Name: DialogStrings(QWidget *parent)
 // Desc:
@@ -76,17 +160,17 @@ void DialogStrings::showEvent(QShowEvent *) {
 
 //------------------------------------------------------------------------------
 // Name: do_find()
-// Desc:
+// Desc: each selected region is read once on this thread (the debugger core
+//       isn't thread safe), a batch of regions is then scanned in parallel
+//       for ASCII and UTF-16 strings and the results are added in one go
 //------------------------------------------------------------------------------
 void DialogStrings::do_find() {
 
-	const int min_string_length = edb::v1::config().min_string_length;
+	const StringExtractor extractor(edb::v1::config().min_string_length, 256);
 
 	const QItemSelectionModel *const selection_model = ui->tableView->selectionModel();
 	const QModelIndexList sel = selection_model->selectedRows();
 
-	QString str;
-
 	if(sel.size() == 0) {
 		QMessageBox::information(
 			this,
@@ -94,36 +178,44 @@ void DialogStrings::do_find() {
 			tr("You must select a region which is to be scanned for strings."));
 	}
 
-	Q_FOREACH(const QModelIndex &selected_item, sel) {
+	const edb::address_t page_size = edb::v1::debugger_core->page_size();
+	const int batch_size           = qMax(QThread::idealThreadCount(), 1);
 
-		const QModelIndex index = filter_model_->mapToSource(selected_item);
+	QVector<RegionScan> batch;
+	int done = 0;
 
-		if(const MemRegion *const region = reinterpret_cast<const MemRegion *>(index.internalPointer())) {
+	try {
+		Q_FOREACH(const QModelIndex &selected_item, sel) {
 
-			edb::address_t start_address     = region->start;
-			const edb::address_t end_address = region->end;
-			const edb::address_t orig_start  = start_address;
+			const QModelIndex index = filter_model_->mapToSource(selected_item);
 
-			// do the search for this region!
-			while(start_address < end_address) {
+			if(const MemRegion *const region = reinterpret_cast<const MemRegion *>(index.internalPointer())) {
 
-				int string_length = 0;
-				const bool ok = edb::v1::get_ascii_string_at_address(start_address, str, min_string_length, 256, string_length);
-				if(ok) {
-					QListWidgetItem *const item = new QListWidgetItem(QString("%1: %2").arg(edb::v1::format_pointer(start_address)).arg(str));
-					item->setData(Qt::UserRole, start_address);
-					ui->listWidget->addItem(item);
-				}
+				const edb::address_t size_in_pages = region->size() / page_size;
 
-				ui->progressBar->setValue(util::percentage((start_address - orig_start), region->size()));
+				RegionScan scan;
+				scan.address = region->start;
+				scan.bytes.resize(size_in_pages * page_size);
 
-				if(ok) {
-					start_address += string_length;
-				} else {
-					++start_address;
+				if(edb::v1::debugger_core->read_pages(scan.address, scan.bytes.data(), size_in_pages)) {
+					batch.push_back(scan);
 				}
 			}
+
+			++done;
+
+			if(batch.size() >= batch_size) {
+				add_results(extractor, batch, ui->listWidget);
+				ui->progressBar->setValue(util::percentage(done, sel.size()));
+			}
 		}
+
+		add_results(extractor, batch, ui->listWidget);
+	} catch(const std::bad_alloc &) {
+		QMessageBox::information(
+			0,
+			tr("Memroy Allocation Error"),
+			tr("Unable to satisfy memory allocation request for requested region."));
 	}
 }
 
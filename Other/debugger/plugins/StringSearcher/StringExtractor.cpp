@@ -0,0 +1,158 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StringExtractor.h"
+#include <cctype>
+#include <cstring>
+
+namespace {
+	const std::size_t npos = static_cast<std::size_t>(-1);
+}
+
+//------------------------------------------------------------------------------
+// Name: StringExtractor(int min_length, int max_length)
+// Desc: builds the character class table so that the scan only needs one
+//       lookup per byte for both encodings
+//------------------------------------------------------------------------------
+StringExtractor::StringExtractor(int min_length, int max_length) : min_length_(qMax(min_length, 1)), max_length_(qMax(max_length, 1)) {
+	for(int c = 0; c < 256; ++c) {
+		class_[c] = 0;
+		if(c < 0x80 && (std::isprint(c) || std::isspace(c))) {
+			class_[c] |= CLASS_ASCII;
+		}
+
+		if(c >= 0x20 && c < 0x80) {
+			class_[c] |= CLASS_UTF16;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: add_run(std::size_t offset, std::size_t length, Encoding encoding, QVector<Match> &results) const
+// Desc: splits a run of length characters into strings of at most max_length
+//------------------------------------------------------------------------------
+void StringExtractor::add_run(std::size_t offset, std::size_t length, Encoding encoding, QVector<Match> &results) const {
+
+	const std::size_t char_size  = (encoding == UTF16) ? 2 : 1;
+	const std::size_t max_length = max_length_;
+
+	while(length >= static_cast<std::size_t>(min_length_)) {
+		Match match;
+		match.offset   = offset;
+		match.length   = qMin(length, max_length);
+		match.encoding = encoding;
+		results.push_back(match);
+
+		offset += match.length * char_size;
+		length -= match.length;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: find_all(const quint8 *first, const quint8 *last, QVector<Match> &results) const
+// Desc: one pass over [first, last) tracks three runs at once: the ASCII run
+//       and a UTF-16 run for each byte alignment. Zero filled memory is
+//       skipped a word at a time while no run is open.
+//------------------------------------------------------------------------------
+void StringExtractor::find_all(const quint8 *first, const quint8 *last, QVector<Match> &results) const {
+
+	const std::size_t n = last - first;
+
+	std::size_t ascii_start    = npos;
+	std::size_t utf16_start[2] = { npos, npos };
+
+	std::size_t i = 0;
+	while(i < n) {
+
+		if(ascii_start == npos && utf16_start[0] == npos && utf16_start[1] == npos) {
+			quint64 word;
+			while(i + sizeof(word) <= n) {
+				std::memcpy(&word, first + i, sizeof(word));
+				if(word != 0) {
+					break;
+				}
+				i += sizeof(word);
+			}
+
+			if(i == n) {
+				break;
+			}
+		}
+
+		const quint8 c = class_[first[i]];
+
+		if(c & CLASS_ASCII) {
+			if(ascii_start == npos) {
+				ascii_start = i;
+			}
+		} else if(ascii_start != npos) {
+			add_run(ascii_start, i - ascii_start, ASCII, results);
+			ascii_start = npos;
+		}
+
+		std::size_t &start = utf16_start[i & 1];
+		if((c & CLASS_UTF16) && i + 1 < n && first[i + 1] == 0) {
+			if(start == npos) {
+				start = i;
+			}
+		} else if(start != npos) {
+			add_run(start, (i - start) / 2, UTF16, results);
+			start = npos;
+		}
+
+		++i;
+	}
+
+	if(ascii_start != npos) {
+		add_run(ascii_start, n - ascii_start, ASCII, results);
+	}
+
+	// an open UTF-16 run can't include the last byte (it has no high byte)
+	for(int parity = 0; parity < 2; ++parity) {
+		if(utf16_start[parity] != npos) {
+			add_run(utf16_start[parity], (n - utf16_start[parity]) / 2, UTF16, results);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: text(const quint8 *first, const Match &match) const
+// Desc: the string for a match, with C-style escapes like the ones
+//       edb::v1::get_ascii_string_at_address uses
+//------------------------------------------------------------------------------
+QString StringExtractor::text(const quint8 *first, const Match &match) const {
+
+	const quint8 *p = first + match.offset;
+	const std::size_t step = (match.encoding == UTF16) ? 2 : 1;
+
+	QString s;
+	s.reserve(match.length);
+	for(int i = 0; i < match.length; ++i, p += step) {
+		switch(*p) {
+		case '\r': s += "\\r";  break;
+		case '\n': s += "\\n";  break;
+		case '\t': s += "\\t";  break;
+		case '\v': s += "\\v";  break;
+		case '"':  s += "\\\""; break;
+		default:
+			s += QChar(*p);
+			break;
+		}
+	}
+	return s;
+}
@@ -0,0 +1,66 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STRINGEXTRACTOR_20121017_H_
+#define STRINGEXTRACTOR_20121017_H_
+
+#include "Types.h"
+#include <QString>
+#include <QVector>
+#include <cstddef>
+
+// finds the ASCII and UTF-16LE strings in a block of memory in a single pass,
+// a string is a run of at least min_length characters, longer runs are split
+// into pieces of max_length characters like edb::v1::get_ascii_string_at_address
+// does when it is called for every address
+class StringExtractor {
+public:
+	enum Encoding {
+		ASCII,
+		UTF16
+	};
+
+	struct Match {
+		std::size_t offset;
+		int         length;   // in characters
+		Encoding    encoding;
+	};
+
+public:
+	StringExtractor(int min_length, int max_length);
+
+public:
+	void find_all(const quint8 *first, const quint8 *last, QVector<Match> &results) const;
+	QString text(const quint8 *first, const Match &match) const;
+
+private:
+	void add_run(std::size_t offset, std::size_t length, Encoding encoding, QVector<Match> &results) const;
+
+private:
+	enum {
+		CLASS_ASCII = 0x01, // printable or whitespace
+		CLASS_UTF16 = 0x02  // the low byte of an ASCII char encoded as UTF-16
+	};
+
+private:
+	int    min_length_;
+	int    max_length_;
+	quint8 class_[256];
+};
+
+#endif
@@ -2,6 +2,6 @@
 include(../plugins.pri)
 
 # Input
-HEADERS += StringSearcher.h DialogStrings.h
+HEADERS += StringSearcher.h DialogStrings.h StringExtractor.h
 FORMS += dialogstrings.ui
-SOURCES += StringSearcher.cpp DialogStrings.cpp
+SOURCES += StringSearcher.cpp DialogStrings.cpp StringExtractor.cpp
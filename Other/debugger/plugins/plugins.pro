@@ -27,5 +27,8 @@ unix {
 
 	linux-* {
 		SUBDIRS += OpenFiles 
+
+		# the headless harness for the debugger core, not installed
+		SUBDIRS += DebuggerCore/benchmark
 	}
 }
@@ -29,7 +29,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 class HexStringValidator : public QValidator {
 public:
-	HexStringValidator(QObject * parent) : QValidator(parent) {}
+	HexStringValidator(QObject * parent) : QValidator(parent), wildcards_(false) {}
+
+public:
+	void set_wildcards(bool enabled) { wildcards_ = enabled; }
 
 public:
 	virtual void fixup(QString &input) const {
@@ -38,7 +41,7 @@ public:
 
 		Q_FOREACH(QChar ch, input) {
 			const int c = ch.toAscii();
-			if(c < 0x80 && std::isxdigit(c)) {
+			if(c < 0x80 && (std::isxdigit(c) || (wildcards_ && c == '?'))) {
 
 				if(index != 0 && (index & 1) == 0) {
 					temp += ' ';
@@ -78,8 +81,41 @@ public:
 		}
 		return QValidator::Acceptable;
 	}
+
+private:
+	bool wildcards_;
 };
 
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: parse_hex_byte(const QString &s, quint8 &mask)
+// Desc: a '?' in place of a digit means "any value", mask gets the bits which
+//       were actually given
+//------------------------------------------------------------------------------
+quint8 parse_hex_byte(const QString &s, quint8 &mask) {
+	quint8 value = 0;
+	mask = 0;
+
+	Q_FOREACH(QChar ch, s) {
+		value <<= 4;
+		mask  <<= 4;
+		if(ch != '?') {
+			value |= QString(ch).toUInt(0, 16);
+			mask  |= 0x0f;
+		}
+	}
+
+	if(s.size() < 2) {
+		// a lone digit is the low nibble, the high one is a known zero
+		mask |= 0xf0;
+	}
+
+	return value;
+}
+
+}
+
 
 //------------------------------------------------------------------------------
 // Name: setMaxLength(int n)
@@ -95,9 +131,17 @@ void BinaryString::setMaxLength(int n) {
 // Name: BinaryString(QWidget *parent)
 // Desc: constructor
 //------------------------------------------------------------------------------
-BinaryString::BinaryString(QWidget *parent) : QWidget(parent), ui(new Ui::BinaryStringWidget) {
+BinaryString::BinaryString(QWidget *parent) : QWidget(parent), ui(new Ui::BinaryStringWidget), validator_(new HexStringValidator(this)) {
 	ui->setupUi(this);
-	ui->txtHex->setValidator(new HexStringValidator(this));
+	ui->txtHex->setValidator(validator_);
+}
+
+//------------------------------------------------------------------------------
+// Name: setWildcardsEnabled(bool enabled)
+// Desc: lets the user type '?' in place of hex digits which may have any value
+//------------------------------------------------------------------------------
+void BinaryString::setWildcardsEnabled(bool enabled) {
+	validator_->set_wildcards(enabled);
 }
 
 //------------------------------------------------------------------------------
@@ -184,7 +228,8 @@ void BinaryString::on_txtHex_textEdited(const QString &text) {
 
 	Q_FOREACH(const QString &s, list1) {
 
-		const quint8 ch = s.toUInt(0, 16);
+		quint8 mask;
+		const quint8 ch = parse_hex_byte(s, mask);
 
 #if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
 		utf16Char = (utf16Char >> 8) | (ch << 8);
@@ -213,7 +258,27 @@ QByteArray BinaryString::value() const {
 	const QStringList list1 = ui->txtHex->text().split(" ", QString::SkipEmptyParts);
 
 	Q_FOREACH(const QString &i, list1) {
-		ret += static_cast<quint8>(i.toUInt(0, 16));
+		quint8 mask;
+		ret += parse_hex_byte(i, mask);
+	}
+
+	return ret;
+}
+
+//------------------------------------------------------------------------------
+// Name: mask() const
+// Desc: which bits of each byte of value() have to match, 0xff unless the
+//       byte has wildcards in it
+//------------------------------------------------------------------------------
+QByteArray BinaryString::mask() const {
+
+	QByteArray ret;
+	const QStringList list1 = ui->txtHex->text().split(" ", QString::SkipEmptyParts);
+
+	Q_FOREACH(const QString &i, list1) {
+		quint8 mask;
+		parse_hex_byte(i, mask);
+		ret += mask;
 	}
 
 	return ret;
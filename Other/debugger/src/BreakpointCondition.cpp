@@ -0,0 +1,80 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BreakpointCondition.h"
+#include "State.h"
+
+//------------------------------------------------------------------------------
+// Name: BreakpointCondition(const QString &condition, memory_reader_t mr)
+// Desc: compiles the condition, variables are handled by evaluate() so no
+//       variable getter is needed
+//------------------------------------------------------------------------------
+BreakpointCondition::BreakpointCondition(const QString &condition, memory_reader_t mr) : text_(condition), expression_(condition, Expression<edb::address_t>::variable_getter_t(), mr), valid_(false), resolved_(false) {
+	valid_ = expression_.compile(error_);
+}
+
+//------------------------------------------------------------------------------
+// Name: resolve(const State &state)
+// Desc: maps each variable of the expression to a register id, this only
+//       needs to happen once since the ids don't change from stop to stop
+//------------------------------------------------------------------------------
+void BreakpointCondition::resolve(const State &state) {
+	const QStringList &variables = expression_.variables();
+
+	register_ids_.resize(variables.size());
+	values_.resize(variables.size());
+
+	for(int i = 0; i < variables.size(); ++i) {
+		register_ids_[i] = state.register_id(variables[i]);
+	}
+
+	resolved_ = true;
+}
+
+//------------------------------------------------------------------------------
+// Name: evaluate(const State &state, bool &ok, ExpressionError &error)
+// Desc: evaluates the condition using the registers in state
+//------------------------------------------------------------------------------
+edb::address_t BreakpointCondition::evaluate(const State &state, bool &ok, ExpressionError &error) {
+
+	if(!valid_) {
+		ok    = false;
+		error = error_;
+		return 0;
+	}
+
+	if(!resolved_) {
+		resolve(state);
+	}
+
+	for(int i = 0; i < register_ids_.size(); ++i) {
+		const int id = register_ids_[i];
+
+		// if the platform doesn't hand out ids, look it up by name
+		const Register reg = (id != -1) ? state.register_value(id) : state.value(expression_.variables()[i]);
+		if(!reg) {
+			ok    = false;
+			error = ExpressionError(ExpressionError::UNKNOWN_VARIABLE);
+			return 0;
+		}
+
+		values_[i] = (reg.type() == Register::TYPE_SEG) ? reg.segment_base() : *reg;
+	}
+
+	return expression_.evaluate(values_.constData(), ok, error);
+}
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Debugger.h"
 #include "ArchProcessor.h"
 #include "BinaryString.h"
+#include "BreakpointCondition.h"
 #include "ByteShiftArray.h"
 #include "Configuration.h"
 #include "DebuggerCoreInterface.h"
@@ -37,6 +38,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "FunctionInfo.h"
 #include "MD5.h"
 #include "MemoryRegions.h"
+#include "ReferenceIndex.h"
 #include "QHexView"
 #include "State.h"
 #include "SymbolManager.h"
@@ -73,6 +75,9 @@ namespace {
 	BinaryInfoList                             g_BinaryInfoList;
 	
 	QHash<QString, FunctionInfo>               g_FunctionDB;
+
+	// breakpoint conditions, compiled when they are set
+	QHash<edb::address_t, QSharedPointer<BreakpointCondition> > g_BreakpointConditions;
 	
 	DebuggerMain *ui() {
 		return qobject_cast<DebuggerMain *>(edb::v1::debugger_ui);
@@ -188,6 +193,15 @@ MemoryRegions &edb::v1::memory_regions() {
 	return g_MemoryRegions;
 }
 
+//------------------------------------------------------------------------------
+// Name: reference_index()
+// Desc:
+//------------------------------------------------------------------------------
+ReferenceIndex &edb::v1::reference_index() {
+	static ReferenceIndex g_ReferenceIndex;
+	return g_ReferenceIndex;
+}
+
 //------------------------------------------------------------------------------
 // Name: arch_processor()
 // Desc:
@@ -322,9 +336,52 @@ void edb::v1::set_breakpoint_condition(edb::address_t address, const QString &co
 	Breakpoint::pointer bp = find_breakpoint(address);
 	if(bp) {
 		bp->condition = condition;
+
+		if(condition.isEmpty()) {
+			g_BreakpointConditions.remove(address);
+		} else {
+			// parse it now, rather than every time the breakpoint is hit
+			QSharedPointer<BreakpointCondition> compiled(new BreakpointCondition(condition, get_value));
+			g_BreakpointConditions[address] = compiled;
+
+			if(!compiled->valid()) {
+				QMessageBox::information(debugger_ui, QT_TRANSLATE_NOOP("edb", "Error In Breakpoint Condition!"), compiled->error().what());
+			}
+		}
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: eval_breakpoint_condition(const Breakpoint::pointer &bp, const State &state, edb::address_t &value, ExpressionError &err)
+// Desc: evaluates the condition of a breakpoint against the given state, this
+//       is called while handling debug events so it never interacts with the
+//       user, errors are reported through err
+//------------------------------------------------------------------------------
+bool edb::v1::eval_breakpoint_condition(const Breakpoint::pointer &bp, const State &state, edb::address_t &value, ExpressionError &err) {
+
+	Q_ASSERT(bp);
+
+	// conditions assigned without going through set_breakpoint_condition get
+	// compiled the first time that they are needed
+	QSharedPointer<BreakpointCondition> &compiled = g_BreakpointConditions[bp->address()];
+	if(!compiled || compiled->text() != bp->condition) {
+		compiled = QSharedPointer<BreakpointCondition>(new BreakpointCondition(bp->condition, get_value));
+	}
+
+	bool ok;
+	value = compiled->evaluate(state, ok, err);
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// Name: clear_breakpoint_conditions()
+// Desc: forgets every compiled condition, called when the breakpoints go
+//       away along with the process they were set in
+//------------------------------------------------------------------------------
+void edb::v1::clear_breakpoint_conditions() {
+	g_BreakpointConditions.clear();
+}
+
 //------------------------------------------------------------------------------
 // Name: get_breakpoint_condition(edb::address_t address)
 // Desc:
@@ -438,6 +495,7 @@ void edb::v1::toggle_breakpoint(edb::address_t address) {
 // Desc: removes a breakpoint
 //------------------------------------------------------------------------------
 void edb::v1::remove_breakpoint(edb::address_t address) {
+	g_BreakpointConditions.remove(address);
 	debugger_core->remove_breakpoint(address);
 	repaint_cpu_view();
 }
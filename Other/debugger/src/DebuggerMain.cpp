@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DialogPlugins.h"
 #include "Expression.h"
 #include "MemoryRegions.h"
+#include "ReferenceIndex.h"
 #include "Instruction.h"
 #include "QHexView"
 #include "RecentFileManager.h"
@@ -199,7 +200,8 @@ DebuggerMain::DebuggerMain(QWidget *parent) : DebuggerUI(parent),
 		recent_file_manager_(new RecentFileManager(this)),
 		stack_comment_server_(new CommentServer),
 		stack_view_locked_(false),
-		step_run_(false)
+		step_run_(false),
+		event_driven_(false)
 #ifdef Q_OS_UNIX
 		,debug_pointer_(0)
 #endif
@@ -207,8 +209,15 @@ DebuggerMain::DebuggerMain(QWidget *parent) : DebuggerUI(parent),
 
 	setup_ui();
 
-	// connect the timer to the debug event
-	connect(timer_, SIGNAL(timeout()), this, SLOT(next_debug_event()));
+	// cores which can tell us when an event is ready don't need to be polled
+	QObject *const core = dynamic_cast<QObject *>(edb::v1::debugger_core);
+	if(core && core->metaObject()->indexOfSignal("debug_event_ready()") != -1) {
+		connect(core, SIGNAL(debug_event_ready()), this, SLOT(next_debug_event()));
+		event_driven_ = true;
+	} else {
+		// connect the timer to the debug event
+		connect(timer_, SIGNAL(timeout()), this, SLOT(next_debug_event()));
+	}
 
 	// create a context menu for the tab bar as well
 	connect(ui->tabWidget, SIGNAL(customContextMenuRequested(int, const QPoint &)), this, SLOT(tab_context_menu(int, const QPoint &)));
@@ -1203,13 +1212,16 @@ void DebuggerMain::mnuStackModify() {
 }
 
 //------------------------------------------------------------------------------
-// Name: breakpoint_condition_true(const QString &condition) const
-// Desc:
+// Name: breakpoint_condition_true(const Breakpoint::pointer &bp, const State &state)
+// Desc: a condition which can't be evaluated counts as true, so that the user
+//       gets a chance to look at it
 //------------------------------------------------------------------------------
-bool DebuggerMain::breakpoint_condition_true(const QString &condition) {
+bool DebuggerMain::breakpoint_condition_true(const Breakpoint::pointer &bp, const State &state) {
 
 	edb::address_t condition_value;
-	if(!edb::v1::eval_expression(condition, condition_value)) {
+	ExpressionError error;
+	if(!edb::v1::eval_breakpoint_condition(bp, state, condition_value, error)) {
+		qDebug() << "Error In Breakpoint Condition at" << edb::v1::format_pointer(bp->address()) << ":" << error.what();
 		return true;
 	}
 	return condition_value;
@@ -1244,11 +1256,9 @@ edb::EVENT_STATUS DebuggerMain::handle_trap() {
 		state.set_instruction_pointer(previous_ip);
 		edb::v1::debugger_core->set_state(state);
 
-		const QString condition = bp->condition;
-
 		// handle conditional breakpoints
-		if(!condition.isEmpty()) {
-			if(!breakpoint_condition_true(condition)) {
+		if(!bp->condition.isEmpty()) {
+			if(!breakpoint_condition_true(bp, state)) {
 				return edb::DEBUG_CONTINUE;
 			}
 		}
@@ -1592,6 +1602,12 @@ void DebuggerMain::resume_execution(EXCEPTION_RESUME pass_exception, DEBUG_MODE
 		State state;
 		edb::v1::debugger_core->get_state(state);
 		reenable_breakpoint_ = edb::v1::find_breakpoint(state.instruction_pointer());
+
+		// one which the user disabled stays that way
+		if(reenable_breakpoint_ && !reenable_breakpoint_->enabled()) {
+			reenable_breakpoint_.clear();
+		}
+
 		if(reenable_breakpoint_) {
 			reenable_breakpoint_->disable();
 
@@ -1709,6 +1725,8 @@ void DebuggerMain::cleanup_debugger() {
 	timer_->stop();
 
 	edb::v1::memory_regions().clear();
+	edb::v1::reference_index().clear();
+	edb::v1::clear_breakpoint_conditions();
 	edb::v1::symbol_manager().clear();
 	edb::v1::arch_processor().reset();
 
@@ -1769,7 +1787,9 @@ void DebuggerMain::detach_from_process(DETACH_ACTION kill) {
 void DebuggerMain::set_initial_debugger_state() {
 
 	update_menu_state(PAUSED);
-	timer_->start(0);
+	if(!event_driven_) {
+		timer_->start(0);
+	}
 
 	edb::v1::symbol_manager().load_symbols(edb::v1::config().symbol_path);
 
@@ -2253,12 +2273,11 @@ void DebuggerMain::next_debug_event() {
 	Q_CHECK_PTR(edb::v1::debugger_core);
 
 	DebugEvent e;
-	if(edb::v1::debugger_core->wait_debug_event(e, 10)) {
+	if(edb::v1::debugger_core->wait_debug_event(e, event_driven_ ? 0 : 10)) {
 	
 		last_event_ = e;
 
-		// TODO: figure out a way to do this less often, if they map an obscene 
-		// number of regions, this really slows things down
+		// this is cheap when the memory map hasn't changed
 		edb::v1::memory_regions().sync();
 
 		// TODO: make the system use this information, this is huge! it will 
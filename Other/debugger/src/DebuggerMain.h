@@ -172,7 +172,7 @@ public:
 
 private:
 	QString session_filename() const;
-	bool breakpoint_condition_true(const QString &condition);
+	bool breakpoint_condition_true(const Breakpoint::pointer &bp, const State &state);
 	bool common_open(const QString &s, const QStringList &args);
 	bool current_instruction_is_return() const;
 	edb::EVENT_STATUS debug_event_handler(const DebugEvent &event);
@@ -240,6 +240,7 @@ private:
 	QString                                          program_executable_;
 	bool                                             stack_view_locked_;
 	bool                                             step_run_;
+	bool                                             event_driven_;
 	DebugEvent                                       last_event_;
 #ifdef Q_OS_UNIX
 	edb::address_t                                   debug_pointer_;
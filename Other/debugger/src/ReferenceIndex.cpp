@@ -0,0 +1,408 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReferenceIndex.h"
+#include "DebuggerCoreInterface.h"
+#include "Debugger.h"
+#include "MemoryRegions.h"
+
+#include <QtAlgorithms>
+#include <QtDebug>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: reference_less(const ReferenceIndex::Reference &lhs, const ReferenceIndex::Reference &rhs)
+// Desc: orders references by target and then by source
+//------------------------------------------------------------------------------
+bool reference_less(const ReferenceIndex::Reference &lhs, const ReferenceIndex::Reference &rhs) {
+	if(lhs.target != rhs.target) {
+		return lhs.target < rhs.target;
+	}
+	return lhs.source < rhs.source;
+}
+
+//------------------------------------------------------------------------------
+// Name: entry_less(const Entry &lhs, const Entry &rhs)
+// Desc: orders stored references by target and then by source
+//------------------------------------------------------------------------------
+template <class Entry>
+bool entry_less(const Entry &lhs, const Entry &rhs) {
+	if(lhs.target != rhs.target) {
+		return lhs.target < rhs.target;
+	}
+	return lhs.offset < rhs.offset;
+}
+
+//------------------------------------------------------------------------------
+// Name: target_less(const Entry &lhs, const Entry &rhs)
+// Desc: orders stored references by target only (for the equal_range lookups)
+//------------------------------------------------------------------------------
+template <class Entry>
+bool target_less(const Entry &lhs, const Entry &rhs) {
+	return lhs.target < rhs.target;
+}
+
+//------------------------------------------------------------------------------
+// Name: range_less(const ReferenceIndex::Range &lhs, const ReferenceIndex::Range &rhs)
+// Desc:
+//------------------------------------------------------------------------------
+template <class Range>
+bool range_less(const Range &lhs, const Range &rhs) {
+	return lhs.start < rhs.start;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_branch_start(const quint8 *p, const quint8 *last)
+// Desc: true if the bytes at p could start a relative jmp, call or jcc, only
+//       these offsets are worth running through the disassembler
+//------------------------------------------------------------------------------
+bool is_branch_start(const quint8 *p, const quint8 *last) {
+	switch(p[0]) {
+	case 0x70: case 0x71: case 0x72: case 0x73:
+	case 0x74: case 0x75: case 0x76: case 0x77:
+	case 0x78: case 0x79: case 0x7a: case 0x7b:
+	case 0x7c: case 0x7d: case 0x7e: case 0x7f:
+	case 0xe3: // jcxz
+	case 0xe8: // call rel32
+	case 0xe9: // jmp rel32
+	case 0xeb: // jmp rel8
+		return true;
+	case 0x0f: // jcc rel32
+		return (p + 1 != last) && (p[1] & 0xf0) == 0x80;
+	default:
+		return false;
+	}
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: ReferenceIndex()
+// Desc:
+//------------------------------------------------------------------------------
+ReferenceIndex::ReferenceIndex() : layout_generation_(0) {
+}
+
+//------------------------------------------------------------------------------
+// Name: clear()
+// Desc:
+//------------------------------------------------------------------------------
+void ReferenceIndex::clear() {
+	regions_.clear();
+	layout_.clear();
+	layout_generation_ = 0;
+}
+
+//------------------------------------------------------------------------------
+// Name: invalidate(const MemRegion &region)
+// Desc:
+//------------------------------------------------------------------------------
+void ReferenceIndex::invalidate(const MemRegion &region) {
+	regions_.remove(region);
+}
+
+//------------------------------------------------------------------------------
+// Name: sync_layout()
+// Desc: data references are only kept if they point into a mapped region, so
+//       if the regions have changed everything has to be rescanned. Returns
+//       true if the layout changed. The regions can only change if the
+//       debugee has run, so they are only looked at once per memory generation.
+//------------------------------------------------------------------------------
+bool ReferenceIndex::sync_layout() {
+
+	const quint64 generation = edb::v1::debugger_core->memory_generation();
+	if(generation != 0 && generation == layout_generation_) {
+		return false;
+	}
+
+	layout_generation_ = generation;
+
+	QVector<Range> layout;
+	Q_FOREACH(const MemRegion &region, edb::v1::memory_regions().regions()) {
+		const Range range = { region.start, region.end };
+		layout.push_back(range);
+	}
+
+	std::sort(layout.begin(), layout.end(), range_less<Range>);
+
+	bool changed = (layout.size() != layout_.size());
+	for(int i = 0; !changed && i < layout.size(); ++i) {
+		changed = layout[i].start != layout_[i].start || layout[i].end != layout_[i].end;
+	}
+
+	if(changed) {
+		regions_.clear();
+		layout_ = layout;
+	}
+
+	return changed;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_current(const MemRegion &region, quint64 generation) const
+// Desc: true if the region's references were checked against its contents
+//       since the last time that memory could have changed
+//------------------------------------------------------------------------------
+bool ReferenceIndex::is_current(const MemRegion &region, quint64 generation) const {
+	if(generation == 0) {
+		return false;
+	}
+
+	QHash<MemRegion, RegionInfo>::const_iterator it = regions_.find(region);
+	return it != regions_.end() && it->generation == generation;
+}
+
+//------------------------------------------------------------------------------
+// Name: is_mapped(edb::address_t address) const
+// Desc: binary search of the (sorted) region layout
+//------------------------------------------------------------------------------
+bool ReferenceIndex::is_mapped(edb::address_t address) const {
+
+	if(layout_.isEmpty() || address < layout_.first().start || address >= layout_.last().end) {
+		return false;
+	}
+
+	int lo = 0;
+	int hi = layout_.size();
+	while(lo < hi) {
+		const int mid = lo + (hi - lo) / 2;
+		if(address < layout_[mid].start) {
+			hi = mid;
+		} else if(address >= layout_[mid].end) {
+			lo = mid + 1;
+		} else {
+			return true;
+		}
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: update(const MemRegion &region)
+// Desc: reads the region and rescans it if its contents have changed, nothing
+//       is read if memory can't have changed since it was last checked
+//------------------------------------------------------------------------------
+bool ReferenceIndex::update(const MemRegion &region) {
+
+	sync_layout();
+
+	const quint64 generation = edb::v1::debugger_core->memory_generation();
+	if(is_current(region, generation)) {
+		return false;
+	}
+
+	const edb::address_t page_size     = edb::v1::debugger_core->page_size();
+	const edb::address_t size_in_pages = region.size() / page_size;
+
+	try {
+		QVector<quint8> pages(size_in_pages * page_size);
+		if(edb::v1::debugger_core->read_pages(region.start, pages.data(), size_in_pages)) {
+			return rebuild(region, pages.constData(), pages.size(), generation);
+		}
+	} catch(const std::bad_alloc &) {
+		qDebug() << "[ReferenceIndex] unable to allocate a snapshot of region" << edb::v1::format_pointer(region.start);
+	}
+
+	invalidate(region);
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// Name: update(const MemRegion &region, const quint8 *bytes, std::size_t size)
+// Desc: rescans the snapshot if its md5 doesn't match the one the region's
+//       references were built from
+//------------------------------------------------------------------------------
+bool ReferenceIndex::update(const MemRegion &region, const quint8 *bytes, std::size_t size) {
+
+	sync_layout();
+
+	const quint64 generation = edb::v1::debugger_core->memory_generation();
+	if(is_current(region, generation)) {
+		return false;
+	}
+
+	return rebuild(region, bytes, size, generation);
+}
+
+//------------------------------------------------------------------------------
+// Name: rebuild(const MemRegion &region, const quint8 *bytes, std::size_t size, quint64 generation)
+// Desc: rescans the snapshot unless its md5 matches the one the region's
+//       references were built from, either way the region is then current as
+//       of <generation>
+//------------------------------------------------------------------------------
+bool ReferenceIndex::rebuild(const MemRegion &region, const quint8 *bytes, std::size_t size, quint64 generation) {
+
+	// the sources are stored as 32-bit offsets
+	if(size > 0xffffffffu) {
+		qDebug() << "[ReferenceIndex] region" << edb::v1::format_pointer(region.start) << "is too large to index";
+		invalidate(region);
+		return false;
+	}
+
+	const QByteArray md5 = edb::v1::get_md5(bytes, size);
+
+	QHash<MemRegion, RegionInfo>::iterator it = regions_.find(region);
+	if(it != regions_.end() && it->md5 == md5) {
+		it->generation = generation;
+		return false;
+	}
+
+	RegionInfo info;
+	info.md5        = md5;
+	info.generation = generation;
+	build(info, region, bytes, size);
+	regions_[region] = info;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: build(RegionInfo &info, const MemRegion &region, const quint8 *bytes, std::size_t size) const
+// Desc: every pointer aligned word is checked for a pointer into a mapped
+//       region, so there is at most one data reference per word. Only the
+//       offsets which start with a relative branch opcode are disassembled.
+//------------------------------------------------------------------------------
+void ReferenceIndex::build(RegionInfo &info, const MemRegion &region, const quint8 *bytes, std::size_t size) const {
+
+	EntryList &entries       = info.entries;
+	const quint8 *const last = bytes + size;
+
+	for(const quint8 *p = bytes; p != last; ++p) {
+
+		const quint32 offset = static_cast<quint32>(p - bytes);
+
+		if((region.start + offset) % sizeof(edb::address_t) == 0 && static_cast<std::size_t>(last - p) >= sizeof(edb::address_t)) {
+			edb::address_t value;
+			std::memcpy(&value, p, sizeof(value));
+			if(is_mapped(value)) {
+				const Entry entry = { value, offset, REF_DATA };
+				entries.push_back(entry);
+			}
+		}
+
+		if(is_branch_start(p, last)) {
+			edb::Instruction insn(p, last - p, region.start + offset, std::nothrow);
+			if(insn.valid() && insn.operand(0).general_type() == edb::Operand::TYPE_REL) {
+				switch(insn.type()) {
+				case edb::Instruction::OP_JMP:
+				case edb::Instruction::OP_JCC:
+					{
+						const Entry entry = { insn.operand(0).relative_target(), offset, REF_JUMP };
+						entries.push_back(entry);
+					}
+					break;
+				case edb::Instruction::OP_CALL:
+					{
+						const Entry entry = { insn.operand(0).relative_target(), offset, REF_CALL };
+						entries.push_back(entry);
+					}
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	}
+
+	// the data references were found in source order, a sort by target is
+	// what makes the lookups cheap
+	std::sort(entries.begin(), entries.end(), entry_less<Entry>);
+	entries.squeeze();
+}
+
+//------------------------------------------------------------------------------
+// Name: expand(const MemRegion &region, const Entry &entry)
+// Desc: turns a stored reference back into one with an absolute source
+//------------------------------------------------------------------------------
+ReferenceIndex::Reference ReferenceIndex::expand(const MemRegion &region, const Entry &entry) {
+	const Reference ref = { entry.target, region.start + entry.offset, static_cast<Type>(entry.type) };
+	return ref;
+}
+
+//------------------------------------------------------------------------------
+// Name: find_in(const MemRegion &region, const EntryList &list, edb::address_t target, ReferenceList &results)
+// Desc:
+//------------------------------------------------------------------------------
+void ReferenceIndex::find_in(const MemRegion &region, const EntryList &list, edb::address_t target, ReferenceList &results) {
+
+	const Entry key = { target, 0, REF_DATA };
+
+	const std::pair<EntryList::const_iterator, EntryList::const_iterator> range =
+		std::equal_range(list.begin(), list.end(), key, target_less<Entry>);
+
+	for(EntryList::const_iterator it = range.first; it != range.second; ++it) {
+		results.push_back(expand(region, *it));
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: references_to(edb::address_t target) const
+// Desc: the references to target from every region which has been indexed
+//------------------------------------------------------------------------------
+ReferenceIndex::ReferenceList ReferenceIndex::references_to(edb::address_t target) const {
+
+	ReferenceList results;
+	for(QHash<MemRegion, RegionInfo>::const_iterator it = regions_.begin(); it != regions_.end(); ++it) {
+		find_in(it.key(), it->entries, target, results);
+	}
+
+	// the regions aren't visited in address order
+	std::sort(results.begin(), results.end(), reference_less);
+	return results;
+}
+
+//------------------------------------------------------------------------------
+// Name: references_to(const MemRegion &region, edb::address_t target)
+// Desc: the references to target from one region, which is indexed (or
+//       brought up to date) first
+//------------------------------------------------------------------------------
+ReferenceIndex::ReferenceList ReferenceIndex::references_to(const MemRegion &region, edb::address_t target) {
+
+	update(region);
+
+	ReferenceList results;
+	QHash<MemRegion, RegionInfo>::const_iterator it = regions_.find(region);
+	if(it != regions_.end()) {
+		find_in(region, it->entries, target, results);
+	}
+	return results;
+}
+
+//------------------------------------------------------------------------------
+// Name: references(const MemRegion &region)
+// Desc: all of the references from one region, which is indexed (or brought
+//       up to date) first
+//------------------------------------------------------------------------------
+ReferenceIndex::ReferenceList ReferenceIndex::references(const MemRegion &region) {
+
+	update(region);
+
+	ReferenceList results;
+	QHash<MemRegion, RegionInfo>::const_iterator it = regions_.find(region);
+	if(it != regions_.end()) {
+		results.reserve(it->entries.size());
+		Q_FOREACH(const Entry &entry, it->entries) {
+			results.push_back(expand(region, entry));
+		}
+	}
+	return results;
+}
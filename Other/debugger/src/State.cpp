@@ -74,6 +74,17 @@ void State::clear() {
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: capture()
+// Desc: makes the state hold everything, so that set_state can put all of it
+//       back even after the thread has run
+//------------------------------------------------------------------------------
+void State::capture() {
+	if(impl_) {
+		impl_->capture();
+	}
+}
+
 //------------------------------------------------------------------------------
 // Name: instruction_pointer() const
 // Desc:
@@ -129,6 +140,29 @@ Register State::value(const QString &reg) const {
 	return Register();
 }
 
+//------------------------------------------------------------------------------
+// Name: register_id(const QString &reg) const
+// Desc: returns an id for the named register which can be passed to
+//       register_value(), -1 if the platform doesn't provide one
+//------------------------------------------------------------------------------
+int State::register_id(const QString &reg) const {
+	if(impl_) {
+		return impl_->register_id(reg);
+	}
+	return -1;
+}
+
+//------------------------------------------------------------------------------
+// Name: register_value(int id) const
+// Desc: 
+//------------------------------------------------------------------------------
+Register State::register_value(int id) const {
+	if(impl_) {
+		return impl_->register_value(id);
+	}
+	return Register();
+}
+
 //------------------------------------------------------------------------------
 // Name: operator[](const QString &reg) const
 // Desc:
@@ -19,8 +19,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Instruction.h"
 #include "Instruction32.h"
 #include "Instruction64.h"
+#include "InstructionLength.tcc"
+#include "edisassm_block.tcc"
 
-// explicitly instantiate these two
+// explicitly instantiate these
 // to make sure everything links ok
 template class Instruction<edisassm::x86>;
 template class Instruction<edisassm::x86_64>;
+template class InstructionLength<edisassm::x86>;
+template class InstructionLength<edisassm::x86_64>;
+template struct edisassm::decoded_block<edisassm::x86>;
+template struct edisassm::decoded_block<edisassm::x86_64>;
+template std::size_t edisassm::decode_block(const uint8_t *, std::size_t, edisassm::x86::address_t, edisassm::decoded_block<edisassm::x86> &);
+template std::size_t edisassm::decode_block(const uint8_t *, std::size_t, edisassm::x86_64::address_t, edisassm::decoded_block<edisassm::x86_64> &);
@@ -62,8 +62,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 	{ "invalid", &Instruction::decode_invalid, OP_INVALID, FLAG_NONE, -1 }
 #endif
 
+template <class M>
+class InstructionLength;
+
 template <class M>
 class EDB_EXPORT Instruction {
+	friend class InstructionLength<M>;
+
 public:
 	static const int MAX_OPERANDS = M::MAX_OPERANDS;
 	static const int MAX_SIZE     = M::MAX_SIZE;
@@ -722,6 +727,7 @@ public:
 
 private:
 	void process_prefixes(const uint8_t *&buf, std::size_t size);
+	static void scan_prefixes(const uint8_t *buf, std::size_t size, uint32_t &prefix, uint8_t &prefix_size, uint8_t &rex, uint8_t &rex_size);
 	operand_t &next_operand();
 
 private:
@@ -1257,7 +1263,7 @@ public:
 	const operand_t &operand(std::size_t index) const { return operands_[index]; }
 	const uint8_t *buffer() const                     { return buffer_; }
 	operator void *() const                           { return reinterpret_cast<void *>(valid()); }
-	std::string mnemonic() const                      { return opcode_->mnemonic; }
+	const char *mnemonic() const                      { return opcode_->mnemonic; }
 	uint32_t prefix() const                           { return prefix_; }
 	uint32_t mandatory_prefix() const                 { return mandatory_prefix_; }
 	unsigned int operand_count() const                { return operand_count_; }
@@ -845,6 +845,22 @@ void Instruction<M>::swap(Instruction &other) {
 template <class M>
 void Instruction<M>::process_prefixes(const uint8_t *&buf, std::size_t size) {
 
+	uint8_t rex = 0;
+	scan_prefixes(buf, size, prefix_, prefix_size_, rex, rex_size_);
+
+	rex_byte_ = rex;
+	buf += prefix_size_ + rex_size_;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_prefixes(const uint8_t *buf, std::size_t size, uint32_t &prefix, uint8_t &prefix_size, uint8_t &rex, uint8_t &rex_size)
+// Desc: the prefix rules shared by the full decoder and InstructionLength,
+//       rex is set to the byte following the legacy prefixes (64-bit only)
+//       and rex_size says whether it actually was a REX prefix
+//------------------------------------------------------------------------------
+template <class M>
+void Instruction<M>::scan_prefixes(const uint8_t *buf, std::size_t size, uint32_t &prefix, uint8_t &prefix_size, uint8_t &rex, uint8_t &rex_size) {
+
 	bool done = false;
 
 	// we only allow one prefix from each group to be set,
@@ -858,48 +874,48 @@ void Instruction<M>::process_prefixes(const uint8_t *&buf, std::size_t size) {
 		switch(*buf) {
 		// group1
 		case 0xf0:
-			prefix_ = (prefix_ & 0xffffff00) | PREFIX_LOCK;
+			prefix = (prefix & 0xffffff00) | PREFIX_LOCK;
 			break;
 		case 0xf2:
-			prefix_ = (prefix_ & 0xffffff00) | PREFIX_REPNE;
+			prefix = (prefix & 0xffffff00) | PREFIX_REPNE;
 			break;
 		case 0xf3:
-			prefix_ = (prefix_ & 0xffffff00) | PREFIX_REP;
+			prefix = (prefix & 0xffffff00) | PREFIX_REP;
 			break;
 		// group2
 		case 0x2e:
-			prefix_ = (prefix_ & 0xffff00ff) | PREFIX_CS;
+			prefix = (prefix & 0xffff00ff) | PREFIX_CS;
 			break;
 		case 0x36:
-			prefix_ = (prefix_ & 0xffff00ff) | PREFIX_SS;
+			prefix = (prefix & 0xffff00ff) | PREFIX_SS;
 			break;
 		case 0x3e:
-			prefix_ = (prefix_ & 0xffff00ff) | PREFIX_DS;
+			prefix = (prefix & 0xffff00ff) | PREFIX_DS;
 			break;
 		case 0x26:
-			prefix_ = (prefix_ & 0xffff00ff) | PREFIX_ES;
+			prefix = (prefix & 0xffff00ff) | PREFIX_ES;
 			break;
 		case 0x64:
-			prefix_ = (prefix_ & 0xffff00ff) | PREFIX_FS;
+			prefix = (prefix & 0xffff00ff) | PREFIX_FS;
 			break;
 		case 0x65:
-			prefix_ = (prefix_ & 0xffff00ff) | PREFIX_GS;
+			prefix = (prefix & 0xffff00ff) | PREFIX_GS;
 			break;
 		#if 0
 		case 0x2e:
-			prefix_ = (prefix_ & 0xffff00ff) | PREFIX_BRANCH_NOT_TAKEN;
+			prefix = (prefix & 0xffff00ff) | PREFIX_BRANCH_NOT_TAKEN;
 			break;
 		case 0x3e:
-			prefix_ = (prefix_ & 0xffff00ff) | PREFIX_BRANCH_TAKEN;
+			prefix = (prefix & 0xffff00ff) | PREFIX_BRANCH_TAKEN;
 			break;
 		#endif
 		// group3
 		case 0x66:
-			prefix_ = (prefix_ & 0xff00ffff) | PREFIX_OPERAND;
+			prefix = (prefix & 0xff00ffff) | PREFIX_OPERAND;
 			break;
 		// group4
 		case 0x67:
-			prefix_ = (prefix_ & 0x00ffffff) | PREFIX_ADDRESS;
+			prefix = (prefix & 0x00ffffff) | PREFIX_ADDRESS;
 			break;
 		default:
 			done = true;
@@ -910,18 +926,16 @@ void Instruction<M>::process_prefixes(const uint8_t *&buf, std::size_t size) {
 		// is smart
 		if(!done) {
 			++buf;
-			++prefix_size_;
+			++prefix_size;
 			--size;
 		}
 	} while(!done);
 
 	if(BITS == 64) {
 		if(size != 0) {
-			rex_byte_ = *buf;
-			if(rex_byte_.is_rex()) {
-				++buf;
-				++rex_size_;
-				--size;
+			rex = *buf;
+			if(REX(rex).is_rex()) {
+				++rex_size;
 			}
 		}
 	}
@@ -743,7 +743,7 @@ const Instruction<edisassm::x86_64>::opcode_entry Instruction<edisassm::x86_64>:
 	{ "cvtpi2pd", &Instruction::decode_Vo_Qq, OP_CVTPI2PD, FLAG_NONE, 2 },
 	{ "movntpd",  &Instruction::decode_Mo_Vo, OP_MOVNTPD, FLAG_NONE, 2 },
 	{ "cvttpd2pi",  &Instruction::decode_Pq_Wo, OP_CVTTPD2PI, FLAG_NONE, 2 },
-	{ "cvtpd2pi",  &Instruction::decode_Qq_Wo, OP_CVTPD2PI, FLAG_NONE, 2 },
+	{ "cvtpd2pi",  &Instruction::decode_Pq_Wo, OP_CVTPD2PI, FLAG_NONE, 2 },
 	{ "ucomisd",  &Instruction::decode_Vo_Wo, OP_UCOMISD, FLAG_NONE, 2 },
 	{ "comisd",  &Instruction::decode_Vo_Wo, OP_COMISD, FLAG_NONE, 2 },
 
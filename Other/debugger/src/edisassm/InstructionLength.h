@@ -0,0 +1,93 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INSTRUCTION_LENGTH_20121017_H_
+#define INSTRUCTION_LENGTH_20121017_H_
+
+#include "Instruction.h"
+#include <vector>
+
+// Finds the size and type of an instruction without decoding its operands.
+// The lookup tables are filled in once, on first use, by running the full
+// decoder over every opcode table entry for each prefix state that it
+// distinguishes, so the two can not disagree. After that, decoding an
+// instruction neither allocates nor throws.
+template <class M>
+class EDB_EXPORT InstructionLength {
+public:
+	static const int MAX_SIZE = M::MAX_SIZE;
+	static const int BITS     = M::BITS;
+
+public:
+	typedef Instruction<M>               instruction_t;
+	typedef typename instruction_t::Type Type;
+
+public:
+	InstructionLength(const uint8_t *buf, std::size_t size) throw();
+
+public:
+	Type type() const                  { return static_cast<Type>(type_); }
+	bool valid() const                 { return type_ != instruction_t::OP_INVALID; }
+	operator void *() const            { return reinterpret_cast<void *>(valid()); }
+	unsigned int size() const          { return size_; }
+	unsigned int opcode_offset() const { return opcode_offset_; } // prefixes and REX
+
+private:
+	enum CellFlags {
+		CELL_MODRM    = 0x01, // a ModRM byte follows the opcode
+		CELL_MEMORY   = 0x02, // the memory form has SIB/displacement bytes
+		CELL_ESCAPE   = 0x04, // the next byte indexes the map in "extra"
+		CELL_FALLBACK = 0x08  // length depends on more than the ModRM byte
+	};
+
+	enum {
+		MAPS        = 4,  // 1 byte, 0x0f, 0x0f 0x38, 0x0f 0x3a
+		REX_CLASSES = (BITS == 64) ? 5 : 1,
+		STATES      = 2 * 3 * REX_CLASSES,
+		CELLS       = 64 + 8 // register forms by reg/rm, memory forms by reg
+	};
+
+	struct cell {
+		uint8_t  flags;
+		uint8_t  extra; // immediate size, or the map for CELL_ESCAPE
+		uint16_t type;
+	};
+
+	struct row {
+		cell cells[CELLS];
+	};
+
+	struct table {
+		table();
+
+		std::vector<uint16_t> index; // [state][map][opcode] -> rows
+		std::vector<row>      rows;
+	};
+
+private:
+	static const table &lookup_table();
+	static int state_index(uint32_t prefix, uint8_t rex, uint8_t rex_size);
+	static cell probe(int state, int map, uint8_t opcode, const uint8_t *modrm, std::size_t modrm_size);
+
+private:
+	uint16_t type_;
+	uint8_t  size_;
+	uint8_t  opcode_offset_;
+};
+
+#endif
@@ -0,0 +1,320 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INSTRUCTION_LENGTH_20121017_TCC_
+#define INSTRUCTION_LENGTH_20121017_TCC_
+
+#include "InstructionLength.h"
+#include "ModRM.h"
+#include "SIB.h"
+#include "REX.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+
+namespace {
+
+// the bytes which select each opcode map, the index into this
+// table is the map number used by InstructionLength
+const uint8_t map_escapes[][2] = {
+	{ 0x00, 0x00 },
+	{ 0x0f, 0x00 },
+	{ 0x0f, 0x38 },
+	{ 0x0f, 0x3a }
+};
+
+const std::size_t map_escape_sizes[] = { 0, 1, 2, 2 };
+
+}
+
+//------------------------------------------------------------------------------
+// Name: InstructionLength(const uint8_t *buf, std::size_t size) throw()
+//------------------------------------------------------------------------------
+template <class M>
+InstructionLength<M>::InstructionLength(const uint8_t *buf, std::size_t size) throw() : type_(instruction_t::OP_INVALID), size_(0), opcode_offset_(0) {
+
+	uint32_t prefix      = 0;
+	uint8_t  prefix_size = 0;
+	uint8_t  rex         = 0;
+	uint8_t  rex_size    = 0;
+
+	instruction_t::scan_prefixes(buf, size, prefix, prefix_size, rex, rex_size);
+
+	const table &t = lookup_table();
+	const uint16_t *const index = &t.index[state_index(prefix, rex, rex_size) * MAPS * 0x100];
+
+	std::size_t n = prefix_size + rex_size;
+	opcode_offset_ = n;
+
+	int map = 0;
+	const row *r;
+
+	// find the row for the opcode, following any escape bytes
+	do {
+		if(n >= size) {
+			return;
+		}
+
+		r = &t.rows[index[map * 0x100 + buf[n++]]];
+		map = r->cells[0].extra;
+	} while(r->cells[0].flags & CELL_ESCAPE);
+
+	const cell *c = &r->cells[0];
+
+	if(c->flags & CELL_FALLBACK) {
+		const instruction_t insn(buf, size, 0, std::nothrow);
+		if(insn) {
+			type_ = insn.type();
+			size_ = insn.size();
+		}
+		return;
+	}
+
+	if(c->flags & CELL_MODRM) {
+		if(n >= size) {
+			return;
+		}
+
+		const ModRM modrm(buf[n++]);
+
+		if(modrm.mod() == 0x03) {
+			c = &r->cells[(modrm.reg() << 3) | modrm.rm()];
+		} else {
+			c = &r->cells[64 + modrm.reg()];
+
+			if(c->flags & CELL_MEMORY) {
+				if(BITS != 64 && (prefix & instruction_t::PREFIX_ADDRESS)) {
+					// 16-bit addressing
+					switch(modrm.mod()) {
+					case 0x00:
+						if(modrm.rm() == 0x06) {
+							n += sizeof(int16_t);
+						}
+						break;
+					case 0x01:
+						n += sizeof(int8_t);
+						break;
+					case 0x02:
+						n += sizeof(int16_t);
+						break;
+					}
+				} else {
+					bool disp32 = false;
+
+					if(modrm.rm() == 0x04) {
+						if(n >= size) {
+							return;
+						}
+
+						const SIB sib(buf[n++]);
+						disp32 = (modrm.mod() == 0x00 && sib.base() == 0x05);
+					} else {
+						disp32 = (modrm.mod() == 0x00 && modrm.rm() == 0x05);
+					}
+
+					switch(modrm.mod()) {
+					case 0x00:
+						if(disp32) {
+							n += sizeof(int32_t);
+						}
+						break;
+					case 0x01:
+						n += sizeof(int8_t);
+						break;
+					case 0x02:
+						n += sizeof(int32_t);
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	if(c->type == instruction_t::OP_INVALID) {
+		return;
+	}
+
+	n += c->extra;
+	if(n > size) {
+		return;
+	}
+
+	type_ = c->type;
+	size_ = n;
+}
+
+//------------------------------------------------------------------------------
+// Name: state_index(uint32_t prefix, uint8_t rex, uint8_t rex_size)
+// Desc: the prefix state the decoders look at: operand size, the mandatory
+//       0xf2/0xf3 prefixes and in 64-bit mode, REX.W and REX.B
+//------------------------------------------------------------------------------
+template <class M>
+int InstructionLength<M>::state_index(uint32_t prefix, uint8_t rex, uint8_t rex_size) {
+
+	int rep = 0;
+	if(prefix & instruction_t::PREFIX_REPNE) {
+		rep = 1;
+	} else if(prefix & instruction_t::PREFIX_REP) {
+		rep = 2;
+	}
+
+	int rex_class = 0;
+	if(BITS == 64 && rex_size != 0) {
+		const REX rex_byte(rex);
+		rex_class = 1 + ((rex_byte.w() << 1) | rex_byte.b());
+	}
+
+	return (rex_class * 3 + rep) * 2 + ((prefix & instruction_t::PREFIX_OPERAND) ? 1 : 0);
+}
+
+//------------------------------------------------------------------------------
+// Name: probe(int state, int map, uint8_t opcode, const uint8_t *modrm, std::size_t modrm_size)
+// Desc: runs the full decoder over an opcode in the given prefix state and
+//       records what it consumed
+//------------------------------------------------------------------------------
+template <class M>
+typename InstructionLength<M>::cell InstructionLength<M>::probe(int state, int map, uint8_t opcode, const uint8_t *modrm, std::size_t modrm_size) {
+
+	uint8_t buf[32];
+	std::memset(buf, 0, sizeof(buf));
+
+	std::size_t n = 0;
+
+	if(state & 1) {
+		buf[n++] = 0x66;
+	}
+
+	switch((state / 2) % 3) {
+	case 1: buf[n++] = 0xf2; break;
+	case 2: buf[n++] = 0xf3; break;
+	}
+
+	if(const int rex_class = state / 6) {
+		buf[n++] = 0x40 | (((rex_class - 1) & 2) << 2) | ((rex_class - 1) & 1);
+	}
+
+	for(std::size_t i = 0; i < map_escape_sizes[map]; ++i) {
+		buf[n++] = map_escapes[map][i];
+	}
+
+	const std::size_t opcode_size = map_escape_sizes[map] + 1;
+	buf[n++] = opcode;
+
+	std::memcpy(&buf[n], modrm, modrm_size);
+
+	const instruction_t insn(buf, sizeof(buf), 0, std::nothrow);
+
+	cell c;
+	c.flags = 0;
+	c.extra = 0;
+	c.type  = instruction_t::OP_INVALID;
+
+	if(insn.opcode_size_ > opcode_size) {
+		// the opcode selects another map
+		c.flags = CELL_FALLBACK;
+		for(int i = 0; i < MAPS; ++i) {
+			if(map_escape_sizes[i] == opcode_size && std::memcmp(map_escapes[i], &buf[n - opcode_size], opcode_size) == 0) {
+				c.flags = CELL_ESCAPE;
+				c.extra = i;
+			}
+		}
+		return c;
+	}
+
+	if(insn.modrm_size_ != 0) {
+		c.flags |= CELL_MODRM;
+	}
+
+	if(insn.valid()) {
+		// a displacement without a SIB byte is a moffs operand,
+		// which is just another fixed size field
+		if(insn.sib_size_ != 0) {
+			c.flags |= CELL_MEMORY;
+			c.extra = insn.immediate_size_;
+		} else {
+			c.extra = insn.immediate_size_ + insn.disp_size_;
+		}
+		c.type  = insn.type();
+	}
+
+	return c;
+}
+
+//------------------------------------------------------------------------------
+// Name: table()
+//------------------------------------------------------------------------------
+template <class M>
+InstructionLength<M>::table::table() : index(STATES * MAPS * 0x100) {
+
+	std::map<std::string, uint16_t> known_rows;
+
+	for(int state = 0; state < STATES; ++state) {
+		for(int map = 0; map < MAPS; ++map) {
+			for(int opcode = 0; opcode < 0x100; ++opcode) {
+
+				row r;
+
+				const uint8_t register_form = 0xc0;
+				cell first = probe(state, map, opcode, &register_form, 1);
+
+				// the only opcode whose length depends on the bytes after it
+				if(map == 0 && instruction_t::Opcodes[opcode].decoder == &instruction_t::wait_feni_fdisi_finit_fclex) {
+					first.flags = CELL_FALLBACK;
+				}
+
+				std::fill(r.cells, r.cells + CELLS, first);
+
+				if(first.flags == CELL_MODRM) {
+					for(int reg = 0; reg < 8; ++reg) {
+						for(int rm = 0; rm < 8; ++rm) {
+							const uint8_t modrm = 0xc0 | (reg << 3) | rm;
+							r.cells[(reg << 3) | rm] = probe(state, map, opcode, &modrm, 1);
+						}
+
+						// mod 2 with a SIB byte, so any addressing bytes get consumed
+						const uint8_t memory_form[2] = { static_cast<uint8_t>(0x84 | (reg << 3)), 0x00 };
+						r.cells[64 + reg] = probe(state, map, opcode, memory_form, sizeof(memory_form));
+					}
+				}
+
+				const std::string key(reinterpret_cast<const char *>(&r), sizeof(r));
+				std::map<std::string, uint16_t>::const_iterator it = known_rows.find(key);
+				if(it == known_rows.end()) {
+					it = known_rows.insert(std::make_pair(key, static_cast<uint16_t>(rows.size()))).first;
+					rows.push_back(r);
+				}
+
+				index[(state * MAPS + map) * 0x100 + opcode] = it->second;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: lookup_table()
+// Desc: built on first use, g++ serializes the initialization so this is
+//       safe to call from several threads
+//------------------------------------------------------------------------------
+template <class M>
+const typename InstructionLength<M>::table &InstructionLength<M>::lookup_table() {
+	static const table t;
+	return t;
+}
+
+#endif
@@ -0,0 +1,230 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Measures decoder throughput over the x86 and x86-64 corpora in corpus/:
+// Instruction, InstructionLength and decode_block over a linear sweep, and
+// the first two at every byte offset (as the call scanners and the backwards
+// disassembly in the CPU view do). Also times formatting the instructions.
+
+#include "Instruction.h"
+#include "InstructionLength.h"
+#include "edisassm_block.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstdlib>
+
+#ifndef EDISASSM_CORPUS_DIR
+#define EDISASSM_CORPUS_DIR "corpus"
+#endif
+
+namespace {
+
+struct result {
+	std::size_t instructions;
+	std::size_t bytes;
+	double      seconds;
+};
+
+//------------------------------------------------------------------------------
+// Name: sweep(const std::vector<uint8_t> &data, bool every_offset, int passes)
+//------------------------------------------------------------------------------
+template <class T>
+result sweep(const std::vector<uint8_t> &data, bool every_offset, int passes) {
+
+	result r = { 0, 0, 0.0 };
+
+	const uint8_t *const first = &data[0];
+	const uint8_t *const last  = first + data.size();
+
+	const std::clock_t start = std::clock();
+
+	for(int pass = 0; pass < passes; ++pass) {
+		const uint8_t *p = first;
+		while(p < last) {
+			const T insn(p, last - p);
+			if(insn) {
+				++r.instructions;
+				r.bytes += insn.size();
+				p += every_offset ? 1 : insn.size();
+			} else {
+				++p;
+			}
+		}
+	}
+
+	r.seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+	return r;
+}
+
+//------------------------------------------------------------------------------
+// Name: sweep_block(const std::vector<uint8_t> &data, int passes)
+//------------------------------------------------------------------------------
+template <class M>
+result sweep_block(const std::vector<uint8_t> &data, int passes) {
+
+	result r = { 0, 0, 0.0 };
+
+	edisassm::decoded_block<M> block;
+
+	const std::clock_t start = std::clock();
+
+	for(int pass = 0; pass < passes; ++pass) {
+		edisassm::decode_block<M>(&data[0], data.size(), 0, block);
+		for(std::size_t i = 0; i < block.size(); ++i) {
+			if(!(block.flags[i] & edisassm::BLOCK_INVALID)) {
+				++r.instructions;
+				r.bytes += block.length[i];
+			}
+		}
+	}
+
+	r.seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+	return r;
+}
+
+//------------------------------------------------------------------------------
+// Name: sweep_format(const std::vector<uint8_t> &data, int passes)
+//------------------------------------------------------------------------------
+template <class M>
+result sweep_format(const std::vector<uint8_t> &data, int passes) {
+
+	result r = { 0, 0, 0.0 };
+
+	const uint8_t *const first = &data[0];
+	const uint8_t *const last  = first + data.size();
+
+	char text[edisassm::MAX_STRING_SIZE];
+
+	const std::clock_t start = std::clock();
+
+	for(int pass = 0; pass < passes; ++pass) {
+		const uint8_t *p = first;
+		while(p < last) {
+			const Instruction<M> insn(p, last - p, p - first, std::nothrow);
+			if(insn) {
+				++r.instructions;
+				r.bytes += edisassm::to_string(insn, edisassm::syntax_intel(), text, sizeof(text));
+				p += insn.size();
+			} else {
+				++p;
+			}
+		}
+	}
+
+	r.seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+	return r;
+}
+
+//------------------------------------------------------------------------------
+// Name: full_decoder
+// Desc: gives Instruction the same constructor signature as InstructionLength
+//------------------------------------------------------------------------------
+template <class M>
+struct full_decoder : Instruction<M> {
+	full_decoder(const uint8_t *buf, std::size_t size) : Instruction<M>(buf, size, 0, std::nothrow) {
+	}
+};
+
+//------------------------------------------------------------------------------
+// Name: report(const char *name, const result &r, std::size_t total_bytes)
+//------------------------------------------------------------------------------
+void report(const char *name, const result &r, std::size_t total_bytes) {
+	std::cout << "  " << name << ": " << r.instructions << " instructions in " << r.seconds << "s, "
+	          << (r.instructions / r.seconds / 1e6) << "M insn/s, "
+	          << (total_bytes / r.seconds / (1024 * 1024)) << " MB/s" << std::endl;
+}
+
+//------------------------------------------------------------------------------
+// Name: run(const std::string &filename, int passes)
+//------------------------------------------------------------------------------
+template <class M>
+bool run(const std::string &filename, int passes) {
+
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if(!file) {
+		std::cerr << "could not open the file: " << filename << std::endl;
+		return false;
+	}
+
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if(data.empty()) {
+		std::cerr << "empty file: " << filename << std::endl;
+		return false;
+	}
+
+	bool ok = true;
+
+	// warm up, this also builds the length tables
+	const std::clock_t start = std::clock();
+	const InstructionLength<M> warmup(&data[0], data.size());
+	(void)warmup;
+
+	std::cout << filename << ": " << data.size() << " bytes, " << passes << " passes, " << M::BITS
+	          << "-bit (length tables built in " << static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC << "s)" << std::endl;
+
+	const std::size_t total_bytes = data.size() * passes;
+
+	std::cout << " linear sweep:" << std::endl;
+	const result full   = sweep<full_decoder<M> >(data, false, passes);
+	const result length = sweep<InstructionLength<M> >(data, false, passes);
+	const result block  = sweep_block<M>(data, passes);
+
+	report("Instruction      ", full, total_bytes);
+	report("InstructionLength", length, total_bytes);
+	report("decode_block     ", block, total_bytes);
+
+	if(full.instructions != length.instructions || full.bytes != length.bytes || full.instructions != block.instructions || full.bytes != block.bytes) {
+		std::cout << "  results differ!" << std::endl;
+		ok = false;
+	}
+
+	std::cout << " every offset:" << std::endl;
+	const result full_all   = sweep<full_decoder<M> >(data, true, passes);
+	const result length_all = sweep<InstructionLength<M> >(data, true, passes);
+
+	report("Instruction      ", full_all, total_bytes);
+	report("InstructionLength", length_all, total_bytes);
+
+	if(full_all.instructions != length_all.instructions || full_all.bytes != length_all.bytes) {
+		std::cout << "  results differ!" << std::endl;
+		ok = false;
+	}
+
+	std::cout << " decode and format:" << std::endl;
+	report("to_string        ", sweep_format<M>(data, passes), total_bytes);
+
+	return ok;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: main(int argc, char *argv[])
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+
+	const std::string directory = (argc > 1) ? argv[1] : EDISASSM_CORPUS_DIR;
+	const int passes = (argc > 2) ? std::atoi(argv[2]) : 400;
+
+	const bool ok32 = run<edisassm::x86>(directory + "/x86.bin", passes);
+	const bool ok64 = run<edisassm::x86_64>(directory + "/x86_64.bin", passes);
+	return (ok32 && ok64) ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EDISASSM_BLOCK_20121017_H_
+#define EDISASSM_BLOCK_20121017_H_
+
+#include "edisassm_types.h"
+#include <cstddef>
+#include <vector>
+
+namespace edisassm {
+
+	enum flow_type {
+		FLOW_NONE,
+		FLOW_JUMP,        // jmp
+		FLOW_CONDITIONAL, // jcc, jcxz and the loops
+		FLOW_CALL,
+		FLOW_RETURN,      // ret, retf and iret
+		FLOW_INTERRUPT,   // int, int3, into and the sys* instructions
+		FLOW_HALT         // hlt and ud2, execution does not continue past them
+	};
+
+	enum block_flags {
+		BLOCK_INVALID  = 0x01, // the byte did not decode, it is skipped as a 1 byte entry
+		BLOCK_RELATIVE = 0x02, // target holds the destination of a relative branch
+		BLOCK_INDIRECT = 0x04, // the branch goes through a register or memory
+		BLOCK_FAR      = 0x08  // the branch loads CS as well
+	};
+
+	//------------------------------------------------------------------------------
+	// Name: decoded_block
+	// Desc: the instructions of a buffer as parallel arrays, entry i of each one
+	//       describes the same instruction
+	//------------------------------------------------------------------------------
+	template <class M>
+	struct decoded_block {
+		typedef typename M::address_t address_t;
+
+		std::vector<uint32_t>  offset; // from the start of the buffer
+		std::vector<uint8_t>   length;
+		std::vector<uint16_t>  type;   // Instruction<M>::Type
+		std::vector<uint8_t>   flow;   // flow_type
+		std::vector<address_t> target; // only set with BLOCK_RELATIVE
+		std::vector<uint8_t>   flags;  // block_flags
+
+		std::size_t size() const { return offset.size(); }
+		bool empty() const       { return offset.empty(); }
+		void clear();
+		void reserve(std::size_t n);
+	};
+
+	//------------------------------------------------------------------------------
+	// Name: decode_block(const uint8_t *buf, std::size_t size, typename M::address_t rva, decoded_block<M> &out)
+	// Desc: linearly decodes the whole buffer into out, which is cleared first,
+	//       but keeps its capacity so reusing it for each block does not
+	//       allocate. Returns the number of instructions decoded
+	//------------------------------------------------------------------------------
+	template <class M>
+	std::size_t decode_block(const uint8_t *buf, std::size_t size, typename M::address_t rva, decoded_block<M> &out);
+}
+
+#endif
@@ -0,0 +1,236 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EDISASSM_BLOCK_20121017_TCC_
+#define EDISASSM_BLOCK_20121017_TCC_
+
+#include "edisassm_block.h"
+#include "Instruction.h"
+#include "InstructionLength.h"
+#include "ModRM.h"
+
+namespace edisassm {
+namespace {
+
+//------------------------------------------------------------------------------
+// Name: flow_of(uint16_t type)
+//------------------------------------------------------------------------------
+template <class M>
+flow_type flow_of(uint16_t type) {
+	typedef Instruction<M> instruction_t;
+
+	switch(type) {
+	case instruction_t::OP_JMP:
+		return FLOW_JUMP;
+	case instruction_t::OP_JCC:
+	case instruction_t::OP_LOOP:
+	case instruction_t::OP_LOOPE:
+	case instruction_t::OP_LOOPNE:
+		return FLOW_CONDITIONAL;
+	case instruction_t::OP_CALL:
+		return FLOW_CALL;
+	case instruction_t::OP_RET:
+	case instruction_t::OP_RETF:
+	case instruction_t::OP_IRET:
+		return FLOW_RETURN;
+	case instruction_t::OP_INT:
+	case instruction_t::OP_INT3:
+	case instruction_t::OP_INTO:
+	case instruction_t::OP_SYSCALL:
+	case instruction_t::OP_SYSENTER:
+	case instruction_t::OP_SYSEXIT:
+	case instruction_t::OP_SYSRET:
+		return FLOW_INTERRUPT;
+	case instruction_t::OP_HLT:
+	case instruction_t::OP_UD2:
+		return FLOW_HALT;
+	default:
+		return FLOW_NONE;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: is_far_indirect(const uint8_t *opcode)
+// Desc: jmpf/callf through memory (0xff /5 and /3) decode to the same operand
+//       types as the near forms, so look at the opcode itself
+//------------------------------------------------------------------------------
+inline bool is_far_indirect(const uint8_t *opcode) {
+	if(opcode[0] != 0xff) {
+		return false;
+	}
+
+	const ModRM modrm(opcode[1]);
+	return modrm.reg() == 0x03 || modrm.reg() == 0x05;
+}
+
+//------------------------------------------------------------------------------
+// Name: direct_target(const uint8_t *buf, const InstructionLength<M> &insn, typename M::address_t rva, typename M::address_t &target)
+// Desc: the rel8 and rel32 branches, which are nearly all of them, read
+//       straight from the bytes. Returns false for anything else
+//------------------------------------------------------------------------------
+template <class M>
+bool direct_target(const uint8_t *buf, const InstructionLength<M> &insn, typename M::address_t rva, typename M::address_t &target) {
+
+	typedef typename M::address_t address_t;
+
+	const uint8_t *const opcode = buf + insn.opcode_offset();
+	const uint8_t *const end    = buf + insn.size();
+	const address_t next        = rva + insn.size();
+
+	std::ptrdiff_t rel_size;
+	if((opcode[0] >= 0x70 && opcode[0] <= 0x7f) || (opcode[0] >= 0xe0 && opcode[0] <= 0xe3) || opcode[0] == 0xeb) {
+		rel_size = sizeof(int8_t);
+	} else if(opcode[0] == 0xe8 || opcode[0] == 0xe9) {
+		rel_size = end - (opcode + 1);
+	} else if(opcode[0] == 0x0f && (opcode[1] & 0xf0) == 0x80) {
+		rel_size = end - (opcode + 2);
+	} else {
+		return false;
+	}
+
+	switch(rel_size) {
+	case sizeof(int8_t):
+		target = static_cast<address_t>(*reinterpret_cast<const int8_t *>(end - sizeof(int8_t)) + next);
+		return true;
+	case sizeof(int32_t):
+		target = static_cast<address_t>(*reinterpret_cast<const int32_t *>(end - sizeof(int32_t)) + next);
+		return true;
+	default:
+		// rel16 gets truncated, leave that to Operand
+		return false;
+	}
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: clear()
+//------------------------------------------------------------------------------
+template <class M>
+void decoded_block<M>::clear() {
+	offset.clear();
+	length.clear();
+	type.clear();
+	flow.clear();
+	target.clear();
+	flags.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: reserve(std::size_t n)
+//------------------------------------------------------------------------------
+template <class M>
+void decoded_block<M>::reserve(std::size_t n) {
+	offset.reserve(n);
+	length.reserve(n);
+	type.reserve(n);
+	flow.reserve(n);
+	target.reserve(n);
+	flags.reserve(n);
+}
+
+//------------------------------------------------------------------------------
+// Name: decode_block(const uint8_t *buf, std::size_t size, typename M::address_t rva, decoded_block<M> &out)
+// Desc: sizes and types come from InstructionLength, only the branches which
+//       direct_target can not handle get fully decoded (on the stack)
+//------------------------------------------------------------------------------
+template <class M>
+std::size_t decode_block(const uint8_t *buf, std::size_t size, typename M::address_t rva, decoded_block<M> &out) {
+
+	typedef typename M::address_t  address_t;
+	typedef Instruction<M>         instruction_t;
+	typedef Operand<M>             operand_t;
+
+	out.clear();
+
+	// compiled code averages a little under 4 bytes per instruction
+	out.reserve(size / 4 + 1);
+
+	std::size_t n = 0;
+	while(n < size) {
+		const InstructionLength<M> insn(buf + n, size - n);
+
+		uint8_t   length = 1;
+		uint16_t  type   = instruction_t::OP_INVALID;
+		uint8_t   flow   = FLOW_NONE;
+		address_t target = 0;
+		uint8_t   flags  = 0;
+
+		if(insn) {
+			length = insn.size();
+			type   = insn.type();
+			flow   = flow_of<M>(type);
+
+			switch(flow) {
+			case FLOW_JUMP:
+			case FLOW_CONDITIONAL:
+			case FLOW_CALL:
+				if(direct_target(buf + n, insn, rva + n, target)) {
+					flags |= BLOCK_RELATIVE;
+				} else {
+					const instruction_t full(buf + n, size - n, rva + n, std::nothrow);
+					const operand_t &operand = full.operand(0);
+
+					switch(operand.general_type()) {
+					case operand_t::TYPE_REL:
+						flags |= BLOCK_RELATIVE;
+						target = operand.relative_target();
+						break;
+					case operand_t::TYPE_ABSOLUTE:
+						flags |= BLOCK_FAR;
+						break;
+					case operand_t::TYPE_EXPRESSION:
+						flags |= BLOCK_INDIRECT;
+						if(is_far_indirect(buf + n + insn.opcode_offset())) {
+							flags |= BLOCK_FAR;
+						}
+						break;
+					default:
+						flags |= BLOCK_INDIRECT;
+						break;
+					}
+				}
+				break;
+			case FLOW_RETURN:
+				if(type != instruction_t::OP_RET) {
+					flags |= BLOCK_FAR;
+				}
+				break;
+			default:
+				break;
+			}
+		} else {
+			flags |= BLOCK_INVALID;
+		}
+
+		out.offset.push_back(n);
+		out.length.push_back(length);
+		out.type.push_back(type);
+		out.flow.push_back(flow);
+		out.target.push_back(target);
+		out.flags.push_back(flags);
+
+		n += length;
+	}
+
+	return out.size();
+}
+
+}
+
+#endif
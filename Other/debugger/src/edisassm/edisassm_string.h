@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef EDISASSM_STRING_20110422_H_
 #define EDISASSM_STRING_20110422_H_
 
+#include <cstddef>
 #include <string>
 
 template <class M>
@@ -29,6 +30,9 @@ class Operand;
 
 namespace edisassm {
 
+	// large enough for any instruction or byte string
+	static const std::size_t MAX_STRING_SIZE = 256;
+
 	struct lower_case {};
 	struct upper_case {};
 	struct syntax_intel_lcase : lower_case {};
@@ -51,6 +55,22 @@ namespace edisassm {
 	std::string to_string(const Operand<M> &operand, const T &);
 	
 	
+	//------------------------------------------------------------------------------
+	// Name: to_string(const Instruction<M> &insn, const T &, char *buf, std::size_t size)
+	// Desc: writes a string which represents the given instruction into buf
+	//       without allocating, cutting it short if it does not fit. buf is
+	//       always NUL terminated, returns the length of the string
+	//------------------------------------------------------------------------------
+	template<class M, class T>
+	std::size_t to_string(const Instruction<M> &insn, const T &, char *buf, std::size_t size);
+
+	//------------------------------------------------------------------------------
+	// Name: to_string(const Operand<M> &operand, const T &, char *buf, std::size_t size)
+	// Desc: writes a string which represents the given operand into buf, as above
+	//------------------------------------------------------------------------------
+	template<class M, class T>
+	std::size_t to_string(const Operand<M> &operand, const T &, char *buf, std::size_t size);
+
 	//------------------------------------------------------------------------------
 	// Name: to_string(const Instruction<M> &insn)
 	// Desc: creates a std::string which represents the given instruction in lowercase
@@ -76,6 +96,13 @@ namespace edisassm {
 	template <class M, class T>
 	std::string to_byte_string(const Instruction<M> &insn, const T&);
 	
+	//------------------------------------------------------------------------------
+	// Name: to_byte_string(const Instruction<M> &insn, const T&, char *buf, std::size_t size)
+	// Desc: writes the bytes of the given instruction into buf, as above
+	//------------------------------------------------------------------------------
+	template <class M, class T>
+	std::size_t to_byte_string(const Instruction<M> &insn, const T&, char *buf, std::size_t size);
+
 	//------------------------------------------------------------------------------
 	// Name: to_byte_string(const Instruction<M> &insn)
 	// Desc: creates a std::string which represents the given instruction
@@ -20,99 +20,214 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EDISASSM_STRING_20110816_TCC_
 
 #include <cassert>
-#include <iomanip>
 #include <limits>
-#include <sstream>
 #include "edisassm_util.h"
 
 namespace edisassm {
 namespace {
 
+const char hex_digits[] = "0123456789abcdef";
+
 //------------------------------------------------------------------------------
-// Name: 
+// Name: string_writer
+// Desc: appends to a caller supplied buffer, anything that does not fit is
+//       dropped. Letters are upper cased for the upper case syntaxes, only
+//       the "x" of a hex prefix is written as is
 //------------------------------------------------------------------------------
-template <class M, class T>
-std::string hex_string(T value, const upper_case&) {
-	if(value == 0) {
-		return "0";
+class string_writer {
+public:
+	string_writer(char *buf, std::size_t size, const lower_case&) : buf_(buf), size_(size), length_(0), upper_(false) {
 	}
 
-	std::ostringstream ss;
-	ss << "0x";
-	ss << std::uppercase << std::hex << std::setw(sizeof(T) * 2) << std::setfill('0') << static_cast<typename M::address_t>(value);
-	return ss.str();
-}
+	string_writer(char *buf, std::size_t size, const upper_case&) : buf_(buf), size_(size), length_(0), upper_(true) {
+	}
 
-//------------------------------------------------------------------------------
-// Name: 
-//------------------------------------------------------------------------------
-template <class M, class T>
-std::string hex_string(T value, const lower_case&) {
-	if(value == 0) {
-		return "0";
+public:
+	void put(char ch) {
+		if(upper_ && ch >= 'a' && ch <= 'z') {
+			ch = ch - 'a' + 'A';
+		}
+		put_raw(ch);
 	}
 
-	std::ostringstream ss;
-	ss << "0x";
-	ss << std::hex << std::setw(sizeof(T) * 2) << std::setfill('0') << static_cast<typename M::address_t>(value);
-	return ss.str();
-}
+	void put(const char *s) {
+		while(*s) {
+			put(*s++);
+		}
+	}
 
-//------------------------------------------------------------------------------
-// Name: 
-//------------------------------------------------------------------------------
-template <class M>
-std::string format_absolute(const Operand<M> &operand, const upper_case &format) {
-	std::ostringstream ss;
+	void put_byte(uint8_t value) {
+		put(hex_digits[value >> 4]);
+		put(hex_digits[value & 0x0f]);
+	}
 
-	ss << "FAR "
-	   << hex_string<M>(operand.absolute().seg, format)
-	   << ':'
-	   << hex_string<M>(operand.absolute().offset, format);
+	void put_hex(uint64_t value, std::size_t min_digits) {
+		char digits[16];
+		std::size_t n = 0;
+		do {
+			digits[n++] = hex_digits[value & 0x0f];
+			value >>= 4;
+		} while(value != 0);
 
-	return ss.str();
-}
+		put_raw('0');
+		put_raw('x');
+
+		for(; min_digits > n; --min_digits) {
+			put_raw('0');
+		}
+
+		while(n != 0) {
+			put(digits[--n]);
+		}
+	}
+
+	void put_decimal(int64_t value, bool show_sign) {
+		uint64_t magnitude = static_cast<uint64_t>(value);
+		if(value < 0) {
+			magnitude = 0 - magnitude;
+			put_raw('-');
+		} else if(show_sign) {
+			put_raw('+');
+		}
+
+		char digits[20];
+		std::size_t n = 0;
+		do {
+			digits[n++] = static_cast<char>('0' + magnitude % 10);
+			magnitude /= 10;
+		} while(magnitude != 0);
+
+		while(n != 0) {
+			put_raw(digits[--n]);
+		}
+	}
+
+	// NUL terminates the buffer and returns the length of the string
+	std::size_t finish() {
+		if(size_ != 0) {
+			buf_[length_] = '\0';
+		}
+		return length_;
+	}
+
+private:
+	void put_raw(char ch) {
+		if(length_ + 1 < size_) {
+			buf_[length_++] = ch;
+		}
+	}
+
+private:
+	char *const       buf_;
+	const std::size_t size_;
+	std::size_t       length_;
+	const bool        upper_;
+};
 
 //------------------------------------------------------------------------------
-// Name: 
+// Name: register_string(unsigned int reg)
 //------------------------------------------------------------------------------
-template <class M>
-std::string format_absolute(const Operand<M> &operand, const lower_case &format) {
-	std::ostringstream ss;
+inline const char *register_string(unsigned int reg) {
 
-	ss << "far "
-	   << hex_string<M>(operand.absolute().seg, format)
-	   << ':'
-	   << hex_string<M>(operand.absolute().offset, format);
+	static const char *names[] = {
+		"",
 
-	return ss.str();
-}
+		"rax",	"rcx",	"rdx",	"rbx",
+		"rsp",	"rbp",	"rsi",	"rdi",
+		"r8",	"r9",	"r10",	"r11",
+		"r12",	"r13",	"r14",	"r15",
+
+		"eax",	"ecx",	"edx",	"ebx",
+		"esp",	"ebp",	"esi",	"edi",
+		"r8d",	"r9d",	"r10d",	"r11d",
+		"r12d",	"r13d",	"r14d",	"r15d",
+
+		"ax",	"cx",	"dx",	"bx",
+		"sp",	"bp",	"si",	"di",
+		"r8w",	"r9w",	"r10w",	"r11w",
+		"r12w",	"r13w",	"r14w",	"r15w",
+
+		"al",	"cl",	"dl",	"bl",
+		"ah",	"ch",	"dh",	"bh",
+		"r8b",	"r9b",	"r10b",	"r11b",
+		"r12b",	"r13b",	"r14b",	"r15b",
+		"spl",	"bpl",	"sil",	"dil",
+
+		"es",	"cs",	"ss",	"ds",
+		"fs",	"gs",	"seg7",	"seg8",
+
+		"cr0",	"cr1",	"cr2",	"cr3",
+		"cr4",	"cr5",	"cr6",	"cr7",
+		"cr8",	"cr9",	"cr10",	"cr11",
+		"cr12",	"cr13",	"cr14",	"cr15",
+
+		"dr0",	"dr1",	"dr2",	"dr3",
+		"dr4",	"dr5",	"dr6",	"dr7",
+		"dr8",	"dr9",	"dr10",	"dr11",
+		"dr12",	"dr13",	"dr14",	"dr15",
+
+		"tr0",	"tr1",	"tr2",	"tr3",
+		"tr4",	"tr5",	"tr6",	"tr7",
+
+		"mm0",	"mm1",	"mm2",	"mm3",
+		"mm4",	"mm5",	"mm6",	"mm7",
+
+		"xmm0",	"xmm1",	"xmm2",	"xmm3",
+		"xmm4",	"xmm5",	"xmm6",	"xmm7",
+		"xmm8",	"xmm9",	"xmm10","xmm11",
+		"xmm12","xmm13","xmm14","xmm15",
+
+		"st",
+		"st(0)", "st(1)", "st(2)", "st(3)",
+		"st(4)", "st(5)", "st(6)", "st(7)",
+
+		"rip",
+		"eip",
+
+		"(invalid)"
+	};
 
+	assert(reg < sizeof(names) / sizeof(names[0]));
+	return names[reg];
+}
 
 //------------------------------------------------------------------------------
-// Name: 
+// Name: format_hex(string_writer &out, T value)
+// Desc: zero is just "0", anything else is padded to the width of T
 //------------------------------------------------------------------------------
 template <class M, class T>
-std::string format_register(const Operand<M> &operand, const T &format) {
-	return register_name<M>(operand.reg(), format);
+void format_hex(string_writer &out, T value) {
+	if(value == 0) {
+		out.put('0');
+	} else {
+		out.put_hex(static_cast<typename M::address_t>(value), sizeof(T) * 2);
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: 
-// Desc: 
+// Name: format_absolute(string_writer &out, const Operand<M> &operand)
 //------------------------------------------------------------------------------
-template <class M, class T>
-std::string format_relative(const Operand<M> &operand, const T &format) {
-	return hex_string<M>(static_cast<typename M::address_t>(operand.relative_target()), format);
+template <class M>
+void format_absolute(string_writer &out, const Operand<M> &operand) {
+	out.put("far ");
+	format_hex<M>(out, operand.absolute().seg);
+	out.put(':');
+	format_hex<M>(out, operand.absolute().offset);
 }
 
+//------------------------------------------------------------------------------
+// Name: format_relative(string_writer &out, const Operand<M> &operand)
+//------------------------------------------------------------------------------
+template <class M>
+void format_relative(string_writer &out, const Operand<M> &operand) {
+	format_hex<M>(out, static_cast<typename M::address_t>(operand.relative_target()));
+}
 
 //------------------------------------------------------------------------------
-// Name: 
+// Name: format_immediate(string_writer &out, const Operand<M> &operand)
 //------------------------------------------------------------------------------
-template <class M, class T>
-std::string format_immediate(const Operand<M> &operand, const T &format) {
-	std::ostringstream ss;
+template <class M>
+void format_immediate(string_writer &out, const Operand<M> &operand) {
 
 	switch(operand.complete_type()) {
 	case Operand<M>::TYPE_IMMEDIATE64:
@@ -120,9 +235,9 @@ std::string format_immediate(const Operand<M> &operand, const T &format) {
 			// this will lead to a fall through, we can print smaller
 		} else {
 			if(util::is_small_num(operand.sqword())) {
-				ss << operand.sqword();
+				out.put_decimal(operand.sqword(), false);
 			} else {
-				ss << hex_string<M>(operand.sqword(), format);
+				format_hex<M>(out, operand.sqword());
 			}
 			break;
 		}
@@ -132,9 +247,9 @@ std::string format_immediate(const Operand<M> &operand, const T &format) {
 			// this will lead to a fall through, we can print smaller
 		} else {
 			if(util::is_small_num(operand.sdword())) {
-				ss << operand.sdword();
+				out.put_decimal(operand.sdword(), false);
 			} else {
-				ss << hex_string<M>(operand.sdword(), format);
+				format_hex<M>(out, operand.sdword());
 			}
 			break;
 		}
@@ -144,235 +259,61 @@ std::string format_immediate(const Operand<M> &operand, const T &format) {
 			// this will lead to a fall through, we can print smaller
 		} else {
 			if(util::is_small_num(operand.sword())) {
-				ss << operand.sword();
+				out.put_decimal(operand.sword(), false);
 			} else {
-				ss << hex_string<M>(operand.sword(), format);
+				format_hex<M>(out, operand.sword());
 			}
 			break;
 		}
 		// FALL THROUGH
 	case Operand<M>::TYPE_IMMEDIATE8:
 		if(operand.sbyte() & 0x80) {
-			ss << hex_string<M>(operand.byte(), format);
+			format_hex<M>(out, operand.byte());
 		} else {
-			ss << static_cast<int>(operand.sbyte());
+			out.put_decimal(operand.sbyte(), false);
 		}
 		break;
 	default:
 		break;
 	}
-
-	return ss.str();
 }
 
 //------------------------------------------------------------------------------
-// Name: format_prefix(const Instruction<M> &insn, const lower_case &)
+// Name: format_prefix(string_writer &out, const Instruction<M> &insn)
 //------------------------------------------------------------------------------
 template <class M>
-std::string format_prefix(const Instruction<M> &insn, const lower_case &) {
-	std::string ret;
+void format_prefix(string_writer &out, const Instruction<M> &insn) {
 
 	if((insn.prefix() & Instruction<M>::PREFIX_LOCK) && !(insn.mandatory_prefix() & Instruction<M>::PREFIX_LOCK)) {
-		
-		// TODO: this is only legal for the memory dest versions of:
-		// ADD, ADC, AND, BTC, BTR, BTS, CMPXCHG, CMPXCH8B, (CMPXCH16B?)
-		// DEC, INC, NEG, NOT, OR, SBB, SUB, XOR, XADD, XCHG
-		
-		ret = "lock ";
 
-	} else if((insn.prefix() & Instruction<M>::PREFIX_REP) && !(insn.mandatory_prefix() & Instruction<M>::PREFIX_REP)) {
-		if(insn.type() == Instruction<M>::OP_CMPS || insn.type() == Instruction<M>::OP_SCAS) {
-			ret = "repe ";
-		} else {
-			
-			// TODO: this is only legal for:
-			// INS, OUTS, MOVS, LODS and STOS
-			
-			ret = "rep ";
-		}
-	} else if((insn.prefix() & Instruction<M>::PREFIX_REPNE) && !(insn.mandatory_prefix() & Instruction<M>::PREFIX_REPNE)) {
-		// TODO: this is only legal for:
-		// CMPS and SCAS
-		ret = "repne ";
-	}
-
-	return ret;
-}
-
-//------------------------------------------------------------------------------
-// Name: format_prefix(const Instruction<M> &insn, const upper_case &)
-//------------------------------------------------------------------------------
-template <class M>
-std::string format_prefix(const Instruction<M> &insn, const upper_case &) {
-	std::string ret;
-
-	if((insn.prefix() & Instruction<M>::PREFIX_LOCK) && !(insn.mandatory_prefix() & Instruction<M>::PREFIX_LOCK)) {
-		
 		// TODO: this is only legal for the memory dest versions of:
 		// ADD, ADC, AND, BTC, BTR, BTS, CMPXCHG, CMPXCH8B, (CMPXCH16B?)
 		// DEC, INC, NEG, NOT, OR, SBB, SUB, XOR, XADD, XCHG
-		
-		ret = "LOCK ";
+
+		out.put("lock ");
 
 	} else if((insn.prefix() & Instruction<M>::PREFIX_REP) && !(insn.mandatory_prefix() & Instruction<M>::PREFIX_REP)) {
 		if(insn.type() == Instruction<M>::OP_CMPS || insn.type() == Instruction<M>::OP_SCAS) {
-			ret = "REPE ";
+			out.put("repe ");
 		} else {
-			
+
 			// TODO: this is only legal for:
 			// INS, OUTS, MOVS, LODS and STOS
-			
-			ret = "REP ";
+
+			out.put("rep ");
 		}
 	} else if((insn.prefix() & Instruction<M>::PREFIX_REPNE) && !(insn.mandatory_prefix() & Instruction<M>::PREFIX_REPNE)) {
 		// TODO: this is only legal for:
 		// CMPS and SCAS
-		ret = "REPNE ";
+		out.put("repne ");
 	}
-
-	return ret;
 }
 
 //------------------------------------------------------------------------------
-// Name: 
+// Name: format_expression(string_writer &out, const Operand<M> &operand)
 //------------------------------------------------------------------------------
 template <class M>
-std::string format_expression(const Operand<M> &operand, const upper_case &format) {
-
-	typedef Instruction<M> instruction_t;
-
-	static const char *expression_strings[] = {
-		"",
-		"BYTE PTR ",
-		"WORD PTR ",
-		"DWORD PTR ",
-		"FWORD PTR ",
-		"QWORD PTR ",
-		"TBYTE PTR ",
-		"XMMWORD PTR ",
-	};
-
-	std::ostringstream ss;
-	ss << expression_strings[operand.complete_type() - Operand<M>::TYPE_EXPRESSION];
-
-	const uint32_t prefix = operand.owner()->prefix();
-
-	if(prefix & instruction_t::PREFIX_CS)      ss << "CS:";
-	else if(prefix & instruction_t::PREFIX_SS) ss << "SS:";
-	else if(prefix & instruction_t::PREFIX_DS) ss << "DS:";
-	else if(prefix & instruction_t::PREFIX_ES) ss << "ES:";
-	else if(prefix & instruction_t::PREFIX_FS) ss << "FS:";
-	else if(prefix & instruction_t::PREFIX_GS) ss << "GS:";
-	
-	bool only_disp = true;
-
-	ss << '[';
-
-	// the base, if any
-	if(operand.expression().base != Operand<M>::REG_NULL) {
-		ss << register_name<M>(operand.expression().base, format);
-		only_disp = false;
-	}
-
-	// the index, if any
-	if(operand.expression().index != Operand<M>::REG_NULL) {
-		if(!only_disp) {
-			ss << '+';
-		}
-		ss << register_name<M>(operand.expression().index, format);
-		only_disp = false;
-
-		// the scale, if any
-		if(operand.expression().scale != 1) {
-			ss << '*' << static_cast<int>(operand.expression().scale);
-		}
-	}
-
-	// the displacement, if any
-	switch(operand.expression().displacement_type) {
-	case Operand<M>::DISP_U32:
-		if(operand.expression().u_disp32 <= std::numeric_limits<uint16_t>::max()) {
-			// this will lead to a fall through, we can print smaller
-		} else {
-			if(!only_disp) {
-				ss << '+';
-			}
-			ss << hex_string<M>(operand.expression().u_disp32, format);
-			break;
-		}
-		// FALL THROUGH
-	case Operand<M>::DISP_U16:
-		if(operand.expression().u_disp16 <= std::numeric_limits<uint8_t>::max()) {
-			// this will lead to a fall through, we can print smaller
-		} else {
-			if(!only_disp) {
-				ss << '+';
-			}
-			ss << hex_string<M>(operand.expression().u_disp16, format);
-			break;
-		}
-		// FALL THROUGH
-	case Operand<M>::DISP_U8:
-		if(operand.expression().u_disp8 != 0 || only_disp) {
-			if(!only_disp) {
-				ss << '+';
-			}
-			ss << hex_string<M>(operand.expression().u_disp8, format);
-		}
-		break;
-
-	case Operand<M>::DISP_S32:
-		if(operand.expression().s_disp32 <= std::numeric_limits<int16_t>::max() && operand.expression().s_disp32 >= std::numeric_limits<int16_t>::min()) {
-			// this will lead to a fall through, we can print smaller
-		} else {
-			if(only_disp) {
-				// we only have a displacement, so we wanna display in hex since it is likely an address
-				ss << hex_string<M>(operand.expression().s_disp32, format);
-			} else {
-				ss << '+';
-				ss << hex_string<M>(operand.expression().s_disp32, format);
-			}
-			break;
-		}
-		// FALL THROUGH
-	case Operand<M>::DISP_S16:
-		if(operand.expression().s_disp16 <= std::numeric_limits<int8_t>::max() && operand.expression().s_disp16 >= std::numeric_limits<int8_t>::min()) {
-			// this will lead to a fall through, we can print smaller
-		} else {
-			if(only_disp) {
-				// we only have a displacement, so we wanna display in hex since it is likely an address
-				ss << hex_string<M>(operand.expression().s_disp16, format);
-			} else {
-				ss << std::showpos << static_cast<int32_t>(operand.expression().s_disp16);
-			}
-			break;
-		}
-		// FALL THROUGH
-	case Operand<M>::DISP_S8:
-		if(operand.expression().s_disp8 != 0 || only_disp) {
-			if(only_disp) {
-				// we only have a displacement, so we wanna display in hex since it is likely an address
-				ss << hex_string<M>(operand.expression().s_disp8, format);
-			} else {
-				ss << std::showpos << static_cast<int32_t>(operand.expression().s_disp8);
-			}
-		}
-		break;
-
-	default:
-		break;
-	}
-	ss << ']';
-
-	return ss.str();
-}
-
-
-//------------------------------------------------------------------------------
-// Name: 
-//------------------------------------------------------------------------------
-template <class M>
-std::string format_expression(const Operand<M> &operand, const lower_case &format) {
+void format_expression(string_writer &out, const Operand<M> &operand) {
 
 	typedef Instruction<M> instruction_t;
 
@@ -387,39 +328,39 @@ std::string format_expression(const Operand<M> &operand, const lower_case &forma
 		"xmmword ptr ",
 	};
 
-	std::ostringstream ss;
-	ss << expression_strings[operand.complete_type() - Operand<M>::TYPE_EXPRESSION];
+	out.put(expression_strings[operand.complete_type() - Operand<M>::TYPE_EXPRESSION]);
 
 	const uint32_t prefix = operand.owner()->prefix();
 
-	if(prefix & instruction_t::PREFIX_CS)      ss << "cs:";
-	else if(prefix & instruction_t::PREFIX_SS) ss << "ss:";
-	else if(prefix & instruction_t::PREFIX_DS) ss << "ds:";
-	else if(prefix & instruction_t::PREFIX_ES) ss << "es:";
-	else if(prefix & instruction_t::PREFIX_FS) ss << "fs:";
-	else if(prefix & instruction_t::PREFIX_GS) ss << "gs:";
-	
+	if(prefix & instruction_t::PREFIX_CS)      out.put("cs:");
+	else if(prefix & instruction_t::PREFIX_SS) out.put("ss:");
+	else if(prefix & instruction_t::PREFIX_DS) out.put("ds:");
+	else if(prefix & instruction_t::PREFIX_ES) out.put("es:");
+	else if(prefix & instruction_t::PREFIX_FS) out.put("fs:");
+	else if(prefix & instruction_t::PREFIX_GS) out.put("gs:");
+
 	bool only_disp = true;
 
-	ss << '[';
+	out.put('[');
 
 	// the base, if any
 	if(operand.expression().base != Operand<M>::REG_NULL) {
-		ss << register_name<M>(operand.expression().base, format);
+		out.put(register_string(operand.expression().base));
 		only_disp = false;
 	}
 
 	// the index, if any
 	if(operand.expression().index != Operand<M>::REG_NULL) {
 		if(!only_disp) {
-			ss << '+';
+			out.put('+');
 		}
-		ss << register_name<M>(operand.expression().index, format);
+		out.put(register_string(operand.expression().index));
 		only_disp = false;
 
 		// the scale, if any
 		if(operand.expression().scale != 1) {
-			ss << '*' << static_cast<int>(operand.expression().scale);
+			out.put('*');
+			out.put_decimal(operand.expression().scale, false);
 		}
 	}
 
@@ -430,9 +371,9 @@ std::string format_expression(const Operand<M> &operand, const lower_case &forma
 			// this will lead to a fall through, we can print smaller
 		} else {
 			if(!only_disp) {
-				ss << '+';
+				out.put('+');
 			}
-			ss << hex_string<M>(operand.expression().u_disp32, format);
+			format_hex<M>(out, operand.expression().u_disp32);
 			break;
 		}
 		// FALL THROUGH
@@ -441,18 +382,18 @@ std::string format_expression(const Operand<M> &operand, const lower_case &forma
 			// this will lead to a fall through, we can print smaller
 		} else {
 			if(!only_disp) {
-				ss << '+';
+				out.put('+');
 			}
-			ss << hex_string<M>(operand.expression().u_disp16, format);
+			format_hex<M>(out, operand.expression().u_disp16);
 			break;
 		}
 		// FALL THROUGH
 	case Operand<M>::DISP_U8:
 		if(operand.expression().u_disp8 != 0 || only_disp) {
 			if(!only_disp) {
-				ss << '+';
+				out.put('+');
 			}
-			ss << hex_string<M>(operand.expression().u_disp8, format);
+			format_hex<M>(out, operand.expression().u_disp8);
 		}
 		break;
 
@@ -462,10 +403,10 @@ std::string format_expression(const Operand<M> &operand, const lower_case &forma
 		} else {
 			if(only_disp) {
 				// we only have a displacement, so we wanna display in hex since it is likely an address
-				ss << hex_string<M>(operand.expression().s_disp32, format);
+				format_hex<M>(out, operand.expression().s_disp32);
 			} else {
-				ss << '+';
-				ss << hex_string<M>(operand.expression().s_disp32, format);
+				out.put('+');
+				format_hex<M>(out, operand.expression().s_disp32);
 			}
 			break;
 		}
@@ -476,9 +417,9 @@ std::string format_expression(const Operand<M> &operand, const lower_case &forma
 		} else {
 			if(only_disp) {
 				// we only have a displacement, so we wanna display in hex since it is likely an address
-				ss << hex_string<M>(operand.expression().s_disp16, format);
+				format_hex<M>(out, operand.expression().s_disp16);
 			} else {
-				ss << std::showpos << static_cast<int32_t>(operand.expression().s_disp16);
+				out.put_decimal(operand.expression().s_disp16, true);
 			}
 			break;
 		}
@@ -487,9 +428,9 @@ std::string format_expression(const Operand<M> &operand, const lower_case &forma
 		if(operand.expression().s_disp8 != 0 || only_disp) {
 			if(only_disp) {
 				// we only have a displacement, so we wanna display in hex since it is likely an address
-				ss << hex_string<M>(operand.expression().s_disp8, format);
+				format_hex<M>(out, operand.expression().s_disp8);
 			} else {
-				ss << std::showpos << static_cast<int32_t>(operand.expression().s_disp8);
+				out.put_decimal(operand.expression().s_disp8, true);
 			}
 		}
 		break;
@@ -497,9 +438,26 @@ std::string format_expression(const Operand<M> &operand, const lower_case &forma
 	default:
 		break;
 	}
-	ss << ']';
+	out.put(']');
+}
+
+//------------------------------------------------------------------------------
+// Name: format_operand(string_writer &out, const Operand<M> &operand)
+//------------------------------------------------------------------------------
+template <class M>
+void format_operand(string_writer &out, const Operand<M> &operand) {
 
-	return ss.str();
+	switch(operand.general_type()) {
+	case Operand<M>::TYPE_ABSOLUTE:   format_absolute(out, operand);                break;
+	case Operand<M>::TYPE_EXPRESSION: format_expression(out, operand);              break;
+	case Operand<M>::TYPE_IMMEDIATE:  format_immediate(out, operand);               break;
+	case Operand<M>::TYPE_REGISTER:   out.put(register_string(operand.reg()));      break;
+	case Operand<M>::TYPE_REL:        format_relative(out, operand);                break;
+	default:
+		out.put(register_string(Operand<M>::REG_INVALID));
+		// is it better to throw, or return a string?
+		//throw invalid_operand(owner_->size());
+	}
 }
 
 }
@@ -510,67 +468,7 @@ std::string format_expression(const Operand<M> &operand, const lower_case &forma
 //------------------------------------------------------------------------------
 template <class M>
 std::string register_name(typename Operand<M>::Register reg, const lower_case&) {
-
-	static const char *names[] = {
-		"",
-
-		"rax",	"rcx",	"rdx",	"rbx",
-		"rsp",	"rbp",	"rsi",	"rdi",
-		"r8",	"r9",	"r10",	"r11",
-		"r12",	"r13",	"r14",	"r15",
-
-		"eax",	"ecx",	"edx",	"ebx",
-		"esp",	"ebp",	"esi",	"edi",
-		"r8d",	"r9d",	"r10d",	"r11d",
-		"r12d",	"r13d",	"r14d",	"r15d",
-
-		"ax",	"cx",	"dx",	"bx",
-		"sp",	"bp",	"si",	"di",
-		"r8w",	"r9w",	"r10w",	"r11w",
-		"r12w",	"r13w",	"r14w",	"r15w",
-
-		"al",	"cl",	"dl",	"bl",
-		"ah",	"ch",	"dh",	"bh",
-		"r8b",	"r9b",	"r10b",	"r11b",
-		"r12b",	"r13b",	"r14b",	"r15b",
-		"spl",	"bpl",	"sil",	"dil",
-
-		"es",	"cs",	"ss",	"ds",
-		"fs",	"gs",	"seg7",	"seg8",
-
-		"cr0",	"cr1",	"cr2",	"cr3",
-		"cr4",	"cr5",	"cr6",	"cr7",
-		"cr8",	"cr9",	"cr10",	"cr11",
-		"cr12",	"cr13",	"cr14",	"cr15",
-
-		"dr0",	"dr1",	"dr2",	"dr3",
-		"dr4",	"dr5",	"dr6",	"dr7",
-		"dr8",	"dr9",	"dr10",	"dr11",
-		"dr12",	"dr13",	"dr14",	"dr15",
-
-		"tr0",	"tr1",	"tr2",	"tr3",
-		"tr4",	"tr5",	"tr6",	"tr7",
-
-		"mm0",	"mm1",	"mm2",	"mm3",
-		"mm4",	"mm5",	"mm6",	"mm7",
-
-		"xmm0",	"xmm1",	"xmm2",	"xmm3",
-		"xmm4",	"xmm5",	"xmm6",	"xmm7",
-		"xmm8",	"xmm9",	"xmm10","xmm11",
-		"xmm12","xmm13","xmm14","xmm15",
-
-		"st",
-		"st(0)", "st(1)", "st(2)", "st(3)",
-		"st(4)", "st(5)", "st(6)", "st(7)",
-
-		"rip",
-		"eip",
-
-		"(invalid)"
-	};
-
-	assert(reg < sizeof(names) / sizeof(names[0]));
-	return names[reg];
+	return register_string(reg);
 }
 
 //------------------------------------------------------------------------------
@@ -579,174 +477,98 @@ std::string register_name(typename Operand<M>::Register reg, const lower_case&)
 //------------------------------------------------------------------------------
 template <class M>
 std::string register_name(typename Operand<M>::Register reg, const upper_case&) {
-
-	static const char *names[] = {
-		"",
-
-		"RAX",	"RCX",	"RDX",	"RBX",
-		"RSP",	"RBP",	"RSI",	"RDI",
-		"R8",	"R9",	"R10",	"R11",
-		"R12",	"R13",	"R14",	"R15",
-
-		"EAX",	"ECX",	"EDX",	"EBX",
-		"ESP",	"EBP",	"ESI",	"EDI",
-		"R8D",	"R9D",	"R10D",	"R11D",
-		"R12D",	"R13D",	"R14D",	"R15D",
-
-		"AX",	"CX",	"DX",	"BX",
-		"SP",	"BP",	"SI",	"DI",
-		"R8W",	"R9W",	"R10W",	"R11W",
-		"R12W",	"R13W",	"R14W",	"R15W",
-
-		"AL",	"CL",	"DL",	"BL",
-		"AH",	"CH",	"DH",	"BH",
-		"R8B",	"R9B",	"R10B",	"R11B",
-		"R12B",	"R13B",	"R14B",	"R15B",
-		"SPL",	"BPL",	"SIL",	"DIL",
-
-		"ES",	"CS",	"SS",	"DS",
-		"FS",	"GS",	"SEG7",	"SEG8",
-
-		"CR0",	"CR1",	"CR2",	"CR3",
-		"CR4",	"CR5",	"CR6",	"CR7",
-		"CR8",	"CR9",	"CR10",	"CR11",
-		"CR12",	"CR13",	"CR14",	"CR15",
-
-		"DR0",	"DR1",	"DR2",	"DR3",
-		"DR4",	"DR5",	"DR6",	"DR7",
-		"DR8",	"DR9",	"DR10",	"DR11",
-		"DR12",	"DR13",	"DR14",	"DR15",
-
-		"TR0",	"TR1",	"TR2",	"TR3",
-		"TR4",	"TR5",	"TR6",	"TR7",
-
-		"MM0",	"MM1",	"MM2",	"MM3",
-		"MM4",	"MM5",	"MM6",	"MM7",
-
-		"XMM0",	"XMM1",	"XMM2",	"XMM3",
-		"XMM4",	"XMM5",	"XMM6",	"XMM7",
-		"XMM8",	"XMM9",	"XMM10","XMM11",
-		"XMM12","XMM13","XMM14","XMM15",
-
-		"ST",
-		"ST(0)", "ST(1)", "ST(2)", "ST(3)",
-		"ST(4)", "ST(5)", "ST(6)", "ST(7)",
-
-		"RIP",
-		"EIP",
-
-		"(INVALID)"
-	};
-
-	assert(reg < sizeof(names) / sizeof(names[0]));
-	return names[reg];
+	return util::toupper_copy(register_string(reg));
 }
 
-
 //------------------------------------------------------------------------------
-// Name: 
-// Desc: 
+// Name: to_string(const Operand<M> &operand, const T &format, char *buf, std::size_t size)
+// Desc: writes a string which represents the given operand into buf
 //------------------------------------------------------------------------------
-template<class M, class T>
-std::string to_string(const Operand<M> &operand, const T &format) {
-	
-	switch(operand.general_type()) {
-	case Operand<M>::TYPE_ABSOLUTE:   return format_absolute(operand, format);
-	case Operand<M>::TYPE_EXPRESSION: return format_expression(operand, format);
-	case Operand<M>::TYPE_IMMEDIATE:  return format_immediate(operand, format);
-	case Operand<M>::TYPE_REGISTER:   return format_register(operand, format);
-	case Operand<M>::TYPE_REL:        return format_relative(operand, format);
-	default:
-		return register_name<M>(Operand<M>::REG_INVALID, format);
-		// is it better to throw, or return a string?
-		//throw invalid_operand(owner_->size());
-	}
+template <class M, class T>
+std::size_t to_string(const Operand<M> &operand, const T &format, char *buf, std::size_t size) {
+	string_writer out(buf, size, format);
+	format_operand(out, operand);
+	return out.finish();
 }
 
 //------------------------------------------------------------------------------
-// Name: to_string(const Instruction<M> &insn, const syntax_intel_lcase &syntax)
-// Desc: creates a std::string which represents the given instruction
+// Name: to_string(const Instruction<M> &insn, const T &format, char *buf, std::size_t size)
+// Desc: writes a string which represents the given instruction into buf
 //------------------------------------------------------------------------------
-template <class M>
-std::string to_string(const Instruction<M> &insn, const syntax_intel_lcase &syntax) {
+template <class M, class T>
+std::size_t to_string(const Instruction<M> &insn, const T &format, char *buf, std::size_t size) {
 
-	std::ostringstream ss;
+	string_writer out(buf, size, format);
 
-	ss << format_prefix(insn, syntax);
-	ss << insn.mnemonic();
+	format_prefix(out, insn);
+	out.put(insn.mnemonic());
 
 	const std::size_t count = insn.operand_count();
 	if(count != 0) {
-		ss << ' ' << to_string(insn.operand(0), syntax);
+		out.put(' ');
+		format_operand(out, insn.operand(0));
 		for(std::size_t i = 1; i < count; ++i) {
-			ss << ", " << to_string(insn.operand(i), syntax);
+			out.put(", ");
+			format_operand(out, insn.operand(i));
 		}
 	}
 
-	return ss.str();
+	return out.finish();
 }
 
 //------------------------------------------------------------------------------
-// Name: to_string(const Instruction<M> &insn, const syntax_intel_ucase &syntax)
-// Desc: creates a std::string which represents the given instruction
+// Name: to_byte_string(const Instruction<M> &insn, const T &format, char *buf, std::size_t size)
+// Desc: writes the bytes of the given instruction into buf, as hex
 //------------------------------------------------------------------------------
-template <class M>
-std::string to_string(const Instruction<M> &insn, const syntax_intel_ucase &syntax) {
-	
-	std::ostringstream ss;
+template <class M, class T>
+std::size_t to_byte_string(const Instruction<M> &insn, const T &format, char *buf, std::size_t size) {
 
-	ss << format_prefix(insn, syntax);
-	ss << util::toupper_copy(insn.mnemonic());
+	string_writer out(buf, size, format);
 
-	const std::size_t count = insn.operand_count();
-	if(count != 0) {
-		ss << ' ' << to_string(insn.operand(0), syntax);
-		for(std::size_t i = 1; i < count; ++i) {
-			ss << ", " << to_string(insn.operand(i), syntax);
+	const uint8_t *const ptr = insn.buffer();
+	const unsigned int insn_size = insn.size();
+	if(insn_size != 0) {
+		out.put_byte(ptr[0]);
+		for(unsigned int i = 1; i < insn_size; ++i) {
+			out.put(' ');
+			out.put_byte(ptr[i]);
 		}
 	}
 
-	return ss.str();
+	return out.finish();
 }
 
+//------------------------------------------------------------------------------
+// Name: to_string(const Operand<M> &operand, const T &format)
+// Desc: creates a std::string which represents the given operand
+//------------------------------------------------------------------------------
+template<class M, class T>
+std::string to_string(const Operand<M> &operand, const T &format) {
+	char buf[MAX_STRING_SIZE];
+	const std::size_t n = to_string(operand, format, buf, sizeof(buf));
+	return std::string(buf, n);
+}
 
 //------------------------------------------------------------------------------
-// Name: to_byte_string(const Instruction<M> &insn, const upper_case&)
+// Name: to_string(const Instruction<M> &insn, const T &format)
 // Desc: creates a std::string which represents the given instruction
 //------------------------------------------------------------------------------
-template <class M>
-std::string to_byte_string(const Instruction<M> &insn, const upper_case&) {
-
-	std::ostringstream ss;
-
-	const uint8_t *const ptr = insn.buffer();
-	const unsigned int size = insn.size();
-	if(size != 0) {
-		ss << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(ptr[0]);
-		for(unsigned int i = 1; i < size; ++i) {
-			ss << ' ' << std::uppercase << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(ptr[i]);
-		}
-	}
-	return ss.str();
-
-	
+template <class M, class T>
+std::string to_string(const Instruction<M> &insn, const T &format) {
+	char buf[MAX_STRING_SIZE];
+	const std::size_t n = to_string(insn, format, buf, sizeof(buf));
+	return std::string(buf, n);
 }
 
 //------------------------------------------------------------------------------
-// Name: to_byte_string(const Instruction<M> &insn, const lower_case&)
-// Desc: creates a std::string which represents the given instruction
+// Name: to_byte_string(const Instruction<M> &insn, const T &format)
+// Desc: creates a std::string which represents the bytes of the given instruction
 //------------------------------------------------------------------------------
-template <class M>
-std::string to_byte_string(const Instruction<M> &insn, const lower_case&) {
-	std::ostringstream ss;
-	
-	const uint8_t *const ptr = insn.buffer();
-	
-	ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(ptr[0]);
-	for(unsigned int i = 1; i < insn.size(); ++i) {
-		ss << ' ' << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(ptr[i]);
-	}
-	return ss.str();
+template <class M, class T>
+std::string to_byte_string(const Instruction<M> &insn, const T &format) {
+	char buf[MAX_STRING_SIZE];
+	const std::size_t n = to_byte_string(insn, format, buf, sizeof(buf));
+	return std::string(buf, n);
 }
 
 }
@@ -0,0 +1,495 @@
+/*
+Copyright (C) 2006 - 2011 Evan Teran
+                          eteran@alum.rit.edu
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Checks that InstructionLength agrees with Instruction on validity, size and
+// type for every opcode in every map, under every ModRM byte and a set of SIB
+// bytes, for every combination of the prefixes the decoders look at; some
+// they ignore and the REX variants get every register form and a sample of
+// the memory forms. Each buffer is also checked cut short at the
+// instruction's end. Random buffers cover the rest, and decode_block is
+// checked against decoding them one Instruction at a time. The buffer forms of
+// to_string and to_byte_string are checked against the std::string forms in
+// both cases, and with every buffer size which is too small.
+
+#include "Instruction.h"
+#include "InstructionLength.h"
+#include "edisassm_block.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+namespace {
+
+const uint8_t filler[] = {
+	0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88,
+	0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x01
+};
+
+//------------------------------------------------------------------------------
+// Name: upper_case_of(const std::string &s)
+// Desc: what the upper case syntax should make of a lower case string, the
+//       "x" of a hex prefix stays as it is
+//------------------------------------------------------------------------------
+std::string upper_case_of(const std::string &s) {
+	std::string r(s);
+	for(std::size_t i = 0; i < r.size(); ++i) {
+		if(r[i] >= 'a' && r[i] <= 'z' && !(r[i] == 'x' && i != 0 && r[i - 1] == '0')) {
+			r[i] = r[i] - 'a' + 'A';
+		}
+	}
+	return r;
+}
+
+//------------------------------------------------------------------------------
+// Name: buffer_matches(const std::string &expected, const char *buf, std::size_t buf_size, std::size_t size, std::size_t length)
+// Desc: buf was given to a formatter as size bytes and filled with '#' before
+//       that. It should hold as much of expected as fits, NUL terminated, and
+//       nothing past size should have been touched
+//------------------------------------------------------------------------------
+bool buffer_matches(const std::string &expected, const char *buf, std::size_t buf_size, std::size_t size, std::size_t length) {
+
+	for(std::size_t i = size; i < buf_size; ++i) {
+		if(buf[i] != '#') {
+			return false;
+		}
+	}
+
+	if(size == 0) {
+		return length == 0;
+	}
+
+	const std::size_t n = std::min(expected.size(), size - 1);
+	return length == n && expected.compare(0, n, buf, n) == 0 && buf[n] == '\0';
+}
+
+//------------------------------------------------------------------------------
+// Name: check_buffers(const std::string &expected, F format)
+// Desc: format(buf, size) writes the same thing as expected into a buffer,
+//       tries it with room to spare and with every size which is too small
+//------------------------------------------------------------------------------
+template <class F>
+bool check_buffers(const std::string &expected, F format) {
+
+	char buf[edisassm::MAX_STRING_SIZE + 1];
+
+	for(std::size_t size = 0; size <= expected.size() + 1; ++size) {
+		std::memset(buf, '#', sizeof(buf));
+		if(!buffer_matches(expected, buf, sizeof(buf), size, format(buf, size))) {
+			return false;
+		}
+	}
+
+	std::memset(buf, '#', sizeof(buf));
+	return buffer_matches(expected, buf, sizeof(buf), edisassm::MAX_STRING_SIZE, format(buf, edisassm::MAX_STRING_SIZE));
+}
+
+//------------------------------------------------------------------------------
+// Name: instruction_format
+//------------------------------------------------------------------------------
+template <class M, class T>
+struct instruction_format {
+	instruction_format(const Instruction<M> &insn) : insn_(insn) {
+	}
+
+	std::size_t operator()(char *buf, std::size_t size) const {
+		return edisassm::to_string(insn_, T(), buf, size);
+	}
+
+	const Instruction<M> &insn_;
+};
+
+//------------------------------------------------------------------------------
+// Name: operand_format
+//------------------------------------------------------------------------------
+template <class M, class T>
+struct operand_format {
+	operand_format(const Operand<M> &operand) : operand_(operand) {
+	}
+
+	std::size_t operator()(char *buf, std::size_t size) const {
+		return edisassm::to_string(operand_, T(), buf, size);
+	}
+
+	const Operand<M> &operand_;
+};
+
+//------------------------------------------------------------------------------
+// Name: byte_format
+//------------------------------------------------------------------------------
+template <class M, class T>
+struct byte_format {
+	byte_format(const Instruction<M> &insn) : insn_(insn) {
+	}
+
+	std::size_t operator()(char *buf, std::size_t size) const {
+		return edisassm::to_byte_string(insn_, T(), buf, size);
+	}
+
+	const Instruction<M> &insn_;
+};
+
+//------------------------------------------------------------------------------
+// Name: agreement_test
+//------------------------------------------------------------------------------
+template <class M>
+class agreement_test {
+public:
+	typedef Instruction<M>       instruction_t;
+	typedef InstructionLength<M> length_t;
+
+public:
+	agreement_test() : checked_(0), failures_(0) {
+	}
+
+public:
+	std::size_t checked() const  { return checked_; }
+	std::size_t failures() const { return failures_; }
+
+public:
+	//------------------------------------------------------------------------------
+	// Name: check(const uint8_t *buf, std::size_t size)
+	// Desc: returns the size of the instruction, or 0 if it is invalid
+	//------------------------------------------------------------------------------
+	std::size_t check(const uint8_t *buf, std::size_t size) {
+
+		const instruction_t insn(buf, size, 0, std::nothrow);
+		const length_t length(buf, size);
+
+		const std::size_t insn_size = insn.valid() ? insn.size() : 0;
+
+		++checked_;
+
+		if(insn.valid() == length.valid()) {
+			if(!insn.valid() || (insn.size() == length.size() && insn.type() == length.type())) {
+				return insn_size;
+			}
+		}
+
+		if(failures_++ < 25) {
+			std::cout << "mismatch (" << M::BITS << "-bit, " << std::dec << size << " bytes):" << std::hex;
+			for(std::size_t i = 0; i < size && i < 24; ++i) {
+				std::cout << ' ' << std::setw(2) << std::setfill('0') << static_cast<int>(buf[i]);
+			}
+
+			std::cout << std::dec << "\n\tInstruction:       valid=" << insn.valid() << " size=" << insn.size() << " type=" << insn.type()
+			          << "\n\tInstructionLength: valid=" << length.valid() << " size=" << length.size() << " type=" << length.type() << std::endl;
+		}
+
+		return insn_size;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: check_truncated(const uint8_t *buf, std::size_t size)
+	// Desc: checks the buffer, then the buffer ending at the instruction and
+	//       one byte short of it
+	//------------------------------------------------------------------------------
+	void check_truncated(const uint8_t *buf, std::size_t size) {
+		if(const std::size_t insn_size = check(buf, size)) {
+			check(buf, insn_size);
+			check(buf, insn_size - 1);
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: run_tables()
+	//------------------------------------------------------------------------------
+	void run_tables() {
+
+		// the first few cover each prefix state the decoders distinguish
+		static const uint8_t prefix_sets[][4] = {
+			{ 0 },
+			{ 1, 0x66 },
+			{ 1, 0xf2 },
+			{ 1, 0xf3 },
+			{ 2, 0x66, 0xf2 },
+			{ 2, 0xf3, 0x66 },
+			{ 1, 0x67 },
+			{ 1, 0xf0 },
+			{ 1, 0x2e },
+			{ 2, 0xf2, 0xf3 },
+			{ 2, 0xf3, 0xf0 },
+			{ 2, 0x66, 0x67 },
+			{ 3, 0x67, 0xf2, 0x66 }
+		};
+
+		// with a REX prefix, only those are repeated
+		static const std::size_t rex_prefix_sets = 7;
+		static const uint8_t rex_bytes[] = { 0x00, 0x41, 0x44, 0x48, 0x4f };
+
+		static const uint8_t map_escapes[][3] = {
+			{ 0 },
+			{ 1, 0x0f },
+			{ 2, 0x0f, 0x38 },
+			{ 2, 0x0f, 0x3a }
+		};
+
+		static const uint8_t sib_bytes[] = { 0x24, 0x25 };
+
+		const std::size_t rex_count = (M::BITS == 64) ? sizeof(rex_bytes) : 1;
+
+		uint8_t buf[32];
+
+		for(std::size_t p = 0; p < sizeof(prefix_sets) / sizeof(prefix_sets[0]); ++p) {
+			for(std::size_t x = 0; x < rex_count && (x == 0 || p < rex_prefix_sets); ++x) {
+				for(std::size_t m = 0; m < sizeof(map_escapes) / sizeof(map_escapes[0]); ++m) {
+					for(int opcode = 0; opcode < 0x100; ++opcode) {
+
+						std::size_t n = 0;
+						std::memcpy(&buf[n], &prefix_sets[p][1], prefix_sets[p][0]);
+						n += prefix_sets[p][0];
+
+						if(rex_bytes[x] != 0) {
+							buf[n++] = rex_bytes[x];
+						}
+
+						std::memcpy(&buf[n], &map_escapes[m][1], map_escapes[m][0]);
+						n += map_escapes[m][0];
+
+						buf[n++] = opcode;
+
+						// every ModRM byte for the prefix states, otherwise
+						// every register form and a sample of the memory forms
+						const bool all_forms = (p < rex_prefix_sets && x == 0);
+
+						for(int modrm = 0; modrm < 0x100; ++modrm) {
+							if(!all_forms && (modrm & 0xc0) != 0xc0 && (modrm & 0x38) != 0x00 && (modrm & 0x07) != 0x04 && (modrm & 0x07) != 0x05) {
+								continue;
+							}
+
+							buf[n] = modrm;
+							std::memcpy(&buf[n + 1], filler, sizeof(filler));
+							check_truncated(buf, n + 1 + sizeof(filler));
+
+							if((modrm & 0x07) == 0x04 && (modrm & 0xc0) != 0xc0) {
+								for(std::size_t s = 0; s < sizeof(sib_bytes); ++s) {
+									buf[n + 1] = sib_bytes[s];
+									check_truncated(buf, n + 1 + sizeof(filler));
+								}
+							}
+						}
+
+						// nothing but the opcode
+						check(buf, n);
+					}
+				}
+			}
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: run_special()
+	// Desc: the fwait forms which look past the opcode, and lone prefixes
+	//------------------------------------------------------------------------------
+	void run_special() {
+		static const uint8_t cases[][6] = {
+			{ 1, 0x9b },
+			{ 2, 0x9b, 0xdb },
+			{ 3, 0x9b, 0xdb, 0xe0 },
+			{ 3, 0x9b, 0xdb, 0xe1 },
+			{ 3, 0x9b, 0xdb, 0xe2 },
+			{ 3, 0x9b, 0xdb, 0xe3 },
+			{ 3, 0x9b, 0xdb, 0xe4 },
+			{ 4, 0x66, 0x9b, 0xdb, 0xe3 },
+			{ 4, 0x48, 0x9b, 0xdb, 0xe2 },
+			{ 1, 0x66 },
+			{ 2, 0xf3, 0x67 },
+			{ 1, 0x48 },
+			{ 2, 0x48, 0x48 },
+			{ 3, 0x66, 0x48, 0x66 }
+		};
+
+		for(std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+			for(std::size_t n = 0; n <= cases[i][0]; ++n) {
+				check(&cases[i][1], n);
+			}
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: run_random(std::size_t count)
+	//------------------------------------------------------------------------------
+	void run_random(std::size_t count) {
+
+		static const uint8_t prefixes[] = { 0x66, 0x67, 0xf0, 0xf2, 0xf3, 0x2e, 0x3e, 0x26, 0x64, 0x65, 0x36, 0x40, 0x48, 0x41, 0x0f };
+
+		std::srand(0x1234);
+
+		uint8_t buf[24];
+		for(std::size_t i = 0; i < count; ++i) {
+			for(std::size_t j = 0; j < sizeof(buf); ++j) {
+				buf[j] = static_cast<uint8_t>(std::rand() >> 4);
+			}
+
+			// favour prefix runs
+			const int prefix_count = std::rand() % 5;
+			for(int j = 0; j < prefix_count; ++j) {
+				buf[j] = prefixes[std::rand() % sizeof(prefixes)];
+			}
+
+			check_truncated(buf, sizeof(buf));
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: run_block(std::size_t count)
+	// Desc: random buffers heavy with branches, so both the fast and the slow
+	//       target paths get used
+	//------------------------------------------------------------------------------
+	void run_block(std::size_t count) {
+
+		static const uint8_t branches[] = { 0x74, 0xeb, 0xe2, 0xe3, 0xe8, 0xe9, 0xff, 0x0f, 0x66, 0x9a, 0xea, 0xc3, 0xcf };
+
+		typedef typename M::address_t address_t;
+		typedef Operand<M>            operand_t;
+
+		const address_t rva = static_cast<address_t>(0x7ffffff0);
+
+		std::srand(0x5678);
+
+		edisassm::decoded_block<M> block;
+		uint8_t buf[256];
+
+		for(std::size_t i = 0; i < count; ++i) {
+			for(std::size_t j = 0; j < sizeof(buf); ++j) {
+				const int r = std::rand();
+				buf[j] = (r & 0x300) ? static_cast<uint8_t>(r >> 4) : branches[(r >> 4) % sizeof(branches)];
+			}
+
+			edisassm::decode_block<M>(buf, sizeof(buf), rva, block);
+
+			std::size_t n = 0;
+			for(std::size_t k = 0; k < block.size(); ++k) {
+				const instruction_t insn(buf + n, sizeof(buf) - n, rva + n, std::nothrow);
+
+				++checked_;
+
+				bool ok = block.offset[k] == n;
+				if(insn) {
+					ok = ok && block.length[k] == insn.size() && block.type[k] == insn.type() && !(block.flags[k] & edisassm::BLOCK_INVALID);
+
+					if(insn.operand_count() != 0 && insn.operand(0).general_type() == operand_t::TYPE_REL) {
+						ok = ok && (block.flags[k] & edisassm::BLOCK_RELATIVE) && block.target[k] == insn.operand(0).relative_target();
+					} else {
+						ok = ok && !(block.flags[k] & edisassm::BLOCK_RELATIVE);
+					}
+				} else {
+					ok = ok && block.length[k] == 1 && (block.flags[k] & edisassm::BLOCK_INVALID);
+				}
+
+				if(!ok && failures_++ < 25) {
+					std::cout << "decode_block mismatch (" << M::BITS << "-bit) at offset " << n << std::endl;
+				}
+
+				n += insn ? insn.size() : 1;
+			}
+
+			if(n != sizeof(buf)) {
+				if(failures_++ < 25) {
+					std::cout << "decode_block stopped at " << n << " (" << M::BITS << "-bit)" << std::endl;
+				}
+			}
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: check_strings(const instruction_t &insn, const T &, bool &ok)
+	// Desc: the buffer forms of the formatters against the std::string forms,
+	//       ok is cleared on a mismatch, returns the instruction as a string
+	//------------------------------------------------------------------------------
+	template <class T>
+	std::string check_strings(const instruction_t &insn, const T &, bool &ok) {
+
+		const std::string text = edisassm::to_string(insn, T());
+		ok = ok && check_buffers(text, instruction_format<M, T>(insn));
+
+		for(std::size_t i = 0; i < insn.operand_count(); ++i) {
+			ok = ok && check_buffers(edisassm::to_string(insn.operand(i), T()), operand_format<M, T>(insn.operand(i)));
+		}
+
+		ok = ok && check_buffers(edisassm::to_byte_string(insn, T()), byte_format<M, T>(insn));
+		return text;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: run_strings(std::size_t count)
+	// Desc: formats random instructions in both cases
+	//------------------------------------------------------------------------------
+	void run_strings(std::size_t count) {
+
+		std::srand(0x9abc);
+
+		uint8_t buf[24];
+		for(std::size_t i = 0; i < count; ++i) {
+			for(std::size_t j = 0; j < sizeof(buf); ++j) {
+				buf[j] = static_cast<uint8_t>(std::rand() >> 4);
+			}
+
+			const instruction_t insn(buf, sizeof(buf), 0x7ffffff0, std::nothrow);
+			if(!insn) {
+				continue;
+			}
+
+			++checked_;
+
+			bool ok = true;
+			const std::string lower = check_strings(insn, edisassm::syntax_intel_lcase(), ok);
+			const std::string upper = check_strings(insn, edisassm::syntax_intel_ucase(), ok);
+
+			ok = ok && !lower.empty() && upper == upper_case_of(lower);
+			ok = ok && edisassm::to_byte_string(insn, edisassm::upper_case()) == upper_case_of(edisassm::to_byte_string(insn, edisassm::lower_case()));
+
+			if(!ok && failures_++ < 25) {
+				std::cout << "to_string mismatch (" << M::BITS << "-bit): \"" << lower << "\" / \"" << upper << "\"" << std::endl;
+			}
+		}
+	}
+
+private:
+	std::size_t checked_;
+	std::size_t failures_;
+};
+
+//------------------------------------------------------------------------------
+// Name: run()
+//------------------------------------------------------------------------------
+template <class M>
+std::size_t run() {
+	agreement_test<M> test;
+	test.run_tables();
+	test.run_special();
+	test.run_random(200000);
+	test.run_block(2000);
+	test.run_strings(20000);
+
+	std::cout << M::BITS << "-bit: " << test.checked() << " buffers checked, " << test.failures() << " mismatches" << std::endl;
+	return test.failures();
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: main()
+//------------------------------------------------------------------------------
+int main() {
+	const std::size_t failures = run<edisassm::x86>() + run<edisassm::x86_64>();
+	return failures == 0 ? 0 : 1;
+}
@@ -95,7 +95,10 @@ BackupInfo<N>::BackupInfo(edb::address_t address, quint8 perms, MemRegion &regio
 //------------------------------------------------------------------------------
 template <size_t N>
 bool BackupInfo<N>::backup() {
+	// the state is only fetched as it is used, the shellcode will have run
+	// by the time that it is put back
 	edb::v1::debugger_core->get_state(state_);
+	state_.capture();
 	return edb::v1::debugger_core->read_bytes(address_, buffer_, N);
 }
 
@@ -227,7 +230,10 @@ void MemRegion::set_permissions(bool read, bool write, bool execute, edb::addres
 			// write out our shellcode
 			if(edb::v1::debugger_core->write_bytes(temp_address, shellcode, sizeof(shellcode))) {
 
+				// start from the real registers, the segment registers
+				// have to stay valid
 				State state;
+				edb::v1::debugger_core->get_state(state);
 				state.set_instruction_pointer(temp_address);
 
 #if defined(EDB_X86)
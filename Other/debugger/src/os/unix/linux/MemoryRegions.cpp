@@ -23,15 +23,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "State.h"
 #include "Debugger.h"
 
-#include <sstream>
-#include <string>
+#include <algorithm>
 #include <cstring>
 
 #include <QApplication>
 #include <QDebug>
 #include <QFile>
-#include <QStringList>
-#include <QTextStream>
+#include <QtAlgorithms>
 #include <QtGlobal>
 
 #include <sys/mman.h>
@@ -57,6 +55,8 @@ MemoryRegions::~MemoryRegions() {
 void MemoryRegions::set_pid(edb::pid_t pid) {
 	pid_ = pid;
 	regions_.clear();
+	raw_map_.clear();
+	reset();
 	sync();
 }
 
@@ -67,94 +67,227 @@ void MemoryRegions::set_pid(edb::pid_t pid) {
 void MemoryRegions::clear() {
 	pid_ = 0;
 	regions_.clear();
+	raw_map_.clear();
+	reset();
 }
 
 namespace {
 	//------------------------------------------------------------------------------
-	// Name: process_map_line(const QString &line, MemRegion &region)
-	// Desc: parses the data from a line of a memory map file
+	// Name: skip_spaces(const char *p, const char *end)
+	// Desc:
+	//------------------------------------------------------------------------------
+	const char *skip_spaces(const char *p, const char *end) {
+		while(p != end && (*p == ' ' || *p == '\t')) {
+			++p;
+		}
+		return p;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: skip_field(const char *p, const char *end)
+	// Desc: skips a field and the whitespace after it
+	//------------------------------------------------------------------------------
+	const char *skip_field(const char *p, const char *end) {
+		while(p != end && *p != ' ' && *p != '\t') {
+			++p;
+		}
+		return skip_spaces(p, end);
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: parse_hex(const char *&p, const char *end, edb::address_t &value)
+	// Desc: parses a hex number, leaving p just past it
+	//------------------------------------------------------------------------------
+	bool parse_hex(const char *&p, const char *end, edb::address_t &value) {
+		const char *const first = p;
+		value = 0;
+		for(; p != end; ++p) {
+			const char ch = *p;
+			if(ch >= '0' && ch <= '9')      value = (value << 4) | (ch - '0');
+			else if(ch >= 'a' && ch <= 'f') value = (value << 4) | (ch - 'a' + 10);
+			else if(ch >= 'A' && ch <= 'F') value = (value << 4) | (ch - 'A' + 10);
+			else break;
+		}
+		return p != first;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: process_map_line(const char *p, const char *end, MemRegion &region)
+	// Desc: parses the data from a line of a memory map file, lines look like:
+	//       start-end perms offset dev inode [name]
+	//------------------------------------------------------------------------------
+	bool process_map_line(const char *p, const char *end, MemRegion &region) {
+
+		p = skip_spaces(p, end);
+		if(!parse_hex(p, end, region.start) || p == end || *p++ != '-') {
+			return false;
+		}
+
+		if(!parse_hex(p, end, region.end)) {
+			return false;
+		}
+
+		p = skip_spaces(p, end);
+		if(end - p < 3) {
+			return false;
+		}
+
+		MemRegion::permissions_t permissions = 0;
+		if(p[0] == 'r') permissions |= PROT_READ;
+		if(p[1] == 'w') permissions |= PROT_WRITE;
+		if(p[2] == 'x') permissions |= PROT_EXEC;
+		region.permissions_ = permissions;
+
+		p = skip_field(p, end);
+		if(!parse_hex(p, end, region.base)) {
+			return false;
+		}
+
+		// skip the offset's trailing space, the device and the inode
+		p = skip_field(skip_field(skip_spaces(p, end), end), end);
+
+		const char *const name = p;
+		while(p != end && *p != ' ' && *p != '\t') {
+			++p;
+		}
+
+		if(p != name) {
+			region.name = QString::fromLocal8Bit(name, p - name);
+		}
+
+		return true;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: load_module_symbols(const MemRegion &region)
+	// Desc: if the region has a name, is mapped starting at the beginning of the
+	//       file, and is executable, sounds like a module mapping!
 	//------------------------------------------------------------------------------
-	bool process_map_line(const QString &line, MemRegion &region) {
-
-		bool ret = false;
-		const QStringList items = line.split(" ", QString::SkipEmptyParts);
-		if(items.size() >= 3) {
-			bool ok;
-			const QStringList bounds = items[0].split("-");
-			if(bounds.size() == 2) {
-				region.start = bounds[0].toULongLong(&ok, 16);
-				if(ok) {
-					region.end = bounds[1].toULongLong(&ok, 16);
-					if(ok) {
-						region.base = items[2].toULongLong(&ok, 16);
-						if(ok) {
-							const QString perms = items[1];
-							MemRegion::permissions_t permissions = 0;
-							if(perms[0] == 'r') permissions |= PROT_READ;
-							if(perms[1] == 'w') permissions |= PROT_WRITE;
-							if(perms[2] == 'x') permissions |= PROT_EXEC;
-							region.permissions_ = permissions;
-
-							if(items.size() >= 6) {
-								region.name = items[5];
-							}
-
-							// if the region has a name, is mapped starting
-							// at the beginning of the file, and is executable, sounds
-							// like a module mapping!
-							if(!region.name.isEmpty()) {
-								if(region.base == 0) {
-									if(region.executable()) {
-										edb::v1::symbol_manager().load_symbol_file(region.name, region.start);
-									}
-								}
-							}
-
-							ret = true;
-						}
-					}
-				}
+	void load_module_symbols(const MemRegion &region) {
+		if(!region.name.isEmpty() && region.base == 0 && region.executable()) {
+			edb::v1::symbol_manager().load_symbol_file(region.name, region.start);
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: read_map_file(const QString &filename)
+	// Desc: files in /proc have no size, so read until there is nothing left
+	//------------------------------------------------------------------------------
+	QByteArray read_map_file(const QString &filename) {
+		QByteArray ret;
+
+		QFile file(filename);
+		if(file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+			char buffer[65536];
+			qint64 n;
+			while((n = file.read(buffer, sizeof(buffer))) > 0) {
+				ret.append(buffer, n);
 			}
 		}
+
 		return ret;
 	}
+
+	// for binary searching a sorted list of regions by address
+	struct region_ends_before {
+		bool operator()(const MemRegion &region, edb::address_t address) const {
+			return region.end <= address;
+		}
+	};
 }
 
 //------------------------------------------------------------------------------
 // Name: sync()
-// Desc: reads a memory map file line by line
+// Desc: brings the region list up to date with the process's memory map
+// Note: the map is only parsed when it has changed, and only the rows which
+//       differ are updated so views don't need to rebuild themselves
 //------------------------------------------------------------------------------
 void MemoryRegions::sync() {
 
+	QByteArray raw_map;
 	QList<MemRegion> regions;
 
 	if(pid_ != 0) {
-		const QString mapFile(QString("/proc/%1/maps").arg(pid_));
+		raw_map = read_map_file(QString("/proc/%1/maps").arg(pid_));
+		if(raw_map == raw_map_ && !raw_map.isEmpty()) {
+			return;
+		}
 
-		QFile file(mapFile);
-        if(file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		const char *p         = raw_map.constData();
+		const char *const end = p + raw_map.size();
 
-			QTextStream in(&file);
-			QString line = in.readLine();
+		while(p != end) {
+			const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+			if(eol == 0) {
+				eol = end;
+			}
 
-			while(!line.isNull()) {
-				MemRegion region;
-				if(process_map_line(line, region)) {
-					regions.push_back(region);
-				}
-				line = in.readLine();
+			MemRegion region;
+			if(process_map_line(p, eol, region)) {
+				regions.push_back(region);
 			}
+
+			p = (eol == end) ? end : eol + 1;
 		}
 
 		if(regions.isEmpty()) {
 			qDebug() << "[MemoryRegions] warning: empty memory map";
 		}
+
+		// the kernel gives them to us in order, but find_region depends on it
+		for(int i = 1; i < regions.size(); ++i) {
+			if(regions[i] < regions[i - 1]) {
+				qSort(regions);
+				break;
+			}
+		}
 	}
 
+	raw_map_ = raw_map;
 
-	qSwap(regions_, regions);
+	// walk both (sorted) lists together, updating the model as we go
+	int row = 0;
+	int i   = 0;
+	while(row < regions_.size() || i < regions.size()) {
 
-	reset();
+		if(row < regions_.size() && i < regions.size() && regions_[row].start == regions[i].start) {
+			if(regions_[row] != regions[i]) {
+				regions_[row] = regions[i];
+				Q_EMIT dataChanged(index(row, 0), index(row, columnCount() - 1));
+			}
+			++row;
+			++i;
+			continue;
+		}
+
+		if(row < regions_.size() && (i == regions.size() || regions_[row].start < regions[i].start)) {
+			// a run of regions which are gone
+			int last = row;
+			while(last + 1 < regions_.size() && (i == regions.size() || regions_[last + 1].start < regions[i].start)) {
+				++last;
+			}
+
+			beginRemoveRows(QModelIndex(), row, last);
+			regions_.erase(regions_.begin() + row, regions_.begin() + last + 1);
+			endRemoveRows();
+			continue;
+		}
+
+		// a run of new regions
+		int last = i;
+		while(last + 1 < regions.size() && (row == regions_.size() || regions[last + 1].start < regions_[row].start)) {
+			++last;
+		}
+
+		beginInsertRows(QModelIndex(), row, row + (last - i));
+		for(int j = i; j <= last; ++j) {
+			regions_.insert(row++, regions[j]);
+			load_module_symbols(regions[j]);
+		}
+		endInsertRows();
+
+		i = last + 1;
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -162,24 +295,19 @@ void MemoryRegions::sync() {
 // Desc:
 //------------------------------------------------------------------------------
 bool MemoryRegions::find_region(edb::address_t address) const {
-	Q_FOREACH(const MemRegion &i, regions_) {
-		if(i.contains(address)) {
-			return true;
-		}
-	}
-	return false;
+	const QList<MemRegion>::const_iterator it = std::lower_bound(regions_.begin(), regions_.end(), address, region_ends_before());
+	return it != regions_.end() && it->contains(address);
 }
 
 //------------------------------------------------------------------------------
 // Name: find_region(edb::address_t address, MemRegion &region) const
-// Desc:
+// Desc: binary searches the (sorted, non-overlapping) region list
 //------------------------------------------------------------------------------
 bool MemoryRegions::find_region(edb::address_t address, MemRegion &region) const {
-	Q_FOREACH(const MemRegion &i, regions_) {
-		if(i.contains(address)) {
-			region = i;
-			return true;
-		}
+	const QList<MemRegion>::const_iterator it = std::lower_bound(regions_.begin(), regions_.end(), address, region_ends_before());
+	if(it != regions_.end() && it->contains(address)) {
+		region = *it;
+		return true;
 	}
 	return false;
 }
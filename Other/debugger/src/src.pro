@@ -21,6 +21,7 @@ HEADERS += \
 	BinaryInfo.h \
 	BinaryString.h \
 	Breakpoint.h \
+	BreakpointCondition.h \
 	ByteShiftArray.h \
 	CommentServer.h \
 	Configuration.h \
@@ -53,6 +54,7 @@ HEADERS += \
 	QLongValidator.h \
 	QULongValidator.h \
 	RecentFileManager.h \
+	ReferenceIndex.h \
 	RegionBuffer.h \
 	Register.h \
 	RegisterViewDelegate.h \
@@ -84,6 +86,7 @@ SOURCES += \
 	ArchProcessor.cpp \
 	BinaryInfo.cpp \
 	BinaryString.cpp \
+	BreakpointCondition.cpp \
 	ByteShiftArray.cpp \
 	CommentServer.cpp \
 	Configuration.cpp \
@@ -111,6 +114,7 @@ SOURCES += \
 	QLongValidator.cpp \
 	QULongValidator.cpp \
 	RecentFileManager.cpp \
+	ReferenceIndex.cpp \
 	RegionBuffer.cpp \
 	Register.cpp \
 	RegisterViewDelegate.cpp \
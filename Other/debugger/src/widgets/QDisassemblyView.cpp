@@ -163,7 +163,7 @@ size_t QDisassemblyView::length_disasm_back(const quint8 *buf, size_t size) cons
 
 	while(offs < edb::Instruction::MAX_SIZE) {
 	
-		const edb::Instruction insn(tmp + offs, edb::Instruction::MAX_SIZE, 0, std::nothrow);
+		const edb::InstructionLength insn(tmp + offs, edb::Instruction::MAX_SIZE);
 		if(!insn.valid()) {
 			return 0;
 		}
@@ -224,7 +224,7 @@ edb::address_t QDisassemblyView::following_instructions(edb::address_t current_a
 			current_address += 1;
 			break;
 		} else {
-			const edb::Instruction insn(buf, buf_size, current_address, std::nothrow);
+			const edb::InstructionLength insn(buf, buf_size);
 			if(insn) {
 				current_address += insn.size();
 			} else {
@@ -407,6 +407,42 @@ QString QDisassemblyView::format_instruction_bytes(const edb::Instruction &insn)
 	return edb::v1::format_bytes(QByteArray::fromRawData(reinterpret_cast<const char *>(insn.buffer()), insn.size()));
 }
 
+//------------------------------------------------------------------------------
+// Name: format_instruction(const edb::Instruction &insn, bool upper, int maxStringPx, const QFontMetrics &metrics) const
+// Desc: lines whose bytes, case and width have not changed since they were
+//       last painted come from the cache instead of being formatted again
+//------------------------------------------------------------------------------
+QString QDisassemblyView::format_instruction(const edb::Instruction &insn, bool upper, int maxStringPx, const QFontMetrics &metrics) const {
+
+	// a few screens worth
+	static const int max_cached_lines = 1024;
+
+	const uint bytes_hash = qHash(QByteArray::fromRawData(reinterpret_cast<const char *>(insn.buffer()), insn.size()));
+
+	QHash<edb::address_t, formatted_line>::const_iterator it = line_cache_.constFind(insn.rva());
+	if(it != line_cache_.constEnd() && it->bytes_hash == bytes_hash && it->upper == upper && it->width == maxStringPx) {
+		return it->text;
+	}
+
+	char text[edisassm::MAX_STRING_SIZE];
+	if(upper) {
+		edisassm::to_string(insn, edisassm::syntax_intel_ucase(), text, sizeof(text));
+	} else {
+		edisassm::to_string(insn, edisassm::syntax_intel_lcase(), text, sizeof(text));
+	}
+
+	if(line_cache_.size() >= max_cached_lines) {
+		line_cache_.clear();
+	}
+
+	formatted_line &line = line_cache_[insn.rva()];
+	line.bytes_hash = bytes_hash;
+	line.upper      = upper;
+	line.width      = maxStringPx;
+	line.text       = metrics.elidedText(QLatin1String(text), Qt::ElideRight, maxStringPx);
+	return line.text;
+}
+
 //------------------------------------------------------------------------------
 // Name: draw_instruction(QPainter &painter, const edb::Instruction &insn, bool upper, int y, int line_height, int l2, int l3) const
 // Desc:
@@ -418,9 +454,7 @@ int QDisassemblyView::draw_instruction(QPainter &painter, const edb::Instruction
 	const int ret         = insn.size();
 
 	if(insn.valid()) {
-		QString opcode = QString::fromStdString(upper ? edisassm::to_string(insn, edisassm::syntax_intel_ucase()) : edisassm::to_string(insn, edisassm::syntax_intel_lcase()));
-		
-		opcode = painter.fontMetrics().elidedText(opcode, Qt::ElideRight, (l3 - l2) - font_width_ * 2);
+		QString opcode = format_instruction(insn, upper, (l3 - l2) - font_width_ * 2, painter.fontMetrics());
 
 
 		//return metrics.elidedText(byte_buffer, Qt::ElideRight, maxStringPx);
@@ -775,6 +809,9 @@ void QDisassemblyView::setFont(const QFont &f) {
 	font_width_  = metrics.width('X');
 	font_height_ = metrics.height();
 
+	// the cached lines were elided with the old font
+	line_cache_.clear();
+
 	updateScrollbars();
 }
 
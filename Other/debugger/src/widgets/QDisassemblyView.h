@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QAbstractScrollArea>
 #include <QAbstractSlider>
+#include <QHash>
 #include <QPixmap>
 #include <QSet>
 
@@ -75,6 +76,7 @@ signals:
 
 private:
 	QString formatAddress(edb::address_t address) const;
+	QString format_instruction(const edb::Instruction &insn, bool upper, int maxStringPx, const QFontMetrics &metrics) const;
 	QString format_instruction_bytes(const edb::Instruction &insn) const;
 	QString format_instruction_bytes(const edb::Instruction &insn, int maxStringPx, const QFontMetrics &metrics) const;
 	QString format_invalid_instruction_bytes(const edb::Instruction &insn, QPainter &painter) const;
@@ -95,11 +97,20 @@ private:
 	void updateScrollbars();
 	void updateSelectedAddress(QMouseEvent *event);
 
+private:
+	struct formatted_line {
+		uint    bytes_hash;
+		bool    upper;
+		int     width;
+		QString text; // already elided to width
+	};
+
 private:
 	MemRegion                region_;
 	QPixmap                  breakpoint_icon_;
 	QPixmap                  current_address_icon_;
 	QSet<edb::address_t>     show_addresses_;
+	mutable QHash<edb::address_t, formatted_line> line_cache_;
 	SyntaxHighlighter *const highlighter_;
 	edb::address_t           address_offset_;
 	edb::address_t           selected_instruction_address_;
@@ -0,0 +1,127 @@
+/*
+ * diStorm3 - distorm_flow benchmark
+ * Finds the flow control instructions in a large buffer, made of a file repeated over and over,
+ * with distorm_decompose and DF_RETURN_FC_ONLY and then with distorm_flow, checking both find the same ones.
+ * Usage: bench_flow [file] [megabytes] [mode 16/32/64]
+ *        (defaults to the benchmark's own executable, 64MB and 64 bits)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../include/distorm.h"
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* fileName = (argc > 1) ? argv[1] : "/proc/self/exe";
+	unsigned int megabytes = (argc > 2) ? (unsigned int)atoi(argv[2]) : 64;
+	int mode = (argc > 3) ? atoi(argv[3]) : 64;
+	unsigned int size, fileSize, used, flowUsed, i, maxInstructions, round;
+	unsigned char* code;
+	_DInst* insts;
+	_DFlowInst* flow;
+	_CodeInfo ci, ci2;
+	_DecodeResult res;
+	double start, seqTime = 0, flowTime = 0, t;
+	FILE* f;
+
+	f = fopen(fileName, "rb");
+	if (f == NULL) {
+		printf("can't open %s\n", fileName);
+		return 1;
+	}
+
+	size = megabytes * 1024 * 1024;
+	code = (unsigned char*)malloc(size);
+	if (code == NULL) {
+		printf("out of memory\n");
+		return 1;
+	}
+
+	/* Repeat the file until the buffer is full. */
+	for (fileSize = 0; fileSize < size; ) {
+		used = (unsigned int)fread(code + fileSize, 1, size - fileSize, f);
+		if (used == 0) {
+			if (fileSize == 0) {
+				printf("%s is empty\n", fileName);
+				return 1;
+			}
+			break;
+		}
+		fileSize += used;
+	}
+	fclose(f);
+	for (i = fileSize; i < size; i++) code[i] = code[i - fileSize];
+
+	/* Only flow control instructions are returned, an eighth of the bytes is plenty. */
+	maxInstructions = size / 8 + 16;
+	insts = (_DInst*)malloc((size_t)maxInstructions * sizeof(_DInst));
+	flow = (_DFlowInst*)malloc((size_t)maxInstructions * sizeof(_DFlowInst));
+	if ((insts == NULL) || (flow == NULL)) {
+		printf("out of memory\n");
+		return 1;
+	}
+
+	/* Touch the result arrays first, so page faults aren't measured. */
+	memset(insts, 0, (size_t)maxInstructions * sizeof(_DInst));
+	memset(flow, 0, (size_t)maxInstructions * sizeof(_DFlowInst));
+
+	memset(&ci, 0, sizeof(ci));
+	ci.codeOffset = 0x400000;
+	ci.code = code;
+	ci.codeLen = (int)size;
+	ci.dt = (mode == 16) ? Decode16Bits : ((mode == 32) ? Decode32Bits : Decode64Bits);
+	ci.features = DF_RETURN_FC_ONLY;
+
+	printf("%s repeated to %uMB, %d bits\n", fileName, megabytes, mode);
+
+	/* Best of three runs each. */
+	for (round = 0; round < 3; round++) {
+		start = now();
+		res = distorm_decompose(&ci, insts, maxInstructions, &used);
+		t = now() - start;
+		if (res != DECRES_SUCCESS) {
+			printf("distorm_decompose failed (%d)\n", (int)res);
+			return 1;
+		}
+		if ((round == 0) || (t < seqTime)) seqTime = t;
+
+		ci2 = ci;
+		start = now();
+		res = distorm_flow(&ci2, flow, maxInstructions, &flowUsed);
+		t = now() - start;
+		if (res != DECRES_SUCCESS) {
+			printf("distorm_flow failed (%d)\n", (int)res);
+			return 1;
+		}
+		if ((round == 0) || (t < flowTime)) flowTime = t;
+	}
+
+	if (flowUsed != used) {
+		printf("distorm_flow found %u instructions instead of %u!\n", flowUsed, used);
+		return 1;
+	}
+	for (i = 0; i < used; i++) {
+		if ((insts[i].addr != flow[i].addr) || (insts[i].size != flow[i].size) || (insts[i].opcode != flow[i].opcode)) {
+			printf("distorm_flow gave a different instruction at 0x%llx!\n", (unsigned long long)insts[i].addr);
+			return 1;
+		}
+	}
+
+	printf("  distorm_decompose(FC_ONLY): %u instructions, %.3fs, %.1f MB/s\n", used, seqTime, megabytes / seqTime);
+	printf("  distorm_flow:               %u instructions, %.3fs, %.1f MB/s, x%.2f\n", flowUsed, flowTime, megabytes / flowTime, seqTime / flowTime);
+
+	free(flow);
+	free(insts);
+	free(code);
+	return 0;
+}
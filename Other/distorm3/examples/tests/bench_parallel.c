@@ -0,0 +1,127 @@
+/*
+ * diStorm3 - distorm_decompose_parallel benchmark
+ * Decomposes a large buffer, made of a file repeated over and over, with distorm_decompose and then
+ * with distorm_decompose_parallel on a growing number of threads, checking the results are the same.
+ * Usage: bench_parallel [file] [megabytes] [mode 16/32/64]
+ *        (defaults to the benchmark's own executable, 128MB and 64 bits)
+ * Note: the result array takes 32 times the size of the input, distorm_decompose_parallel itself only needs
+ *       a bitmap of an eighth of it on top (128MB peaks at about 4.2GB).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../include/distorm.h"
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* FNV-1a over the entries, so the results can be compared without keeping two copies around. */
+static unsigned int checksum(const _DInst* insts, unsigned int count)
+{
+	const unsigned char* p = (const unsigned char*)insts;
+	const unsigned char* end = p + (size_t)count * sizeof(_DInst);
+	unsigned int h = 2166136261u;
+
+	for (; p < end; p++) h = (h ^ *p) * 16777619u;
+	return h;
+}
+
+int main(int argc, char* argv[])
+{
+	static const unsigned int threads[] = { 1, 2, 4, 8, 16, 0 };
+	const char* fileName = (argc > 1) ? argv[1] : "/proc/self/exe";
+	unsigned int megabytes = (argc > 2) ? (unsigned int)atoi(argv[2]) : 128;
+	int mode = (argc > 3) ? atoi(argv[3]) : 64;
+	unsigned int size, fileSize, used, i, maxInstructions, parUsed, sum;
+	unsigned char* code;
+	_DInst* insts;
+	_CodeInfo ci;
+	_DecodeResult res;
+	double start, seqTime, t;
+	FILE* f;
+
+	f = fopen(fileName, "rb");
+	if (f == NULL) {
+		printf("can't open %s\n", fileName);
+		return 1;
+	}
+
+	size = megabytes * 1024 * 1024;
+	code = (unsigned char*)malloc(size);
+	if (code == NULL) {
+		printf("out of memory\n");
+		return 1;
+	}
+
+	/* Repeat the file until the buffer is full. */
+	for (fileSize = 0; fileSize < size; ) {
+		used = (unsigned int)fread(code + fileSize, 1, size - fileSize, f);
+		if (used == 0) {
+			if (fileSize == 0) {
+				printf("%s is empty\n", fileName);
+				return 1;
+			}
+			break;
+		}
+		fileSize += used;
+	}
+	fclose(f);
+	for (i = fileSize; i < size; i++) code[i] = code[i - fileSize];
+
+	/* Instructions are at least a byte long, but real code averages well above 2 bytes. */
+	maxInstructions = size / 2 + 16;
+	insts = (_DInst*)malloc((size_t)maxInstructions * sizeof(_DInst));
+	if (insts == NULL) {
+		printf("out of memory\n");
+		return 1;
+	}
+
+	memset(&ci, 0, sizeof(ci));
+	ci.codeOffset = 0x400000;
+	ci.code = code;
+	ci.codeLen = (int)size;
+	ci.dt = (mode == 16) ? Decode16Bits : ((mode == 32) ? Decode32Bits : Decode64Bits);
+
+	printf("%s repeated to %uMB, %d bits\n", fileName, megabytes, mode);
+
+	/* Touch the result array first, so page faults aren't measured. */
+	memset(insts, 0, (size_t)maxInstructions * sizeof(_DInst));
+
+	start = now();
+	res = distorm_decompose(&ci, insts, maxInstructions, &used);
+	seqTime = now() - start;
+	if (res != DECRES_SUCCESS) {
+		printf("distorm_decompose failed (%d)\n", (int)res);
+		return 1;
+	}
+	printf("  distorm_decompose:               %u instructions, %.3fs, %.1f MB/s\n", used, seqTime, megabytes / seqTime);
+	sum = checksum(insts, used);
+
+	for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+		memset(insts, 0, (size_t)used * sizeof(_DInst));
+
+		start = now();
+		res = distorm_decompose_parallel(&ci, insts, maxInstructions, &parUsed, threads[i]);
+		t = now() - start;
+
+		if ((res != DECRES_SUCCESS) || (parUsed != used) || (checksum(insts, used) != sum)) {
+			printf("distorm_decompose_parallel with %u threads gave a different result!\n", threads[i]);
+			return 1;
+		}
+
+		if (threads[i] == 0) printf("  distorm_decompose_parallel(CPUs): ");
+		else printf("  distorm_decompose_parallel(%2u):   ", threads[i]);
+		printf("%.3fs, %.1f MB/s, x%.2f\n", t, megabytes / t, seqTime / t);
+	}
+
+	free(insts);
+	free(code);
+	return 0;
+}
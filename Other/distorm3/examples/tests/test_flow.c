@@ -0,0 +1,177 @@
+/*
+ * diStorm3 - distorm_flow test
+ * Checks that distorm_flow finds exactly the instructions that distorm_decompose returns with DF_RETURN_FC_ONLY:
+ * same return codes, next offsets, and for every instruction the same address, size, opcode, flow control type and target.
+ * Runs over random code and over the given files (the test's own executable when none are given),
+ * in every decoding mode, with the address limiting and stop features, and with a small result array.
+ * Usage: test_flow [file...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/distorm.h"
+
+static unsigned int failures = 0, checks = 0, found = 0;
+
+static unsigned char* read_file(const char* name, unsigned int* size)
+{
+	FILE* f = fopen(name, "rb");
+	unsigned char* buf;
+	long len;
+
+	if (f == NULL) return NULL;
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	buf = (unsigned char*)malloc(len > 0 ? len : 1);
+	if ((buf == NULL) || (fread(buf, 1, len, f) != (size_t)len)) {
+		free(buf);
+		fclose(f);
+		return NULL;
+	}
+	fclose(f);
+	*size = (unsigned int)len;
+	return buf;
+}
+
+/* Random bytes, heavy with prefixes and flow control opcodes. */
+static void fill_random(unsigned char* buf, unsigned int size, unsigned int seed)
+{
+	static const unsigned char special[] = {
+		0x66, 0x67, 0xf0, 0xf2, 0xf3, 0x2e, 0x3e, 0x26, 0x64, 0x48, 0x41, 0x0f, 0xc4, 0xc5,
+		0xe8, 0xe9, 0xeb, 0x74, 0xe3, 0xe2, 0xc3, 0xc2, 0xca, 0xcf, 0x9a, 0xea, 0xff, 0xcd, 0xcc, 0x0f
+	};
+	unsigned int i;
+
+	srand(seed);
+	for (i = 0; i < size; i++) {
+		if (rand() & 3) buf[i] = (unsigned char)(rand() >> 4);
+		else buf[i] = special[rand() % sizeof(special)];
+	}
+}
+
+static int same(const _DInst* di, const _DFlowInst* fi)
+{
+	_OffsetType target = 0;
+	uint16_t seg = 0;
+
+	if (di->ops[0].type == O_PC) target = INSTRUCTION_GET_TARGET(di);
+	else if (di->ops[0].type == O_PTR) {
+		target = di->imm.ptr.off;
+		seg = di->imm.ptr.seg;
+	}
+
+	return (di->addr == fi->addr) && (di->size == fi->size) && (di->opcode == fi->opcode) &&
+	       (META_GET_FC(di->meta) == fi->fc) && (di->ops[0].type == fi->targetType) &&
+	       (target == fi->target) && (seg == fi->targetSeg);
+}
+
+/* Runs both over the whole code, continuing from nextOffset whenever they return early. */
+static void compare(const char* name, const unsigned char* code, unsigned int size, _DecodeType dt, unsigned int features, _OffsetType offset, unsigned int maxInstructions, _DInst* insts, _DFlowInst* flow)
+{
+	_CodeInfo ci1, ci2;
+	_DecodeResult r1, r2;
+	unsigned int n1, n2, i, calls = 0;
+
+	memset(&ci1, 0, sizeof(ci1));
+	ci1.codeOffset = offset;
+	ci1.code = code;
+	ci1.codeLen = (int)size;
+	ci1.dt = dt;
+	ci1.features = features;
+
+	checks++;
+	for (;;) {
+		ci2 = ci1;
+		ci1.features = features | DF_RETURN_FC_ONLY;
+		r1 = distorm_decompose(&ci1, insts, maxInstructions, &n1);
+		r2 = distorm_flow(&ci2, flow, maxInstructions, &n2);
+		calls++;
+
+		for (i = 0; (i < n1) && (i < n2) && same(&insts[i], &flow[i]); i++);
+		if ((r1 != r2) || (n1 != n2) || (i != n1) || (ci1.nextOffset != ci2.nextOffset)) {
+			if (failures++ < 20) {
+				printf("%s: mode %d, features 0x%x, max %u, call %u: result %d/%d, count %u/%u, next 0x%llx/0x%llx",
+				       name, (int)dt * 16 + 16, features, maxInstructions, calls, (int)r1, (int)r2, n1, n2,
+				       (unsigned long long)ci1.nextOffset, (unsigned long long)ci2.nextOffset);
+				if (i < n1) printf(", first difference at 0x%llx", (unsigned long long)insts[i].addr);
+				printf("\n");
+			}
+			return;
+		}
+		found += n1;
+
+		/* Continue after where it stopped, stop on flow control or a full result array. */
+		if ((r1 != DECRES_SUCCESS) && (r1 != DECRES_MEMORYERR)) return;
+		n1 = (unsigned int)(ci1.nextOffset - ci1.codeOffset);
+		if ((n1 == 0) || ((int)n1 >= ci1.codeLen)) return;
+		ci1.code += n1;
+		ci1.codeLen -= n1;
+		ci1.codeOffset = ci1.nextOffset;
+	}
+}
+
+static void run(const char* name, const unsigned char* code, unsigned int size)
+{
+	static const unsigned int features[] = {
+		0, DF_MAXIMUM_ADDR32, DF_MAXIMUM_ADDR16, DF_STOP_ON_RET, DF_STOP_ON_CND_BRANCH | DF_STOP_ON_INT, DF_STOP_ON_FLOW_CONTROL
+	};
+	unsigned int maxInstructions = size + 16;
+	_DInst* insts = (_DInst*)malloc(maxInstructions * sizeof(_DInst));
+	_DFlowInst* flow = (_DFlowInst*)malloc(maxInstructions * sizeof(_DFlowInst));
+	unsigned int dt, f;
+
+	if ((insts == NULL) || (flow == NULL)) {
+		printf("%s: out of memory\n", name);
+		failures++;
+		free(insts);
+		free(flow);
+		return;
+	}
+
+	for (dt = Decode16Bits; dt <= Decode64Bits; dt++) {
+		for (f = 0; f < sizeof(features) / sizeof(features[0]); f++) {
+			compare(name, code, size, (_DecodeType)dt, features[f], 0x401000, maxInstructions, insts, flow);
+		}
+
+		/* Addresses wrapping around, and a result array that fills up. */
+		compare(name, code, size, (_DecodeType)dt, DF_MAXIMUM_ADDR32, 0xfffff000, maxInstructions, insts, flow);
+		compare(name, code, size, (_DecodeType)dt, 0, 0x401000, 15, insts, flow);
+	}
+
+	free(insts);
+	free(flow);
+}
+
+int main(int argc, char* argv[])
+{
+	static const unsigned int sizes[] = { 0x1000, 0x10000 + 5, 0x40000 + 11 };
+	unsigned char* buf;
+	unsigned int size = 0, i;
+	char name[64];
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		buf = (unsigned char*)malloc(sizes[i]);
+		if (buf == NULL) return 1;
+		fill_random(buf, sizes[i], i + 1);
+		sprintf(name, "random %u bytes", sizes[i]);
+		run(name, buf, sizes[i]);
+		free(buf);
+	}
+
+	for (i = 1; i < (unsigned int)argc || i == 1; i++) {
+		const char* fileName = (argc > 1) ? argv[i] : "/proc/self/exe";
+		buf = read_file(fileName, &size);
+		if (buf == NULL) {
+			printf("can't read %s\n", fileName);
+			return 1;
+		}
+		run(fileName, buf, size);
+		free(buf);
+	}
+
+	printf("%u checks, %u flow control instructions, %u failures\n", checks, found, failures);
+	return (failures == 0) ? 0 : 1;
+}
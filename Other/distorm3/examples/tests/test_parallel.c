@@ -0,0 +1,149 @@
+/*
+ * diStorm3 - distorm_decompose_parallel test
+ * Checks that the parallel decomposer gives exactly what distorm_decompose does:
+ * same return code, entries, count and next offset, over random and real code,
+ * in every decoding mode, with and without features, for a range of thread counts.
+ * Usage: test_parallel [file] (defaults to the test's own executable)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/distorm.h"
+
+static unsigned int failures = 0, checks = 0;
+
+static unsigned char* read_file(const char* name, unsigned int* size)
+{
+	FILE* f = fopen(name, "rb");
+	unsigned char* buf;
+	long len;
+
+	if (f == NULL) return NULL;
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	buf = (unsigned char*)malloc(len > 0 ? len : 1);
+	if ((buf == NULL) || (fread(buf, 1, len, f) != (size_t)len)) {
+		free(buf);
+		fclose(f);
+		return NULL;
+	}
+	fclose(f);
+	*size = (unsigned int)len;
+	return buf;
+}
+
+/* Random bytes, with runs of prefixes and branches so the chunk boundaries land in all sorts of places. */
+static void fill_random(unsigned char* buf, unsigned int size, unsigned int seed)
+{
+	static const unsigned char special[] = { 0x66, 0x67, 0xf0, 0xf2, 0xf3, 0x2e, 0x26, 0x48, 0x0f, 0xe8, 0xe9, 0xeb, 0x74, 0xc3, 0xff };
+	unsigned int i, j, run;
+
+	srand(seed);
+	for (i = 0; i < size; i++) {
+		buf[i] = (unsigned char)(rand() >> 4);
+		if ((rand() & 0xff) == 0) {
+			/* Once in a while more prefixes than an instruction can have. */
+			run = rand() % 20;
+			for (j = 0; (j < run) && (i < size); j++, i++) buf[i] = special[rand() % 8];
+			if (i < size) buf[i] = special[rand() % sizeof(special)];
+		}
+	}
+}
+
+static void compare(const char* name, const unsigned char* code, unsigned int size, _DecodeType dt, unsigned int features, _OffsetType offset, unsigned int maxInstructions, unsigned int threads, _DInst* seq, _DInst* par)
+{
+	_CodeInfo ci1, ci2;
+	_DecodeResult r1, r2;
+	unsigned int n1 = 0, n2 = 0;
+
+	memset(&ci1, 0, sizeof(ci1));
+	ci1.codeOffset = offset;
+	ci1.code = code;
+	ci1.codeLen = (int)size;
+	ci1.dt = dt;
+	ci1.features = features;
+	ci2 = ci1;
+
+	memset(seq, 0, maxInstructions * sizeof(_DInst));
+	memset(par, 0xcc, maxInstructions * sizeof(_DInst));
+
+	r1 = distorm_decompose(&ci1, seq, maxInstructions, &n1);
+	r2 = distorm_decompose_parallel(&ci2, par, maxInstructions, &n2, threads);
+
+	checks++;
+	if ((r1 != r2) || (n1 != n2) || (ci1.nextOffset != ci2.nextOffset) || (memcmp(seq, par, n1 * sizeof(_DInst)) != 0)) {
+		unsigned int i = 0;
+		while ((i < n1) && (i < n2) && (memcmp(&seq[i], &par[i], sizeof(_DInst)) == 0)) i++;
+		if (failures++ < 20) {
+			printf("%s: mode %d, features 0x%x, %u threads, max %u: result %d/%d, count %u/%u, next 0x%llx/0x%llx, first difference at entry %u\n",
+			       name, (int)dt * 16 + 16, features, threads, maxInstructions, (int)r1, (int)r2, n1, n2,
+			       (unsigned long long)ci1.nextOffset, (unsigned long long)ci2.nextOffset, i);
+		}
+	}
+}
+
+static void run(const char* name, const unsigned char* code, unsigned int size)
+{
+	static const unsigned int features[] = { 0, DF_RETURN_FC_ONLY, DF_MAXIMUM_ADDR32, DF_MAXIMUM_ADDR32 | DF_RETURN_FC_ONLY, DF_MAXIMUM_ADDR16, DF_STOP_ON_RET };
+	static const unsigned int threads[] = { 1, 2, 3, 7, 16 };
+	unsigned int maxInstructions = size + 16;
+	_DInst* seq = (_DInst*)malloc(maxInstructions * sizeof(_DInst));
+	_DInst* par = (_DInst*)malloc(maxInstructions * sizeof(_DInst));
+	unsigned int dt, f, t;
+
+	if ((seq == NULL) || (par == NULL)) {
+		printf("%s: out of memory\n", name);
+		failures++;
+		free(seq);
+		free(par);
+		return;
+	}
+
+	for (dt = Decode16Bits; dt <= Decode64Bits; dt++) {
+		for (f = 0; f < sizeof(features) / sizeof(features[0]); f++) {
+			for (t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+				compare(name, code, size, (_DecodeType)dt, features[f], 0x401000, maxInstructions, threads[t], seq, par);
+			}
+		}
+
+		/* Addresses wrapping around 4GB, a result array too small, and threads for each CPU. */
+		compare(name, code, size, (_DecodeType)dt, DF_MAXIMUM_ADDR32, 0xfff80000, maxInstructions, 5, seq, par);
+		compare(name, code, size, (_DecodeType)dt, 0, 0x401000, size / 8, 4, seq, par);
+		compare(name, code, size, (_DecodeType)dt, 0, 0x401000, maxInstructions, 0, seq, par);
+	}
+
+	free(seq);
+	free(par);
+}
+
+int main(int argc, char* argv[])
+{
+	static const unsigned int sizes[] = { 0x10000, 0x20000 + 13, 0x100000 + 7 };
+	const char* fileName = (argc > 1) ? argv[1] : "/proc/self/exe";
+	unsigned char* buf;
+	unsigned int size = 0, i;
+	char name[64];
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		buf = (unsigned char*)malloc(sizes[i]);
+		if (buf == NULL) return 1;
+		fill_random(buf, sizes[i], i + 1);
+		sprintf(name, "random %u bytes", sizes[i]);
+		run(name, buf, sizes[i]);
+		free(buf);
+	}
+
+	buf = read_file(fileName, &size);
+	if (buf == NULL) {
+		printf("can't read %s\n", fileName);
+		return 1;
+	}
+	run(fileName, buf, size);
+	free(buf);
+
+	printf("%u checks, %u failures\n", checks, failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -78,40 +78,43 @@ static _DecodeType decode_get_effective_op_size(_DecodeType dt, _iflags decodedP
 	return dt;
 }
 
-static _DecodeResult decode_inst(_CodeInfo* ci, _PrefixState* ps, _DInst* di)
-{
+/* What decode_inst_lookup found out about the instruction, before any of its operands were read. */
+typedef struct {
+	/* The first byte of the instruction (after the prefixes). */
+	const uint8_t* startCode;
+	_InstInfo* ii;
+	_InstSharedInfo* isi;
+	_iflags instFlags;
 	/* The ModR/M byte of the current instruction. */
-	unsigned int modrm = 0;
+	unsigned int modrm;
+	/* Calcualte (and cache) effective-operand-size and effective-address-size only once. */
+	_DecodeType effOpSz, effAdrSz;
+} _InstLookup;
 
+/*
+ * Finds the instruction and validates it against the decoding mode and its ModR/M byte.
+ * Returns FALSE if it can't be decoded, otherwise ci points to the first byte after the opcode (and ModR/M byte).
+ */
+static int decode_inst_lookup(_CodeInfo* ci, _PrefixState* ps, _InstLookup* il)
+{
 	/* The REX/VEX prefix byte value. */
 	unsigned int vrex = ps->vrex;
 
-	/*
-	 * Backup original input, so we can use it later if a problem occurs
-	 * (like not enough data for decoding, invalid opcode, etc).
-	 */
-	const uint8_t* startCode = ci->code;
-
 	/* Holds the info about the current found instruction. */
 	_InstInfo* ii = NULL;
 	_InstSharedInfo* isi = NULL;
+	_iflags instFlags;
 
-	/* Used only for special CMP instructions which have pseudo opcodes suffix. */
-	unsigned char cmpType = 0;
+	unsigned int modrm = 0;
 
 	/*
-	 * Indicates whether it is right to LOCK the instruction by decoding its first operand.
-	 * Only then you know if it's ok to output the LOCK prefix's text...
-	 * Used for first operand only.
+	 * Backup original input, so we can use it later if a problem occurs
+	 * (like not enough data for decoding, invalid opcode, etc).
 	 */
-	int lockable = FALSE;
-
-	/* Calcualte (and cache) effective-operand-size and effective-address-size only once. */
-	_DecodeType effOpSz, effAdrSz;
-	_iflags instFlags;
+	il->startCode = ci->code;
 
 	ii = inst_lookup(ci, ps);
-	if (ii == NULL) goto _Undecodable;
+	if (ii == NULL) return FALSE;
 	isi = &InstSharedInfoTable[ii->sharedIndex];
 	instFlags = FlagsTable[isi->flagsIndex];
 
@@ -147,30 +150,79 @@ static _DecodeResult decode_inst(_CodeInfo* ci, _PrefixState* ps, _DInst* di)
 	/* if (ii && (dt == Decode16Bits) && (instFlags & INST_32BITS) && (~instFlags & INST_16BITS)) ii = NULL; */
 
 	/* Drop instructions which are invalid in 64 bits. */
-	if ((ci->dt == Decode64Bits) && (instFlags & INST_INVALID_64BITS)) goto _Undecodable;
+	if ((ci->dt == Decode64Bits) && (instFlags & INST_INVALID_64BITS)) return FALSE;
 
 	/* If it's only a 64 bits instruction drop it in other decoding modes. */
-	if ((ci->dt != Decode64Bits) && (instFlags & INST_64BITS_FETCH)) goto _Undecodable;
+	if ((ci->dt != Decode64Bits) && (instFlags & INST_64BITS_FETCH)) return FALSE;
 
 	if (instFlags & INST_MODRM_REQUIRED) {
 		/* If the ModRM byte is not part of the opcode, skip the last byte code, so code points now to ModRM. */
 		if (~instFlags & INST_MODRM_INCLUDED) {
 			ci->code++;
-			if (--ci->codeLen < 0) goto _Undecodable;
+			if (--ci->codeLen < 0) return FALSE;
 		}
 		modrm = *ci->code;
 
 		/* Some instructions enforce that reg=000, so validate that. (Specifically EXTRQ). */
-		if ((instFlags & INST_FORCE_REG0) && (((modrm >> 3) & 7) != 0)) goto _Undecodable;
+		if ((instFlags & INST_FORCE_REG0) && (((modrm >> 3) & 7) != 0)) return FALSE;
 		/* Some instructions enforce that mod=11, so validate that. */
-		if ((instFlags & INST_MODRR_REQUIRED) && (modrm < INST_DIVIDED_MODRM)) goto _Undecodable;
+		if ((instFlags & INST_MODRR_REQUIRED) && (modrm < INST_DIVIDED_MODRM)) return FALSE;
 	}
 
 	ci->code++; /* Skip the last byte we just read (either last opcode's byte code or a ModRM). */
 
+	il->ii = ii;
+	il->isi = isi;
+	il->instFlags = instFlags;
+	il->modrm = modrm;
+
 	/* Cache the effective operand-size and address-size. */
-	effOpSz = decode_get_effective_op_size(ci->dt, ps->decodedPrefixes, vrex, instFlags);
-	effAdrSz = decode_get_effective_addr_size(ci->dt, ps->decodedPrefixes);
+	il->effOpSz = decode_get_effective_op_size(ci->dt, ps->decodedPrefixes, vrex, instFlags);
+	il->effAdrSz = decode_get_effective_addr_size(ci->dt, ps->decodedPrefixes);
+	return TRUE;
+}
+
+/* If the instruction couldn't be decoded for some reason, drop the first byte. */
+static _DecodeResult decode_inst_undecodable(const uint8_t* startCode, _PrefixState* ps, _DInst* di)
+{
+	memset(di, 0, sizeof(_DInst));
+	di->base = R_NONE;
+
+	di->size = 1;
+	/* Clean prefixes just in case... */
+	ps->usedPrefixes = 0;
+
+	/* Special case for WAIT instruction: If it's dropped, you have to return a valid instruction! */
+	if (*startCode == INST_WAIT_INDEX) {
+		di->opcode = I_WAIT;
+		META_SET_ISC(di, ISC_INTEGER);
+		return DECRES_SUCCESS;
+	}
+
+	/* Mark that we didn't manage to decode the instruction well, caller will drop it. */
+	return DECRES_INPUTERR;
+}
+
+/* Extracts the operands of a looked up instruction and fills in the rest of the result. */
+static _DecodeResult decode_inst_operands(_CodeInfo* ci, _PrefixState* ps, const _InstLookup* il, _DInst* di)
+{
+	unsigned int modrm = il->modrm;
+	unsigned int vrex = ps->vrex;
+	const uint8_t* startCode = il->startCode;
+	_InstInfo* ii = il->ii;
+	_InstSharedInfo* isi = il->isi;
+	_iflags instFlags = il->instFlags;
+	_DecodeType effOpSz = il->effOpSz, effAdrSz = il->effAdrSz;
+
+	/* Used only for special CMP instructions which have pseudo opcodes suffix. */
+	unsigned char cmpType = 0;
+
+	/*
+	 * Indicates whether it is right to LOCK the instruction by decoding its first operand.
+	 * Only then you know if it's ok to output the LOCK prefix's text...
+	 * Used for first operand only.
+	 */
+	int lockable = FALSE;
 
 	memset(di, 0, sizeof(_DInst));
 	di->base = R_NONE;
@@ -372,34 +424,90 @@ static _DecodeResult decode_inst(_CodeInfo* ci, _PrefixState* ps, _DInst* di)
 	di->size = (uint8_t)((ci->code - startCode) & 0xff);
 	return DECRES_SUCCESS;
 
-_Undecodable: /* If the instruction couldn't be decoded for some reason, drop the first byte. */
-	memset(di, 0, sizeof(_DInst));
-	di->base = R_NONE;
+_Undecodable:
+	return decode_inst_undecodable(startCode, ps, di);
+}
 
-	di->size = 1;
-	/* Clean prefixes just in case... */
-	ps->usedPrefixes = 0;
+static _DecodeResult decode_inst(_CodeInfo* ci, _PrefixState* ps, _DInst* di)
+{
+	_InstLookup il;
 
-	/* Special case for WAIT instruction: If it's dropped, you have to return a valid instruction! */
-	if (*startCode == INST_WAIT_INDEX) {
-		di->opcode = I_WAIT;
-		META_SET_ISC(di, ISC_INTEGER);
-		return DECRES_SUCCESS;
+	if (!decode_inst_lookup(ci, ps, &il)) return decode_inst_undecodable(il.startCode, ps, di);
+	return decode_inst_operands(ci, ps, &il, di);
+}
+
+/*
+ * The size of a looked up instruction, as decode_inst_operands would find it, but without extracting anything.
+ * Returns 0 if the instruction can't be decoded, and -1 when only decode_inst_operands can tell.
+ */
+static int decode_inst_length(const _CodeInfo* ci, const _PrefixState* ps, const _InstLookup* il)
+{
+	const uint8_t* code = ci->code;
+	int codeLen = ci->codeLen;
+	_iflags instFlags = il->instFlags;
+	_OpType types[OPERANDS_NO];
+	int i, count = 0, size;
+
+	/* These look up the instruction again, read a pseudo opcode, or have mnemonics that may reject the ModR/M byte. */
+	if (instFlags & (INST_3DNOW_FETCH | INST_PSEUDO_OPCODE | INST_MNEMONIC_MODRM_BASED)) return -1;
+
+	/* Same operands as decode_inst_operands extracts. */
+	if (il->isi->d != OT_NONE) {
+		types[count++] = (_OpType)il->isi->d;
+		if (il->isi->s != OT_NONE) {
+			types[count++] = (_OpType)il->isi->s;
+			if (instFlags & INST_USE_OP3) {
+				types[count++] = (_OpType)((_InstInfoEx*)il->ii)->op3;
+				if (instFlags & INST_USE_OP4) types[count++] = (_OpType)((_InstInfoEx*)il->ii)->op4;
+			}
+		}
 	}
 
-	/* Mark that we didn't manage to decode the instruction well, caller will drop it. */
-	return DECRES_INPUTERR;
+	for (i = 0; i < count; i++) {
+		size = operands_length(code, codeLen, types[i], il->modrm, instFlags, il->effOpSz, il->effAdrSz);
+		if (size == -1) return 0;
+		if (size < 0) return -1;
+		code += size;
+		codeLen -= size;
+	}
+
+	if ((code - ps->start) > INST_MAXIMUM_SIZE) return 0; /* Drop instruction. */
+
+	return (int)(code - il->startCode);
+}
+
+/* Drops the prefixes that are ignored in 64 bits, code points to the first byte of the instruction. */
+static void decode_prefixes64(_PrefixState* ps, const uint8_t* code)
+{
+	if (ps->decodedPrefixes & INST_PRE_REX) {
+		/* REX prefix must precede first byte of instruction. */
+		if (ps->rexPos != (code - 1)) {
+			ps->decodedPrefixes &= ~INST_PRE_REX;
+			ps->prefixExtType = PET_NONE;
+			prefixes_ignore(ps, PFXIDX_REX);
+		}
+		/*
+		 * We will disable operand size prefix,
+		 * if it exists only after decoding the instruction, since it might be a mandatory prefix.
+		 * This will be done after calling inst_lookup in decode_inst.
+		 */
+	}
+	/* In 64 bits, segment overrides of CS, DS, ES and SS are ignored. So don't take'em into account. */
+	if (ps->decodedPrefixes & INST_PRE_SEGOVRD_MASK32) {
+		ps->decodedPrefixes &= ~INST_PRE_SEGOVRD_MASK32;
+		prefixes_ignore(ps, PFXIDX_SEG);
+	}
 }
 
 /*
- * decode_internal
+ * decode_range
  *
  * supportOldIntr - Since now we work with new structure instead of the old _DecodedInst, we are still interested in backward compatibility.
  *                  So although, the array is now of type _DInst, we want to read it in jumps of the old array element's size.
  *                  This is in order to save memory allocation for conversion between the new and the old structures.
  *                  It really means we can do the conversion in-place now.
  */
-_DecodeResult decode_internal(_CodeInfo* _ci, int supportOldIntr, _DInst result[], unsigned int maxResultCount, unsigned int* usedInstructionsCount)
+static _DecodeResult decode_range(_CodeInfo* _ci, int supportOldIntr, _DInst result[], unsigned int maxResultCount, unsigned int* usedInstructionsCount, _DecodeSlice* slice)
 {
 	_PrefixState ps;
 	unsigned int prefixSize;
@@ -441,6 +549,16 @@ _DecodeResult decode_internal(_CodeInfo* _ci, int supportOldIntr, _DInst result[
 	/* Decode instructions as long as we have what to decode/enough room in entries. */
 	while (codeLen > 0) {
 
+		/* Decoding a slice stops at its end, or where the decoding which marked the steps got in sync with us. */
+		if (slice != NULL) {
+			unsigned int pos = (unsigned int)(code - slice->base);
+			if ((code >= slice->end) || (slice->sync && (slice->steps[pos >> 3] & (1 << (pos & 7))))) {
+				_ci->nextOffset = codeOffset;
+				break;
+			}
+			if (!slice->sync) slice->steps[pos >> 3] |= (uint8_t)(1 << (pos & 7));
+		}
+
 		/* startInstOffset holds the displayed offset of current instruction. */
 		startInstOffset = codeOffset;
 
@@ -491,8 +609,11 @@ _DecodeResult decode_internal(_CodeInfo* _ci, int supportOldIntr, _DInst result[
 			code += prefixSize;
 			codeOffset += prefixSize;
 
-			/* If we got only prefixes continue to next instruction. */
-			if (prefixSize == INST_MAXIMUM_SIZE) continue;
+			/* If we got only prefixes continue to next instruction, they were already reported as used. */
+			if (prefixSize == INST_MAXIMUM_SIZE) {
+				_ci->nextOffset = codeOffset;
+				continue;
+			}
 		}
 
 		/*
@@ -503,26 +624,7 @@ _DecodeResult decode_internal(_CodeInfo* _ci, int supportOldIntr, _DInst result[
 		 * Even if there were a mandatory prefix, we already took into account its size as a normal prefix.
 		 * so prefixSize includes that, and the returned size in pdi is simply the size of the real(=without prefixes) instruction.
 		 */
-		if (ci.dt == Decode64Bits) {
-			if (ps.decodedPrefixes & INST_PRE_REX) {
-				/* REX prefix must precede first byte of instruction. */
-				if (ps.rexPos != (code - 1)) {
-					ps.decodedPrefixes &= ~INST_PRE_REX;
-					ps.prefixExtType = PET_NONE;
-					prefixes_ignore(&ps, PFXIDX_REX);
-				}
-				/*
-				 * We will disable operand size prefix,
-				 * if it exists only after decoding the instruction, since it might be a mandatory prefix.
-				 * This will be done after calling inst_lookup in decode_inst.
-				 */
-			}
-			/* In 64 bits, segment overrides of CS, DS, ES and SS are ignored. So don't take'em into account. */
-			if (ps.decodedPrefixes & INST_PRE_SEGOVRD_MASK32) {
-				ps.decodedPrefixes &= ~INST_PRE_SEGOVRD_MASK32;
-				prefixes_ignore(&ps, PFXIDX_SEG);
-			}
-		}
+		if (ci.dt == Decode64Bits) decode_prefixes64(&ps, code);
 
 		/* Make sure there is at least one more entry to use, for the upcoming instruction. */
 		if (nextPos + 1 > maxResultCount) return DECRES_MEMORYERR;
@@ -613,3 +715,132 @@ _DecodeResult decode_internal(_CodeInfo* _ci, int supportOldIntr, _DInst result[
 
 	return DECRES_SUCCESS;
 }
+
+_DecodeResult decode_internal(_CodeInfo* ci, int supportOldIntr, _DInst result[], unsigned int maxResultCount, unsigned int* usedInstructionsCount)
+{
+	return decode_range(ci, supportOldIntr, result, maxResultCount, usedInstructionsCount, NULL);
+}
+
+_DecodeResult decode_slice(_CodeInfo* ci, _DInst result[], unsigned int maxResultCount, unsigned int* usedInstructionsCount, _DecodeSlice* slice)
+{
+	return decode_range(ci, FALSE, result, maxResultCount, usedInstructionsCount, slice);
+}
+
+/*
+ * decode_flow
+ *
+ * Goes over the code exactly like decode_internal with DF_RETURN_FC_ONLY, including when it returns DECRES_MEMORYERR.
+ * Only the flow control instructions are decoded fully, the rest are skipped over with decode_inst_length.
+ */
+_DecodeResult decode_flow(_CodeInfo* _ci, _DFlowInst result[], unsigned int maxResultCount, unsigned int* usedInstructionsCount)
+{
+	_PrefixState ps;
+	unsigned int prefixSize;
+	_CodeInfo ci;
+	_InstLookup il;
+	_DInst di;
+	int size;
+
+	_OffsetType codeOffset = _ci->codeOffset;
+	const uint8_t* code = _ci->code;
+	int codeLen = _ci->codeLen;
+
+	/* The displayed offset of the current instruction, see decode_range. */
+	_OffsetType startInstOffset = 0;
+
+	unsigned int nextPos = 0;
+	_DFlowInst* fi = NULL;
+
+	_OffsetType addrMask = (_OffsetType)-1;
+
+	if (_ci->features & DF_MAXIMUM_ADDR32) addrMask = 0xffffffff;
+	else if (_ci->features & DF_MAXIMUM_ADDR16) addrMask = 0xffff;
+
+	*usedInstructionsCount = 0;
+	ci.dt = _ci->dt;
+	_ci->nextOffset = codeOffset;
+
+	while (codeLen > 0) {
+		startInstOffset = codeOffset;
+
+		memset(&ps, 0, (size_t)((char*)&ps.pfxIndexer[0] - (char*)&ps));
+		memset(ps.pfxIndexer, PFXIDX_NONE, sizeof(int) * PFXIDX_MAX);
+		ps.start = code;
+		ps.last = code;
+		prefixSize = 0;
+
+		if (prefixes_is_valid(*code, ci.dt)) {
+			prefixes_decode(code, codeLen, &ps, ci.dt);
+			prefixSize = (unsigned int)(ps.last - ps.start);
+			codeLen -= prefixSize;
+			/* Prefixes alone are never returned with DF_RETURN_FC_ONLY. */
+			if (codeLen == 0) break;
+			code += prefixSize;
+			codeOffset += prefixSize;
+
+			if (prefixSize == INST_MAXIMUM_SIZE) {
+				_ci->nextOffset = codeOffset;
+				continue;
+			}
+		}
+
+		if (ci.dt == Decode64Bits) decode_prefixes64(&ps, code);
+
+		/* decode_internal wants room for the instruction even if it's going to be filtered. */
+		if (nextPos + 1 > maxResultCount) return DECRES_MEMORYERR;
+
+		ci.code = code;
+		ci.codeLen = codeLen;
+
+		/* An instruction that can't be decoded is dropped a byte at a time. */
+		size = 1;
+		if (decode_inst_lookup(&ci, &ps, &il)) {
+			size = -1;
+			if (META_GET_FC(il.isi->meta) == FC_NONE) size = decode_inst_length(&ci, &ps, &il);
+
+			if (size == 0) size = 1;
+			else if (size < 0) {
+				/* Flow control, or something only operands_extract can validate. */
+				if ((decode_inst_operands(&ci, &ps, &il, &di) == DECRES_SUCCESS) && (META_GET_FC(di.meta) != FC_NONE)) {
+					fi = &result[nextPos++];
+					fi->addr = startInstOffset & addrMask;
+					fi->size = (uint8_t)(di.size + prefixSize);
+					fi->opcode = di.opcode;
+					fi->fc = META_GET_FC(di.meta);
+					fi->targetType = di.ops[0].type;
+					fi->target = 0;
+					fi->targetSeg = 0;
+					if (di.ops[0].type == O_PC) fi->target = (_OffsetType)(fi->addr + di.imm.addr + fi->size);
+					else if (di.ops[0].type == O_PTR) {
+						fi->target = di.imm.ptr.off;
+						fi->targetSeg = di.imm.ptr.seg;
+					}
+				} else fi = NULL;
+				size = di.size;
+			}
+		}
+
+		/* Advance to next instruction. */
+		codeLen -= size;
+		codeOffset += size;
+		code += size;
+
+		*usedInstructionsCount = nextPos;
+		_ci->nextOffset = codeOffset;
+
+		/* Check whether we need to stop on any flow control instruction. */
+		if ((fi != NULL) && (_ci->features & DF_STOP_ON_FLOW_CONTROL)) {
+			if (((_ci->features & DF_STOP_ON_CALL) && (fi->fc == FC_CALL)) ||
+				((_ci->features & DF_STOP_ON_RET) && (fi->fc == FC_RET)) ||
+				((_ci->features & DF_STOP_ON_SYS) && (fi->fc == FC_SYS)) ||
+				((_ci->features & DF_STOP_ON_UNC_BRANCH) && (fi->fc == FC_UNC_BRANCH)) ||
+				((_ci->features & DF_STOP_ON_CND_BRANCH) && (fi->fc == FC_CND_BRANCH)) ||
+				((_ci->features & DF_STOP_ON_INT) && (fi->fc == FC_INT)) ||
+				((_ci->features & DF_STOP_ON_CMOV) && (fi->fc == FC_CMOV)))
+				return DECRES_SUCCESS;
+		}
+		fi = NULL;
+	}
+
+	return DECRES_SUCCESS;
+}
@@ -28,6 +28,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>
 
 typedef unsigned int _iflags;
 
+/*
+ * A slice of a larger code buffer, used by the parallel decomposer.
+ * Decoding stops before any instruction that would start at or after 'end'.
+ * Bit n in 'steps' stands for base[n], it is set for every position where decoding
+ * of an instruction (or of a run of undecodable prefix bytes) started.
+ * If 'sync' is set the bits are not set, instead decoding stops at the first position whose bit is already set.
+ */
+typedef struct {
+	const uint8_t* base;
+	const uint8_t* end;
+	uint8_t* steps;
+	int sync;
+} _DecodeSlice;
+
 _DecodeResult decode_internal(_CodeInfo* ci, int supportOldIntr, _DInst result[], unsigned int maxResultCount, unsigned int* usedInstructionsCount);
+_DecodeResult decode_slice(_CodeInfo* ci, _DInst result[], unsigned int maxResultCount, unsigned int* usedInstructionsCount, _DecodeSlice* slice);
+_DecodeResult decode_flow(_CodeInfo* ci, _DFlowInst result[], unsigned int maxResultCount, unsigned int* usedInstructionsCount);
 
 #endif /* DECODER_H */
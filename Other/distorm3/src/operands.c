@@ -1296,3 +1296,106 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 
 	return TRUE;
 }
+
+/* How many bytes the memory indirection of a ModR/M byte takes: a SIB byte and a displacement. */
+static int operands_modrm_length(const uint8_t* code, int codeLen, unsigned int mod, unsigned int rm, _DecodeType effAdrSz)
+{
+	unsigned int sib = 0;
+	int size = 0;
+
+	if (effAdrSz == Decode16Bits) {
+		if ((mod == 0) && (rm == 6)) size = sizeof(int16_t);
+		else if (mod == 1) size = sizeof(int8_t);
+		else if (mod == 2) size = sizeof(int16_t);
+	} else if ((mod == 0) && (rm == 5)) size = sizeof(int32_t);
+	else {
+		if (rm == 4) {
+			if (codeLen < 1) return -1;
+			sib = *code;
+			size = sizeof(int8_t);
+		}
+		/* Same as operands_extract_modrm, if there is no BASE, read DISP32. */
+		if (mod == 1) size += sizeof(int8_t);
+		else if ((mod == 2) || ((sib & 7) == 5)) size += sizeof(int32_t);
+	}
+	return (size <= codeLen) ? size : -1;
+}
+
+/*
+ * Used by the flow control scanner to skip over the operands of the instructions it isn't interested in.
+ * Returns the number of bytes the operand takes in the stream, that's where operands_extract would leave ci->code.
+ * Returns -1 when operands_extract would fail because of the ModR/M byte or because the stream ended, and
+ * -2 for the types which it doesn't handle, they have to be extracted (control, debug and segment registers are validated).
+ */
+int operands_length(const uint8_t* code, int codeLen, _OpType type, unsigned int modrm,
+                    _iflags instFlags, _DecodeType effOpSz, _DecodeType effAdrSz)
+{
+	unsigned int mod = (modrm >> 6) & 3, rm = modrm & 7;
+	int size = 0;
+
+	switch (type)
+	{
+		/* The memory is optional, a MOD of 3 means there is no operand. */
+		case OT_MEM_OPT:
+			if (mod == 0x3) return 0;
+			return operands_modrm_length(code, codeLen, mod, rm, effAdrSz);
+
+		/* Memory indirection operands that cannot be a general purpose register. */
+		case OT_MEM64_128: case OT_MEM32: case OT_MEM32_64: case OT_MEM64: case OT_MEM128:
+		case OT_MEM16_FULL: case OT_MEM16_3264: case OT_FPUM16: case OT_FPUM32: case OT_FPUM64:
+		case OT_FPUM80: case OT_LMEM128_256: case OT_MEM:
+			if (mod == 0x3) return -1;
+			return operands_modrm_length(code, codeLen, mod, rm, effAdrSz);
+
+		/* Memory indirection operands that can be a register. */
+		case OT_RM_FULL: case OT_RM16: case OT_RM32_64: case OT_RM16_32: case OT_WXMM32_64:
+		case OT_WRM32_64: case OT_YXMM64_256: case OT_YXMM128_256: case OT_LXMM64_128: case OT_RFULL_M16:
+		case OT_RM8: case OT_R32_M8: case OT_R32_64_M8: case OT_REG32_64_M8: case OT_XMM16:
+		case OT_R32_M16: case OT_R32_64_M16: case OT_REG32_64_M16: case OT_RM32: case OT_MM32:
+		case OT_XMM32: case OT_MM64: case OT_XMM64: case OT_XMM128: case OT_YMM256:
+			if (mod == 0x3) return 0;
+			return operands_modrm_length(code, codeLen, mod, rm, effAdrSz);
+
+		case OT_IMM8: case OT_SEIMM8: case OT_IMM8_1: case OT_IMM8_2: case OT_RELCB:
+		case OT_XMM_IMM: case OT_YXMM_IMM:
+			size = sizeof(int8_t);
+		break;
+		case OT_IMM16: case OT_IMM16_1:
+			size = sizeof(int16_t);
+		break;
+		case OT_IMM32:
+			size = sizeof(int32_t);
+		break;
+		case OT_IMM_FULL:
+			if (effOpSz == Decode16Bits) size = sizeof(int16_t);
+			else if ((effOpSz == Decode64Bits) &&
+			         ((instFlags & (INST_64BITS | INST_PRE_REX)) == (INST_64BITS | INST_PRE_REX))) size = sizeof(int64_t);
+			else size = sizeof(int32_t);
+		break;
+		case OT_RELC_FULL:
+			size = (effOpSz == Decode16Bits) ? sizeof(int16_t) : sizeof(int32_t);
+		break;
+		case OT_PTR16_FULL:
+			size = (effOpSz == Decode16Bits) ? sizeof(int16_t) * 2 : sizeof(int32_t) + sizeof(int16_t);
+		break;
+		case OT_MOFFS8: case OT_MOFFS_FULL:
+			if (effAdrSz == Decode16Bits) size = sizeof(int16_t);
+			else if (effAdrSz == Decode32Bits) size = sizeof(int32_t);
+			else size = sizeof(int64_t);
+		break;
+
+		/* Registers and constants, coded in the opcode, the ModR/M byte or the VEX prefix. */
+		case OT_REG8: case OT_REG16: case OT_REG_FULL: case OT_REG32: case OT_REG32_64:
+		case OT_FREG32_64_RM: case OT_SEG: case OT_ACC8: case OT_ACC16: case OT_ACC_FULL:
+		case OT_ACC_FULL_NOT64: case OT_CONST1: case OT_REGCL: case OT_IB_RB: case OT_IB_R_FULL:
+		case OT_REGI_ESI: case OT_REGI_EDI: case OT_REGI_EBXAL: case OT_REGI_EAX: case OT_REGDX:
+		case OT_REGECX: case OT_FPU_SI: case OT_FPU_SSI: case OT_FPU_SIS: case OT_MM:
+		case OT_MM_RM: case OT_XMM: case OT_XMM_RM: case OT_REGXMM0: case OT_WREG32_64:
+		case OT_VXMM: case OT_YXMM: case OT_YMM: case OT_VYMM: case OT_VYXMM:
+			return 0;
+
+		default: return -2;
+	}
+
+	return (size <= codeLen) ? size : -1;
+}
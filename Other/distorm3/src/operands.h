@@ -36,5 +36,7 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
                      _iflags instFlags, _OpType type, _OperandNumberType opNum,
                      unsigned int modrm, _PrefixState* ps, _DecodeType effOpSz,
                      _DecodeType effAdrSz, int* lockableInstruction);
+int operands_length(const uint8_t* code, int codeLen, _OpType type, unsigned int modrm,
+                    _iflags instFlags, _DecodeType effOpSz, _DecodeType effAdrSz);
 
 #endif /* OPERANDS_H */
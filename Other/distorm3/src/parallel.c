@@ -0,0 +1,337 @@
+/*
+parallel.c
+
+diStorm3 - Powerful disassembler for X86/AMD64
+http://ragestorm.net/distorm/
+distorm at gmail dot com
+Copyright (C) 2003-2012 Gil Dabah
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+#include "../include/distorm.h"
+#include "config.h"
+#include "decoder.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <unistd.h>
+#endif
+
+/*
+ * The code is cut into chunks, each decoded by its own thread as if an instruction started at the chunk's beginning.
+ * That guess is wrong whenever the previous chunk's last instruction crosses the boundary, so every thread
+ * also marks each position where it started decoding in a bitmap of the whole buffer.
+ * Afterwards the real stream, coming from the previous chunk, is decoded again from where it crossed the boundary,
+ * until it gets to a position that was marked by the chunk's thread. From there on the streams are the same,
+ * because decoding only depends on the position (every decoding is given the rest of the buffer).
+ * That is usually a few instructions away, and if they never meet the chunk's results are dropped in favour of the re-decoding.
+ *
+ * Keeping every chunk's entries until they are stitched together would take about as much memory again as the result,
+ * so the threads go over the code twice. The first time they only count the entries and mark the steps.
+ * That is enough to decode the seams straight into the result and to know where each chunk's entries go,
+ * the second time the threads decode their chunks (from where they met the real stream) into their place in the result.
+ */
+
+/* Don't bother with threads for less than this many bytes per thread. Must be a multiple of 64. */
+#define PARALLEL_MIN_CHUNK (0x10000)
+#define PARALLEL_MAX_THREADS (64)
+/* Entries a counting pass decodes into at a time, enough for any single decoding step (a run of prefixes and the byte after them). */
+#define PARALLEL_COUNT_ROOM (256)
+
+typedef struct {
+	_CodeInfo ci; /* Template of the whole buffer: codeOffset, code, codeLen, dt, features. */
+	_DecodeSlice slice;
+	const uint8_t* start; /* Where the chunk's own decoding starts. */
+	_DInst* out; /* Where its entries go, NULL to only count them. */
+	unsigned int room;
+	unsigned int count;
+	_OffsetType nextOffset; /* Where the decoding stopped, the first step at or after slice.end. */
+	int failed;
+} _ParallelChunk;
+
+/*
+ * Decodes the slice from the given position into chunk->out, or counts the entries when there is no destination.
+ * Counting reuses a small buffer, decode_slice reports the used entries up to the step it had no room for,
+ * so it's just called again from there.
+ */
+static void decode_chunk(_ParallelChunk* chunk, const uint8_t* from)
+{
+	_DInst scratch[PARALLEL_COUNT_ROOM];
+	_CodeInfo ci = chunk->ci;
+	_DecodeResult res;
+	unsigned int used;
+	int skip = (int)(from - chunk->ci.code);
+
+	ci.codeOffset += skip;
+	ci.code += skip;
+	ci.codeLen -= skip;
+
+	chunk->count = 0;
+	for (;;) {
+		if (chunk->out == NULL) res = decode_slice(&ci, scratch, PARALLEL_COUNT_ROOM, &used, &chunk->slice);
+		else res = decode_slice(&ci, &chunk->out[chunk->count], chunk->room - chunk->count, &used, &chunk->slice);
+		chunk->count += used;
+		if (res != DECRES_MEMORYERR) break;
+
+		if (chunk->out != NULL) {
+			chunk->failed = TRUE;
+			return;
+		}
+
+		skip = (int)(ci.nextOffset - ci.codeOffset);
+		ci.codeOffset = ci.nextOffset;
+		ci.code += skip;
+		ci.codeLen -= skip;
+	}
+
+	chunk->nextOffset = ci.nextOffset;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI chunk_thread(LPVOID param)
+{
+	_ParallelChunk* chunk = (_ParallelChunk*)param;
+	decode_chunk(chunk, chunk->start);
+	return 0;
+}
+#else
+static void* chunk_thread(void* param)
+{
+	_ParallelChunk* chunk = (_ParallelChunk*)param;
+	decode_chunk(chunk, chunk->start);
+	return NULL;
+}
+#endif
+
+static unsigned int cpus_count(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return (unsigned int)si.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? (unsigned int)n : 1;
+#endif
+}
+
+/* Runs the first chunk on the calling thread and the rest on their own. Returns FALSE if any chunk failed. */
+static int run_chunks(_ParallelChunk* chunks, unsigned int count)
+{
+	unsigned int i, started;
+	int ok = TRUE;
+#ifdef _WIN32
+	HANDLE threads[PARALLEL_MAX_THREADS];
+#else
+	pthread_t threads[PARALLEL_MAX_THREADS];
+#endif
+
+	for (started = 1; started < count; started++) {
+#ifdef _WIN32
+		threads[started] = CreateThread(NULL, 0, chunk_thread, &chunks[started], 0, NULL);
+		if (threads[started] == NULL) break;
+#else
+		if (pthread_create(&threads[started], NULL, chunk_thread, &chunks[started]) != 0) break;
+#endif
+	}
+
+	decode_chunk(&chunks[0], chunks[0].start);
+
+	for (i = 1; i < started; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else
+		pthread_join(threads[i], NULL);
+#endif
+	}
+
+	/* Chunks whose thread couldn't be created are decoded here. */
+	for (i = started; i < count; i++) decode_chunk(&chunks[i], chunks[i].start);
+
+	for (i = 0; i < count; i++) {
+		if (chunks[i].failed) ok = FALSE;
+	}
+	return ok;
+}
+
+/*
+ * Follows the real stream from chunk to chunk after the counting pass (see the comment at the top).
+ * The seams are decoded into the result, and each chunk is set up to decode the rest of its entries into their place.
+ * Returns FALSE when the result array is too small to tell it apart from distorm_decompose's DECRES_MEMORYERR.
+ */
+static int place_chunks(_ParallelChunk* chunks, unsigned int count, _DInst result[], unsigned int maxInstructions, unsigned int* total, _OffsetType* nextOffset)
+{
+	_ParallelChunk seam;
+	const uint8_t* code = chunks[0].ci.code;
+	_OffsetType codeOffset = chunks[0].ci.codeOffset;
+	_OffsetType pos;
+	unsigned int i, skipped;
+
+	if (chunks[0].count >= maxInstructions) return FALSE;
+	chunks[0].out = result;
+	chunks[0].room = chunks[0].count;
+	*total = chunks[0].count;
+	*nextOffset = chunks[0].nextOffset;
+
+	for (i = 1; i < count; i++) {
+		/* Continue the real stream until it meets a step of this chunk, or leaves it. */
+		memset(&seam, 0, sizeof(seam));
+		seam.ci = chunks[i].ci;
+		seam.slice = chunks[i].slice;
+		seam.slice.sync = TRUE;
+		seam.out = &result[*total];
+		seam.room = maxInstructions - *total;
+		decode_chunk(&seam, code + (*nextOffset - codeOffset));
+		if (seam.failed) return FALSE;
+
+		*total += seam.count;
+		if (*total >= maxInstructions) return FALSE;
+		*nextOffset = seam.nextOffset;
+		pos = *nextOffset - codeOffset;
+
+		chunks[i].out = &result[*total];
+		if (code + pos < chunks[i].slice.end) {
+			/* They met, the chunk's entries from there on are good. Count the ones before it, they are dropped. */
+			memset(&seam, 0, sizeof(seam));
+			seam.ci = chunks[i].ci;
+			seam.slice = chunks[i].slice;
+			seam.slice.end = code + pos;
+			decode_chunk(&seam, chunks[i].start);
+			skipped = seam.count;
+
+			chunks[i].start = code + pos;
+			chunks[i].count -= skipped;
+			if (chunks[i].count >= maxInstructions - *total) return FALSE;
+			chunks[i].room = chunks[i].count;
+			*total += chunks[i].count;
+			*nextOffset = chunks[i].nextOffset;
+		} else {
+			/* They never met, the seam took the whole chunk. */
+			chunks[i].start = chunks[i].slice.end;
+			chunks[i].count = 0;
+			chunks[i].room = 0;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Decodes the chunks into the places that place_chunks found for them, each has to come out exactly as counted. */
+static int fill_chunks(_ParallelChunk* chunks, unsigned int count)
+{
+	unsigned int i, expected[PARALLEL_MAX_THREADS];
+	_OffsetType nextOffset[PARALLEL_MAX_THREADS];
+
+	for (i = 0; i < count; i++) {
+		expected[i] = chunks[i].count;
+		nextOffset[i] = chunks[i].nextOffset;
+	}
+
+	if (!run_chunks(chunks, count)) return FALSE;
+
+	for (i = 0; i < count; i++) {
+		if (chunks[i].count != expected[i]) return FALSE;
+		if ((expected[i] != 0) && (chunks[i].nextOffset != nextOffset[i])) return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Same as distorm_decompose, only the code is decoded by several threads.
+ * The result is identical to distorm_decompose's, for small inputs, the DF_STOP_ON_* features,
+ * DF_MAXIMUM_ADDR16 and when the result array turns out to be too small, it simply calls it.
+ */
+#ifdef SUPPORT_64BIT_OFFSET
+	_DLLEXPORT_ _DecodeResult distorm_decompose_parallel64(_CodeInfo* ci, _DInst result[], unsigned int maxInstructions, unsigned int* usedInstructionsCount, unsigned int threadsCount)
+#else
+	_DLLEXPORT_ _DecodeResult distorm_decompose_parallel32(_CodeInfo* ci, _DInst result[], unsigned int maxInstructions, unsigned int* usedInstructionsCount, unsigned int threadsCount)
+#endif
+{
+	_ParallelChunk chunks[PARALLEL_MAX_THREADS];
+	uint8_t* steps = NULL;
+	unsigned int i, chunkSize;
+	_OffsetType nextOffset = 0;
+	unsigned int total = 0;
+	int ok = FALSE;
+
+	if (usedInstructionsCount == NULL) {
+		return DECRES_SUCCESS;
+	}
+
+	/* DECRES_SUCCESS still may indicate we may have something in the result, so zero it first thing. */
+	*usedInstructionsCount = 0;
+
+	if ((ci == NULL) ||
+		(ci->codeLen < 0) ||
+		((ci->dt != Decode16Bits) && (ci->dt != Decode32Bits) && (ci->dt != Decode64Bits)) ||
+		(ci->code == NULL) ||
+		(result == NULL) ||
+		((ci->features & (DF_MAXIMUM_ADDR16 | DF_MAXIMUM_ADDR32)) == (DF_MAXIMUM_ADDR16 | DF_MAXIMUM_ADDR32)))
+	{
+		return DECRES_INPUTERR;
+	}
+
+	/* Assume length=0 is success. */
+	if (ci->codeLen == 0) {
+		return DECRES_SUCCESS;
+	}
+
+	if (threadsCount == 0) threadsCount = cpus_count();
+	if (threadsCount > PARALLEL_MAX_THREADS) threadsCount = PARALLEL_MAX_THREADS;
+	if (threadsCount > (unsigned int)ci->codeLen / PARALLEL_MIN_CHUNK) threadsCount = (unsigned int)ci->codeLen / PARALLEL_MIN_CHUNK;
+
+	/*
+	 * Stopping on flow control depends on everything before it, and with 16 bits addresses
+	 * the entries can't be put back in order by their address.
+	 */
+	if ((threadsCount > 1) && !(ci->features & (DF_STOP_ON_FLOW_CONTROL | DF_MAXIMUM_ADDR16))) {
+		steps = (uint8_t*)calloc((size_t)ci->codeLen / 8 + 1, 1);
+	}
+
+	if (steps != NULL) {
+		chunkSize = ((unsigned int)ci->codeLen / threadsCount) & ~(PARALLEL_MIN_CHUNK - 1);
+
+		memset(chunks, 0, sizeof(chunks));
+		for (i = 0; i < threadsCount; i++) {
+			chunks[i].ci = *ci;
+			chunks[i].start = ci->code + i * chunkSize;
+			chunks[i].slice.base = ci->code;
+			chunks[i].slice.end = (i == threadsCount - 1) ? ci->code + ci->codeLen : chunks[i].start + chunkSize;
+			chunks[i].slice.steps = steps;
+			chunks[i].slice.sync = FALSE;
+		}
+
+		ok = run_chunks(chunks, threadsCount) &&
+			place_chunks(chunks, threadsCount, result, maxInstructions, &total, &nextOffset) &&
+			fill_chunks(chunks, threadsCount);
+
+		free(steps);
+	}
+
+	/* Anything that didn't work out, or a result array too small, is left to the sequential decoder. */
+	if (!ok) {
+		return decode_internal(ci, FALSE, result, maxInstructions, usedInstructionsCount);
+	}
+
+	*usedInstructionsCount = total;
+	ci->nextOffset = nextOffset;
+	return DECRES_SUCCESS;
+}